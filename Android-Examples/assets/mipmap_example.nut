@@ -0,0 +1,138 @@
+local stage = emo.Stage();
+local event = emo.Event();
+
+const TEXTURE_NAME  = "grid_1024.png";
+const TEXTURE_SCALE = 0.25;
+const LAYERS        = 4;
+const WARMUP_FPS    = 2;
+const SAMPLE_FPS    = 5;
+
+/*
+ * This example is a texture bandwidth benchmark for mipmaps.
+ * The screen is covered LAYERS times by a 1024x1024 texture drawn at
+ * quarter size, which is what a zoomed out map does. The frame rate is
+ * measured with GL_LINEAR sampling of level 0 first, then the mipmap
+ * chain is generated and the frame rate is measured again.
+ * The sprites are translucent so that every layer is sampled.
+ */
+class Main {
+
+    sprites = [];
+    text = emo.TextSprite("font_16x16.png",
+        " !\"c*%#'{}@+,-./0123456789:;[|]?&ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+        16, 16, 2, 1);
+
+    phase   = 0;
+    samples = [];
+    results = [];
+    textureBytes = [];
+
+    /*
+     * Called when this class is loaded
+     */
+    function onLoad() {
+        print("onLoad");
+
+        local size    = 1024 * TEXTURE_SCALE;
+        local columns = ceil(stage.getWindowWidth()  / size).tointeger();
+        local rows    = ceil(stage.getWindowHeight() / size).tointeger();
+
+        for (local layer = 0; layer < LAYERS; layer++) {
+            for (local row = 0; row < rows; row++) {
+                for (local column = 0; column < columns; column++) {
+                    local sprite = emo.Sprite(TEXTURE_NAME);
+
+                    // packed images can not have mipmaps
+                    sprite.setPackable(false);
+                    sprite.setMipmap(MIPMAP_NONE);
+
+                    sprite.scale(TEXTURE_SCALE, TEXTURE_SCALE, 0, 0);
+                    sprite.move(column * size, row * size);
+                    sprite.color(1, 1, 1, 0.5);
+                    sprite.load();
+
+                    sprites.append(sprite);
+                }
+            }
+        }
+
+        text.setText("MEASURING WITHOUT MIPMAP");
+        text.scale(0.7, 0.7);
+        text.move(8, 8);
+        text.setZ(99);
+        text.load();
+
+        print(format("%d sprites, %d layers of %dx%d pixels", sprites.len(), LAYERS,
+                stage.getWindowWidth(), stage.getWindowHeight()));
+
+        // onFps(fps) will be called on every second
+        event.enableOnFpsCallback(1000);
+    }
+
+    /*
+     * Called when the app has gained focus
+     */
+    function onGainedFocus() {
+        print("onGainedFocus");
+    }
+
+    /*
+     * Called when the app has lost focus
+     */
+    function onLostFocus() {
+        print("onLostFocus");
+    }
+
+    /*
+     * Called when the class ends
+     */
+    function onDispose() {
+        print("onDispose");
+
+        event.disableOnFpsCallback();
+
+        // remove sprites from the screen
+        for (local i = 0; i < sprites.len(); i++) {
+            sprites[i].remove();
+        }
+        text.remove();
+    }
+
+    /*
+     * Enabled after onFps event is enabled by enableOnFpsCallback
+     */
+    function onFps(fps) {
+        if (phase > 1) return;
+
+        samples.append(fps);
+        print(format("%s FPS: %4.2f", phase == 0 ? "GL_LINEAR" : "GL_LINEAR_MIPMAP_LINEAR", fps));
+
+        if (samples.len() < WARMUP_FPS + SAMPLE_FPS) return;
+
+        local total = 0.0;
+        for (local i = WARMUP_FPS; i < samples.len(); i++) {
+            total += samples[i];
+        }
+        results.append(total / SAMPLE_FPS);
+        textureBytes.append(stage.getTextureMemory().textureBytes);
+        samples = [];
+        phase++;
+
+        if (phase == 1) {
+            // the sprites share one image: the chain is generated once
+            for (local i = 0; i < sprites.len(); i++) {
+                sprites[i].setMipmap(MIPMAP_ALWAYS);
+            }
+            text.setText("MEASURING WITH MIPMAP");
+            return;
+        }
+
+        print(format("without mipmap: %4.2f FPS, texture memory %d bytes", results[0], textureBytes[0]));
+        print(format("with mipmap:    %4.2f FPS, texture memory %d bytes", results[1], textureBytes[1]));
+        text.setText(format("FPS %.1f / MIPMAP %.1f", results[0], results[1]));
+    }
+}
+
+function emo::onLoad() {
+    stage.load(Main());
+}
@@ -93,7 +93,8 @@ public class Launcher extends ExpandableListActivity {
 			"Splash Screen",
 			"HTTP Access",
 			"Compiling a Script",
-			"Using Blendfunc"
+			"Using Blendfunc",
+			"Mipmap Benchmark"
 		}
     };
     private static final String[][] activities = {
@@ -161,7 +162,8 @@ public class Launcher extends ExpandableListActivity {
 			".ModifierEventExample",
 			".HTTPAccessExample",
 			".CompileScriptExample",
-			".BlendfuncExample"
+			".BlendfuncExample",
+			".MipmapExample"
 		}
     	
     };
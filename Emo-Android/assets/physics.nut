@@ -31,6 +31,20 @@ PHYSICS_STATE_REMOVE  <- 2;
 
 PTM_RATIO <- 32;
 
+// number of float values per body in packed body data
+PHYSICS_BATCH_STRIDE <- 10;
+
+PHYSICS_DEBUGDRAW_SHAPE          <- 0x0001;
+PHYSICS_DEBUGDRAW_JOINT          <- 0x0002;
+PHYSICS_DEBUGDRAW_AABB           <- 0x0004;
+PHYSICS_DEBUGDRAW_PAIR           <- 0x0008;
+PHYSICS_DEBUGDRAW_CENTER_OF_MASS <- 0x0010;
+PHYSICS_DEBUGDRAW_CONTACT        <- 0x0020;
+
+PHYSICS_PROFILE_LOG_NONE    <- 0;
+PHYSICS_PROFILE_LOG_STEP    <- 1;
+PHYSICS_PROFILE_LOG_AVERAGE <- 2;
+
 emo.physics <- {};
 
 class emo.physics.World {
@@ -39,8 +53,15 @@ class emo.physics.World {
     scale   = null;
     sprites = null;
     groundBody = null;
-    function constructor(gravity, doSleep) {
-        id = physics.newWorld(gravity, doSleep);
+    // options: table with "stackSize" and "chunkSize" of the allocators in bytes
+    function constructor(gravity, doSleep, options = null) {
+        local stackSize = 0;
+        local chunkSize = 0;
+        if (options != null) {
+            if ("stackSize" in options) stackSize = options.stackSize;
+            if ("chunkSize" in options) chunkSize = options.chunkSize;
+        }
+        id = physics.newWorld(gravity, doSleep, stackSize, chunkSize);
         scale = PTM_RATIO;
         sprites = [];
     }
@@ -87,6 +108,19 @@ class emo.physics.World {
         return physics.destroyBody(id, body.id);
     }
 
+    function createBodies(data) {
+        local result = physics.createBodies(id, data, scale);
+        if (result == null) return null;
+        
+        local bodies   = [];
+        local fixtures = [];
+        for (local i = 0; i < result.bodies.len(); i++) {
+            bodies.append(emo.physics.Body(result.bodies[i]));
+            fixtures.append(emo.physics.Fixture(result.bodies[i], result.fixtures[i]));
+        }
+        return { bodies = bodies, fixtures = fixtures };
+    }
+
     function getGroundBody() {
         if (groundBody == null) {
             groundBody = emo.physics.Body(physics.createGroundBody(id));
@@ -153,6 +187,75 @@ class emo.physics.World {
     function getAutoClearForces() {
         return physics.world_getAutoClearForces(id);
     }
+    
+    function snapshot() {
+        return emo.physics.WorldSnapshot(physics.world_snapshot(id));
+    }
+    
+    function restore(snapshot, clear = true) {
+        local result = physics.world_restore(id, snapshot.id, clear);
+        if (result == null) return null;
+        
+        if (groundBody != null) {
+            if (result.ids.rawin(groundBody.id)) {
+                groundBody.id = result.ids[groundBody.id];
+            } else if (clear) {
+                groundBody = null;
+            }
+        }
+        
+        for (local i = sprites.len() - 1; i >= 0; i--) {
+            if (!sprites[i].remap(result.ids) && clear) {
+                sprites.remove(i);
+            }
+        }
+        return result;
+    }
+    
+    function enableDebugDraw(flags = null, lineWidth = null) {
+        if (flags == null) flags = PHYSICS_DEBUGDRAW_SHAPE | PHYSICS_DEBUGDRAW_JOINT;
+        return physics.world_enableDebugDraw(id, flags, scale, lineWidth);
+    }
+    
+    function disableDebugDraw() {
+        return physics.world_disableDebugDraw(id);
+    }
+    
+    function getDebugDrawStats() {
+        return physics.world_getDebugDrawStats(id);
+    }
+    
+    function enableProfiler(logMode = PHYSICS_PROFILE_LOG_NONE, window = 60) {
+        return physics.world_enableProfiler(id, logMode, window);
+    }
+    
+    function disableProfiler() {
+        return physics.world_disableProfiler(id);
+    }
+    
+    function getProfile(average = false) {
+        return physics.world_getProfile(id, average);
+    }
+    
+    function getAllocatorStats() {
+        return physics.world_getAllocatorStats(id);
+    }
+}
+
+class emo.physics.WorldSnapshot {
+    id      = null;
+    physics = emo.Physics();
+    function constructor(_id) {
+        id = _id;
+    }
+    
+    function save(filename) {
+        return physics.snapshot_save(id, filename);
+    }
+    
+    function size() {
+        return physics.snapshot_size(id);
+    }
 }
 
 class emo.physics.Body {
@@ -859,6 +962,14 @@ class emo.physics.PhysicsInfo {
         return fixture;
     }
     
+    function remap(ids) {
+        if (!ids.rawin(body.id)) return false;
+        body.id = ids[body.id];
+        fixture.bodyId = body.id;
+        if (ids.rawin(fixture.id)) fixture.id = ids[fixture.id];
+        return true;
+    }
+    
     function remove() {
         world.removePhysicsObject(this);
         world.destroyBody(getBody());
@@ -982,6 +1093,19 @@ class emo.physics.SoftPhysicsInfo extends emo.physics.PhysicsInfo {
         }
     }
     
+    function remap(ids) {
+        foreach (segment in segments) {
+            if (ids.rawin(segment.id)) segment.id = ids[segment.id];
+        }
+        foreach (joint in segmentJoints) {
+            if (ids.rawin(joint.id)) joint.id = ids[joint.id];
+        }
+        foreach (joint in innerJoints) {
+            if (ids.rawin(joint.id)) joint.id = ids[joint.id];
+        }
+        return base.remap(ids);
+    }
+    
     function remove() {
         foreach (line in lines) {
             line.remove();
@@ -1002,6 +1126,12 @@ class emo.physics.SoftPhysicsInfo extends emo.physics.PhysicsInfo {
     }
 }
 
+function emo::Physics::loadSnapshot(filename, type = TYPE_ASSET) {
+    local snapshot = emo.Physics().snapshot_load(filename, type);
+    if (snapshot == null) return null;
+    return emo.physics.WorldSnapshot(snapshot);
+}
+
 function emo::Physics::createSoftCircleSprite(world, sprite, fixtureDef = null, debug = false) {
     local segmentCount = sprite.rawin("getSegmentCount") ? sprite.getSegmentCount() - 2 : 16;
     
@@ -1159,6 +1289,31 @@ function emo::Physics::createSprite(world, sprite, bodyType, shape, fixtureDef =
     return physicsInfo;
 }
 
+function emo::Physics::createSprites(world, sprites, bodyType, shapeType = PHYSICS_SHAPE_TYPE_POLYGON, fixtureDef = null) {
+    local ids = [];
+    foreach (sprite in sprites) ids.append(sprite.id);
+    
+    local data = { sprite = ids, type = bodyType, shape = shapeType };
+    if (fixtureDef != null) {
+        if (fixtureDef.density     != null) data.density     <- fixtureDef.density;
+        if (fixtureDef.friction    != null) data.friction    <- fixtureDef.friction;
+        if (fixtureDef.restitution != null) data.restitution <- fixtureDef.restitution;
+        if (fixtureDef.isSensor    != null) data.isSensor    <- fixtureDef.isSensor;
+    }
+    
+    local result = world.createBodies(data);
+    if (result == null) return null;
+    
+    local infos = [];
+    for (local i = 0; i < sprites.len(); i++) {
+        local physicsInfo = emo.physics.PhysicsInfo(world, sprites[i], result.fixtures[i], bodyType);
+        world.addPhysicsObject(physicsInfo);
+        sprites[i].setPhysicsInfo(physicsInfo);
+        infos.append(physicsInfo);
+    }
+    return infos;
+}
+
 function emo::Physics::createStaticSprite(world, sprite, fixtureDef = null, bodyDef = null) {
     local shape = emo.physics.PolygonShape();
     return emo.Physics.createSprite(world, sprite, PHYSICS_BODY_TYPE_STATIC, shape, fixtureDef, bodyDef);
@@ -54,6 +54,11 @@ OPT_ORIENTATION_LANDSCAPE       <- 0x1007;
 OPT_ORIENTATION_UNSPECIFIED     <- 0x1008;
 OPT_ORIENTATION_LANDSCAPE_LEFT  <- 0x1009;
 OPT_ORIENTATION_LANDSCAPE_RIGHT <- 0x1010;
+OPT_ENABLE_PREMULTIPLIED_ALPHA  <- 0x1011;
+OPT_DISABLE_PREMULTIPLIED_ALPHA <- 0x1012;
+OPT_ENABLE_MIPMAP               <- 0x1013;
+OPT_AUTO_MIPMAP                 <- 0x1014;
+OPT_DISABLE_MIPMAP              <- 0x1015;
 
 MODE_PRIVATE                    <- 0x0000;
 MODE_WORLD_READABLE             <- 0x0001;
@@ -218,6 +223,18 @@ AUDIO_CHANNEL_STOPPED   <- 1;
 AUDIO_CHANNEL_PAUSED    <- 2;
 AUDIO_CHANNEL_PLAYING   <- 3;
 
+AUDIO_RESAMPLE_LINEAR    <- 0;
+AUDIO_RESAMPLE_POLYPHASE <- 1;
+
+AUDIO_VOICE_INVALID  <- -1;
+AUDIO_STEAL_OLDEST   <- 0;
+AUDIO_STEAL_QUIETEST <- 1;
+AUDIO_STEAL_NONE     <- 2;
+
+MIPMAP_NONE   <- 0;
+MIPMAP_ALWAYS <- 1;
+MIPMAP_AUTO   <- 2;
+
 CONTROL_UP     <- 0;
 CONTROL_DOWN   <- 1;
 CONTROL_LEFT   <- 2;
@@ -1133,6 +1150,14 @@ class emo.AudioChannel {
         }
         return manager.load(id, file);
     }
+    function loadStream(file) {
+        local runtime = emo.Runtime();
+        if (runtime.os() == OS_ANDROID) {
+            file = ANDROID_SOUNDS_DIR + file;
+        }
+        return manager.loadStream(id, file);
+    }
+    function getStreamStats() { return manager.getStreamStats(id); }
     function play(reset = false)  {
         if (reset) {
             return manager.play(id);
@@ -1166,6 +1191,64 @@ function emo::Audio::createChannel(id) {
     return emo.AudioChannel(id, this);
 }
 
+function emo::Audio::preload(group, files, workers = null) {
+    local runtime = emo.Runtime();
+    local names = [];
+    foreach (file in files) {
+        if (runtime.os() == OS_ANDROID) {
+            file = ANDROID_SOUNDS_DIR + file;
+        }
+        names.append(file);
+    }
+    if (workers == null) {
+        return preloadSamples(group, names);
+    }
+    return preloadSamples(group, names, workers);
+}
+
+function emo::Audio::playSound(file, category = "", priority = 0, volume = 1.0, loop = false) {
+    local runtime = emo.Runtime();
+    if (runtime.os() == OS_ANDROID) {
+        file = ANDROID_SOUNDS_DIR + file;
+    }
+    return playVoice(file, category, priority, volume, loop);
+}
+
+class emo.Statement {
+
+    id        = null;
+    manager   = null;
+
+    function constructor(_id, _manager) {
+        id = _id;
+        manager = _manager;
+    }
+
+    function bind(...) {
+        if (vargv.len() == 1) {
+            return manager.bind(id, vargv[0]);
+        }
+        return manager.bind(id, vargv[0], vargv[1]);
+    }
+    function step() { return manager.step(id); }
+    function fetch(count) { return manager.fetch(id, count); }
+    function getColumns() { return manager.getColumns(id); }
+    function reset() { return manager.resetStatement(id); }
+    function finalize() { return manager.finalizeStatement(id); }
+}
+
+function emo::Database::prepare(sql, params = null) {
+    local id = prepareStatement(sql);
+    if (id < 0) return null;
+
+    local stmt = emo.Statement(id, this);
+    if (params != null && stmt.bind(params) != EMO_NO_ERROR) {
+        stmt.finalize();
+        return null;
+    }
+    return stmt;
+}
+
 class emo.Sprite {
 
     name   = null;
@@ -1194,6 +1277,18 @@ class emo.Sprite {
         return rawname;
     }
 
+    function setPackable(packable = true) {
+        return stage.setPackable(id, packable);
+    }
+
+    function getTextureSize() {
+        return stage.getTextureSize(id);
+    }
+
+    function setMipmap(mode = MIPMAP_ALWAYS) {
+        return stage.setMipmap(id, mode);
+    }
+
     function load(x = null, y = null, width = null, height = null) {
         local status = EMO_NO_ERROR;
         if (!loaded) {
@@ -1371,6 +1466,23 @@ class emo.FontSprite extends emo.Sprite {
     }
 }
 
+class emo.GlyphSprite extends emo.Sprite {
+    text = null;
+    function constructor(_text, _fontsize = null, _fontface = null, _isBold = false, _isItalic = false) {
+        text = _text.tostring();
+        id = stage.createGlyphSprite(text, _fontsize, _fontface, _isBold, _isItalic);
+    }
+    function setText(_text) {
+        _text = _text.tostring();
+        if (_text == text) return EMO_NO_ERROR;
+        text = _text;
+        return stage.setText(id, text);
+    }
+    function getText() {
+        return text;
+    }
+}
+
 class emo.SpriteSheet extends emo.Sprite {
 
     function constructor(rawname, frameWidth = 1, frameHeight = 1, border = 0, margin = 0, frameIndex = 0) {
@@ -1912,6 +2024,10 @@ class emo.Snapshot extends emo.Sprite {
     function stop() {
         return stage.stopSnapshot(id);
     }
+    function capture(fileName, captureName = null) {
+        if (captureName == null) captureName = fileName;
+        return stage.captureSnapshot(id, fileName, captureName);
+    }
 }
 
 function emo::_onStopOffScreen(dt) {
@@ -2052,6 +2168,43 @@ function emo::Stage::getCenterY() {
     return getWindowHeight() * 0.5;
 }
 
+function emo::Stage::preloadScene(group, manifest, workers = null) {
+    local assets = [];
+    local sounds = [];
+    foreach (name in manifest) {
+        if (name.len() > 4 && name.slice(-4) == ".wav") {
+            sounds.append(name);
+        } else {
+            assets.append(name);
+        }
+    }
+    if (sounds.len() > 0) {
+        emo.Audio().preload(group, sounds, workers);
+    }
+    if (workers == null) {
+        return preload(group, assets);
+    }
+    return preload(group, assets, workers);
+}
+
+function emo::Stage::getSceneProgress(group) {
+    local progress = getPreloadProgress(group);
+    if (progress == null) return null;
+    local audio = emo.Audio().getPreloadProgress(group);
+    if (audio != null) {
+        progress.total  += audio.total;
+        progress.loaded += audio.loaded;
+        progress.failed += audio.failed;
+        progress.done = progress.done && audio.done;
+    }
+    return progress;
+}
+
+function emo::Stage::unloadScene(group) {
+    emo.Audio().unloadSamples(group);
+    return unloadPreload(group);
+}
+
 function emo::_onLoad() { 
     if (emo.rawin("onLoad")) {
         emo.onLoad();
@@ -2198,6 +2351,34 @@ function emo::_onNetCallback(...) {
     }
 }
 
+function emo::_onDatabaseCallback(name, rows, code, message) {
+    local err   = emo.Error();
+    err.code    = code;
+    err.message = message;
+
+    if (emo.rawin("onDatabaseCallback")) {
+        emo.onDatabaseCallback(name, rows, err);
+    }
+    if (EMO_RUNTIME_DELEGATE != null &&
+             EMO_RUNTIME_DELEGATE.rawin("onDatabaseCallback")) {
+        EMO_RUNTIME_DELEGATE.onDatabaseCallback(name, rows, err);
+    }
+}
+
+function emo::_onCaptureCallback(name, path, code, message) {
+    local err   = emo.Error();
+    err.code    = code;
+    err.message = message;
+
+    if (emo.rawin("onCapture")) {
+        emo.onCapture(name, path, err);
+    }
+    if (EMO_RUNTIME_DELEGATE != null &&
+             EMO_RUNTIME_DELEGATE.rawin("onCapture")) {
+        EMO_RUNTIME_DELEGATE.onCapture(name, path, err);
+    }
+}
+
 function emo::_onFps(fps) {
     if (emo.rawin("onFps")) {
         emo.onFps(fps);
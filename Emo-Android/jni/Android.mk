@@ -30,6 +30,9 @@ LOCAL_ARM_MODE  := arm
 LOCAL_SRC_FILES := native_app_glue.c main.cpp $(EMO_SRC_FILES) $(SQUIRREL_SRC_FILES) $(LIBPNG_SRC_FILES) $(SQLITE_SRC_FILES) $(BOX2D_SRC_FILES)
 LOCAL_LDLIBS    := -llog -landroid -lEGL -lGLESv1_CM -lOpenSLES -lz
 LOCAL_C_INCLUDES += $(LOCAL_PATH) $(LOCAL_PATH)/squirrel/include $(LOCAL_PATH)/libpng $(LOCAL_PATH)/sqlite $(LOCAL_PATH)/emo $(LOCAL_PATH)/Box2D $(LOCAL_PATH)/rapidxml
-LOCAL_CFLAGS    := $(SQUIRREL_CFLAGS) $(SQLITE_CFLAGS)
+LOCAL_CFLAGS    := $(SQUIRREL_CFLAGS) $(SQLITE_CFLAGS) $(BOX2D_CFLAGS) $(EMO_CFLAGS)
+LOCAL_STATIC_LIBRARIES := cpufeatures
 
 include $(BUILD_SHARED_LIBRARY)
+
+$(call import-module,android/cpufeatures)
@@ -1,2 +1,3 @@
 APP_PLATFORM := android-9
 APP_STL := stlport_static
+APP_ABI := armeabi armeabi-v7a
@@ -11,6 +11,7 @@ Box2D/Common/b2BlockAllocator.cpp \
 Box2D/Common/b2Math.cpp \
 Box2D/Common/b2Settings.cpp \
 Box2D/Common/b2StackAllocator.cpp \
+Box2D/Common/b2Timer.cpp \
 Box2D/Dynamics/b2Body.cpp \
 Box2D/Dynamics/b2ContactManager.cpp \
 Box2D/Dynamics/b2Fixture.cpp \
@@ -34,4 +35,10 @@ Box2D/Dynamics/Joints/b2PulleyJoint.cpp \
 Box2D/Dynamics/Joints/b2RevoluteJoint.cpp \
 Box2D/Dynamics/Joints/b2WeldJoint.cpp
 
+# step profiler (b2World::GetProfile), build with EMO_PROFILE=1 to compile it in
+BOX2D_CFLAGS :=
+ifeq ($(EMO_PROFILE),1)
+BOX2D_CFLAGS += -DB2_PROFILE
+endif
+
 LOCAL_C_INCLUDES += $(LOCAL_PATH) $(LOCAL_PATH)/Box2D
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Math.h>
 #include <cstdlib>
 #include <climits>
 #include <cstring>
@@ -59,6 +60,10 @@ b2BlockAllocator::b2BlockAllocator()
 
 	m_chunkSpace = b2_chunkArrayIncrement;
 	m_chunkCount = 0;
+	m_chunkSize = b2_chunkSize;
+	m_blockCount = 0;
+	m_blockBytes = 0;
+	m_maxBlockBytes = 0;
 	m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
@@ -105,47 +110,87 @@ void* b2BlockAllocator::Allocate(int32 size)
 	int32 index = s_blockSizeLookup[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
-	if (m_freeLists[index])
+	if (m_freeLists[index] == NULL)
 	{
-		b2Block* block = m_freeLists[index];
-		m_freeLists[index] = block->next;
-		return block;
+		AllocateChunk(index);
 	}
-	else
+
+	b2Block* block = m_freeLists[index];
+	m_freeLists[index] = block->next;
+
+	++m_blockCount;
+	m_blockBytes += s_blockSizes[index];
+	m_maxBlockBytes = b2Max(m_maxBlockBytes, m_blockBytes);
+	return block;
+}
+
+void b2BlockAllocator::Reserve(int32 size, int32 count)
+{
+	if (size == 0 || count <= 0)
 	{
-		if (m_chunkCount == m_chunkSpace)
-		{
-			b2Chunk* oldChunks = m_chunks;
-			m_chunkSpace += b2_chunkArrayIncrement;
-			m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
-			memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
-			memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
-			b2Free(oldChunks);
-		}
+		return;
+	}
+
+	b2Assert(0 < size && size <= b2_maxBlockSize);
+
+	int32 index = s_blockSizeLookup[size];
+	b2Assert(0 <= index && index < b2_blockSizes);
 
-		b2Chunk* chunk = m_chunks + m_chunkCount;
-		chunk->blocks = (b2Block*)b2Alloc(b2_chunkSize);
+	int32 freeCount = 0;
+	for (b2Block* block = m_freeLists[index]; block && freeCount < count; block = block->next)
+	{
+		++freeCount;
+	}
+
+	int32 blockCount = m_chunkSize / s_blockSizes[index];
+	while (freeCount < count)
+	{
+		AllocateChunk(index);
+		freeCount += blockCount;
+	}
+}
+
+b2Chunk* b2BlockAllocator::AllocateChunk(int32 index)
+{
+	if (m_chunkCount == m_chunkSpace)
+	{
+		b2Chunk* oldChunks = m_chunks;
+		m_chunkSpace += b2_chunkArrayIncrement;
+		m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
+		memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
+		memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
+		b2Free(oldChunks);
+	}
+
+	b2Chunk* chunk = m_chunks + m_chunkCount;
+	chunk->blocks = (b2Block*)b2Alloc(m_chunkSize);
 #if defined(_DEBUG)
-		memset(chunk->blocks, 0xcd, b2_chunkSize);
+	memset(chunk->blocks, 0xcd, m_chunkSize);
 #endif
-		int32 blockSize = s_blockSizes[index];
-		chunk->blockSize = blockSize;
-		int32 blockCount = b2_chunkSize / blockSize;
-		b2Assert(blockCount * blockSize <= b2_chunkSize);
-		for (int32 i = 0; i < blockCount - 1; ++i)
-		{
-			b2Block* block = (b2Block*)((int8*)chunk->blocks + blockSize * i);
-			b2Block* next = (b2Block*)((int8*)chunk->blocks + blockSize * (i + 1));
-			block->next = next;
-		}
-		b2Block* last = (b2Block*)((int8*)chunk->blocks + blockSize * (blockCount - 1));
-		last->next = NULL;
+	chunk->blockSize = s_blockSizes[index];
+	LinkChunk(chunk);
 
-		m_freeLists[index] = chunk->blocks->next;
-		++m_chunkCount;
+	++m_chunkCount;
 
-		return chunk->blocks;
+	return chunk;
+}
+
+// Link the blocks of the chunk and push them in front of the free list.
+void b2BlockAllocator::LinkChunk(b2Chunk* chunk)
+{
+	int32 blockSize = chunk->blockSize;
+	int32 index = s_blockSizeLookup[blockSize];
+	int32 blockCount = m_chunkSize / blockSize;
+	b2Assert(blockCount * blockSize <= m_chunkSize);
+	for (int32 i = 0; i < blockCount - 1; ++i)
+	{
+		b2Block* block = (b2Block*)((int8*)chunk->blocks + blockSize * i);
+		b2Block* next = (b2Block*)((int8*)chunk->blocks + blockSize * (i + 1));
+		block->next = next;
 	}
+	b2Block* last = (b2Block*)((int8*)chunk->blocks + blockSize * (blockCount - 1));
+	last->next = m_freeLists[index];
+	m_freeLists[index] = chunk->blocks;
 }
 
 void b2BlockAllocator::Free(void* p, int32 size)
@@ -170,11 +215,11 @@ void b2BlockAllocator::Free(void* p, int32 size)
 		if (chunk->blockSize != blockSize)
 		{
 			b2Assert(	(int8*)p + blockSize <= (int8*)chunk->blocks ||
-						(int8*)chunk->blocks + b2_chunkSize <= (int8*)p);
+						(int8*)chunk->blocks + m_chunkSize <= (int8*)p);
 		}
 		else
 		{
-			if ((int8*)chunk->blocks <= (int8*)p && (int8*)p + blockSize <= (int8*)chunk->blocks + b2_chunkSize)
+			if ((int8*)chunk->blocks <= (int8*)p && (int8*)p + blockSize <= (int8*)chunk->blocks + m_chunkSize)
 			{
 				found = true;
 			}
@@ -189,6 +234,9 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	b2Block* block = (b2Block*)p;
 	block->next = m_freeLists[index];
 	m_freeLists[index] = block;
+
+	--m_blockCount;
+	m_blockBytes -= s_blockSizes[index];
 }
 
 void b2BlockAllocator::Clear()
@@ -202,4 +250,59 @@ void b2BlockAllocator::Clear()
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+
+	m_blockCount = 0;
+	m_blockBytes = 0;
+}
+
+bool b2BlockAllocator::Recycle()
+{
+	// Relinking a block that is still in use would hand it out twice,
+	// so this is checked in release builds as well.
+	b2Assert(m_blockCount == 0);
+	if (m_blockCount != 0)
+	{
+		return false;
+	}
+
+	memset(m_freeLists, 0, sizeof(m_freeLists));
+
+	// Link in reverse so the first chunk ends up at the head of its free list.
+	for (int32 i = m_chunkCount - 1; i >= 0; --i)
+	{
+		LinkChunk(m_chunks + i);
+	}
+	return true;
+}
+
+void b2BlockAllocator::SetChunkSize(int32 chunkSize)
+{
+	b2Assert(m_chunkCount == 0);
+	b2Assert(chunkSize >= b2_maxBlockSize);
+	m_chunkSize = chunkSize;
+}
+
+int32 b2BlockAllocator::GetChunkSize() const
+{
+	return m_chunkSize;
+}
+
+int32 b2BlockAllocator::GetChunkCount() const
+{
+	return m_chunkCount;
+}
+
+int32 b2BlockAllocator::GetBlockCount() const
+{
+	return m_blockCount;
+}
+
+int32 b2BlockAllocator::GetBlockBytes() const
+{
+	return m_blockBytes;
+}
+
+int32 b2BlockAllocator::GetMaxBlockBytes() const
+{
+	return m_maxBlockBytes;
 }
@@ -21,7 +21,7 @@
 
 #include <Box2D/Common/b2Settings.h>
 
-const int32 b2_chunkSize = 4096;
+const int32 b2_chunkSize = 4096;	// default chunk size
 const int32 b2_maxBlockSize = 640;
 const int32 b2_blockSizes = 14;
 const int32 b2_chunkArrayIncrement = 128;
@@ -41,13 +41,40 @@ public:
 	void* Allocate(int32 size);
 	void Free(void* p, int32 size);
 
+	/// Make sure at least count blocks of the given size are on the free list,
+	/// so a following bulk load does not allocate chunk by chunk.
+	void Reserve(int32 size, int32 count);
+
 	void Clear();
 
+	/// Relink all chunks into fresh free lists while keeping their memory.
+	/// Every block must have been freed, otherwise nothing is relinked
+	/// and false is returned.
+	bool Recycle();
+
+	/// Set the chunk size. This can only be called before the first allocation.
+	void SetChunkSize(int32 chunkSize);
+	int32 GetChunkSize() const;
+	int32 GetChunkCount() const;
+
+	/// Number and bytes of blocks currently in use.
+	int32 GetBlockCount() const;
+	int32 GetBlockBytes() const;
+	int32 GetMaxBlockBytes() const;
+
 private:
 
+	b2Chunk* AllocateChunk(int32 index);
+	void LinkChunk(b2Chunk* chunk);
+
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
+	int32 m_chunkSize;
+
+	int32 m_blockCount;
+	int32 m_blockBytes;
+	int32 m_maxBlockBytes;
 
 	b2Block* m_freeLists[b2_blockSizes];
 
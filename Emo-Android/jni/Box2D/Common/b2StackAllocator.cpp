@@ -21,9 +21,12 @@
 
 b2StackAllocator::b2StackAllocator()
 {
+	m_size = b2_stackSize;
+	m_data = (char*)b2Alloc(m_size);
 	m_index = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_overflowCount = 0;
 	m_entryCount = 0;
 }
 
@@ -31,6 +34,27 @@ b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
 	b2Assert(m_entryCount == 0);
+	b2Free(m_data);
+}
+
+void b2StackAllocator::SetSize(int32 size)
+{
+	b2Assert(m_entryCount == 0);
+	b2Assert(size > 0);
+
+	if (size == m_size)
+	{
+		return;
+	}
+
+	b2Free(m_data);
+	m_size = size;
+	m_data = (char*)b2Alloc(m_size);
+}
+
+int32 b2StackAllocator::GetSize() const
+{
+	return m_size;
 }
 
 void* b2StackAllocator::Allocate(int32 size)
@@ -39,10 +63,11 @@ void* b2StackAllocator::Allocate(int32 size)
 
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	if (m_index + size > m_size)
 	{
 		entry->data = (char*)b2Alloc(size);
 		entry->usedMalloc = true;
+		++m_overflowCount;
 	}
 	else
 	{
@@ -81,3 +106,8 @@ int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
 }
+
+int32 b2StackAllocator::GetOverflowCount() const
+{
+	return m_overflowCount;
+}
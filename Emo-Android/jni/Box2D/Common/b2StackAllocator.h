@@ -21,7 +21,7 @@
 
 #include <Box2D/Common/b2Settings.h>
 
-const int32 b2_stackSize = 100 * 1024;	// 100k
+const int32 b2_stackSize = 100 * 1024;	// default size, 100k
 const int32 b2_maxStackEntries = 32;
 
 struct b2StackEntry
@@ -43,15 +43,25 @@ public:
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	/// Resize the stack. This must not be called during a time step.
+	void SetSize(int32 size);
+	int32 GetSize() const;
+
+	/// High water mark of the allocated bytes, including overflows.
 	int32 GetMaxAllocation() const;
 
+	/// Number of allocations that did not fit the stack and fell back to b2Alloc.
+	int32 GetOverflowCount() const;
+
 private:
 
-	char m_data[b2_stackSize];
+	char* m_data;
+	int32 m_size;
 	int32 m_index;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_overflowCount;
 
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
@@ -0,0 +1,40 @@
+/*
+* Copyright (c) 2011 emo-framework project
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2Timer.h>
+#include <time.h>
+
+b2Timer::b2Timer()
+{
+	Reset();
+}
+
+void b2Timer::Reset()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	m_start_sec = t.tv_sec;
+	m_start_nsec = t.tv_nsec;
+}
+
+float32 b2Timer::GetMilliseconds() const
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (t.tv_sec - m_start_sec) * 1000.0f + (t.tv_nsec - m_start_nsec) * 0.000001f;
+}
@@ -0,0 +1,54 @@
+/*
+* Copyright (c) 2011 emo-framework project
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TIMER_H
+#define B2_TIMER_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// Timer for profiling. This has platform specific code and may
+/// not work on every platform.
+class b2Timer
+{
+public:
+
+	/// Constructor
+	b2Timer();
+
+	/// Reset the timer.
+	void Reset();
+
+	/// Get the time since construction or the last reset.
+	float32 GetMilliseconds() const;
+
+private:
+	int32 m_start_sec;
+	int32 m_start_nsec;
+};
+
+#ifdef B2_PROFILE
+#define b2ProfileBegin(timer)		b2Timer timer
+#define b2ProfileEnd(timer, value)	value += timer.GetMilliseconds()
+#define b2ProfileCount(value)		++value
+#else
+#define b2ProfileBegin(timer)
+#define b2ProfileEnd(timer, value)
+#define b2ProfileCount(value)
+#endif
+
+#endif
@@ -73,6 +73,12 @@ public:
 	b2Vec2 GetReactionForce(float32 inv_dt) const;
 	float32 GetReactionTorque(float32 inv_dt) const;
 
+	/// Get the local anchor point relative to bodyA's origin.
+	const b2Vec2& GetLocalAnchorA() const { return m_localAnchor1; }
+
+	/// Get the local anchor point relative to bodyB's origin.
+	const b2Vec2& GetLocalAnchorB() const { return m_localAnchor2; }
+
 	/// Set/get the natural length.
 	/// Manipulating the length can lead to non-physical behavior when the frequency is zero.
 	void SetLength(float32 length);
@@ -257,3 +257,21 @@ float32 b2GearJoint::GetRatio() const
 {
 	return m_ratio;
 }
+
+b2Joint* b2GearJoint::GetJoint1() const
+{
+	if (m_revolute1)
+	{
+		return m_revolute1;
+	}
+	return m_prismatic1;
+}
+
+b2Joint* b2GearJoint::GetJoint2() const
+{
+	if (m_revolute2)
+	{
+		return m_revolute2;
+	}
+	return m_prismatic2;
+}
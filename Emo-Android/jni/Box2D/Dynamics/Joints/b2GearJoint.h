@@ -66,6 +66,12 @@ public:
 	b2Vec2 GetReactionForce(float32 inv_dt) const;
 	float32 GetReactionTorque(float32 inv_dt) const;
 
+	/// Get the first revolute/prismatic joint attached to this joint.
+	b2Joint* GetJoint1() const;
+
+	/// Get the second revolute/prismatic joint attached to this joint.
+	b2Joint* GetJoint2() const;
+
 	/// Set/Get the gear ratio.
 	void SetRatio(float32 ratio);
 	float32 GetRatio() const;
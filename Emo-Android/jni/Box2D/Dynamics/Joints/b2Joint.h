@@ -140,6 +140,9 @@ public:
 	/// Short-cut function to determine if either body is inactive.
 	bool IsActive() const;
 
+	/// Get collide connected.
+	bool GetCollideConnected() const { return m_collideConnected; }
+
 protected:
 	friend class b2World;
 	friend class b2Body;
@@ -88,6 +88,15 @@ public:
 	b2Vec2 GetReactionForce(float32 inv_dt) const;
 	float32 GetReactionTorque(float32 inv_dt) const;
 
+	/// Get the local anchor point relative to bodyA's origin.
+	const b2Vec2& GetLocalAnchorA() const { return m_localAnchor1; }
+
+	/// Get the local anchor point relative to bodyB's origin.
+	const b2Vec2& GetLocalAnchorB() const { return m_localAnchor2; }
+
+	/// Get the translation axis in bodyA's frame.
+	const b2Vec2& GetLocalAxisA() const { return m_localXAxis1; }
+
 	/// Get the current joint translation, usually in meters.
 	float32 GetJointTranslation() const;
 
@@ -167,4 +176,9 @@ inline float32 b2LineJoint::GetMotorSpeed() const
 	return m_motorSpeed;
 }
 
+inline float32 b2LineJoint::GetMaxMotorForce() const
+{
+	return m_maxMotorForce;
+}
+
 #endif
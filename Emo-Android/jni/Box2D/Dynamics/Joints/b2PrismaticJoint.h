@@ -93,6 +93,18 @@ public:
 	b2Vec2 GetReactionForce(float32 inv_dt) const;
 	float32 GetReactionTorque(float32 inv_dt) const;
 
+	/// Get the local anchor point relative to bodyA's origin.
+	const b2Vec2& GetLocalAnchorA() const { return m_localAnchor1; }
+
+	/// Get the local anchor point relative to bodyB's origin.
+	const b2Vec2& GetLocalAnchorB() const { return m_localAnchor2; }
+
+	/// Get the translation axis in bodyA's frame.
+	const b2Vec2& GetLocalAxisA() const { return m_localXAxis1; }
+
+	/// Get the reference angle.
+	float32 GetReferenceAngle() const { return m_refAngle; }
+
 	/// Get the current joint translation, usually in meters.
 	float32 GetJointTranslation() const;
 
@@ -129,6 +141,9 @@ public:
 	/// Set the maximum motor force, usually in N.
 	void SetMaxMotorForce(float32 force);
 
+	/// Get the maximum motor force, usually in N.
+	float32 GetMaxMotorForce() const { return m_maxMotorForce; }
+
 	/// Get the current motor force, usually in N.
 	float32 GetMotorForce() const;
 
@@ -92,6 +92,18 @@ public:
 	b2Vec2 GetReactionForce(float32 inv_dt) const;
 	float32 GetReactionTorque(float32 inv_dt) const;
 
+	/// Get the local anchor point relative to bodyA's origin.
+	const b2Vec2& GetLocalAnchorA() const { return m_localAnchor1; }
+
+	/// Get the local anchor point relative to bodyB's origin.
+	const b2Vec2& GetLocalAnchorB() const { return m_localAnchor2; }
+
+	/// Get the maximum length of the segment attached to body1.
+	float32 GetMaxLength1() const { return m_maxLength1; }
+
+	/// Get the maximum length of the segment attached to body2.
+	float32 GetMaxLength2() const { return m_maxLength2; }
+
 	/// Get the first ground anchor.
 	b2Vec2 GetGroundAnchorA() const;
 
@@ -107,6 +119,9 @@ public:
 	/// Get the pulley ratio.
 	float32 GetRatio() const;
 
+	/// Get the rope constant: lengthA + ratio * lengthB of the rest lengths.
+	float32 GetConstant() const { return m_constant; }
+
 protected:
 
 	friend class b2Joint;
@@ -96,6 +96,15 @@ public:
 	b2Vec2 GetReactionForce(float32 inv_dt) const;
 	float32 GetReactionTorque(float32 inv_dt) const;
 
+	/// Get the local anchor point relative to bodyA's origin.
+	const b2Vec2& GetLocalAnchorA() const { return m_localAnchor1; }
+
+	/// Get the local anchor point relative to bodyB's origin.
+	const b2Vec2& GetLocalAnchorB() const { return m_localAnchor2; }
+
+	/// Get the reference angle.
+	float32 GetReferenceAngle() const { return m_referenceAngle; }
+
 	/// Get the current joint angle in radians.
 	float32 GetJointAngle() const;
 
@@ -132,6 +141,9 @@ public:
 	/// Set the maximum motor torque, usually in N-m.
 	void SetMaxMotorTorque(float32 torque);
 
+	/// Get the maximum motor torque, usually in N-m.
+	float32 GetMaxMotorTorque() const { return m_maxMotorTorque; }
+
 	/// Get the current motor torque, usually in N-m.
 	float32 GetMotorTorque() const;
 
@@ -32,4 +32,23 @@ struct b2TimeStep
 	bool warmStarting;
 };
 
+/// Profiling data of the last time step. Times are in milliseconds.
+/// Contact listener time is also included in the phase that dispatched it.
+/// All values stay zero unless Box2D is built with B2_PROFILE.
+struct b2Profile
+{
+	float32 step;
+	float32 collide;
+	float32 findNewContacts;
+	float32 solve;
+	float32 solveTOI;
+	float32 listener;
+	int32 bodyCount;
+	int32 awakeBodyCount;
+	int32 contactCount;
+	int32 islandCount;
+	int32 toiCount;
+	int32 proxyCount;
+};
+
 #endif
@@ -29,7 +29,12 @@
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
+#include <Box2D/Common/b2Timer.h>
 #include <new>
+#include <string.h>
+
+extern b2ContactFilter b2_defaultFilter;
+extern b2ContactListener b2_defaultListener;
 
 b2World::b2World(const b2Vec2& gravity, bool doSleep)
 {
@@ -53,6 +58,12 @@ b2World::b2World(const b2Vec2& gravity, bool doSleep)
 	m_inv_dt0 = 0.0f;
 
 	m_contactManager.m_allocator = &m_blockAllocator;
+
+	memset(&m_profile, 0, sizeof(b2Profile));
+#ifdef B2_PROFILE
+	m_profileListener.m_listener = m_contactManager.m_contactListener;
+	m_contactManager.m_contactListener = &m_profileListener;
+#endif
 }
 
 b2World::~b2World()
@@ -71,7 +82,11 @@ void b2World::SetContactFilter(b2ContactFilter* filter)
 
 void b2World::SetContactListener(b2ContactListener* listener)
 {
+#ifdef B2_PROFILE
+	m_profileListener.m_listener = listener;
+#else
 	m_contactManager.m_contactListener = listener;
+#endif
 }
 
 void b2World::SetDebugDraw(b2DebugDraw* debugDraw)
@@ -79,6 +94,89 @@ void b2World::SetDebugDraw(b2DebugDraw* debugDraw)
 	m_debugDraw = debugDraw;
 }
 
+void b2World::SetStackSize(int32 size)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_stackAllocator.SetSize(size);
+}
+
+void b2World::SetChunkSize(int32 size)
+{
+	m_blockAllocator.SetChunkSize(size);
+}
+
+b2AllocatorStats b2World::GetAllocatorStats() const
+{
+	b2AllocatorStats stats;
+	stats.chunkSize = m_blockAllocator.GetChunkSize();
+	stats.chunkCount = m_blockAllocator.GetChunkCount();
+	stats.blockCount = m_blockAllocator.GetBlockCount();
+	stats.blockBytes = m_blockAllocator.GetBlockBytes();
+	stats.maxBlockBytes = m_blockAllocator.GetMaxBlockBytes();
+	stats.stackSize = m_stackAllocator.GetSize();
+	stats.maxStackAllocation = m_stackAllocator.GetMaxAllocation();
+	stats.stackOverflowCount = m_stackAllocator.GetOverflowCount();
+	return stats;
+}
+
+void b2World::SetAllowSleeping(bool flag)
+{
+	m_allowSleep = flag;
+	if (flag == false)
+	{
+		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		{
+			b->SetAwake(true);
+		}
+	}
+}
+
+bool b2World::Clear()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return false;
+	}
+
+	// Detach the user callbacks first. Destroying the bodies below ends their
+	// contacts, and the listener may already be gone when the world is released.
+	m_destructionListener = NULL;
+	m_contactManager.m_contactFilter = &b2_defaultFilter;
+	SetContactListener(&b2_defaultListener);
+	m_debugDraw = NULL;
+
+	while (m_jointList)
+	{
+		DestroyJoint(m_jointList);
+	}
+
+	while (m_bodyList)
+	{
+		DestroyBody(m_bodyList);
+	}
+
+	// All blocks are free now. Relink them chunk by chunk so the next
+	// level allocates from contiguous memory instead of a scattered free list.
+	if (m_blockAllocator.Recycle() == false)
+	{
+		return false;
+	}
+
+	m_warmStarting = true;
+	m_continuousPhysics = true;
+	m_flags = e_clearForces;
+	m_inv_dt0 = 0.0f;
+
+	memset(&m_profile, 0, sizeof(b2Profile));
+	return true;
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -337,6 +435,8 @@ void b2World::DestroyJoint(b2Joint* j)
 // Find islands, integrate and solve constraints, solve position constraints
 void b2World::Solve(const b2TimeStep& step)
 {
+	b2ProfileBegin(timer);
+
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
@@ -476,6 +576,7 @@ void b2World::Solve(const b2TimeStep& step)
 		}
 
 		island.Solve(step, m_gravity, m_allowSleep);
+		b2ProfileCount(m_profile.islandCount);
 
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -509,8 +610,12 @@ void b2World::Solve(const b2TimeStep& step)
 		b->SynchronizeFixtures();
 	}
 
+	b2ProfileEnd(timer, m_profile.solve);
+
 	// Look for new contacts.
+	b2ProfileBegin(findTimer);
 	m_contactManager.FindNewContacts();
+	b2ProfileEnd(findTimer, m_profile.findNewContacts);
 }
 
 // Advance a dynamic body to its first time of contact
@@ -620,6 +725,8 @@ void b2World::SolveTOI(b2Body* body)
 		return;
 	}
 
+	b2ProfileCount(m_profile.toiCount);
+
 	b2Sweep backup = body->m_sweep;
 	body->Advance(toi);
 	toiContact->Update(m_contactManager.m_contactListener);
@@ -777,10 +884,18 @@ void b2World::SolveTOI()
 
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
+#ifdef B2_PROFILE
+	b2Timer stepTimer;
+	memset(&m_profile, 0, sizeof(b2Profile));
+	m_profileListener.m_time = 0.0f;
+#endif
+
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_flags & e_newFixture)
 	{
+		b2ProfileBegin(timer);
 		m_contactManager.FindNewContacts();
+		b2ProfileEnd(timer, m_profile.findNewContacts);
 		m_flags &= ~e_newFixture;
 	}
 
@@ -804,7 +919,11 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.warmStarting = m_warmStarting;
 
 	// Update contacts. This is where some contacts are destroyed.
-	m_contactManager.Collide();
+	{
+		b2ProfileBegin(timer);
+		m_contactManager.Collide();
+		b2ProfileEnd(timer, m_profile.collide);
+	}
 
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	if (step.dt > 0.0f)
@@ -815,7 +934,9 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	// Handle TOI events.
 	if (m_continuousPhysics && step.dt > 0.0f)
 	{
+		b2ProfileBegin(timer);
 		SolveTOI();
+		b2ProfileEnd(timer, m_profile.solveTOI);
 	}
 
 	if (step.dt > 0.0f)
@@ -829,6 +950,21 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	}
 
 	m_flags &= ~e_locked;
+
+#ifdef B2_PROFILE
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		if (b->GetType() != b2_staticBody && b->IsAwake())
+		{
+			++m_profile.awakeBodyCount;
+		}
+	}
+	m_profile.bodyCount = m_bodyCount;
+	m_profile.contactCount = m_contactManager.m_contactCount;
+	m_profile.proxyCount = m_contactManager.m_broadPhase.GetProxyCount();
+	m_profile.listener = m_profileListener.m_time;
+	m_profile.step = stepTimer.GetMilliseconds();
+#endif
 }
 
 void b2World::ClearForces()
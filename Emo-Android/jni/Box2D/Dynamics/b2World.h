@@ -24,11 +24,25 @@
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
 
 struct b2AABB;
 struct b2BodyDef;
 struct b2JointDef;
 struct b2TimeStep;
+
+/// Memory statistics of the world allocators. Sizes are in bytes.
+struct b2AllocatorStats
+{
+	int32 chunkSize;
+	int32 chunkCount;
+	int32 blockCount;
+	int32 blockBytes;
+	int32 maxBlockBytes;
+	int32 stackSize;
+	int32 maxStackAllocation;
+	int32 stackOverflowCount;
+};
 class b2Body;
 class b2Fixture;
 class b2Joint;
@@ -103,6 +117,10 @@ public:
 	/// Call this to draw shapes and other debug draw data.
 	void DrawDebugData();
 
+	/// Get the timings and counters of the last time step.
+	/// These are only recorded when Box2D is built with B2_PROFILE.
+	const b2Profile& GetProfile() const;
+
 	/// Query the world for all fixtures that potentially overlap the
 	/// provided AABB.
 	/// @param callback a user implemented callback class.
@@ -166,6 +184,31 @@ public:
 	/// Get the flag that controls automatic clearing of forces after each time step.
 	bool GetAutoClearForces() const;
 
+	/// Pre-allocate room for count objects of the given size in the world's
+	/// small object allocator. Use this before creating many bodies at once.
+	void ReserveBlocks(int32 size, int32 count);
+
+	/// Set the size of the per step stack allocator. Island data that does not
+	/// fit the stack falls back to b2Alloc. This is locked during callbacks.
+	void SetStackSize(int32 size);
+
+	/// Set the chunk size of the small object allocator.
+	/// This can only be called before anything is created in the world.
+	void SetChunkSize(int32 size);
+
+	/// Get the memory statistics of the world allocators.
+	b2AllocatorStats GetAllocatorStats() const;
+
+	/// Enable/disable sleeping.
+	void SetAllowSleeping(bool flag);
+
+	/// Destroy all bodies and joints and reset the world settings,
+	/// keeping the allocator memory so the world can be used again.
+	/// Returns false if the world is locked or blocks are still in use,
+	/// in which case it must not be reused.
+	/// @warning This function is locked during callbacks.
+	bool Clear();
+
 private:
 
 	// m_flags
@@ -217,8 +260,18 @@ private:
 
 	// This is for debugging the solver.
 	bool m_continuousPhysics;
+
+	b2Profile m_profile;
+#ifdef B2_PROFILE
+	b2ProfileContactListener m_profileListener;
+#endif
 };
 
+inline const b2Profile& b2World::GetProfile() const
+{
+	return m_profile;
+}
+
 inline b2Body* b2World::GetBodyList()
 {
 	return m_bodyList;
@@ -282,4 +335,9 @@ inline bool b2World::GetAutoClearForces() const
 	return (m_flags & e_clearForces) == e_clearForces;
 }
 
+inline void b2World::ReserveBlocks(int32 size, int32 count)
+{
+	m_blockAllocator.Reserve(size, count);
+}
+
 #endif
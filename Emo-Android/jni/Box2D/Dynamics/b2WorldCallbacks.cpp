@@ -18,6 +18,7 @@
 
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Common/b2Timer.h>
 
 // Return true if contact calculations should be performed between these two shapes.
 // If you implement your own collision filter you may want to build from this implementation.
@@ -59,3 +60,55 @@ void b2DebugDraw::ClearFlags(uint32 flags)
 {
 	m_drawFlags &= ~flags;
 }
+
+#ifdef B2_PROFILE
+b2ProfileContactListener::b2ProfileContactListener()
+{
+	m_listener = NULL;
+	m_time = 0.0f;
+}
+
+void b2ProfileContactListener::BeginContact(b2Contact* contact)
+{
+	if (m_listener == NULL)
+	{
+		return;
+	}
+	b2Timer timer;
+	m_listener->BeginContact(contact);
+	m_time += timer.GetMilliseconds();
+}
+
+void b2ProfileContactListener::EndContact(b2Contact* contact)
+{
+	if (m_listener == NULL)
+	{
+		return;
+	}
+	b2Timer timer;
+	m_listener->EndContact(contact);
+	m_time += timer.GetMilliseconds();
+}
+
+void b2ProfileContactListener::PreSolve(b2Contact* contact, const b2Manifold* oldManifold)
+{
+	if (m_listener == NULL)
+	{
+		return;
+	}
+	b2Timer timer;
+	m_listener->PreSolve(contact, oldManifold);
+	m_time += timer.GetMilliseconds();
+}
+
+void b2ProfileContactListener::PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
+{
+	if (m_listener == NULL)
+	{
+		return;
+	}
+	b2Timer timer;
+	m_listener->PostSolve(contact, impulse);
+	m_time += timer.GetMilliseconds();
+}
+#endif
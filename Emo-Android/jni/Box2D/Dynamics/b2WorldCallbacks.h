@@ -118,6 +118,24 @@ public:
 	}
 };
 
+#ifdef B2_PROFILE
+/// Forwards contact events to the user listener and accumulates
+/// the time spent in them. This is used internally by b2World.
+class b2ProfileContactListener : public b2ContactListener
+{
+public:
+	b2ProfileContactListener();
+
+	void BeginContact(b2Contact* contact);
+	void EndContact(b2Contact* contact);
+	void PreSolve(b2Contact* contact, const b2Manifold* oldManifold);
+	void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse);
+
+	b2ContactListener* m_listener;
+	float32 m_time;
+};
+#endif
+
 /// Callback class for AABB queries.
 /// See b2World::Query
 class b2QueryCallback
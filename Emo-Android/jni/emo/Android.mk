@@ -4,16 +4,44 @@ EMO_SRC_FILES :=\
 	emo/Stage.cpp \
 	emo/Drawable.cpp \
 	emo/Drawable_glue.cpp \
+	emo/Drawable_atlas.cpp \
 	emo/Audio.cpp \
+	emo/Audio_mixer.cpp \
+	emo/Audio_kernels.cpp \
+	emo/Audio_stream.cpp \
+	emo/Audio_bank.cpp \
+	emo/Audio_pool.cpp \
+	emo/Audio_metrics.cpp \
 	emo/VmFunc.cpp \
 	emo/Image.cpp \
+	emo/Image_packer.cpp \
+	emo/Image_etc1.cpp \
+	emo/Image_mipmap.cpp \
+	emo/Image_capture.cpp \
+	emo/Image_glyph.cpp \
+	emo/Asset.cpp \
+	emo/Asset_archive.cpp \
+	emo/Asset_preload.cpp \
 	emo/Database.cpp \
+	emo/Database_preference.cpp \
+	emo/Database_executor.cpp \
 	emo/Util.cpp \
 	emo/JavaGlue.cpp \
 	emo/Physics.cpp \
 	emo/Physics_glue.cpp \
 	emo/Physics_util.cpp \
-	emo/Physics_contact.cpp
+	emo/Physics_contact.cpp \
+	emo/Physics_snapshot.cpp \
+	emo/Physics_debugdraw.cpp \
+	emo/Physics_profiler.cpp
+
+# NEON audio and mipmap kernels are selected at runtime on armeabi-v7a
+EMO_CFLAGS :=
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+EMO_SRC_FILES += emo/Audio_kernels_neon.cpp.neon
+EMO_SRC_FILES += emo/Image_mipmap_neon.cpp.neon
+EMO_CFLAGS    += -DEMO_AUDIO_NEON -DEMO_IMAGE_NEON
+endif
 
 LOCAL_C_INCLUDES += $(LOCAL_PATH) $(LOCAL_PATH)/emo
 
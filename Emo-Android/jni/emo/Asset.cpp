@@ -0,0 +1,322 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Asset.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace emo {
+
+    AssetView::AssetView() {
+        this->data      = NULL;
+        this->length    = 0;
+        this->refs      = 0;
+        this->mapBase   = NULL;
+        this->mapLength = 0;
+        this->heap      = NULL;
+#ifdef __ANDROID__
+        this->asset     = NULL;
+#endif
+    }
+
+    AssetView::~AssetView() {
+        if (this->mapBase != NULL) {
+            munmap(this->mapBase, this->mapLength);
+        }
+        if (this->heap != NULL) {
+            free(this->heap);
+        }
+#ifdef __ANDROID__
+        if (this->asset != NULL) {
+            AAsset_close(this->asset);
+        }
+#endif
+    }
+
+    /*
+     * map the region of the file into the view.
+     * the offset is aligned down to the page size.
+     */
+    bool mapAssetView(AssetView* view, int fd, off_t start, size_t length) {
+        if (length == 0) return false;
+
+        off_t pageSize = sysconf(_SC_PAGESIZE);
+        off_t aligned  = start - (start % pageSize);
+        size_t delta   = start - aligned;
+
+        void* base = mmap(NULL, length + delta, PROT_READ, MAP_PRIVATE, fd, aligned);
+        if (base == MAP_FAILED) return false;
+
+        view->mapBase   = base;
+        view->mapLength = length + delta;
+        view->data      = (const unsigned char*)base + delta;
+        view->length    = length;
+        return true;
+    }
+
+#ifdef __ANDROID__
+    AndroidAssetBackend::AndroidAssetBackend(AAssetManager* manager) {
+        this->manager = manager;
+    }
+
+    /*
+     * uncompressed assets are mapped from the package file descriptor.
+     * compressed assets are inflated once by the asset manager.
+     */
+    AssetView* AndroidAssetBackend::load(const std::string& name) {
+        if (this->manager == NULL) return NULL;
+
+        AAsset* asset = AAssetManager_open(this->manager, name.c_str(), AASSET_MODE_BUFFER);
+        if (asset == NULL) return NULL;
+
+        AssetView* view = new AssetView();
+        size_t length = AAsset_getLength(asset);
+
+        off_t start, fdLength;
+        int fd = AAsset_openFileDescriptor(asset, &start, &fdLength);
+        if (fd >= 0) {
+            bool mapped = mapAssetView(view, fd, start, fdLength);
+            close(fd);
+            if (mapped) {
+                AAsset_close(asset);
+                return view;
+            }
+        }
+
+        const void* buffer = AAsset_getBuffer(asset);
+        if (buffer != NULL) {
+            view->asset  = asset;
+            view->data   = (const unsigned char*)buffer;
+            view->length = length;
+            return view;
+        }
+
+        view->heap = (unsigned char*)malloc(length > 0 ? length : 1);
+        if (AAsset_read(asset, view->heap, length) != (int)length) {
+            AAsset_close(asset);
+            delete view;
+            return NULL;
+        }
+        AAsset_close(asset);
+        view->data   = view->heap;
+        view->length = length;
+        return view;
+    }
+#endif
+
+    FileAssetBackend::FileAssetBackend(const std::string& root) {
+        this->root = root;
+    }
+
+    AssetView* FileAssetBackend::load(const std::string& name) {
+        std::string path = this->root.empty() ? name : this->root + "/" + name;
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return NULL;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return NULL;
+        }
+
+        AssetView* view = new AssetView();
+        size_t length = st.st_size;
+        if (mapAssetView(view, fd, 0, length)) {
+            close(fd);
+            return view;
+        }
+
+        view->heap = (unsigned char*)malloc(length > 0 ? length : 1);
+        size_t total = 0;
+        while (total < length) {
+            ssize_t count = read(fd, view->heap + total, length - total);
+            if (count <= 0) break;
+            total += count;
+        }
+        close(fd);
+        if (total != length) {
+            delete view;
+            return NULL;
+        }
+        view->data   = view->heap;
+        view->length = length;
+        return view;
+    }
+
+    AssetStore::AssetStore(AssetBackend* backend) {
+        this->backend = backend;
+        this->archiveView = NULL;
+        this->hits    = 0;
+        this->misses  = 0;
+        pthread_mutex_init(&this->mutex, NULL);
+    }
+
+    /*
+     * the store owns the views, so views still held by callers are
+     * freed as well and must not be used after the store is deleted.
+     * this includes the archive view that stored entries point into.
+     */
+    AssetStore::~AssetStore() {
+        for (ViewMap::iterator it = this->views.begin(); it != this->views.end(); it++) {
+            delete it->second;
+        }
+        this->views.clear();
+        delete this->backend;
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    /*
+     * returns the shared view of the asset, loading it on a miss.
+     * the asset is read without holding the lock, so workers load
+     * different assets in parallel. the caller must release the view.
+     */
+    AssetView* AssetStore::acquire(const std::string& name) {
+        pthread_mutex_lock(&this->mutex);
+        ViewMap::iterator it = this->views.find(name);
+        if (it != this->views.end()) {
+            it->second->refs++;
+            this->hits++;
+            pthread_mutex_unlock(&this->mutex);
+            return it->second;
+        }
+        this->misses++;
+        pthread_mutex_unlock(&this->mutex);
+
+        AssetView* view = this->loadFromArchive(name);
+        if (view == NULL) view = this->backend->load(name);
+        if (view == NULL) return NULL;
+        view->name = name;
+
+        pthread_mutex_lock(&this->mutex);
+        it = this->views.find(name);
+        if (it != this->views.end()) {
+            // loaded by another thread meanwhile
+            delete view;
+            view = it->second;
+        } else {
+            this->views[name] = view;
+        }
+        view->refs++;
+        pthread_mutex_unlock(&this->mutex);
+        return view;
+    }
+
+    /*
+     * map the packed archive. it stays mapped until the store is deleted.
+     */
+    bool AssetStore::openArchive(const std::string& name) {
+        if (this->archiveView != NULL) return false;
+
+        AssetView* view = this->acquire(name);
+        if (view == NULL) return false;
+
+        if (!this->archive.open(view->data, view->length)) {
+            this->release(view);
+            return false;
+        }
+        this->archiveView = view;
+        return true;
+    }
+
+    /*
+     * false if the archive was compressed in the package
+     * and had to be inflated into memory
+     */
+    bool AssetStore::isArchiveMapped() {
+        return this->archiveView != NULL && this->archiveView->mapBase != NULL;
+    }
+
+    /*
+     * stored entries point into the archive mapping,
+     * compressed entries are inflated into their own buffer.
+     */
+    AssetView* AssetStore::loadFromArchive(const std::string& name) {
+        if (!this->archive.isOpen()) return NULL;
+
+        const AssetArchiveEntry* entry = this->archive.find(name.c_str(), name.size());
+        if (entry == NULL) return NULL;
+
+        AssetView* view = new AssetView();
+        if (entry->flags & ASSET_ARCHIVE_COMPRESSED) {
+            view->heap = (unsigned char*)malloc(entry->rawSize > 0 ? entry->rawSize : 1);
+            if (!this->archive.inflate(entry, view->heap)) {
+                delete view;
+                return NULL;
+            }
+            view->data   = view->heap;
+            view->length = entry->rawSize;
+        } else {
+            view->data   = this->archive.getData(entry);
+            view->length = entry->size;
+        }
+        return view;
+    }
+
+    /*
+     * returns the image dimensions stored in the archive index
+     */
+    bool AssetStore::getImageInfo(const std::string& name, int* width, int* height, int* format) {
+        const AssetArchiveEntry* entry = this->archive.find(name.c_str(), name.size());
+        if (entry == NULL || entry->width == 0 || entry->height == 0) return false;
+
+        *width  = entry->width;
+        *height = entry->height;
+        if (format != NULL) *format = entry->format;
+        return true;
+    }
+
+    void AssetStore::release(AssetView* view) {
+        if (view == NULL) return;
+
+        pthread_mutex_lock(&this->mutex);
+        if (--view->refs <= 0) {
+            this->views.erase(view->name);
+            delete view;
+        }
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void AssetStore::getStats(AssetStoreStats* stats) {
+        pthread_mutex_lock(&this->mutex);
+        stats->viewCount   = this->views.size();
+        stats->bytes       = 0;
+        stats->mappedBytes = 0;
+        for (ViewMap::iterator it = this->views.begin(); it != this->views.end(); it++) {
+            stats->bytes += it->second->length;
+            if (it->second->mapBase != NULL) stats->mappedBytes += it->second->length;
+        }
+        stats->hits   = this->hits;
+        stats->misses = this->misses;
+        stats->archiveEntries = this->archive.getEntryCount();
+        pthread_mutex_unlock(&this->mutex);
+    }
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_ASSET_H
+#define EMO_ASSET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <string>
+#include <map>
+#include "Asset_archive.h"
+
+#ifdef __ANDROID__
+#include <android/asset_manager.h>
+#endif
+
+/*
+ * Read-only views of asset contents.
+ * Uncompressed assets are memory mapped from the package file, compressed
+ * assets use the buffer of the asset manager or one bulk read. Views are
+ * reference counted and shared by every caller of the same asset name
+ * while any of them holds it. The host backend maps plain files so the
+ * same code runs on Linux builds. Assets found in the packed archive
+ * are served from its mapping before the backend is asked.
+ * The store owns every view: a caller only borrows a view between
+ * acquire() and release(), and must release it before the store is
+ * deleted. The engine deletes the preloader, which releases the views
+ * of its groups, before the store.
+ */
+namespace emo {
+    class AssetView {
+    public:
+        AssetView();
+        ~AssetView();
+
+        const unsigned char* data;
+        size_t length;
+
+        std::string name;
+        int refs;
+
+        // backing storage, released by the destructor
+        void*  mapBase;
+        size_t mapLength;
+        unsigned char* heap;
+#ifdef __ANDROID__
+        AAsset* asset;
+#endif
+    };
+
+    class AssetBackend {
+    public:
+        virtual ~AssetBackend() {}
+        virtual AssetView* load(const std::string& name) = 0;
+    };
+
+#ifdef __ANDROID__
+    class AndroidAssetBackend : public AssetBackend {
+    public:
+        AndroidAssetBackend(AAssetManager* manager);
+        virtual AssetView* load(const std::string& name);
+    protected:
+        AAssetManager* manager;
+    };
+#endif
+
+    class FileAssetBackend : public AssetBackend {
+    public:
+        FileAssetBackend(const std::string& root);
+        virtual AssetView* load(const std::string& name);
+    protected:
+        std::string root;
+    };
+
+    struct AssetStoreStats {
+        uint32_t viewCount;
+        uint32_t bytes;
+        uint32_t mappedBytes;
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t archiveEntries;
+    };
+
+    class AssetStore {
+    public:
+        AssetStore(AssetBackend* backend);
+        ~AssetStore();
+
+        bool openArchive(const std::string& name);
+        bool isArchiveMapped();
+        AssetView* acquire(const std::string& name);
+        void release(AssetView* view);
+        bool getImageInfo(const std::string& name, int* width, int* height, int* format);
+        void getStats(AssetStoreStats* stats);
+    protected:
+        typedef std::map<std::string, AssetView*> ViewMap;
+
+        AssetBackend* backend;
+        AssetView*    archiveView;
+        AssetArchive  archive;
+        ViewMap  views;
+        uint32_t hits;
+        uint32_t misses;
+
+        pthread_mutex_t mutex;
+
+        AssetView* loadFromArchive(const std::string& name);
+    };
+
+    bool mapAssetView(AssetView* view, int fd, off_t start, size_t length);
+}
+#endif
@@ -0,0 +1,128 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Asset_archive.h"
+
+#include <string.h>
+#include <zlib.h>
+
+namespace emo {
+
+    AssetArchive::AssetArchive() {
+        this->data    = NULL;
+        this->length  = 0;
+        this->header  = NULL;
+        this->entries = NULL;
+        this->names   = NULL;
+    }
+
+    /*
+     * validate the header and every index entry against the archive size.
+     * the data must stay mapped while the archive is used.
+     */
+    bool AssetArchive::open(const unsigned char* data, size_t length) {
+        if (length < sizeof(AssetArchiveHeader)) return false;
+
+        const AssetArchiveHeader* header = (const AssetArchiveHeader*)data;
+        if (header->magic != ASSET_ARCHIVE_MAGIC || header->version != ASSET_ARCHIVE_VERSION) {
+            return false;
+        }
+
+        // computed in 64bit so that a crafted header can not wrap a 32bit size_t
+        uint64_t indexEnd = sizeof(AssetArchiveHeader) + (uint64_t)header->entryCount * sizeof(AssetArchiveEntry);
+        if (indexEnd > length || header->namesOffset < indexEnd ||
+                (uint64_t)header->namesOffset + header->namesSize > length || header->dataOffset > length) {
+            return false;
+        }
+
+        const AssetArchiveEntry* entries = (const AssetArchiveEntry*)(data + sizeof(AssetArchiveHeader));
+        for (uint32_t i = 0; i < header->entryCount; i++) {
+            const AssetArchiveEntry& entry = entries[i];
+            if ((uint64_t)entry.nameOffset + entry.nameLength > header->namesSize ||
+                    (uint64_t)entry.offset + entry.size > length ||
+                    (i > 0 && entries[i - 1].hash > entry.hash)) {
+                return false;
+            }
+        }
+
+        this->data    = data;
+        this->length  = length;
+        this->header  = header;
+        this->entries = entries;
+        this->names   = (const char*)data + header->namesOffset;
+        return true;
+    }
+
+    bool AssetArchive::isOpen() {
+        return this->header != NULL;
+    }
+
+    uint32_t AssetArchive::getEntryCount() {
+        return this->header != NULL ? this->header->entryCount : 0;
+    }
+
+    /*
+     * binary search of the path hash. entries with the same hash
+     * are compared by path.
+     */
+    const AssetArchiveEntry* AssetArchive::find(const char* name, size_t length) {
+        if (this->header == NULL) return NULL;
+
+        uint32_t hash = assetArchiveHash(name, length);
+        uint32_t low  = 0;
+        uint32_t high = this->header->entryCount;
+        while (low < high) {
+            uint32_t mid = (low + high) / 2;
+            if (this->entries[mid].hash < hash) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        for (uint32_t i = low; i < this->header->entryCount && this->entries[i].hash == hash; i++) {
+            const AssetArchiveEntry* entry = &this->entries[i];
+            if (entry->nameLength == length && memcmp(this->names + entry->nameOffset, name, length) == 0) {
+                return entry;
+            }
+        }
+        return NULL;
+    }
+
+    const unsigned char* AssetArchive::getData(const AssetArchiveEntry* entry) {
+        return this->data + entry->offset;
+    }
+
+    /*
+     * inflate the compressed entry. out must hold rawSize bytes.
+     */
+    bool AssetArchive::inflate(const AssetArchiveEntry* entry, unsigned char* out) {
+        uLongf outLength = entry->rawSize;
+        int rcode = uncompress(out, &outLength, this->getData(entry), entry->size);
+        return rcode == Z_OK && outLength == entry->rawSize;
+    }
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_ASSET_ARCHIVE_H
+#define EMO_ASSET_ARCHIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ASSET_ARCHIVE_MAGIC   0x4b41504f /* "OPAK" */
+#define ASSET_ARCHIVE_VERSION 1
+#define ASSET_ARCHIVE_NAME    "emo.pak"
+
+#define ASSET_ARCHIVE_COMPRESSED 0x01
+
+#define ASSET_FORMAT_UNKNOWN   0
+#define ASSET_FORMAT_PNG_RGB   1
+#define ASSET_FORMAT_PNG_RGBA  2
+#define ASSET_FORMAT_PNG_OTHER 3
+
+/*
+ * Packed asset archive.
+ * The file starts with the header, followed by the index sorted by path
+ * hash, the path string table and the asset contents. All values are
+ * little endian. The archive is mapped once and looked up by binary
+ * search, so an asset lookup never touches the file system. The index
+ * keeps the dimensions of the images to create sprites without decoding
+ * their headers. Archives are written by tools/emopack.
+ */
+namespace emo {
+    struct AssetArchiveHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t namesOffset;
+        uint32_t namesSize;
+        uint32_t dataOffset;
+    };
+
+    struct AssetArchiveEntry {
+        uint32_t hash;
+        uint32_t nameOffset;
+        uint32_t offset;
+        uint32_t size;
+        uint32_t rawSize;
+        uint16_t width;
+        uint16_t height;
+        uint8_t  flags;
+        uint8_t  format;
+        uint16_t nameLength;
+    };
+
+    /*
+     * FNV-1a hash of the asset path
+     */
+    inline uint32_t assetArchiveHash(const char* name, size_t length) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char)name[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    class AssetArchive {
+    public:
+        AssetArchive();
+
+        bool open(const unsigned char* data, size_t length);
+        bool isOpen();
+        const AssetArchiveEntry* find(const char* name, size_t length);
+        const unsigned char* getData(const AssetArchiveEntry* entry);
+        bool inflate(const AssetArchiveEntry* entry, unsigned char* out);
+        uint32_t getEntryCount();
+    protected:
+        const unsigned char* data;
+        size_t length;
+        const AssetArchiveHeader* header;
+        const AssetArchiveEntry*  entries;
+        const char* names;
+    };
+}
+#endif
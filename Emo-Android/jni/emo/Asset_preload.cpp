@@ -0,0 +1,249 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Asset_preload.h"
+
+#include <unistd.h>
+#include <GLES/gl.h>
+
+#include "Image.h"
+
+namespace emo {
+
+    /*
+     * one worker per online core
+     */
+    int getAssetPreloadWorkers() {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        if (count < 1) count = 1;
+        if (count > ASSET_PRELOAD_MAX_WORKERS) count = ASSET_PRELOAD_MAX_WORKERS;
+        return count;
+    }
+
+    static bool isImageName(const std::string& name) {
+        return name.size() > 4 && name.compare(name.size() - 4, 4, ".png") == 0;
+    }
+
+    AssetPreloader::AssetPreloader(AssetStore* store, AssetImageDecoder decoder) {
+        this->store   = store;
+        this->decoder = decoder;
+        this->activeWorkers = 0;
+        this->closing = false;
+
+        pthread_mutex_init(&this->mutex, NULL);
+        pthread_cond_init(&this->finished, NULL);
+    }
+
+    /*
+     * waits for the workers and releases every group
+     */
+    AssetPreloader::~AssetPreloader() {
+        pthread_mutex_lock(&this->mutex);
+        this->closing = true;
+        while (this->activeWorkers > 0) {
+            pthread_cond_wait(&this->finished, &this->mutex);
+        }
+        for (GroupMap::iterator it = this->groups.begin(); it != this->groups.end(); it++) {
+            this->release(it->second);
+            delete it->second;
+        }
+        this->groups.clear();
+        pthread_mutex_unlock(&this->mutex);
+
+        pthread_cond_destroy(&this->finished);
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    /*
+     * start loading the named assets on worker threads. returns immediately.
+     */
+    bool AssetPreloader::preload(const std::string& group, const std::vector<std::string>& names, int workers) {
+        this->unload(group);
+
+        if (workers < 1) workers = 1;
+        if (workers > ASSET_PRELOAD_MAX_WORKERS) workers = ASSET_PRELOAD_MAX_WORKERS;
+        if (workers > (int)names.size()) workers = names.size();
+
+        pthread_mutex_lock(&this->mutex);
+
+        Group* g = new Group();
+        g->preloader = this;
+        g->next      = 0;
+        g->workers   = 0;
+        g->unloaded  = false;
+        g->progress.total  = names.size();
+        g->progress.loaded = 0;
+        g->progress.failed = 0;
+        g->items.resize(names.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            g->items[i].name  = names[i];
+            g->items[i].view  = NULL;
+            g->items[i].image = NULL;
+        }
+        this->groups[group] = g;
+
+        bool result = true;
+        for (int i = 0; i < workers; i++) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, workerThread, g) != 0) {
+                result = false;
+                break;
+            }
+            pthread_detach(thread);
+            g->workers++;
+            this->activeWorkers++;
+        }
+        if (g->workers == 0 && !names.empty()) {
+            result = false;
+        }
+
+        pthread_mutex_unlock(&this->mutex);
+        return result;
+    }
+
+    bool AssetPreloader::getProgress(const std::string& group, AssetPreloadProgress* progress) {
+        pthread_mutex_lock(&this->mutex);
+        GroupMap::iterator it = this->groups.find(group);
+        bool found = it != this->groups.end();
+        if (found) *progress = it->second->progress;
+        pthread_mutex_unlock(&this->mutex);
+        return found;
+    }
+
+    /*
+     * wait for the workers of the group and move its decoded images
+     * to the caller, which owns them from now on.
+     */
+    bool AssetPreloader::takeImages(const std::string& group, std::vector<std::pair<std::string, Image*> >* images) {
+        pthread_mutex_lock(&this->mutex);
+        GroupMap::iterator it = this->groups.find(group);
+        if (it == this->groups.end()) {
+            pthread_mutex_unlock(&this->mutex);
+            return false;
+        }
+
+        Group* g = it->second;
+        while (g->workers > 0) {
+            pthread_cond_wait(&this->finished, &this->mutex);
+        }
+        for (size_t i = 0; i < g->items.size(); i++) {
+            if (g->items[i].image != NULL) {
+                images->push_back(std::make_pair(g->items[i].name, g->items[i].image));
+                g->items[i].image = NULL;
+            }
+        }
+        pthread_mutex_unlock(&this->mutex);
+        return true;
+    }
+
+    /*
+     * release the pinned views and the images which are not taken.
+     * names of the image assets in the group are stored to imageNames
+     * so that the caller can release the images it has taken.
+     * running workers delete the group when they finish.
+     */
+    bool AssetPreloader::unload(const std::string& group, std::vector<std::string>* imageNames) {
+        pthread_mutex_lock(&this->mutex);
+        GroupMap::iterator it = this->groups.find(group);
+        if (it == this->groups.end()) {
+            pthread_mutex_unlock(&this->mutex);
+            return false;
+        }
+
+        Group* g = it->second;
+        this->groups.erase(it);
+        g->unloaded = true;
+        if (imageNames != NULL) {
+            for (size_t i = 0; i < g->items.size(); i++) {
+                if (isImageName(g->items[i].name)) {
+                    imageNames->push_back(g->items[i].name);
+                }
+            }
+        }
+        if (g->workers == 0) {
+            this->release(g);
+            delete g;
+        }
+        pthread_mutex_unlock(&this->mutex);
+        return true;
+    }
+
+    void AssetPreloader::release(Group* group) {
+        for (size_t i = 0; i < group->items.size(); i++) {
+            Item& item = group->items[i];
+            if (item.view != NULL) {
+                this->store->release(item.view);
+                item.view = NULL;
+            }
+            if (item.image != NULL) {
+                delete item.image;
+                item.image = NULL;
+            }
+        }
+    }
+
+    void AssetPreloader::worker(Group* group) {
+        pthread_mutex_lock(&this->mutex);
+        while (!this->closing && !group->unloaded && group->next < group->items.size()) {
+            size_t index = group->next++;
+            std::string name = group->items[index].name;
+            pthread_mutex_unlock(&this->mutex);
+
+            AssetView* view = NULL;
+            Image* image = NULL;
+            if (isImageName(name)) {
+                image = this->decoder(name.c_str());
+            } else {
+                view = this->store->acquire(name);
+            }
+
+            pthread_mutex_lock(&this->mutex);
+            group->items[index].view  = view;
+            group->items[index].image = image;
+            if (view != NULL || image != NULL) {
+                group->progress.loaded++;
+            } else {
+                group->progress.failed++;
+            }
+        }
+
+        group->workers--;
+        if (group->unloaded && group->workers == 0) {
+            this->release(group);
+            delete group;
+        }
+        this->activeWorkers--;
+        pthread_cond_broadcast(&this->finished);
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void* AssetPreloader::workerThread(void* arg) {
+        Group* group = (Group*)arg;
+        group->preloader->worker(group);
+        return NULL;
+    }
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_ASSET_PRELOAD_H
+#define EMO_ASSET_PRELOAD_H
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "Asset.h"
+
+#define ASSET_PRELOAD_MAX_WORKERS 8
+
+/*
+ * Preloads the assets of a scene manifest on worker threads.
+ * PNG images are decoded by the workers, other assets (atlases, scripts)
+ * are read into shared views and stay pinned until the group is unloaded.
+ * The decoded images are taken on the main thread which creates and
+ * uploads their textures in one pass.
+ */
+namespace emo {
+    class Image;
+
+    typedef Image* (*AssetImageDecoder)(const char* name);
+
+    struct AssetPreloadProgress {
+        int total;
+        int loaded;
+        int failed;
+    };
+
+    class AssetPreloader {
+    public:
+        AssetPreloader(AssetStore* store, AssetImageDecoder decoder);
+        ~AssetPreloader();
+
+        bool preload(const std::string& group, const std::vector<std::string>& names, int workers);
+        bool getProgress(const std::string& group, AssetPreloadProgress* progress);
+        bool takeImages(const std::string& group, std::vector<std::pair<std::string, Image*> >* images);
+        bool unload(const std::string& group, std::vector<std::string>* imageNames = NULL);
+    protected:
+        struct Item {
+            std::string name;
+            AssetView* view;
+            Image*     image;
+        };
+
+        struct Group {
+            AssetPreloader* preloader;
+            std::vector<Item> items;
+            size_t next;
+            int    workers;
+            bool   unloaded;
+            AssetPreloadProgress progress;
+        };
+
+        typedef std::map<std::string, Group*> GroupMap;
+
+        AssetStore* store;
+        AssetImageDecoder decoder;
+        GroupMap groups;
+        int      activeWorkers;
+        bool     closing;
+
+        pthread_mutex_t mutex;
+        pthread_cond_t  finished;
+
+        void release(Group* group);
+        void worker(Group* group);
+
+        static void* workerThread(void* arg);
+    };
+
+    int getAssetPreloadWorkers();
+}
+#endif
@@ -28,11 +28,16 @@
 #include <SLES/OpenSLES.h>
 #include <SLES/OpenSLES_Android.h>
 #include <squirrel.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
 
 #include "Constants.h"
 #include "Engine.h"
 #include "Runtime.h"
 #include "Audio.h"
+#include "Audio_kernels.h"
 #include "VmFunc.h"
 
 extern emo::Engine* engine;
@@ -42,12 +47,31 @@ void initAudioFunctions() {
 
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "constructor",    emoCreateAudioEngine);
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "load",           emoLoadAudio);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "loadStream",     emoLoadAudioStream);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "getStreamStats", emoGetAudioStreamStats);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "preloadSamples", emoPreloadAudioSamples);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "unloadSamples",  emoUnloadAudioSamples);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "getPreloadProgress", emoGetAudioPreloadProgress);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "getSampleBankStats", emoGetAudioSampleBankStats);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "setSampleBudget",    emoSetAudioSampleBudget);
+
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "playVoice",          emoPlayAudioVoice);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "stopVoice",          emoStopAudioVoice);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "setVoiceVolume",     emoSetAudioVoiceVolume);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "isVoicePlaying",     emoIsAudioVoicePlaying);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "setVoiceCategoryLimit", emoSetAudioVoiceCategoryLimit);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "setVoiceStealPolicy",   emoSetAudioVoiceStealPolicy);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "getVoicePoolStats",     emoGetAudioVoicePoolStats);
+
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "getLatencyStats",   emoGetAudioLatencyStats);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "resetLatencyStats", emoResetAudioLatencyStats);
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "play",           emoPlayAudioChannel);
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "resume_play",    emoResumeAudioChannel);
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "pause",          emoPauseAudioChannel);
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "stop",           emoStopAudioChannel);
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "seek",           emoSeekAudioChannel);
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "getChannelCount",emoGetAudioChannelCount);
+    registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "setResampler",   emoSetAudioResampler);
 
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "getVolume",      emoGetAudioChannelVolume);
     registerClassFunc(engine->sqvm, EMO_AUDIO_CLASS,    "setVolume",      emoSetAudioChannelVolume);
@@ -74,6 +98,93 @@ static SLresult checkOpenSLresult(const char* message, SLresult result) {
     return result;
 }
 
+/*
+ * reads the audio stream from the asset on the decode thread
+ */
+class AssetStreamSource : public emo::AudioStreamSource {
+public:
+    AssetStreamSource(AAsset* asset) {
+        this->asset = asset;
+    }
+    virtual ~AssetStreamSource() {
+        AAsset_close(this->asset);
+    }
+    virtual int read(void* buffer, int size) {
+        return AAsset_read(this->asset, buffer, size);
+    }
+    virtual bool seek(long offset) {
+        return AAsset_seek(this->asset, offset, SEEK_SET) >= 0;
+    }
+protected:
+    AAsset* asset;
+};
+
+/*
+ * decode the wav asset for the sample bank. called on the preload workers.
+ */
+static emo::AudioSample* decodeSampleAsset(const char* fname) {
+    AAssetManager* mgr = engine->app->activity->assetManager;
+    if (mgr == NULL) {
+        LOGE("emo_audio: failed to load AAssetManager");
+        return NULL;
+    }
+
+    AAsset* asset = AAssetManager_open(mgr, fname, AASSET_MODE_BUFFER);
+    if (asset == NULL) {
+        LOGE("emo_audio: failed to open an audio file");
+        LOGE(fname);
+        return NULL;
+    }
+
+    emo::AudioSample* sample = new emo::AudioSample();
+    const unsigned char* bytes = (const unsigned char*)AAsset_getBuffer(asset);
+    bool decoded = bytes != NULL && sample->loadWav(bytes, AAsset_getLength(asset));
+    AAsset_close(asset);
+
+    if (!decoded) {
+        delete sample;
+        LOGE("emo_audio: failed to decode an audio file");
+        LOGE(fname);
+        return NULL;
+    }
+    return sample;
+}
+
+/*
+ * returns true if the file name has wav extension
+ */
+static bool isWavFile(const char* fname) {
+    size_t length = strlen(fname);
+    return length > 4 && strcasecmp(fname + length - 4, ".wav") == 0;
+}
+
+/*
+ * convert OpenSL volume level to linear gain
+ */
+static float millibelToGain(SLmillibel volumeLevel) {
+    if (volumeLevel <= SL_MILLIBEL_MIN) return 0;
+    return powf(10.0f, volumeLevel / 2000.0f);
+}
+
+/*
+ * script volume (0 to 1) to mixer gain, same curve as the channel volume
+ */
+static float volumeToGain(float volume) {
+    return millibelToGain((SLmillibel)((1 - volume) * SL_MILLIBEL_MIN));
+}
+
+/*
+ * called by OpenSL when the mixer output buffer has been played
+ */
+static void mixerBufferQueueCallback(SLAndroidSimpleBufferQueueItf queue, void* context) {
+    reinterpret_cast<emo::Audio*>(context)->onMixerBufferDone();
+}
+
+static void enqueueMixerBuffer(void* context, int16_t* buffer, int size) {
+    SLAndroidSimpleBufferQueueItf queue = (SLAndroidSimpleBufferQueueItf)context;
+    (*queue)->Enqueue(queue, buffer, size);
+}
+
 namespace emo {
 
     Audio::Audio() {
@@ -81,26 +192,41 @@ namespace emo {
         this->engineObject    = NULL;
         this->outputMixObject = NULL;
         this->engineEngine    = NULL;
+
+        this->mixer             = NULL;
+        this->bank              = NULL;
+        this->pool              = NULL;
+        this->metrics           = NULL;
+        this->poolVoiceCount    = 0;
+        this->mixerPlayerObject = NULL;
+        this->mixerPlay         = NULL;
+        this->mixerQueue        = NULL;
+        this->mixerOutput       = NULL;
     }
 
     Audio::~Audio() {
 
     }
 
-    bool Audio::create(int channelCount) {
+    bool Audio::create(int channelCount, bool useMixer, int poolVoiceCount) {
         if (this->running) {
             engine->setLastError(ERR_AUDIO_ENGINE_CREATED);
             LOGE("emo_audio: audio engine is already created.");
             return false;
         }
 
-        this->channelCount = channelCount;
+        this->channelCount   = channelCount;
+        this->poolVoiceCount = useMixer ? poolVoiceCount : 0;
 
         SLresult result;
         this->channels = (Channel *)malloc(sizeof(Channel) * channelCount);
 
         for (int i = 0; i < channelCount; i++) {
             channels[i].loaded = SL_BOOLEAN_FALSE;
+            channels[i].mixed  = false;
+            channels[i].sample = NULL;
+            channels[i].stream = NULL;
+            channels[i].volume = 0;
         }
 
         // create engine
@@ -147,10 +273,179 @@ namespace emo {
             return false;
         }
 
+        if (useMixer && !this->createMixer()) {
+            engine->setLastError(ERR_AUDIO_ENGINE_INIT);
+            return false;
+        }
+
         this->running = true;
         return true;
     }
 
+    /*
+     * create the software mixer and one buffer queue player
+     * that plays the mixed output of all wav channels
+     */
+    bool Audio::createMixer() {
+        SLresult result;
+
+        // configure audio source
+        SLDataLocator_AndroidSimpleBufferQueue loc_bq = {SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, 2};
+        SLDataFormat_PCM format_pcm = {SL_DATAFORMAT_PCM, AUDIO_MIXER_CHANNELS, AUDIO_MIXER_SAMPLE_RATE * 1000,
+                SL_PCMSAMPLEFORMAT_FIXED_16, SL_PCMSAMPLEFORMAT_FIXED_16,
+                SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT, SL_BYTEORDER_LITTLEENDIAN};
+        SLDataSource audioSrc = {&loc_bq, &format_pcm};
+
+        // configure audio sink
+        SLDataLocator_OutputMix loc_outmix = {SL_DATALOCATOR_OUTPUTMIX, this->outputMixObject};
+        SLDataSink audioSnk = {&loc_outmix, NULL};
+
+        // create audio player
+        const SLInterfaceID player_ids[2] = {SL_IID_PLAY, SL_IID_ANDROIDSIMPLEBUFFERQUEUE};
+        const SLboolean player_req[2] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE};
+        result = (*engineEngine)->CreateAudioPlayer(this->engineEngine, &this->mixerPlayerObject, &audioSrc, &audioSnk,
+                2, player_ids, player_req);
+        if (SL_RESULT_SUCCESS != result) {
+            this->mixerPlayerObject = NULL;
+            LOGE("emo_audio: failed to create mixer player");
+            return false;
+        }
+
+        // realize the player
+        result = (*this->mixerPlayerObject)->Realize(this->mixerPlayerObject, SL_BOOLEAN_FALSE);
+        if (SL_RESULT_SUCCESS != result) {
+            LOGE("emo_audio: failed to realize mixer player");
+            this->closeMixer();
+            return false;
+        }
+
+        // get the play and buffer queue interface
+        result = (*this->mixerPlayerObject)->GetInterface(this->mixerPlayerObject, SL_IID_PLAY, &this->mixerPlay);
+        if (SL_RESULT_SUCCESS != result) {
+            LOGE("emo_audio: failed to get mixer play interface");
+            this->closeMixer();
+            return false;
+        }
+        result = (*this->mixerPlayerObject)->GetInterface(this->mixerPlayerObject,
+                SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &this->mixerQueue);
+        if (SL_RESULT_SUCCESS != result) {
+            LOGE("emo_audio: failed to get mixer buffer queue interface");
+            this->closeMixer();
+            return false;
+        }
+
+        // the pool voices follow the script channels
+        this->mixer = new AudioMixer(this->channelCount + this->poolVoiceCount, AUDIO_MIXER_SAMPLE_RATE);
+        this->bank  = new AudioSampleBank(decodeSampleAsset, AUDIO_BANK_DEFAULT_BUDGET);
+        this->pool  = new AudioVoicePool(this->mixer, this->bank, this->channelCount, this->poolVoiceCount);
+        this->metrics = new AudioMetrics(AUDIO_MIXER_BUFFER_FRAMES, AUDIO_MIXER_SAMPLE_RATE);
+
+        char str[128];
+        snprintf(str, sizeof(str), "emo_audio: mixer uses %s kernels", getAudioKernelsName());
+        LOGI(str);
+
+        this->mixerOutput = new AudioMixerOutput(this->mixer, this->metrics,
+                enqueueMixerBuffer, (void*)this->mixerQueue);
+
+        result = (*this->mixerQueue)->RegisterCallback(this->mixerQueue, mixerBufferQueueCallback, this);
+        if (SL_RESULT_SUCCESS != result) {
+            LOGE("emo_audio: failed to register mixer callback");
+            this->closeMixer();
+            return false;
+        }
+
+        this->mixerOutput->start();
+
+        result = (*this->mixerPlay)->SetPlayState(this->mixerPlay, SL_PLAYSTATE_PLAYING);
+        if (SL_RESULT_SUCCESS != result) {
+            LOGE("emo_audio: failed to start mixer player");
+            this->closeMixer();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Audio::onMixerBufferDone() {
+        this->mixerOutput->onBufferDone();
+    }
+
+    /*
+     * rolling timing statistics of the mixer output
+     */
+    bool Audio::getMetrics(AudioMetricsSnapshot* snapshot) {
+        if (this->metrics == NULL) return false;
+        this->metrics->getSnapshot(snapshot);
+        return true;
+    }
+
+    void Audio::resetMetrics() {
+        if (this->metrics != NULL) {
+            this->metrics->reset();
+        }
+    }
+
+    /*
+     * delete the closed streams that no mixer voice pulls any more.
+     * force is used after the mixer output has been destroyed.
+     */
+    void Audio::deleteRetiredStreams(bool force) {
+        std::vector<AudioStream*>::iterator it = this->retiredStreams.begin();
+        while (it != this->retiredStreams.end()) {
+            if (force || !(*it)->isMixing()) {
+                delete *it;
+                it = this->retiredStreams.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+    void Audio::closeMixer() {
+        if (this->mixerPlayerObject != NULL) {
+            // destroying the player stops the buffer queue callbacks
+            (*this->mixerPlayerObject)->Destroy(this->mixerPlayerObject);
+            this->mixerPlayerObject = NULL;
+            this->mixerPlay  = NULL;
+            this->mixerQueue = NULL;
+        }
+        if (this->pool != NULL) {
+            delete this->pool;
+            this->pool = NULL;
+        }
+        this->deleteRetiredStreams(true);
+        if (this->mixer != NULL) {
+            delete this->mixer;
+            this->mixer = NULL;
+        }
+        if (this->bank != NULL) {
+            delete this->bank;
+            this->bank = NULL;
+        }
+        if (this->metrics != NULL) {
+            delete this->metrics;
+            this->metrics = NULL;
+        }
+        if (this->mixerOutput != NULL) {
+            delete this->mixerOutput;
+            this->mixerOutput = NULL;
+        }
+    }
+
+    bool Audio::isMixerRunning() {
+        return this->mixer != NULL;
+    }
+
+    /*
+     * select the resampler of the software mixer
+     */
+    bool Audio::setMixerResampler(int resampler) {
+        if (this->mixer == NULL) return false;
+        if (resampler != AUDIO_RESAMPLE_LINEAR && resampler != AUDIO_RESAMPLE_POLYPHASE) return false;
+        this->mixer->setResampler(resampler);
+        return true;
+    }
+
     bool Audio::createChannelFromAsset(const char* fname, int index) {
         SLresult result;
 
@@ -160,6 +455,10 @@ namespace emo {
             this->closeChannel(index);
         }
 
+        if (this->mixer != NULL && isWavFile(fname)) {
+            return this->createMixedChannelFromAsset(fname, index);
+        }
+
         AAssetManager* mgr = engine->app->activity->assetManager;
         if (mgr == NULL) {
             engine->setLastError(ERR_ASSET_LOAD);
@@ -243,6 +542,104 @@ namespace emo {
         return true;
     }
 
+    /*
+     * decode wav asset to PCM and attach it to the mixer voice of the channel
+     */
+    bool Audio::createMixedChannelFromAsset(const char* fname, int index) {
+        Channel* channel = &this->channels[index];
+
+        // the bank shares the decoded sample with the other channels
+        AudioSample* sample = this->bank->acquire(fname);
+        if (sample == NULL) {
+            engine->setLastError(ERR_AUDIO_ASSET_INIT);
+            LOGE("emo_audio: failed to load an audio file");
+            LOGE(fname);
+            return false;
+        }
+
+        this->mixer->setSample(index, sample);
+        this->mixer->setGain(index, 1);
+        this->mixer->setLooping(index, false);
+
+        channel->mixed  = true;
+        channel->sample = sample;
+        channel->volume = 0;
+        channel->loaded = SL_BOOLEAN_TRUE;
+
+        return true;
+    }
+
+    /*
+     * create the channel that streams the wav asset through the mixer.
+     * only the stream buffers stay in memory, not the whole file.
+     */
+    bool Audio::createStreamChannelFromAsset(const char* fname, int index) {
+        Channel* channel = &this->channels[index];
+
+        if (channel->loaded == SL_BOOLEAN_TRUE) {
+            this->closeChannel(index);
+        }
+
+        if (this->mixer == NULL || !isWavFile(fname)) {
+            engine->setLastError(ERR_NOT_SUPPORTED);
+            LOGE("emo_audio: streaming requires the software mixer and a wav file");
+            LOGE(fname);
+            return false;
+        }
+
+        AAssetManager* mgr = engine->app->activity->assetManager;
+        if (mgr == NULL) {
+            engine->setLastError(ERR_ASSET_LOAD);
+            LOGE("emo_audio: failed to load AAssetManager");
+            return false;
+        }
+
+        AAsset* asset = AAssetManager_open(mgr, fname, AASSET_MODE_STREAMING);
+        if (asset == NULL) {
+            engine->setLastError(ERR_ASSET_OPEN);
+            LOGE("emo_audio: failed to open an audio file");
+            LOGE(fname);
+            return false;
+        }
+
+        AudioStream* stream = new AudioStream(new AssetStreamSource(asset), this->mixer->getSampleRate());
+        if (!stream->open()) {
+            delete stream;
+            engine->setLastError(ERR_AUDIO_ASSET_INIT);
+            LOGE("emo_audio: failed to open an audio stream");
+            LOGE(fname);
+            return false;
+        }
+
+        this->mixer->setStream(index, stream);
+        this->mixer->setGain(index, 1);
+        this->mixer->setLooping(index, false);
+
+        channel->mixed  = true;
+        channel->stream = stream;
+        channel->volume = 0;
+        channel->loaded = SL_BOOLEAN_TRUE;
+
+        return true;
+    }
+
+    AudioSampleBank* Audio::getSampleBank() {
+        return this->bank;
+    }
+
+    AudioVoicePool* Audio::getVoicePool() {
+        return this->pool;
+    }
+
+    bool Audio::getStreamStats(int index, AudioStreamStats* stats) {
+        Channel* channel = &this->channels[index];
+        if (!channel->loaded || channel->stream == NULL) {
+            return false;
+        }
+        channel->stream->getStats(stats);
+        return true;
+    }
+
     bool Audio::setChannelState(int index, SLuint32 state) {
         Channel* channel = &this->channels[index];
         if (!channel->loaded) {
@@ -250,6 +647,16 @@ namespace emo {
             LOGE("emo_audio: audio channel is closed");
             return false;
         }
+        if (channel->mixed) {
+            switch (state) {
+            case SL_PLAYSTATE_PLAYING:
+                return this->mixer->resume(index);
+            case SL_PLAYSTATE_PAUSED:
+                return this->mixer->pause(index);
+            default:
+                return this->mixer->stop(index);
+            }
+        }
         SLresult result = (*channel->playerPlay)->SetPlayState(channel->playerPlay, state);
         checkOpenSLresult("emo_audio: failed to set play state", result);
         return (SL_RESULT_SUCCESS == result);
@@ -262,6 +669,16 @@ namespace emo {
             LOGE("emo_audio: audio channel is closed");
             return SL_PLAYSTATE_STOPPED;
         }
+        if (channel->mixed) {
+            switch (this->mixer->getState(index)) {
+            case AUDIO_CHANNEL_PLAYING:
+                return SL_PLAYSTATE_PLAYING;
+            case AUDIO_CHANNEL_PAUSED:
+                return SL_PLAYSTATE_PAUSED;
+            default:
+                return SL_PLAYSTATE_STOPPED;
+            }
+        }
         SLuint32 state;
         SLresult result = (*channel->playerPlay)->GetPlayState(channel->playerPlay, &state);
         checkOpenSLresult("emo_audio: failed to get play state", result);
@@ -270,7 +687,20 @@ namespace emo {
 
     void Audio::closeChannel(int index) {
         Channel* channel = &this->channels[index];
-        if (channel->loaded) {
+        if (channel->loaded && channel->mixed) {
+            // the audio thread detaches the voice on its next mix.
+            // the bank keeps the sample until then, the stream is retired.
+            this->mixer->setSample(index, NULL);
+            this->bank->release(channel->sample);
+            if (channel->stream != NULL) {
+                this->retiredStreams.push_back(channel->stream);
+            }
+            this->deleteRetiredStreams(false);
+            channel->sample = NULL;
+            channel->stream = NULL;
+            channel->mixed  = false;
+            channel->loaded = SL_BOOLEAN_FALSE;
+        } else if (channel->loaded) {
             if (this->getChannelState(index) != SL_PLAYSTATE_PAUSED) {
                 this->stopChannel(index);
             }
@@ -295,6 +725,9 @@ namespace emo {
             LOGE("emo_audio: audio channel is closed");
             return 0;
         }
+        if (channel->mixed) {
+            return channel->volume;
+        }
         SLmillibel volumeLevel;
         SLresult result = (*channel->playerVolume)->GetVolumeLevel(channel->playerVolume, &volumeLevel);
         checkOpenSLresult("emo_audio: failed to get audio channel volume", result);
@@ -309,6 +742,11 @@ namespace emo {
             LOGE("emo_audio: audio channel is closed");
             return 0;
         }
+        if (channel->mixed) {
+            channel->volume = volumeLevel;
+            this->mixer->setGain(index, millibelToGain(volumeLevel));
+            return channel->volume;
+        }
         SLresult result = (*channel->playerVolume)->SetVolumeLevel(channel->playerVolume, volumeLevel);
         checkOpenSLresult("emo_audio: failed to set audio channel volume", result);
 
@@ -322,6 +760,9 @@ namespace emo {
             LOGE("emo_audio: audio channel is closed");
             return 0;
         }
+        if (channel->mixed) {
+            return 0;
+        }
         SLmillibel volumeLevel;
         SLresult result = (*channel->playerVolume)->GetMaxVolumeLevel(channel->playerVolume, &volumeLevel);
         checkOpenSLresult("emo_audio: failed to get audio channel max volume", result);
@@ -337,6 +778,9 @@ namespace emo {
             LOGE("emo_audio: audio channel is closed");
             return false;
         }
+        if (channel->mixed) {
+            return this->mixer->seek(index, pos);
+        }
         SLresult result = (*channel->playerSeek)->SetPosition(channel->playerSeek, pos, seekMode);
         checkOpenSLresult("emo_audio: failed to seek audio channel", result);
         return (SL_RESULT_SUCCESS == result);
@@ -349,6 +793,9 @@ namespace emo {
             LOGE("emo_audio: audio channel is closed");
             return false;
         }
+        if (channel->mixed) {
+            return this->mixer->play(index);
+        }
         if (this->getChannelState(index) != SL_PLAYSTATE_STOPPED) {
             this->setChannelState(index, SL_PLAYSTATE_STOPPED);
             this->seekChannel(index, 0, SL_SEEKMODE_FAST);
@@ -393,6 +840,8 @@ namespace emo {
             }
             free(channels);
 
+            this->closeMixer();
+
             (*this->outputMixObject)->Destroy(this->outputMixObject);
             (*this->engineObject)->Destroy(this->engineObject);
 
@@ -415,6 +864,10 @@ namespace emo {
     bool Audio::getChannelLooping(int index) {
         Channel* channel = &this->channels[index];
 
+        if (channel->mixed) {
+            return this->mixer->isLooping(index);
+        }
+
         SLboolean enabled;
         SLmillisecond start = 0;
         SLmillisecond end = SL_TIME_UNKNOWN;
@@ -434,6 +887,11 @@ namespace emo {
     bool Audio::setChannelLooping(int index, SQBool enable) {
         Channel* channel = &this->channels[index];
 
+        if (channel->mixed) {
+            this->mixer->setLooping(index, enable);
+            return true;
+        }
+
         SLresult result;
         if (enable) {
             result = (*channel->playerSeek)->SetLoop(channel->playerSeek, SL_BOOLEAN_TRUE, 0, SL_TIME_UNKNOWN);
@@ -485,26 +943,37 @@ SQInteger emoLoadAudio(HSQUIRRELVM v) {
 }
 
 /*
- * create audio engine
+ * SQInteger loadAudioStream(SQInteger audioIndex, SQChar* filename);
+ * the wav file is streamed by the software mixer
  *
- * @param channel count
+ * @param audio channel index
+ * @param file name to be streamed
  * @return EMO_NO_ERROR if succeeds
  */
-SQInteger emoCreateAudioEngine(HSQUIRRELVM v) {
-    if (engine->audio->isRunning()) {
-        sq_pushinteger(v, ERR_AUDIO_ENGINE_CREATED);
+SQInteger emoLoadAudioStream(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
         return 1;
     }
 
-    SQInteger channelCount;
+    SQInteger channelIndex;
+    const SQChar* filename;
 
-    if (sq_gettype(v, 2) != OT_NULL) {
-        sq_getinteger(v, 2, &channelCount);
+    if (sq_gettype(v, 2) != OT_NULL && sq_gettype(v, 3) == OT_STRING) {
+        sq_getinteger(v, 2, &channelIndex);
+        sq_tostring(v, 3);
+        sq_getstring(v, -1, &filename);
     } else {
-        channelCount = DEFAULT_AUDIO_CHANNEL_COUNT;
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (channelIndex >= engine->audio->getChannelCount()) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
     }
 
-    if (!engine->audio->create(channelCount)) {
+    if (!engine->audio->createStreamChannelFromAsset(filename, channelIndex)) {
         sq_pushinteger(v, engine->getLastError());
         return 1;
     }
@@ -515,15 +984,14 @@ SQInteger emoCreateAudioEngine(HSQUIRRELVM v) {
 }
 
 /*
- * play audio with given channel 
+ * returns the buffer statistics of the streaming channel
  *
  * @param audio channel index
- * @return EMO_NO_ERROR if succeeds
+ * @return table {underrunCount, underrunFrames, bufferedFrames, capacityFrames, memoryBytes}
  */
-SQInteger emoPlayAudioChannel(HSQUIRRELVM v) {
+SQInteger emoGetAudioStreamStats(HSQUIRRELVM v) {
     if (!engine->audio->isRunning()) {
-        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
-        return 1;
+        return 0;
     }
 
     SQInteger channelIndex;
@@ -531,101 +999,636 @@ SQInteger emoPlayAudioChannel(HSQUIRRELVM v) {
     if (sq_gettype(v, 2) != OT_NULL) {
         sq_getinteger(v, 2, &channelIndex);
     } else {
-        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
-        return 1;
+        return 0;
     }
 
     if (channelIndex >= engine->audio->getChannelCount()) {
-        sq_pushinteger(v, ERR_INVALID_PARAM);
-        return 1;
+        return 0;
     }
 
-    if (!engine->audio->playChannel(channelIndex)) {
-        sq_pushinteger(v, ERR_AUDIO_ENGINE_STATUS);
-        return 1;
+    emo::AudioStreamStats stats;
+    if (!engine->audio->getStreamStats(channelIndex, &stats)) {
+        return 0;
     }
 
-    sq_pushinteger(v, EMO_NO_ERROR);
+    sq_newtable(v);
+    newSlotInteger(v, "underrunCount",  stats.underrunCount);
+    newSlotInteger(v, "underrunFrames", stats.underrunFrames);
+    newSlotInteger(v, "bufferedFrames", stats.bufferedFrames);
+    newSlotInteger(v, "capacityFrames", stats.capacityFrames);
+    newSlotInteger(v, "memoryBytes",    stats.memoryBytes);
 
     return 1;
 }
 
 /*
- * resume audio with given channel
+ * decode the wav files of the group on worker threads.
+ * the samples stay in memory until the group is unloaded.
  *
- * @param audio channel index
+ * @param group name
+ * @param array of file names
+ * @param worker count (optional)
  * @return EMO_NO_ERROR if succeeds
  */
-SQInteger emoResumeAudioChannel(HSQUIRRELVM v) {
+SQInteger emoPreloadAudioSamples(HSQUIRRELVM v) {
     if (!engine->audio->isRunning()) {
         sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
         return 1;
     }
 
-    SQInteger channelIndex;
+    if (!engine->audio->isMixerRunning()) {
+        sq_pushinteger(v, ERR_NOT_SUPPORTED);
+        return 1;
+    }
 
-    if (sq_gettype(v, 2) != OT_NULL) {
-        sq_getinteger(v, 2, &channelIndex);
-    } else {
+    if (sq_gettype(v, 2) != OT_STRING || sq_gettype(v, 3) != OT_ARRAY) {
         sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
         return 1;
     }
 
-    if (channelIndex >= engine->audio->getChannelCount()) {
-        sq_pushinteger(v, ERR_INVALID_PARAM);
-        return 1;
+    const SQChar* group;
+    sq_getstring(v, 2, &group);
+
+    SQInteger workers = AUDIO_BANK_DEFAULT_WORKERS;
+    if (sq_gettop(v) >= 4 && sq_gettype(v, 4) == OT_INTEGER) {
+        sq_getinteger(v, 4, &workers);
     }
 
-    if (!engine->audio->resumeChannel(channelIndex)) {
+    std::vector<std::string> names;
+    sq_push(v, 3);
+    sq_pushnull(v);
+    while(SQ_SUCCEEDED(sq_next(v, -2))) {
+        if (sq_gettype(v, -1) == OT_STRING) {
+            const SQChar* name;
+            sq_getstring(v, -1, &name);
+            names.push_back(name);
+        }
+        sq_pop(v, 2);
+    }
+    sq_pop(v, 2);
+
+    if (!engine->audio->getSampleBank()->preload(group, names, workers)) {
         sq_pushinteger(v, ERR_AUDIO_ENGINE_STATUS);
         return 1;
     }
 
     sq_pushinteger(v, EMO_NO_ERROR);
-
     return 1;
 }
 
 /*
- * pause audio with given channel
+ * unpin the group and free the samples that no channel uses
  *
- * @param audio channel index
+ * @param group name
  * @return EMO_NO_ERROR if succeeds
  */
-SQInteger emoPauseAudioChannel(HSQUIRRELVM v) {
-    if (!engine->audio->isRunning()) {
+SQInteger emoUnloadAudioSamples(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
         sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
         return 1;
     }
 
-    SQInteger channelIndex;
-
-    if (sq_gettype(v, 2) != OT_NULL) {
-        sq_getinteger(v, 2, &channelIndex);
-    } else {
+    if (sq_gettype(v, 2) != OT_STRING) {
         sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
         return 1;
     }
 
-    if (channelIndex >= engine->audio->getChannelCount()) {
-        sq_pushinteger(v, ERR_INVALID_PARAM);
-        return 1;
-    }
+    const SQChar* group;
+    sq_getstring(v, 2, &group);
 
-    if (!engine->audio->pauseChannel(channelIndex)) {
-        sq_pushinteger(v, ERR_AUDIO_ENGINE_STATUS);
+    if (!engine->audio->getSampleBank()->unload(group)) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
         return 1;
     }
 
     sq_pushinteger(v, EMO_NO_ERROR);
-
     return 1;
 }
 
 /*
- * stop audio with given channel
+ * returns the preload progress of the group
  *
- * @param audio channel index
+ * @param group name
+ * @return table {total, loaded, failed, done}
+ */
+SQInteger emoGetAudioPreloadProgress(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        return 0;
+    }
+
+    if (sq_gettype(v, 2) != OT_STRING) {
+        return 0;
+    }
+
+    const SQChar* group;
+    sq_getstring(v, 2, &group);
+
+    emo::AudioPreloadProgress progress;
+    if (!engine->audio->getSampleBank()->getProgress(group, &progress)) {
+        return 0;
+    }
+
+    sq_newtable(v);
+    newSlotInteger(v, "total",  progress.total);
+    newSlotInteger(v, "loaded", progress.loaded);
+    newSlotInteger(v, "failed", progress.failed);
+    sq_pushstring(v, "done", -1);
+    sq_pushbool(v, progress.loaded + progress.failed >= progress.total);
+    sq_newslot(v, -3, SQFalse);
+
+    return 1;
+}
+
+/*
+ * returns the sample bank statistics
+ *
+ * @return table {sampleCount, bytes, budget, hits, misses, evictions, loading}
+ */
+SQInteger emoGetAudioSampleBankStats(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        return 0;
+    }
+
+    emo::AudioSampleBankStats stats;
+    engine->audio->getSampleBank()->getStats(&stats);
+
+    sq_newtable(v);
+    newSlotInteger(v, "sampleCount", stats.sampleCount);
+    newSlotInteger(v, "bytes",       stats.bytes);
+    newSlotInteger(v, "budget",      stats.budget);
+    newSlotInteger(v, "hits",        stats.hits);
+    newSlotInteger(v, "misses",      stats.misses);
+    newSlotInteger(v, "evictions",   stats.evictions);
+    newSlotInteger(v, "loading",     stats.loading);
+
+    return 1;
+}
+
+/*
+ * set the byte budget of the unpinned samples
+ *
+ * @param bytes
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoSetAudioSampleBudget(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+
+    SQInteger budget;
+    if (sq_gettype(v, 2) == OT_INTEGER) {
+        sq_getinteger(v, 2, &budget);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (budget < 0) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    engine->audio->getSampleBank()->setBudget(budget);
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * play the wav file on a voice of the pool
+ *
+ * @param file name
+ * @param category name (optional)
+ * @param priority (optional, default 0)
+ * @param volume (optional, 0 to 1)
+ * @param loop or not (optional)
+ * @return voice handle or AUDIO_VOICE_INVALID
+ */
+SQInteger emoPlayAudioVoice(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        sq_pushinteger(v, AUDIO_VOICE_INVALID);
+        return 1;
+    }
+
+    if (sq_gettype(v, 2) != OT_STRING) {
+        sq_pushinteger(v, AUDIO_VOICE_INVALID);
+        return 1;
+    }
+
+    const SQChar* name;
+    sq_getstring(v, 2, &name);
+
+    const SQChar* category = "";
+    SQInteger priority = 0;
+    SQFloat volume = 1;
+    SQBool looping = false;
+
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 3 && sq_gettype(v, 3) == OT_STRING) {
+        sq_getstring(v, 3, &category);
+    }
+    if (nargs >= 4 && sq_gettype(v, 4) != OT_NULL) {
+        sq_getinteger(v, 4, &priority);
+    }
+    if (nargs >= 5 && sq_gettype(v, 5) != OT_NULL) {
+        sq_getfloat(v, 5, &volume);
+    }
+    if (nargs >= 6) {
+        getBool(v, 6, &looping);
+    }
+
+    int handle = engine->audio->getVoicePool()->play(name, category, priority, volumeToGain(volume), looping);
+    sq_pushinteger(v, handle);
+    return 1;
+}
+
+/*
+ * stop the voice and return it to the pool
+ *
+ * @param voice handle
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoStopAudioVoice(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+
+    SQInteger handle;
+    if (sq_gettype(v, 2) == OT_INTEGER) {
+        sq_getinteger(v, 2, &handle);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (!engine->audio->getVoicePool()->stop(handle)) {
+        sq_pushinteger(v, ERR_INVALID_ID);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * set the volume of the voice
+ *
+ * @param voice handle
+ * @param volume (0 to 1)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoSetAudioVoiceVolume(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+
+    SQInteger handle;
+    SQFloat volume;
+    if (sq_gettype(v, 2) == OT_INTEGER && sq_gettype(v, 3) != OT_NULL) {
+        sq_getinteger(v, 2, &handle);
+        sq_getfloat(v, 3, &volume);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (volume < 0 || volume > 1) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!engine->audio->getVoicePool()->setGain(handle, volumeToGain(volume))) {
+        sq_pushinteger(v, ERR_INVALID_ID);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * returns true if the voice is still playing
+ *
+ * @param voice handle
+ * @return true if playing
+ */
+SQInteger emoIsAudioVoicePlaying(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        sq_pushbool(v, false);
+        return 1;
+    }
+
+    SQInteger handle = AUDIO_VOICE_INVALID;
+    if (sq_gettype(v, 2) == OT_INTEGER) {
+        sq_getinteger(v, 2, &handle);
+    }
+
+    sq_pushbool(v, engine->audio->getVoicePool()->isPlaying(handle));
+    return 1;
+}
+
+/*
+ * limit the number of voices of the category
+ *
+ * @param category name
+ * @param max voice count (0 removes the limit)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoSetAudioVoiceCategoryLimit(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+
+    const SQChar* category;
+    SQInteger maxVoices;
+    if (sq_gettype(v, 2) == OT_STRING && sq_gettype(v, 3) == OT_INTEGER) {
+        sq_getstring(v, 2, &category);
+        sq_getinteger(v, 3, &maxVoices);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (maxVoices < 0) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    engine->audio->getVoicePool()->setCategoryLimit(category, maxVoices);
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * select the voice to steal when the pool or category is full
+ *
+ * @param AUDIO_STEAL_OLDEST, AUDIO_STEAL_QUIETEST or AUDIO_STEAL_NONE
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoSetAudioVoiceStealPolicy(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+
+    SQInteger policy;
+    if (sq_gettype(v, 2) == OT_INTEGER) {
+        sq_getinteger(v, 2, &policy);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (policy != AUDIO_STEAL_OLDEST && policy != AUDIO_STEAL_QUIETEST && policy != AUDIO_STEAL_NONE) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    engine->audio->getVoicePool()->setStealPolicy(policy);
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * returns the voice pool statistics
+ *
+ * @return table {voiceCount, activeCount, playCount, stealCount, rejectCount}
+ */
+SQInteger emoGetAudioVoicePoolStats(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning() || !engine->audio->isMixerRunning()) {
+        return 0;
+    }
+
+    emo::AudioVoicePoolStats stats;
+    engine->audio->getVoicePool()->getStats(&stats);
+
+    sq_newtable(v);
+    newSlotInteger(v, "voiceCount",  stats.voiceCount);
+    newSlotInteger(v, "activeCount", stats.activeCount);
+    newSlotInteger(v, "playCount",   stats.playCount);
+    newSlotInteger(v, "stealCount",  stats.stealCount);
+    newSlotInteger(v, "rejectCount", stats.rejectCount);
+
+    return 1;
+}
+
+/*
+ * add the rolling statistics as a table slot
+ */
+static void newSlotRollingStats(HSQUIRRELVM v, const char* name, const emo::AudioRollingStats& stats) {
+    sq_pushstring(v, name, -1);
+    sq_newtable(v);
+    newSlotFloat(v,   "last",    stats.last);
+    newSlotFloat(v,   "min",     stats.min);
+    newSlotFloat(v,   "max",     stats.max);
+    newSlotFloat(v,   "average", stats.average);
+    newSlotInteger(v, "count",   stats.count);
+    sq_newslot(v, -3, SQFalse);
+}
+
+/*
+ * returns the timing statistics of the mixer output.
+ * times are in microseconds over the last 128 values.
+ *
+ * @return table {latency, period, cpu, streamFill, callbackCount, underrunCount, streamUnderrunCount}
+ */
+SQInteger emoGetAudioLatencyStats(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning()) {
+        return 0;
+    }
+
+    emo::AudioMetricsSnapshot snapshot;
+    if (!engine->audio->getMetrics(&snapshot)) {
+        return 0;
+    }
+
+    sq_newtable(v);
+    newSlotRollingStats(v, "latency",    snapshot.latency);
+    newSlotRollingStats(v, "period",     snapshot.period);
+    newSlotRollingStats(v, "cpu",        snapshot.cpu);
+    newSlotRollingStats(v, "streamFill", snapshot.streamFill);
+    newSlotInteger(v, "callbackCount",       snapshot.callbackCount);
+    newSlotInteger(v, "underrunCount",       snapshot.underrunCount);
+    newSlotInteger(v, "streamUnderrunCount", snapshot.streamUnderrunCount);
+
+    return 1;
+}
+
+SQInteger emoResetAudioLatencyStats(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+    engine->audio->resetMetrics();
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * create audio engine
+ * wav files are decoded and mixed in software if mixer is enabled.
+ *
+ * @param channel count
+ * @param use software mixer (optional)
+ * @param voice pool size (optional, mixer only)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoCreateAudioEngine(HSQUIRRELVM v) {
+    if (engine->audio->isRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CREATED);
+        return 1;
+    }
+
+    SQInteger channelCount;
+
+    if (sq_gettype(v, 2) != OT_NULL) {
+        sq_getinteger(v, 2, &channelCount);
+    } else {
+        channelCount = DEFAULT_AUDIO_CHANNEL_COUNT;
+    }
+
+    SQBool useMixer = false;
+    if (sq_gettop(v) >= 3) {
+        getBool(v, 3, &useMixer);
+    }
+
+    SQInteger poolVoiceCount = AUDIO_POOL_DEFAULT_VOICES;
+    if (sq_gettop(v) >= 4 && sq_gettype(v, 4) == OT_INTEGER) {
+        sq_getinteger(v, 4, &poolVoiceCount);
+    }
+    if (poolVoiceCount < 0 || poolVoiceCount > AUDIO_POOL_MAX_VOICES) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!engine->audio->create(channelCount, useMixer, poolVoiceCount)) {
+        sq_pushinteger(v, engine->getLastError());
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+
+    return 1;
+}
+
+/*
+ * play audio with given channel 
+ *
+ * @param audio channel index
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoPlayAudioChannel(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+
+    SQInteger channelIndex;
+
+    if (sq_gettype(v, 2) != OT_NULL) {
+        sq_getinteger(v, 2, &channelIndex);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (channelIndex >= engine->audio->getChannelCount()) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!engine->audio->playChannel(channelIndex)) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_STATUS);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+
+    return 1;
+}
+
+/*
+ * resume audio with given channel
+ *
+ * @param audio channel index
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoResumeAudioChannel(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+
+    SQInteger channelIndex;
+
+    if (sq_gettype(v, 2) != OT_NULL) {
+        sq_getinteger(v, 2, &channelIndex);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (channelIndex >= engine->audio->getChannelCount()) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!engine->audio->resumeChannel(channelIndex)) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_STATUS);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+
+    return 1;
+}
+
+/*
+ * pause audio with given channel
+ *
+ * @param audio channel index
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoPauseAudioChannel(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+
+    SQInteger channelIndex;
+
+    if (sq_gettype(v, 2) != OT_NULL) {
+        sq_getinteger(v, 2, &channelIndex);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (channelIndex >= engine->audio->getChannelCount()) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!engine->audio->pauseChannel(channelIndex)) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_STATUS);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+
+    return 1;
+}
+
+/*
+ * stop audio with given channel
+ *
+ * @param audio channel index
  * @return EMO_NO_ERROR if succeeds
  */
 SQInteger emoStopAudioChannel(HSQUIRRELVM v) {
@@ -790,6 +1793,40 @@ SQInteger emoGetAudioChannelCount(HSQUIRRELVM v) {
 
 }
 
+/*
+ * select the resampler of the software mixer
+ *
+ * @param AUDIO_RESAMPLE_LINEAR or AUDIO_RESAMPLE_POLYPHASE
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoSetAudioResampler(HSQUIRRELVM v) {
+    if (!engine->audio->isRunning()) {
+        sq_pushinteger(v, ERR_AUDIO_ENGINE_CLOSED);
+        return 1;
+    }
+
+    SQInteger resampler = AUDIO_RESAMPLE_LINEAR;
+    if (sq_gettype(v, 2) == OT_INTEGER) {
+        sq_getinteger(v, 2, &resampler);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    if (!engine->audio->isMixerRunning()) {
+        sq_pushinteger(v, ERR_NOT_SUPPORTED);
+        return 1;
+    }
+
+    if (!engine->audio->setMixerResampler(resampler)) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
 /*
  * returns min audio volume (always 0)
  */
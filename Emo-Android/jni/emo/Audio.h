@@ -31,6 +31,9 @@
 #include <SLES/OpenSLES.h>
 #include <SLES/OpenSLES_Android.h>
 #include <squirrel.h>
+#include "Audio_mixer.h"
+#include "Audio_bank.h"
+#include "Audio_pool.h"
 
 namespace emo {
     class Audio {
@@ -41,8 +44,10 @@ namespace emo {
         bool isRunning();
         void close();
 
-        bool create(int channelCount);
+        bool create(int channelCount, bool useMixer = false, int poolVoiceCount = 0);
         bool createChannelFromAsset(const char* fname, int index);
+        bool createMixedChannelFromAsset(const char* fname, int index);
+        bool createStreamChannelFromAsset(const char* fname, int index);
         bool setChannelState(int index, SLuint32 state);
         SLuint32 getChannelState(int index);
         void closeChannel(int index);
@@ -63,6 +68,15 @@ namespace emo {
         bool getChannelLooping(int index);
         bool setChannelLooping(int index, SQBool enable);
 
+        bool isMixerRunning();
+        bool setMixerResampler(int resampler);
+        bool getStreamStats(int index, AudioStreamStats* stats);
+        AudioSampleBank* getSampleBank();
+        AudioVoicePool*  getVoicePool();
+        bool getMetrics(AudioMetricsSnapshot* snapshot);
+        void resetMetrics();
+        void onMixerBufferDone();
+
     protected:
         bool running;
 
@@ -74,6 +88,10 @@ namespace emo {
             SLPlayItf     playerPlay;
             SLSeekItf     playerSeek;
             SLVolumeItf   playerVolume;
+            bool          mixed;
+            AudioSample*  sample;
+            AudioStream*  stream;
+            SLmillibel    volume;
         };
 
         Channel* channels;
@@ -81,12 +99,44 @@ namespace emo {
         SLObjectItf engineObject;
         SLEngineItf engineEngine;
         SLObjectItf outputMixObject;
+
+        bool createMixer();
+        void closeMixer();
+        void deleteRetiredStreams(bool force);
+
+        AudioMixer* mixer;
+        AudioSampleBank* bank;
+        AudioVoicePool*  pool;
+        AudioMetrics*    metrics;
+        int         poolVoiceCount;
+        SLObjectItf mixerPlayerObject;
+        SLPlayItf   mixerPlay;
+        SLAndroidSimpleBufferQueueItf mixerQueue;
+        AudioMixerOutput* mixerOutput;
+        // closed streams that the audio thread has not detached yet
+        std::vector<AudioStream*> retiredStreams;
     };
 }
 
 void initAudioFunctions();
 
 SQInteger emoLoadAudio(HSQUIRRELVM v);
+SQInteger emoLoadAudioStream(HSQUIRRELVM v);
+SQInteger emoGetAudioStreamStats(HSQUIRRELVM v);
+SQInteger emoPreloadAudioSamples(HSQUIRRELVM v);
+SQInteger emoUnloadAudioSamples(HSQUIRRELVM v);
+SQInteger emoGetAudioPreloadProgress(HSQUIRRELVM v);
+SQInteger emoGetAudioSampleBankStats(HSQUIRRELVM v);
+SQInteger emoSetAudioSampleBudget(HSQUIRRELVM v);
+SQInteger emoPlayAudioVoice(HSQUIRRELVM v);
+SQInteger emoStopAudioVoice(HSQUIRRELVM v);
+SQInteger emoSetAudioVoiceVolume(HSQUIRRELVM v);
+SQInteger emoIsAudioVoicePlaying(HSQUIRRELVM v);
+SQInteger emoSetAudioVoiceCategoryLimit(HSQUIRRELVM v);
+SQInteger emoSetAudioVoiceStealPolicy(HSQUIRRELVM v);
+SQInteger emoGetAudioVoicePoolStats(HSQUIRRELVM v);
+SQInteger emoGetAudioLatencyStats(HSQUIRRELVM v);
+SQInteger emoResetAudioLatencyStats(HSQUIRRELVM v);
 SQInteger emoCreateAudioEngine(HSQUIRRELVM v);
 SQInteger emoPlayAudioChannel(HSQUIRRELVM v);
 SQInteger emoResumeAudioChannel(HSQUIRRELVM v);
@@ -106,5 +156,6 @@ SQInteger emoGetAudioChannelLooping(HSQUIRRELVM v);
 SQInteger emoGetAudioChannelState(HSQUIRRELVM v);
 
 SQInteger emoGetAudioChannelCount(HSQUIRRELVM v);
+SQInteger emoSetAudioResampler(HSQUIRRELVM v);
 SQInteger emoAudioVibrate(HSQUIRRELVM v);
 #endif // EMO_AUDIO_H
@@ -0,0 +1,343 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Audio_bank.h"
+
+namespace emo {
+
+    AudioSampleBank::AudioSampleBank(AudioSampleDecoder decoder, size_t budget) {
+        this->decoder   = decoder;
+        this->budget    = budget;
+        this->bytes     = 0;
+        this->clock     = 0;
+        this->hits      = 0;
+        this->misses    = 0;
+        this->evictions = 0;
+        this->activeWorkers = 0;
+        this->closing   = false;
+
+        pthread_mutex_init(&this->mutex, NULL);
+        pthread_cond_init(&this->loaded, NULL);
+    }
+
+    /*
+     * waits for the preload workers. the channels must have released their samples.
+     */
+    AudioSampleBank::~AudioSampleBank() {
+        pthread_mutex_lock(&this->mutex);
+        this->closing = true;
+        while (this->activeWorkers > 0) {
+            pthread_cond_wait(&this->loaded, &this->mutex);
+        }
+        for (EntryMap::iterator it = this->entries.begin(); it != this->entries.end(); it++) {
+            delete it->second.sample;
+        }
+        this->entries.clear();
+        for (GroupMap::iterator it = this->groups.begin(); it != this->groups.end(); it++) {
+            delete it->second;
+        }
+        this->groups.clear();
+        pthread_mutex_unlock(&this->mutex);
+
+        pthread_cond_destroy(&this->loaded);
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    /*
+     * decode the sample without holding the lock.
+     * the entry is in ENTRY_LOADING state and no one else touches it meanwhile.
+     */
+    AudioSample* AudioSampleBank::decode(const std::string& name) {
+        pthread_mutex_unlock(&this->mutex);
+        AudioSample* sample = this->decoder(name.c_str());
+        pthread_mutex_lock(&this->mutex);
+
+        EntryMap::iterator it = this->entries.find(name);
+        if (sample == NULL) {
+            this->entries.erase(it);
+        } else {
+            it->second.sample   = sample;
+            it->second.state    = ENTRY_READY;
+            it->second.lastUsed = ++this->clock;
+            this->bytes += sample->data.size() * sizeof(int16_t);
+        }
+        pthread_cond_broadcast(&this->loaded);
+        return sample;
+    }
+
+    /*
+     * returns the shared sample, decoding it on a miss.
+     * waits if the sample is being decoded by a preload worker.
+     * the caller must release the sample.
+     */
+    AudioSample* AudioSampleBank::acquire(const std::string& name) {
+        pthread_mutex_lock(&this->mutex);
+        AudioSample* sample = NULL;
+        while (true) {
+            EntryMap::iterator it = this->entries.find(name);
+            if (it == this->entries.end() || it->second.state == ENTRY_QUEUED) {
+                if (it == this->entries.end()) {
+                    Entry entry;
+                    entry.sample   = NULL;
+                    entry.refs     = 0;
+                    entry.pins     = 0;
+                    entry.lastUsed = 0;
+                    it = this->entries.insert(EntryMap::value_type(name, entry)).first;
+                }
+                it->second.state = ENTRY_LOADING;
+                this->misses++;
+                sample = this->decode(name);
+                if (sample == NULL) break;
+                it = this->entries.find(name);
+            } else if (it->second.state == ENTRY_LOADING) {
+                pthread_cond_wait(&this->loaded, &this->mutex);
+                continue;
+            } else {
+                this->hits++;
+            }
+            it->second.refs++;
+            it->second.lastUsed = ++this->clock;
+            sample = it->second.sample;
+            break;
+        }
+        this->evict();
+        pthread_mutex_unlock(&this->mutex);
+        return sample;
+    }
+
+    void AudioSampleBank::release(AudioSample* sample) {
+        if (sample == NULL) return;
+        pthread_mutex_lock(&this->mutex);
+        for (EntryMap::iterator it = this->entries.begin(); it != this->entries.end(); it++) {
+            if (it->second.sample == sample) {
+                it->second.refs--;
+                it->second.lastUsed = ++this->clock;
+                break;
+            }
+        }
+        this->evict();
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    /*
+     * start decoding the named samples on worker threads and pin them
+     * until the group is unloaded. returns immediately.
+     */
+    bool AudioSampleBank::preload(const std::string& group, const std::vector<std::string>& names, int workers) {
+        this->unload(group);
+
+        if (workers < 1) workers = 1;
+        if (workers > AUDIO_BANK_MAX_WORKERS) workers = AUDIO_BANK_MAX_WORKERS;
+        if (workers > (int)names.size()) workers = names.size();
+
+        pthread_mutex_lock(&this->mutex);
+
+        Group* g = new Group();
+        g->bank     = this;
+        g->names    = names;
+        g->next     = 0;
+        g->workers  = 0;
+        g->unloaded = false;
+        g->progress.total  = names.size();
+        g->progress.loaded = 0;
+        g->progress.failed = 0;
+        this->groups[group] = g;
+
+        for (size_t i = 0; i < names.size(); i++) {
+            EntryMap::iterator it = this->entries.find(names[i]);
+            if (it == this->entries.end()) {
+                Entry entry;
+                entry.sample   = NULL;
+                entry.state    = ENTRY_QUEUED;
+                entry.refs     = 0;
+                entry.pins     = 0;
+                entry.lastUsed = 0;
+                it = this->entries.insert(EntryMap::value_type(names[i], entry)).first;
+            }
+            it->second.pins++;
+        }
+
+        bool result = true;
+        for (int i = 0; i < workers; i++) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, workerThread, g) != 0) {
+                result = false;
+                break;
+            }
+            pthread_detach(thread);
+            g->workers++;
+            this->activeWorkers++;
+        }
+        // nothing to wait for
+        if (g->workers == 0 && !names.empty()) {
+            result = false;
+        }
+
+        pthread_mutex_unlock(&this->mutex);
+        return result;
+    }
+
+    void AudioSampleBank::worker(Group* group) {
+        pthread_mutex_lock(&this->mutex);
+        while (!this->closing && !group->unloaded && group->next < group->names.size()) {
+            const std::string& name = group->names[group->next++];
+
+            EntryMap::iterator it = this->entries.find(name);
+            while (it != this->entries.end() && it->second.state == ENTRY_LOADING) {
+                pthread_cond_wait(&this->loaded, &this->mutex);
+                it = this->entries.find(name);
+            }
+
+            bool ok = false;
+            if (it != this->entries.end() && it->second.state == ENTRY_QUEUED) {
+                it->second.state = ENTRY_LOADING;
+                ok = this->decode(name) != NULL;
+            } else {
+                ok = (it != this->entries.end());
+            }
+            if (ok) {
+                group->progress.loaded++;
+            } else {
+                group->progress.failed++;
+            }
+        }
+
+        group->workers--;
+        if (group->unloaded && group->workers == 0) {
+            delete group;
+        }
+        this->activeWorkers--;
+        this->evict();
+        pthread_cond_broadcast(&this->loaded);
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void* AudioSampleBank::workerThread(void* arg) {
+        Group* group = (Group*)arg;
+        group->bank->worker(group);
+        return NULL;
+    }
+
+    /*
+     * unpin the group names and free the samples no channel uses
+     */
+    void AudioSampleBank::unpin(Group* group) {
+        for (size_t i = 0; i < group->names.size(); i++) {
+            EntryMap::iterator it = this->entries.find(group->names[i]);
+            if (it == this->entries.end()) continue;
+            Entry* entry = &it->second;
+            entry->pins--;
+            if (entry->pins > 0 || entry->refs > 0 || entry->state == ENTRY_LOADING) continue;
+            // a detached voice may still be reading it. evict() drops it later.
+            if (entry->sample != NULL && entry->sample->isMixing()) continue;
+            if (entry->sample != NULL) {
+                this->bytes -= entry->sample->data.size() * sizeof(int16_t);
+                delete entry->sample;
+            }
+            this->entries.erase(it);
+        }
+    }
+
+    bool AudioSampleBank::unload(const std::string& group) {
+        pthread_mutex_lock(&this->mutex);
+        GroupMap::iterator it = this->groups.find(group);
+        bool result = (it != this->groups.end());
+        if (result) {
+            Group* g = it->second;
+            this->groups.erase(it);
+            this->unpin(g);
+            g->unloaded = true;
+            if (g->workers == 0) {
+                delete g;
+            }
+        }
+        pthread_mutex_unlock(&this->mutex);
+        return result;
+    }
+
+    bool AudioSampleBank::getProgress(const std::string& group, AudioPreloadProgress* progress) {
+        pthread_mutex_lock(&this->mutex);
+        GroupMap::iterator it = this->groups.find(group);
+        bool result = (it != this->groups.end());
+        if (result) {
+            *progress = it->second->progress;
+        }
+        pthread_mutex_unlock(&this->mutex);
+        return result;
+    }
+
+    void AudioSampleBank::setBudget(size_t budget) {
+        pthread_mutex_lock(&this->mutex);
+        this->budget = budget;
+        this->evict();
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    /*
+     * drop the least recently used samples that are neither played nor pinned
+     * until the bank fits the budget. samples that the audio thread has not
+     * detached yet are kept until a later call. called with the lock held.
+     */
+    void AudioSampleBank::evict() {
+        while (this->bytes > this->budget) {
+            EntryMap::iterator oldest = this->entries.end();
+            for (EntryMap::iterator it = this->entries.begin(); it != this->entries.end(); it++) {
+                const Entry& entry = it->second;
+                if (entry.state != ENTRY_READY || entry.refs > 0 || entry.pins > 0) continue;
+                if (entry.sample->isMixing()) continue;
+                if (oldest == this->entries.end() || entry.lastUsed < oldest->second.lastUsed) {
+                    oldest = it;
+                }
+            }
+            if (oldest == this->entries.end()) break;
+
+            this->bytes -= oldest->second.sample->data.size() * sizeof(int16_t);
+            delete oldest->second.sample;
+            this->entries.erase(oldest);
+            this->evictions++;
+        }
+    }
+
+    void AudioSampleBank::getStats(AudioSampleBankStats* stats) {
+        pthread_mutex_lock(&this->mutex);
+        stats->sampleCount = 0;
+        stats->loading     = 0;
+        for (EntryMap::iterator it = this->entries.begin(); it != this->entries.end(); it++) {
+            if (it->second.state == ENTRY_READY) {
+                stats->sampleCount++;
+            } else {
+                stats->loading++;
+            }
+        }
+        stats->bytes     = this->bytes;
+        stats->budget    = this->budget;
+        stats->hits      = this->hits;
+        stats->misses    = this->misses;
+        stats->evictions = this->evictions;
+        pthread_mutex_unlock(&this->mutex);
+    }
+}
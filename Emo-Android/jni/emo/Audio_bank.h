@@ -0,0 +1,134 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_AUDIO_BANK_H
+#define EMO_AUDIO_BANK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "Audio_mixer.h"
+
+#define AUDIO_BANK_DEFAULT_BUDGET  (8 * 1024 * 1024)
+#define AUDIO_BANK_DEFAULT_WORKERS 2
+#define AUDIO_BANK_MAX_WORKERS     4
+
+/*
+ * Bank of decoded samples shared by the mixer channels.
+ * Samples are reference counted: any number of channels play the same
+ * buffer. Groups of samples are preloaded in parallel on worker threads
+ * and stay pinned until the group is unloaded. Unused and unpinned
+ * samples are evicted in LRU order when the bank exceeds its byte budget.
+ * The decoder reads the platform asset (AAssetManager on Android).
+ */
+namespace emo {
+    typedef AudioSample* (*AudioSampleDecoder)(const char* name);
+
+    struct AudioSampleBankStats {
+        uint32_t sampleCount;
+        uint32_t bytes;
+        uint32_t budget;
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t evictions;
+        uint32_t loading;
+    };
+
+    struct AudioPreloadProgress {
+        int total;
+        int loaded;
+        int failed;
+    };
+
+    class AudioSampleBank {
+    public:
+        AudioSampleBank(AudioSampleDecoder decoder, size_t budget);
+        ~AudioSampleBank();
+
+        AudioSample* acquire(const std::string& name);
+        void release(AudioSample* sample);
+
+        bool preload(const std::string& group, const std::vector<std::string>& names, int workers);
+        bool unload(const std::string& group);
+        bool getProgress(const std::string& group, AudioPreloadProgress* progress);
+
+        void setBudget(size_t budget);
+        void getStats(AudioSampleBankStats* stats);
+    protected:
+        enum EntryState {
+            ENTRY_QUEUED,
+            ENTRY_LOADING,
+            ENTRY_READY
+        };
+
+        struct Entry {
+            AudioSample* sample;
+            EntryState state;
+            int      refs;
+            int      pins;
+            uint32_t lastUsed;
+        };
+
+        struct Group {
+            AudioSampleBank* bank;
+            std::vector<std::string> names;
+            size_t next;
+            int    workers;
+            bool   unloaded;
+            AudioPreloadProgress progress;
+        };
+
+        typedef std::map<std::string, Entry> EntryMap;
+        typedef std::map<std::string, Group*> GroupMap;
+
+        AudioSampleDecoder decoder;
+        EntryMap entries;
+        GroupMap groups;
+        size_t   budget;
+        size_t   bytes;
+        uint32_t clock;
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t evictions;
+        int      activeWorkers;
+        bool     closing;
+
+        pthread_mutex_t mutex;
+        pthread_cond_t  loaded;
+
+        AudioSample* decode(const std::string& name);
+        void unpin(Group* group);
+        void evict();
+        void worker(Group* group);
+
+        static void* workerThread(void* arg);
+    };
+}
+#endif
@@ -0,0 +1,357 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include <math.h>
+#include <string.h>
+#include "Audio_kernels.h"
+
+#if defined(EMO_AUDIO_NEON)
+#include <cpu-features.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define FRAC_SCALE (1.0f / 16777216.0f)
+
+namespace emo {
+
+    AudioAccumulateFunc     audioAccumulate        = audioAccumulateScalar;
+    AudioAccumulateRampFunc audioAccumulateRamp    = audioAccumulateRampScalar;
+    AudioFloatToInt16Func   audioFloatToInt16      = audioFloatToInt16Scalar;
+    AudioResampleFunc       audioResampleLinear    = audioResampleLinearScalar;
+    AudioResampleFunc       audioResamplePolyphase = audioResamplePolyphaseScalar;
+
+    float audioPolyphaseTable[AUDIO_POLYPHASE_PHASES][AUDIO_POLYPHASE_TAPS];
+    float audioPolyphaseTableStereo[AUDIO_POLYPHASE_PHASES][AUDIO_POLYPHASE_TAPS * 2];
+
+    static const char* audioKernelsName = "scalar";
+    static bool audioKernelsInitialized = false;
+
+    /*
+     * build the Blackman windowed sinc filter for each fractional phase.
+     * tap k weights the input frame (index - 3 + k).
+     */
+    static void initPolyphaseTable() {
+        const double cutoff = 0.9;
+        const double half   = AUDIO_POLYPHASE_TAPS / 2;
+        for (int phase = 0; phase < AUDIO_POLYPHASE_PHASES; phase++) {
+            double frac = (double)phase / AUDIO_POLYPHASE_PHASES;
+            double coefs[AUDIO_POLYPHASE_TAPS];
+            double sum = 0;
+            for (int k = 0; k < AUDIO_POLYPHASE_TAPS; k++) {
+                double t = (k - (half - 1)) - frac;
+                double x = M_PI * t * cutoff;
+                double sinc = (x == 0) ? 1.0 : sin(x) / x;
+                double window = 0.42 + 0.5 * cos(M_PI * t / half) + 0.08 * cos(2 * M_PI * t / half);
+                coefs[k] = sinc * window;
+                sum += coefs[k];
+            }
+            for (int k = 0; k < AUDIO_POLYPHASE_TAPS; k++) {
+                float coef = (float)(coefs[k] / sum);
+                audioPolyphaseTable[phase][k] = coef;
+                audioPolyphaseTableStereo[phase][k * 2]     = coef;
+                audioPolyphaseTableStereo[phase][k * 2 + 1] = coef;
+            }
+        }
+    }
+
+    /*
+     * select the kernels for this CPU. called once before the mixer starts.
+     */
+    void initAudioKernels() {
+        if (audioKernelsInitialized) return;
+        audioKernelsInitialized = true;
+
+        initPolyphaseTable();
+
+#if defined(EMO_AUDIO_NEON)
+        if (android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+                (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
+            audioAccumulate        = audioAccumulateNeon;
+            audioAccumulateRamp    = audioAccumulateRampNeon;
+            audioFloatToInt16      = audioFloatToInt16Neon;
+            audioResampleLinear    = audioResampleLinearNeon;
+            audioResamplePolyphase = audioResamplePolyphaseNeon;
+            audioKernelsName = "neon";
+        }
+#elif defined(__SSE2__)
+        audioAccumulate        = audioAccumulateSSE2;
+        audioAccumulateRamp    = audioAccumulateRampSSE2;
+        audioFloatToInt16      = audioFloatToInt16SSE2;
+        audioResampleLinear    = audioResampleLinearSSE2;
+        audioResamplePolyphase = audioResamplePolyphaseSSE2;
+        audioKernelsName = "sse2";
+#endif
+    }
+
+    const char* getAudioKernelsName() {
+        return audioKernelsName;
+    }
+
+    /*
+     * scalar reference implementations.
+     * the SIMD kernels use the same arithmetic so that they produce
+     * the same results except for the summation order of the polyphase filter.
+     */
+    void audioAccumulateScalar(float* out, const float* in, int count, float gain) {
+        for (int i = 0; i < count; i++) {
+            out[i] += in[i] * gain;
+        }
+    }
+
+    /*
+     * accumulate interleaved stereo frames with the gain ramping linearly
+     * from startGain towards endGain to avoid clicks on volume changes
+     */
+    void audioAccumulateRampScalar(float* out, const float* in, int frames, float startGain, float endGain) {
+        if (frames <= 0) return;
+        float delta = (endGain - startGain) / frames;
+        for (int i = 0; i < frames; i++) {
+            float gain = startGain + delta * (float)i;
+            out[i * 2]     += in[i * 2]     * gain;
+            out[i * 2 + 1] += in[i * 2 + 1] * gain;
+        }
+    }
+
+    /*
+     * saturate and round half away from zero
+     */
+    void audioFloatToInt16Scalar(int16_t* out, const float* in, int count) {
+        for (int i = 0; i < count; i++) {
+            float value = in[i];
+            if (value > 32767.0f)  value = 32767.0f;
+            if (value < -32768.0f) value = -32768.0f;
+            out[i] = (int16_t)(value + (value < 0 ? -0.5f : 0.5f));
+        }
+    }
+
+    int audioResampleLinearScalar(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                  uint64_t* position, uint64_t step) {
+        if (frames < 2) return 0;
+        const uint64_t limit = (uint64_t)(frames - 1) << 32;
+        uint64_t pos = *position;
+        int i = 0;
+        for (; i < outFrames && pos < limit; i++) {
+            uint32_t index = pos >> 32;
+            float frac = ((uint32_t)pos >> 8) * FRAC_SCALE;
+            if (channels == 2) {
+                float left0  = in[index * 2];
+                float right0 = in[index * 2 + 1];
+                float left1  = in[index * 2 + 2];
+                float right1 = in[index * 2 + 3];
+                out[i * 2]     = left0  + (left1  - left0)  * frac;
+                out[i * 2 + 1] = right0 + (right1 - right0) * frac;
+            } else {
+                float value0 = in[index];
+                float value1 = in[index + 1];
+                float value  = value0 + (value1 - value0) * frac;
+                out[i * 2]     = value;
+                out[i * 2 + 1] = value;
+            }
+            pos += step;
+        }
+        *position = pos;
+        return i;
+    }
+
+    int audioResamplePolyphaseScalar(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                     uint64_t* position, uint64_t step) {
+        const int before = AUDIO_POLYPHASE_TAPS / 2 - 1;
+        const int after  = AUDIO_POLYPHASE_TAPS / 2;
+        if (frames <= before + after) return 0;
+        const uint64_t first = (uint64_t)before << 32;
+        const uint64_t limit = (uint64_t)(frames - after) << 32;
+        uint64_t pos = *position;
+        if (pos < first) return 0;
+        int i = 0;
+        for (; i < outFrames && pos < limit; i++) {
+            uint32_t index = pos >> 32;
+            const float* coefs = audioPolyphaseTable[(uint32_t)pos >> (32 - 5)];
+            const int16_t* src = in + (index - before) * channels;
+            if (channels == 2) {
+                float left = 0, right = 0;
+                for (int k = 0; k < AUDIO_POLYPHASE_TAPS; k++) {
+                    left  += src[k * 2]     * coefs[k];
+                    right += src[k * 2 + 1] * coefs[k];
+                }
+                out[i * 2]     = left;
+                out[i * 2 + 1] = right;
+            } else {
+                float value = 0;
+                for (int k = 0; k < AUDIO_POLYPHASE_TAPS; k++) {
+                    value += src[k] * coefs[k];
+                }
+                out[i * 2]     = value;
+                out[i * 2 + 1] = value;
+            }
+            pos += step;
+        }
+        *position = pos;
+        return i;
+    }
+
+#if defined(__SSE2__)
+    void audioAccumulateSSE2(float* out, const float* in, int count, float gain) {
+        __m128 g = _mm_set1_ps(gain);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128 a = _mm_add_ps(_mm_loadu_ps(out + i),     _mm_mul_ps(_mm_loadu_ps(in + i),     g));
+            __m128 b = _mm_add_ps(_mm_loadu_ps(out + i + 4), _mm_mul_ps(_mm_loadu_ps(in + i + 4), g));
+            _mm_storeu_ps(out + i,     a);
+            _mm_storeu_ps(out + i + 4, b);
+        }
+        audioAccumulateScalar(out + i, in + i, count - i, gain);
+    }
+
+    void audioAccumulateRampSSE2(float* out, const float* in, int frames, float startGain, float endGain) {
+        if (frames <= 0) return;
+        float delta = (endGain - startGain) / frames;
+        __m128 start = _mm_set1_ps(startGain);
+        __m128 d     = _mm_set1_ps(delta);
+        __m128 index = _mm_set_ps(1, 1, 0, 0);
+        __m128 two   = _mm_set1_ps(2);
+        int i = 0;
+        for (; i + 2 <= frames; i += 2) {
+            __m128 gain = _mm_add_ps(start, _mm_mul_ps(d, index));
+            __m128 sum  = _mm_add_ps(_mm_loadu_ps(out + i * 2), _mm_mul_ps(_mm_loadu_ps(in + i * 2), gain));
+            _mm_storeu_ps(out + i * 2, sum);
+            index = _mm_add_ps(index, two);
+        }
+        for (; i < frames; i++) {
+            float gain = startGain + delta * (float)i;
+            out[i * 2]     += in[i * 2]     * gain;
+            out[i * 2 + 1] += in[i * 2 + 1] * gain;
+        }
+    }
+
+    void audioFloatToInt16SSE2(int16_t* out, const float* in, int count) {
+        const __m128 maxValue = _mm_set1_ps(32767.0f);
+        const __m128 minValue = _mm_set1_ps(-32768.0f);
+        const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+        const __m128 half     = _mm_set1_ps(0.5f);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128 a = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i),     maxValue), minValue);
+            __m128 b = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i + 4), maxValue), minValue);
+            a = _mm_add_ps(a, _mm_or_ps(half, _mm_and_ps(a, signMask)));
+            b = _mm_add_ps(b, _mm_or_ps(half, _mm_and_ps(b, signMask)));
+            __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+            _mm_storeu_si128((__m128i*)(out + i), packed);
+        }
+        audioFloatToInt16Scalar(out + i, in + i, count - i);
+    }
+
+    int audioResampleLinearSSE2(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                uint64_t* position, uint64_t step) {
+        if (frames < 2) return 0;
+        const uint64_t limit = (uint64_t)(frames - 1) << 32;
+        const __m128 scale = _mm_set1_ps(FRAC_SCALE);
+        uint64_t pos = *position;
+        int i = 0;
+        if (channels == 2) {
+            // two stereo frames per iteration: (L, R, L, R)
+            for (; i + 2 <= outFrames && pos + step < limit; i += 2) {
+                uint64_t pos1 = pos + step;
+                uint32_t index0 = pos >> 32;
+                uint32_t index1 = pos1 >> 32;
+                __m128 v0 = _mm_set_ps(in[index1 * 2 + 1], in[index1 * 2], in[index0 * 2 + 1], in[index0 * 2]);
+                __m128 v1 = _mm_set_ps(in[index1 * 2 + 3], in[index1 * 2 + 2], in[index0 * 2 + 3], in[index0 * 2 + 2]);
+                int frac0 = (uint32_t)pos  >> 8;
+                int frac1 = (uint32_t)pos1 >> 8;
+                __m128 frac = _mm_mul_ps(_mm_cvtepi32_ps(_mm_set_epi32(frac1, frac1, frac0, frac0)), scale);
+                _mm_storeu_ps(out + i * 2, _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), frac)));
+                pos = pos1 + step;
+            }
+        } else {
+            // four mono frames per iteration, duplicated to both channels
+            for (; i + 4 <= outFrames && pos + step * 3 < limit; i += 4) {
+                uint64_t pos1 = pos  + step;
+                uint64_t pos2 = pos1 + step;
+                uint64_t pos3 = pos2 + step;
+                uint32_t index0 = pos >> 32, index1 = pos1 >> 32, index2 = pos2 >> 32, index3 = pos3 >> 32;
+                __m128 v0 = _mm_set_ps(in[index3],     in[index2],     in[index1],     in[index0]);
+                __m128 v1 = _mm_set_ps(in[index3 + 1], in[index2 + 1], in[index1 + 1], in[index0 + 1]);
+                __m128i fracs = _mm_set_epi32((uint32_t)pos3 >> 8, (uint32_t)pos2 >> 8,
+                                              (uint32_t)pos1 >> 8, (uint32_t)pos  >> 8);
+                __m128 frac  = _mm_mul_ps(_mm_cvtepi32_ps(fracs), scale);
+                __m128 value = _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), frac));
+                _mm_storeu_ps(out + i * 2,     _mm_unpacklo_ps(value, value));
+                _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(value, value));
+                pos = pos3 + step;
+            }
+        }
+        *position = pos;
+        return i + audioResampleLinearScalar(out + i * 2, outFrames - i, in, channels, frames, position, step);
+    }
+
+    static inline __m128 loadInt16x4(const int16_t* src) {
+        __m128i value = _mm_loadl_epi64((const __m128i*)src);
+        return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16));
+    }
+
+    int audioResamplePolyphaseSSE2(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                   uint64_t* position, uint64_t step) {
+        const int before = AUDIO_POLYPHASE_TAPS / 2 - 1;
+        const int after  = AUDIO_POLYPHASE_TAPS / 2;
+        if (frames <= before + after) return 0;
+        const uint64_t first = (uint64_t)before << 32;
+        const uint64_t limit = (uint64_t)(frames - after) << 32;
+        uint64_t pos = *position;
+        if (pos < first) return 0;
+        int i = 0;
+        for (; i < outFrames && pos < limit; i++) {
+            uint32_t index = pos >> 32;
+            uint32_t phase = (uint32_t)pos >> (32 - 5);
+            const int16_t* src = in + (index - before) * channels;
+            float result[4];
+            if (channels == 2) {
+                const float* coefs = audioPolyphaseTableStereo[phase];
+                __m128 sum = _mm_mul_ps(loadInt16x4(src), _mm_loadu_ps(coefs));
+                sum = _mm_add_ps(sum, _mm_mul_ps(loadInt16x4(src + 4),  _mm_loadu_ps(coefs + 4)));
+                sum = _mm_add_ps(sum, _mm_mul_ps(loadInt16x4(src + 8),  _mm_loadu_ps(coefs + 8)));
+                sum = _mm_add_ps(sum, _mm_mul_ps(loadInt16x4(src + 12), _mm_loadu_ps(coefs + 12)));
+                _mm_storeu_ps(result, sum);
+                out[i * 2]     = result[0] + result[2];
+                out[i * 2 + 1] = result[1] + result[3];
+            } else {
+                const float* coefs = audioPolyphaseTable[phase];
+                __m128 sum = _mm_mul_ps(loadInt16x4(src), _mm_loadu_ps(coefs));
+                sum = _mm_add_ps(sum, _mm_mul_ps(loadInt16x4(src + 4), _mm_loadu_ps(coefs + 4)));
+                _mm_storeu_ps(result, sum);
+                float value = (result[0] + result[1]) + (result[2] + result[3]);
+                out[i * 2]     = value;
+                out[i * 2 + 1] = value;
+            }
+            pos += step;
+        }
+        *position = pos;
+        return i;
+    }
+#endif
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_AUDIO_KERNELS_H
+#define EMO_AUDIO_KERNELS_H
+
+#include <stdint.h>
+
+#define AUDIO_POLYPHASE_TAPS   8
+#define AUDIO_POLYPHASE_PHASES 32
+
+#define AUDIO_RESAMPLE_LINEAR    0
+#define AUDIO_RESAMPLE_POLYPHASE 1
+
+/*
+ * Mixing kernels of the software mixer.
+ *
+ * The mixer buffers are interleaved stereo floats in 16bit sample range.
+ * Resamplers read 16bit PCM (mono or interleaved stereo) at the 32.32
+ * fixed point frame position, advance it by step per output frame and
+ * return the number of frames produced. They stop before reading past
+ * the end of the input, so the caller handles the last frames and loops.
+ *
+ * The dispatched kernels point to the NEON or SSE2 implementation when
+ * the CPU supports it, or to the scalar reference implementation.
+ */
+namespace emo {
+    typedef void (*AudioAccumulateFunc)(float* out, const float* in, int count, float gain);
+    typedef void (*AudioAccumulateRampFunc)(float* out, const float* in, int frames, float startGain, float endGain);
+    typedef void (*AudioFloatToInt16Func)(int16_t* out, const float* in, int count);
+    typedef int  (*AudioResampleFunc)(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                      uint64_t* position, uint64_t step);
+
+    void initAudioKernels();
+    const char* getAudioKernelsName();
+
+    extern AudioAccumulateFunc     audioAccumulate;
+    extern AudioAccumulateRampFunc audioAccumulateRamp;
+    extern AudioFloatToInt16Func   audioFloatToInt16;
+    extern AudioResampleFunc       audioResampleLinear;
+    extern AudioResampleFunc       audioResamplePolyphase;
+
+    extern float audioPolyphaseTable[AUDIO_POLYPHASE_PHASES][AUDIO_POLYPHASE_TAPS];
+    extern float audioPolyphaseTableStereo[AUDIO_POLYPHASE_PHASES][AUDIO_POLYPHASE_TAPS * 2];
+
+    void audioAccumulateScalar(float* out, const float* in, int count, float gain);
+    void audioAccumulateRampScalar(float* out, const float* in, int frames, float startGain, float endGain);
+    void audioFloatToInt16Scalar(int16_t* out, const float* in, int count);
+    int  audioResampleLinearScalar(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                   uint64_t* position, uint64_t step);
+    int  audioResamplePolyphaseScalar(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                      uint64_t* position, uint64_t step);
+
+#if defined(EMO_AUDIO_NEON)
+    void audioAccumulateNeon(float* out, const float* in, int count, float gain);
+    void audioAccumulateRampNeon(float* out, const float* in, int frames, float startGain, float endGain);
+    void audioFloatToInt16Neon(int16_t* out, const float* in, int count);
+    int  audioResampleLinearNeon(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                 uint64_t* position, uint64_t step);
+    int  audioResamplePolyphaseNeon(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                    uint64_t* position, uint64_t step);
+#endif
+
+#if defined(__SSE2__)
+    void audioAccumulateSSE2(float* out, const float* in, int count, float gain);
+    void audioAccumulateRampSSE2(float* out, const float* in, int frames, float startGain, float endGain);
+    void audioFloatToInt16SSE2(int16_t* out, const float* in, int count);
+    int  audioResampleLinearSSE2(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                 uint64_t* position, uint64_t step);
+    int  audioResamplePolyphaseSSE2(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                    uint64_t* position, uint64_t step);
+#endif
+}
+#endif
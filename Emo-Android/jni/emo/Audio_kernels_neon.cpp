@@ -0,0 +1,181 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Audio_kernels.h"
+
+/*
+ * NEON kernels. This file is compiled with NEON enabled only on armeabi-v7a,
+ * and the kernels are selected at runtime by initAudioKernels().
+ */
+#if defined(EMO_AUDIO_NEON) && defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+#define FRAC_SCALE (1.0f / 16777216.0f)
+
+namespace emo {
+
+    void audioAccumulateNeon(float* out, const float* in, int count, float gain) {
+        float32x4_t g = vdupq_n_f32(gain);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            float32x4_t a = vld1q_f32(out + i);
+            float32x4_t b = vld1q_f32(out + i + 4);
+            a = vaddq_f32(a, vmulq_f32(vld1q_f32(in + i),     g));
+            b = vaddq_f32(b, vmulq_f32(vld1q_f32(in + i + 4), g));
+            vst1q_f32(out + i,     a);
+            vst1q_f32(out + i + 4, b);
+        }
+        audioAccumulateScalar(out + i, in + i, count - i, gain);
+    }
+
+    void audioAccumulateRampNeon(float* out, const float* in, int frames, float startGain, float endGain) {
+        if (frames <= 0) return;
+        float delta = (endGain - startGain) / frames;
+        static const float initial[4] = { 0, 0, 1, 1 };
+        float32x4_t start = vdupq_n_f32(startGain);
+        float32x4_t d     = vdupq_n_f32(delta);
+        float32x4_t index = vld1q_f32(initial);
+        float32x4_t two   = vdupq_n_f32(2);
+        int i = 0;
+        for (; i + 2 <= frames; i += 2) {
+            float32x4_t gain = vaddq_f32(start, vmulq_f32(d, index));
+            float32x4_t sum  = vaddq_f32(vld1q_f32(out + i * 2), vmulq_f32(vld1q_f32(in + i * 2), gain));
+            vst1q_f32(out + i * 2, sum);
+            index = vaddq_f32(index, two);
+        }
+        for (; i < frames; i++) {
+            float gain = startGain + delta * (float)i;
+            out[i * 2]     += in[i * 2]     * gain;
+            out[i * 2 + 1] += in[i * 2 + 1] * gain;
+        }
+    }
+
+    void audioFloatToInt16Neon(int16_t* out, const float* in, int count) {
+        const float32x4_t maxValue = vdupq_n_f32(32767.0f);
+        const float32x4_t minValue = vdupq_n_f32(-32768.0f);
+        const uint32x4_t  signMask = vdupq_n_u32(0x80000000);
+        const uint32x4_t  half     = vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            float32x4_t a = vmaxq_f32(vminq_f32(vld1q_f32(in + i),     maxValue), minValue);
+            float32x4_t b = vmaxq_f32(vminq_f32(vld1q_f32(in + i + 4), maxValue), minValue);
+            a = vaddq_f32(a, vreinterpretq_f32_u32(vorrq_u32(half, vandq_u32(vreinterpretq_u32_f32(a), signMask))));
+            b = vaddq_f32(b, vreinterpretq_f32_u32(vorrq_u32(half, vandq_u32(vreinterpretq_u32_f32(b), signMask))));
+            int16x4_t lo = vqmovn_s32(vcvtq_s32_f32(a));
+            int16x4_t hi = vqmovn_s32(vcvtq_s32_f32(b));
+            vst1q_s16(out + i, vcombine_s16(lo, hi));
+        }
+        audioFloatToInt16Scalar(out + i, in + i, count - i);
+    }
+
+    int audioResampleLinearNeon(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                uint64_t* position, uint64_t step) {
+        if (frames < 2) return 0;
+        const uint64_t limit = (uint64_t)(frames - 1) << 32;
+        const float32x4_t scale = vdupq_n_f32(FRAC_SCALE);
+        uint64_t pos = *position;
+        float v0[4], v1[4];
+        int32_t fracs[4];
+        int i = 0;
+        if (channels == 2) {
+            for (; i + 2 <= outFrames && pos + step < limit; i += 2) {
+                uint64_t pos1 = pos + step;
+                const int16_t* src0 = in + (pos  >> 32) * 2;
+                const int16_t* src1 = in + (pos1 >> 32) * 2;
+                v0[0] = src0[0]; v0[1] = src0[1]; v0[2] = src1[0]; v0[3] = src1[1];
+                v1[0] = src0[2]; v1[1] = src0[3]; v1[2] = src1[2]; v1[3] = src1[3];
+                fracs[0] = fracs[1] = (uint32_t)pos  >> 8;
+                fracs[2] = fracs[3] = (uint32_t)pos1 >> 8;
+                float32x4_t a = vld1q_f32(v0);
+                float32x4_t b = vld1q_f32(v1);
+                float32x4_t frac = vmulq_f32(vcvtq_f32_s32(vld1q_s32(fracs)), scale);
+                vst1q_f32(out + i * 2, vaddq_f32(a, vmulq_f32(vsubq_f32(b, a), frac)));
+                pos = pos1 + step;
+            }
+        } else {
+            for (; i + 4 <= outFrames && pos + step * 3 < limit; i += 4) {
+                for (int k = 0; k < 4; k++) {
+                    uint32_t index = pos >> 32;
+                    v0[k] = in[index];
+                    v1[k] = in[index + 1];
+                    fracs[k] = (uint32_t)pos >> 8;
+                    pos += step;
+                }
+                float32x4_t a = vld1q_f32(v0);
+                float32x4_t b = vld1q_f32(v1);
+                float32x4_t frac  = vmulq_f32(vcvtq_f32_s32(vld1q_s32(fracs)), scale);
+                float32x4_t value = vaddq_f32(a, vmulq_f32(vsubq_f32(b, a), frac));
+                float32x4x2_t stereo = vzipq_f32(value, value);
+                vst1q_f32(out + i * 2,     stereo.val[0]);
+                vst1q_f32(out + i * 2 + 4, stereo.val[1]);
+            }
+        }
+        *position = pos;
+        return i + audioResampleLinearScalar(out + i * 2, outFrames - i, in, channels, frames, position, step);
+    }
+
+    static inline float32x4_t loadInt16x4(const int16_t* src) {
+        return vcvtq_f32_s32(vmovl_s16(vld1_s16(src)));
+    }
+
+    int audioResamplePolyphaseNeon(float* out, int outFrames, const int16_t* in, int channels, int frames,
+                                   uint64_t* position, uint64_t step) {
+        const int before = AUDIO_POLYPHASE_TAPS / 2 - 1;
+        const int after  = AUDIO_POLYPHASE_TAPS / 2;
+        if (frames <= before + after) return 0;
+        const uint64_t first = (uint64_t)before << 32;
+        const uint64_t limit = (uint64_t)(frames - after) << 32;
+        uint64_t pos = *position;
+        if (pos < first) return 0;
+        int i = 0;
+        for (; i < outFrames && pos < limit; i++) {
+            uint32_t index = pos >> 32;
+            uint32_t phase = (uint32_t)pos >> (32 - 5);
+            const int16_t* src = in + (index - before) * channels;
+            if (channels == 2) {
+                const float* coefs = audioPolyphaseTableStereo[phase];
+                float32x4_t sum = vmulq_f32(loadInt16x4(src), vld1q_f32(coefs));
+                sum = vmlaq_f32(sum, loadInt16x4(src + 4),  vld1q_f32(coefs + 4));
+                sum = vmlaq_f32(sum, loadInt16x4(src + 8),  vld1q_f32(coefs + 8));
+                sum = vmlaq_f32(sum, loadInt16x4(src + 12), vld1q_f32(coefs + 12));
+                float32x2_t lr = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+                vst1_f32(out + i * 2, lr);
+            } else {
+                const float* coefs = audioPolyphaseTable[phase];
+                float32x4_t sum = vmulq_f32(loadInt16x4(src), vld1q_f32(coefs));
+                sum = vmlaq_f32(sum, loadInt16x4(src + 4), vld1q_f32(coefs + 4));
+                float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+                pair = vpadd_f32(pair, pair);
+                vst1_f32(out + i * 2, pair);
+            }
+            pos += step;
+        }
+        *position = pos;
+        return i;
+    }
+}
+#endif
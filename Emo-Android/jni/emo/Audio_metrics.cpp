@@ -0,0 +1,215 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include <time.h>
+#include <string.h>
+#include "Audio_metrics.h"
+
+static uint64_t monotonicMicros() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static emo::AudioClockFunc audioClock = monotonicMicros;
+
+namespace emo {
+
+    uint64_t audioNow() {
+        return audioClock();
+    }
+
+    /*
+     * replace the clock. NULL restores the monotonic clock.
+     */
+    void setAudioClock(AudioClockFunc clock) {
+        audioClock = (clock != NULL) ? clock : monotonicMicros;
+    }
+
+    AudioMetricWindow::AudioMetricWindow() {
+        this->reset();
+    }
+
+    void AudioMetricWindow::add(float value) {
+        this->values[this->next] = value;
+        this->next = (this->next + 1) % AUDIO_METRICS_WINDOW;
+        if (this->filled < AUDIO_METRICS_WINDOW) this->filled++;
+        this->count++;
+    }
+
+    void AudioMetricWindow::get(AudioRollingStats* stats) {
+        stats->count   = this->count;
+        stats->last    = 0;
+        stats->min     = 0;
+        stats->max     = 0;
+        stats->average = 0;
+        if (this->filled == 0) return;
+
+        stats->last = this->values[(this->next + AUDIO_METRICS_WINDOW - 1) % AUDIO_METRICS_WINDOW];
+        stats->min  = this->values[0];
+        stats->max  = this->values[0];
+        float sum = 0;
+        for (int i = 0; i < this->filled; i++) {
+            float value = this->values[i];
+            if (value < stats->min) stats->min = value;
+            if (value > stats->max) stats->max = value;
+            sum += value;
+        }
+        stats->average = sum / this->filled;
+    }
+
+    void AudioMetricWindow::reset() {
+        this->next   = 0;
+        this->filled = 0;
+        this->count  = 0;
+    }
+
+    AudioMetrics::AudioMetrics(int bufferFrames, int sampleRate) {
+        this->bufferMicros = (uint64_t)bufferFrames * 1000000 / sampleRate;
+        this->lastCallback = 0;
+        this->callbackCount = 0;
+        this->underrunCount = 0;
+        this->streamUnderrunCount = 0;
+        this->streamUnderrunBase  = 0;
+        this->sequence       = 0;
+        this->resetRequested = 0;
+        this->resetApplied   = 0;
+    }
+
+    AudioMetrics::~AudioMetrics() {
+
+    }
+
+    /*
+     * audio thread: open the write section. a pending reset is applied here.
+     */
+    void AudioMetrics::beginWrite() {
+        this->sequence++;
+        __sync_synchronize();
+
+        uint32_t requested = this->resetRequested;
+        if (requested != this->resetApplied) {
+            this->latency.reset();
+            this->period.reset();
+            this->cpu.reset();
+            this->streamFill.reset();
+            this->lastCallback  = 0;
+            this->callbackCount = 0;
+            this->underrunCount = 0;
+            this->streamUnderrunBase = this->streamUnderrunCount;
+            this->resetApplied = requested;
+        }
+    }
+
+    void AudioMetrics::endWrite() {
+        __sync_synchronize();
+        this->sequence++;
+    }
+
+    /*
+     * called by the audio thread after the buffer is enqueued.
+     * the output underruns if the callback comes later than
+     * the audio that was still queued before it.
+     */
+    void AudioMetrics::recordCallback(uint64_t start, uint64_t end, int queuedBuffers) {
+        this->beginWrite();
+        if (this->lastCallback != 0) {
+            uint64_t period = start - this->lastCallback;
+            this->period.add(period);
+            if (period > this->bufferMicros * queuedBuffers) {
+                this->underrunCount++;
+            }
+        }
+        this->lastCallback = start;
+        this->cpu.add(end - start);
+        this->callbackCount++;
+        this->endWrite();
+    }
+
+    void AudioMetrics::recordLatency(uint64_t playTime, uint64_t enqueueTime) {
+        this->beginWrite();
+        this->latency.add(enqueueTime - playTime);
+        this->endWrite();
+    }
+
+    void AudioMetrics::recordStreamFill(float percent) {
+        this->beginWrite();
+        this->streamFill.add(percent);
+        this->endWrite();
+    }
+
+    /*
+     * the total underruns of the attached streams
+     */
+    void AudioMetrics::setStreamUnderrunCount(uint32_t count) {
+        this->beginWrite();
+        // the total drops when a stream is closed
+        if (count < this->streamUnderrunBase) {
+            this->streamUnderrunBase = count;
+        }
+        this->streamUnderrunCount = count;
+        this->endWrite();
+    }
+
+    /*
+     * copy the metrics without blocking the audio thread.
+     * retries while the audio thread is writing.
+     */
+    void AudioMetrics::getSnapshot(AudioMetricsSnapshot* snapshot) {
+        while (true) {
+            uint32_t before = this->sequence;
+            __sync_synchronize();
+            if (before & 1) continue;
+
+            this->latency.get(&snapshot->latency);
+            this->period.get(&snapshot->period);
+            this->cpu.get(&snapshot->cpu);
+            this->streamFill.get(&snapshot->streamFill);
+            snapshot->callbackCount = this->callbackCount;
+            snapshot->underrunCount = this->underrunCount;
+            snapshot->streamUnderrunCount = this->streamUnderrunCount - this->streamUnderrunBase;
+            bool resetPending = (this->resetRequested != this->resetApplied);
+
+            __sync_synchronize();
+            if (this->sequence != before) continue;
+
+            if (resetPending) {
+                memset(snapshot, 0, sizeof(AudioMetricsSnapshot));
+            }
+            return;
+        }
+    }
+
+    /*
+     * caller thread: the audio thread clears the metrics on its next write.
+     * snapshots are empty until then.
+     */
+    void AudioMetrics::reset() {
+        this->resetRequested++;
+        __sync_synchronize();
+    }
+}
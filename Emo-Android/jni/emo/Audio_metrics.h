@@ -0,0 +1,118 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_AUDIO_METRICS_H
+#define EMO_AUDIO_METRICS_H
+
+#include <stdint.h>
+#include <vector>
+
+#define AUDIO_METRICS_WINDOW 128
+
+/*
+ * Timing instrumentation of the software mixer output.
+ * Times are in microseconds from audioNow(), which can be replaced
+ * by setAudioClock() to drive the mixer with a fake clock.
+ * The audio thread is the only writer. Readers copy the values under
+ * a sequence lock, so the audio thread never waits for them.
+ */
+namespace emo {
+    typedef uint64_t (*AudioClockFunc)();
+
+    uint64_t audioNow();
+    void setAudioClock(AudioClockFunc clock);
+
+    struct AudioRollingStats {
+        float    last;
+        float    min;
+        float    max;
+        float    average;
+        uint32_t count;
+    };
+
+    /*
+     * the last AUDIO_METRICS_WINDOW values of a metric
+     */
+    class AudioMetricWindow {
+    public:
+        AudioMetricWindow();
+
+        void add(float value);
+        void get(AudioRollingStats* stats);
+        void reset();
+    protected:
+        float    values[AUDIO_METRICS_WINDOW];
+        int      next;
+        int      filled;
+        uint32_t count;
+    };
+
+    struct AudioMetricsSnapshot {
+        AudioRollingStats latency;     // play() to the enqueue of its first buffer
+        AudioRollingStats period;      // between buffer callbacks
+        AudioRollingStats cpu;         // mixing time per callback
+        AudioRollingStats streamFill;  // lowest stream ring fill in percent
+        uint32_t callbackCount;
+        uint32_t underrunCount;        // callbacks later than the queued audio
+        uint32_t streamUnderrunCount;  // since the last reset
+    };
+
+    class AudioMetrics {
+    public:
+        AudioMetrics(int bufferFrames, int sampleRate);
+        ~AudioMetrics();
+
+        void recordCallback(uint64_t start, uint64_t end, int queuedBuffers);
+        void recordLatency(uint64_t playTime, uint64_t enqueueTime);
+        void recordStreamFill(float percent);
+        void setStreamUnderrunCount(uint32_t count);
+
+        void getSnapshot(AudioMetricsSnapshot* snapshot);
+        void reset();
+    protected:
+        // odd while the audio thread is writing
+        volatile uint32_t sequence;
+        // reset() only requests the reset, the audio thread applies it
+        volatile uint32_t resetRequested;
+        uint32_t resetApplied;
+
+        AudioMetricWindow latency;
+        AudioMetricWindow period;
+        AudioMetricWindow cpu;
+        AudioMetricWindow streamFill;
+        uint64_t lastCallback;
+        uint64_t bufferMicros;
+        uint32_t callbackCount;
+        uint32_t underrunCount;
+        uint32_t streamUnderrunCount;
+        uint32_t streamUnderrunBase;
+
+        void beginWrite();
+        void endWrite();
+    };
+}
+#endif
@@ -0,0 +1,717 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include <string.h>
+#include <unistd.h>
+#include "Constants.h"
+#include "Audio_mixer.h"
+#include "Audio_kernels.h"
+
+static uint32_t readUint32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t readUint16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+namespace emo {
+
+    AudioSample::AudioSample() {
+        this->channels   = 0;
+        this->sampleRate = 0;
+        this->frameCount = 0;
+        this->voiceRefs  = 0;
+    }
+
+    AudioSample::~AudioSample() {
+
+    }
+
+    /*
+     * true while a mixer voice may read the data
+     */
+    bool AudioSample::isMixing() {
+        __sync_synchronize();
+        return this->voiceRefs > 0;
+    }
+
+    /*
+     * decode RIFF WAVE (8bit or 16bit linear PCM, mono or stereo)
+     */
+    bool AudioSample::loadWav(const unsigned char* bytes, size_t size) {
+        if (size < 12 || memcmp(bytes, "RIFF", 4) != 0 || memcmp(bytes + 8, "WAVE", 4) != 0) {
+            return false;
+        }
+
+        int bitsPerSample = 0;
+        const unsigned char* pcm = NULL;
+        size_t pcmSize = 0;
+
+        size_t offset = 12;
+        while (offset + 8 <= size) {
+            const unsigned char* chunk = bytes + offset;
+            size_t chunkSize = readUint32(chunk + 4);
+            if (chunkSize > size - offset - 8) {
+                chunkSize = size - offset - 8;
+            }
+
+            if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+                uint16_t formatTag = readUint16(chunk + 8);
+                if (formatTag != 1 && formatTag != 0xFFFE) return false;
+                this->channels   = readUint16(chunk + 10);
+                this->sampleRate = readUint32(chunk + 12);
+                bitsPerSample    = readUint16(chunk + 22);
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                pcm = chunk + 8;
+                pcmSize = chunkSize;
+            }
+            // chunks are word aligned
+            offset += 8 + chunkSize + (chunkSize & 1);
+        }
+
+        if (pcm == NULL || this->sampleRate <= 0) return false;
+        if (this->channels < 1 || this->channels > 2) return false;
+        if (bitsPerSample != 8 && bitsPerSample != 16) return false;
+
+        int bytesPerSample = bitsPerSample / 8;
+        int sampleCount = pcmSize / bytesPerSample;
+        this->frameCount = sampleCount / this->channels;
+        sampleCount = this->frameCount * this->channels;
+
+        this->data.resize(sampleCount);
+        if (bitsPerSample == 16) {
+            for (int i = 0; i < sampleCount; i++) {
+                this->data[i] = (int16_t)readUint16(pcm + i * 2);
+            }
+        } else {
+            for (int i = 0; i < sampleCount; i++) {
+                this->data[i] = (int16_t)((pcm[i] - 128) << 8);
+            }
+        }
+
+        return true;
+    }
+
+    AudioMixer::AudioMixer(int voiceCount, int sampleRate) {
+        this->sampleRate = sampleRate;
+        this->resampler  = AUDIO_RESAMPLE_LINEAR;
+
+        initAudioKernels();
+
+        AudioVoice voice;
+        voice.sample   = NULL;
+        voice.stream   = NULL;
+        voice.state    = AUDIO_CHANNEL_STOPPED;
+        voice.looping  = false;
+        voice.gain     = 1;
+        voice.currentGain = 1;
+        voice.position = 0;
+        voice.step     = 0;
+        voice.playTime = 0;
+        this->voices.resize(voiceCount, voice);
+
+        AudioVoiceControl control;
+        control.sample  = NULL;
+        control.stream  = NULL;
+        control.state   = AUDIO_CHANNEL_STOPPED;
+        control.looping = false;
+        control.gain    = 1;
+        control.posted  = 0;
+        this->controls.resize(voiceCount, control);
+
+        this->status = new AudioVoiceStatus[voiceCount];
+        for (int i = 0; i < voiceCount; i++) {
+            this->status[i].state   = AUDIO_CHANNEL_STOPPED;
+            this->status[i].applied = 0;
+        }
+
+        this->queue      = new AudioCommand[AUDIO_MIXER_QUEUE_SIZE];
+        this->queueWrite = 0;
+        this->queueRead  = 0;
+
+        // everything mix() uses is allocated here so that mix() does not allocate
+        this->startedTimes.reserve(voiceCount);
+        this->streamFill = -1;
+        this->streamUnderrunCount = 0;
+
+        this->mixBuffer.resize(AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS);
+        this->voiceBuffer.resize(AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS);
+        this->streamBuffer.resize(AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS);
+    }
+
+    /*
+     * the output must be stopped before the mixer is deleted
+     */
+    AudioMixer::~AudioMixer() {
+        delete[] this->queue;
+        delete[] this->status;
+    }
+
+    int AudioMixer::getVoiceCount() {
+        return this->voices.size();
+    }
+
+    int AudioMixer::getSampleRate() {
+        return this->sampleRate;
+    }
+
+    static void initCommand(AudioCommand* command, int type, int index) {
+        command->type     = type;
+        command->index    = index;
+        command->sequence = 0;
+        command->sample   = NULL;
+        command->stream   = NULL;
+        command->gain     = 0;
+        command->value    = 0;
+        command->time     = 0;
+    }
+
+    /*
+     * caller thread: queue the command for the audio thread.
+     * the queue is drained at the start of every mix, so it only stays
+     * full if the output has stopped. the command is dropped then.
+     */
+    bool AudioMixer::post(AudioCommand* command) {
+        for (int retry = 0; this->queueWrite - this->queueRead >= AUDIO_MIXER_QUEUE_SIZE; retry++) {
+            if (retry >= AUDIO_MIXER_QUEUE_RETRY) return false;
+            usleep(1000);
+        }
+
+        AudioVoiceControl* control = &this->controls[command->index];
+        control->state = this->getState(command->index);
+        command->sequence = ++control->posted;
+
+        this->queue[this->queueWrite & (AUDIO_MIXER_QUEUE_SIZE - 1)] = *command;
+        __sync_synchronize();
+        this->queueWrite++;
+        return true;
+    }
+
+    /*
+     * audio thread: apply the commands posted since the last mix
+     */
+    void AudioMixer::drainCommands() {
+        uint32_t end = this->queueWrite;
+        __sync_synchronize();
+        while (this->queueRead != end) {
+            this->applyCommand(&this->queue[this->queueRead & (AUDIO_MIXER_QUEUE_SIZE - 1)]);
+            __sync_synchronize();
+            this->queueRead++;
+        }
+    }
+
+    /*
+     * audio thread: the voice does not read its sample or stream after this
+     */
+    void AudioMixer::detachVoice(AudioVoice* voice) {
+        if (voice->sample != NULL) {
+            __sync_fetch_and_sub(&voice->sample->voiceRefs, 1);
+        }
+        if (voice->stream != NULL) {
+            __sync_fetch_and_sub(&voice->stream->voiceRefs, 1);
+        }
+        voice->sample = NULL;
+        voice->stream = NULL;
+    }
+
+    void AudioMixer::applyCommand(const AudioCommand* command) {
+        AudioVoice* voice = &this->voices[command->index];
+        bool hasSource = (voice->sample != NULL || voice->stream != NULL);
+
+        switch (command->type) {
+        case COMMAND_SET_SOURCE:
+            this->detachVoice(voice);
+            voice->sample   = command->sample;
+            voice->stream   = command->stream;
+            voice->state    = AUDIO_CHANNEL_STOPPED;
+            voice->position = 0;
+            voice->step     = 0;
+            if (voice->sample != NULL) {
+                voice->step = ((uint64_t)voice->sample->sampleRate << 32) / this->sampleRate;
+            }
+            break;
+        case COMMAND_PLAY:
+            if (!hasSource) break;
+            // a stopped stream has already been rewound and buffered
+            if (voice->stream != NULL && voice->state != AUDIO_CHANNEL_STOPPED) {
+                voice->stream->seek(0);
+            }
+            voice->position    = 0;
+            voice->playTime    = command->time;
+            voice->currentGain = voice->gain;
+            voice->state       = AUDIO_CHANNEL_PLAYING;
+            break;
+        case COMMAND_RESUME:
+            if (hasSource) voice->state = AUDIO_CHANNEL_PLAYING;
+            break;
+        case COMMAND_PAUSE:
+            if (voice->state == AUDIO_CHANNEL_PLAYING) voice->state = AUDIO_CHANNEL_PAUSED;
+            break;
+        case COMMAND_STOP:
+            if (voice->stream != NULL && voice->state != AUDIO_CHANNEL_STOPPED) {
+                voice->stream->seek(0);
+            }
+            voice->state    = AUDIO_CHANNEL_STOPPED;
+            voice->position = 0;
+            break;
+        case COMMAND_SEEK:
+            if (voice->stream != NULL) {
+                // the decode thread seeks, the audio thread does not wait for it
+                voice->stream->seek(command->value);
+            } else if (voice->sample != NULL) {
+                uint64_t frame = (uint64_t)command->value * voice->sample->sampleRate / 1000;
+                if (frame > (uint64_t)voice->sample->frameCount) {
+                    frame = voice->sample->frameCount;
+                }
+                voice->position = frame << 32;
+            }
+            break;
+        case COMMAND_SET_GAIN:
+            // the playing voice ramps to the new gain during the next mix
+            voice->gain = command->gain;
+            if (voice->state != AUDIO_CHANNEL_PLAYING) {
+                voice->currentGain = command->gain;
+            }
+            break;
+        case COMMAND_SET_LOOPING:
+            voice->looping = (command->value != 0);
+            if (voice->stream != NULL) {
+                voice->stream->setLooping(voice->looping);
+            }
+            break;
+        }
+
+        AudioVoiceStatus* status = &this->status[command->index];
+        status->state = voice->state;
+        __sync_synchronize();
+        status->applied = command->sequence;
+    }
+
+    /*
+     * attach the sample to the voice. the voice is stopped.
+     * the sample must not be deleted while isMixing() is true.
+     */
+    void AudioMixer::setSample(int index, AudioSample* sample) {
+        if (sample != NULL) {
+            __sync_fetch_and_add(&sample->voiceRefs, 1);
+        }
+        AudioCommand command;
+        initCommand(&command, COMMAND_SET_SOURCE, index);
+        command.sample = sample;
+        if (!this->post(&command)) {
+            if (sample != NULL) __sync_fetch_and_sub(&sample->voiceRefs, 1);
+            return;
+        }
+        AudioVoiceControl* control = &this->controls[index];
+        control->sample = sample;
+        control->stream = NULL;
+        control->state  = AUDIO_CHANNEL_STOPPED;
+    }
+
+    AudioSample* AudioMixer::getSample(int index) {
+        return this->controls[index].sample;
+    }
+
+    /*
+     * attach the stream to the voice. the voice is stopped.
+     * the stream must not be deleted while isMixing() is true.
+     */
+    void AudioMixer::setStream(int index, AudioStream* stream) {
+        if (stream != NULL) {
+            __sync_fetch_and_add(&stream->voiceRefs, 1);
+        }
+        AudioCommand command;
+        initCommand(&command, COMMAND_SET_SOURCE, index);
+        command.stream = stream;
+        if (!this->post(&command)) {
+            if (stream != NULL) __sync_fetch_and_sub(&stream->voiceRefs, 1);
+            return;
+        }
+        AudioVoiceControl* control = &this->controls[index];
+        control->sample = NULL;
+        control->stream = stream;
+        control->state  = AUDIO_CHANNEL_STOPPED;
+    }
+
+    AudioStream* AudioMixer::getStream(int index) {
+        return this->controls[index].stream;
+    }
+
+    /*
+     * play the voice from the beginning
+     */
+    bool AudioMixer::play(int index) {
+        AudioVoiceControl* control = &this->controls[index];
+        if (control->sample == NULL && control->stream == NULL) return false;
+
+        AudioCommand command;
+        initCommand(&command, COMMAND_PLAY, index);
+        command.time = audioNow();
+        if (!this->post(&command)) return false;
+        control->state = AUDIO_CHANNEL_PLAYING;
+        return true;
+    }
+
+    bool AudioMixer::resume(int index) {
+        AudioVoiceControl* control = &this->controls[index];
+        if (control->sample == NULL && control->stream == NULL) return false;
+
+        AudioCommand command;
+        initCommand(&command, COMMAND_RESUME, index);
+        if (!this->post(&command)) return false;
+        control->state = AUDIO_CHANNEL_PLAYING;
+        return true;
+    }
+
+    bool AudioMixer::pause(int index) {
+        AudioVoiceControl* control = &this->controls[index];
+        if (control->sample == NULL && control->stream == NULL) return false;
+
+        AudioCommand command;
+        initCommand(&command, COMMAND_PAUSE, index);
+        if (!this->post(&command)) return false;
+        if (control->state == AUDIO_CHANNEL_PLAYING) {
+            control->state = AUDIO_CHANNEL_PAUSED;
+        }
+        return true;
+    }
+
+    bool AudioMixer::stop(int index) {
+        AudioVoiceControl* control = &this->controls[index];
+        bool result = (control->sample != NULL || control->stream != NULL);
+
+        AudioCommand command;
+        initCommand(&command, COMMAND_STOP, index);
+        if (!this->post(&command)) return false;
+        control->state = AUDIO_CHANNEL_STOPPED;
+        return result;
+    }
+
+    bool AudioMixer::seek(int index, int millis) {
+        AudioVoiceControl* control = &this->controls[index];
+        if (millis < 0 || (control->sample == NULL && control->stream == NULL)) return false;
+
+        AudioCommand command;
+        initCommand(&command, COMMAND_SEEK, index);
+        command.value = millis;
+        return this->post(&command);
+    }
+
+    /*
+     * the state after the posted commands, or the state the audio
+     * thread published once they are applied (a voice stops by itself
+     * at the end of the sample)
+     */
+    int AudioMixer::getState(int index) {
+        AudioVoiceStatus* status = &this->status[index];
+        uint32_t applied = status->applied;
+        __sync_synchronize();
+        int state = status->state;
+        if (applied != this->controls[index].posted) {
+            return this->controls[index].state;
+        }
+        return state;
+    }
+
+    /*
+     * the playing voice ramps to the new gain during the next mix
+     * so that volume changes do not click
+     */
+    void AudioMixer::setGain(int index, float gain) {
+        AudioCommand command;
+        initCommand(&command, COMMAND_SET_GAIN, index);
+        command.gain = gain;
+        if (this->post(&command)) {
+            this->controls[index].gain = gain;
+        }
+    }
+
+    float AudioMixer::getGain(int index) {
+        return this->controls[index].gain;
+    }
+
+    void AudioMixer::setLooping(int index, bool looping) {
+        AudioCommand command;
+        initCommand(&command, COMMAND_SET_LOOPING, index);
+        command.value = looping ? 1 : 0;
+        if (this->post(&command)) {
+            this->controls[index].looping = looping;
+        }
+    }
+
+    bool AudioMixer::isLooping(int index) {
+        return this->controls[index].looping;
+    }
+
+    /*
+     * AUDIO_RESAMPLE_LINEAR or AUDIO_RESAMPLE_POLYPHASE
+     */
+    void AudioMixer::setResampler(int resampler) {
+        this->resampler = resampler;
+    }
+
+    int AudioMixer::getResampler() {
+        return this->resampler;
+    }
+
+    /*
+     * resample the voice into interleaved stereo floats.
+     * the kernels stop before the last frames of the sample;
+     * those frames and the loop points are interpolated here.
+     */
+    int AudioMixer::resampleVoice(AudioVoice* voice, float* out, int frameCount) {
+        const AudioSample* sample = voice->sample;
+        const int16_t* data = &sample->data[0];
+        const uint32_t frames = sample->frameCount;
+        const int channels = sample->channels;
+
+        int produced = 0;
+        while (produced < frameCount) {
+            uint32_t index = voice->position >> 32;
+            if (index >= frames) {
+                if (voice->looping && frames > 0) {
+                    voice->position -= (uint64_t)frames << 32;
+                } else {
+                    voice->state    = AUDIO_CHANNEL_STOPPED;
+                    voice->position = 0;
+                    break;
+                }
+            }
+
+            if (this->resampler == AUDIO_RESAMPLE_POLYPHASE) {
+                produced += audioResamplePolyphase(out + produced * 2, frameCount - produced,
+                                                   data, channels, frames, &voice->position, voice->step);
+            } else {
+                produced += audioResampleLinear(out + produced * 2, frameCount - produced,
+                                                data, channels, frames, &voice->position, voice->step);
+            }
+            if (produced >= frameCount) break;
+
+            index = voice->position >> 32;
+            if (index >= frames) continue;
+
+            uint32_t next = index + 1;
+            if (next >= frames) next = voice->looping ? 0 : index;
+
+            float frac = ((uint32_t)voice->position >> 8) * (1.0f / 16777216.0f);
+
+            float left0 = data[index * channels];
+            float left1 = data[next  * channels];
+            float left  = left0 + (left1 - left0) * frac;
+            float right = left;
+            if (channels == 2) {
+                float right0 = data[index * channels + 1];
+                float right1 = data[next  * channels + 1];
+                right = right0 + (right1 - right0) * frac;
+            }
+            out[produced * 2]     = left;
+            out[produced * 2 + 1] = right;
+            produced++;
+
+            voice->position += voice->step;
+        }
+        return produced;
+    }
+
+    /*
+     * take the decoded frames of the streaming voice.
+     * the frames missing on underrun are left silent.
+     */
+    int AudioMixer::pullStream(AudioVoice* voice, float* out, int frameCount) {
+        int16_t* frames = &this->streamBuffer[0];
+        int count = voice->stream->pull(frames, frameCount);
+        for (int i = 0; i < count * AUDIO_MIXER_CHANNELS; i++) {
+            out[i] = frames[i];
+        }
+        if (voice->stream->isEnded()) {
+            // rewind so that the next play starts without waiting for the decoder
+            voice->stream->seek(0);
+            voice->state = AUDIO_CHANNEL_STOPPED;
+        }
+        return count;
+    }
+
+    /*
+     * resample the voice and add it to the float buffer
+     */
+    void AudioMixer::mixVoice(AudioVoice* voice, float* out, int frameCount) {
+        float* buffer = &this->voiceBuffer[0];
+        int frames;
+        if (voice->stream != NULL) {
+            frames = this->pullStream(voice, buffer, frameCount);
+        } else {
+            frames = this->resampleVoice(voice, buffer, frameCount);
+        }
+
+        // a voice starts at most once per mix, so the reserved
+        // capacity is never exceeded and push_back does not allocate
+        if (frames > 0 && voice->playTime != 0) {
+            if (this->startedTimes.size() < this->startedTimes.capacity()) {
+                this->startedTimes.push_back(voice->playTime);
+            }
+            voice->playTime = 0;
+        }
+
+        float gain = voice->gain;
+        if (voice->currentGain != gain) {
+            audioAccumulateRamp(out, buffer, frames, voice->currentGain, gain);
+            voice->currentGain = gain;
+        } else {
+            audioAccumulate(out, buffer, frames * AUDIO_MIXER_CHANNELS, gain);
+        }
+    }
+
+    /*
+     * mix all playing voices into at most AUDIO_MIXER_BUFFER_FRAMES frames
+     */
+    void AudioMixer::mixFrames(int16_t* out, int frameCount) {
+        int samples = frameCount * AUDIO_MIXER_CHANNELS;
+        float* buffer = &this->mixBuffer[0];
+        memset(buffer, 0, samples * sizeof(float));
+
+        for (size_t i = 0; i < this->voices.size(); i++) {
+            AudioVoice* voice = &this->voices[i];
+            if (voice->state != AUDIO_CHANNEL_PLAYING) continue;
+            if (voice->sample == NULL && voice->stream == NULL) continue;
+            this->mixVoice(voice, buffer, frameCount);
+        }
+
+        audioFloatToInt16(out, buffer, samples);
+    }
+
+    /*
+     * mix all playing voices into interleaved stereo 16bit frames.
+     * this is called from the audio output thread. it takes no locks
+     * and does not allocate.
+     */
+    void AudioMixer::mix(int16_t* out, int frameCount) {
+        this->drainCommands();
+
+        this->startedTimes.clear();
+        this->streamFill = -1;
+        this->streamUnderrunCount = 0;
+
+        for (size_t i = 0; i < this->voices.size(); i++) {
+            AudioVoice* voice = &this->voices[i];
+            if (voice->stream == NULL) continue;
+            AudioStreamStats stats;
+            voice->stream->getStats(&stats);
+            this->streamUnderrunCount += stats.underrunCount;
+            if (voice->state == AUDIO_CHANNEL_PLAYING) {
+                float fill = stats.bufferedFrames * 100.0f / stats.capacityFrames;
+                if (this->streamFill < 0 || fill < this->streamFill) this->streamFill = fill;
+            }
+        }
+
+        while (frameCount > 0) {
+            int frames = frameCount;
+            if (frames > AUDIO_MIXER_BUFFER_FRAMES) frames = AUDIO_MIXER_BUFFER_FRAMES;
+            this->mixFrames(out, frames);
+            out += frames * AUDIO_MIXER_CHANNELS;
+            frameCount -= frames;
+        }
+
+        // publish the voices that stopped at the end of their sample
+        for (size_t i = 0; i < this->voices.size(); i++) {
+            if (this->status[i].state != this->voices[i].state) {
+                this->status[i].state = this->voices[i].state;
+            }
+        }
+    }
+
+    /*
+     * play() times of the voices whose first frames were in the last mix
+     */
+    const std::vector<uint64_t>& AudioMixer::getStartedTimes() {
+        return this->startedTimes;
+    }
+
+    /*
+     * the lowest ring fill in percent of the playing streams, -1 if none
+     */
+    float AudioMixer::getStreamFill() {
+        return this->streamFill;
+    }
+
+    uint32_t AudioMixer::getStreamUnderrunCount() {
+        return this->streamUnderrunCount;
+    }
+
+    AudioMixerOutput::AudioMixerOutput(AudioMixer* mixer, AudioMetrics* metrics, AudioEnqueueFunc enqueue, void* context) {
+        this->mixer   = mixer;
+        this->metrics = metrics;
+        this->enqueue = enqueue;
+        this->context = context;
+        for (int i = 0; i < AUDIO_MIXER_QUEUE_BUFFERS; i++) {
+            this->buffers[i] = new int16_t[AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS];
+        }
+        this->bufferIndex = 0;
+    }
+
+    AudioMixerOutput::~AudioMixerOutput() {
+        for (int i = 0; i < AUDIO_MIXER_QUEUE_BUFFERS; i++) {
+            delete[] this->buffers[i];
+        }
+    }
+
+    /*
+     * prime the queue: the callback keeps all buffers in flight from now on
+     */
+    void AudioMixerOutput::start() {
+        for (int i = 0; i < AUDIO_MIXER_QUEUE_BUFFERS; i++) {
+            this->onBufferDone();
+        }
+    }
+
+    /*
+     * refill the oldest buffer and enqueue it.
+     * called from the buffer queue callback on the audio thread.
+     */
+    void AudioMixerOutput::onBufferDone() {
+        uint64_t start = audioNow();
+
+        int16_t* buffer = this->buffers[this->bufferIndex];
+        this->mixer->mix(buffer, AUDIO_MIXER_BUFFER_FRAMES);
+        this->enqueue(this->context, buffer,
+                AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS * sizeof(int16_t));
+        this->bufferIndex = (this->bufferIndex + 1) % AUDIO_MIXER_QUEUE_BUFFERS;
+
+        uint64_t end = audioNow();
+
+        // the output starves if the callback is later than the queued buffers
+        this->metrics->recordCallback(start, end, AUDIO_MIXER_QUEUE_BUFFERS);
+        const std::vector<uint64_t>& started = this->mixer->getStartedTimes();
+        for (size_t i = 0; i < started.size(); i++) {
+            this->metrics->recordLatency(started[i], end);
+        }
+        if (this->mixer->getStreamFill() >= 0) {
+            this->metrics->recordStreamFill(this->mixer->getStreamFill());
+        }
+        this->metrics->setStreamUnderrunCount(this->mixer->getStreamUnderrunCount());
+    }
+}
@@ -0,0 +1,217 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_AUDIO_MIXER_H
+#define EMO_AUDIO_MIXER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "Audio_stream.h"
+#include "Audio_metrics.h"
+
+#define AUDIO_MIXER_SAMPLE_RATE   44100
+#define AUDIO_MIXER_CHANNELS      2
+#define AUDIO_MIXER_BUFFER_FRAMES 512
+#define AUDIO_MIXER_QUEUE_BUFFERS 2    // buffers in flight on the output
+#define AUDIO_MIXER_QUEUE_SIZE    1024 // commands, power of two
+#define AUDIO_MIXER_QUEUE_RETRY   100  // 1ms waits while the queue is full
+
+/*
+ * Software mixer for sound effects.
+ * This file does not depend on the platform audio API: the output
+ * (OpenSL ES buffer queue on Android) pulls mixed frames by mix().
+ *
+ * The voices are owned by the audio thread. The caller thread posts
+ * commands into a single producer / single consumer queue that mix()
+ * drains, so the audio callback never waits for a lock.
+ */
+namespace emo {
+    /*
+     * decoded 16bit PCM sound (interleaved if stereo)
+     */
+    class AudioSample {
+    public:
+        AudioSample();
+        ~AudioSample();
+
+        bool loadWav(const unsigned char* bytes, size_t size);
+
+        bool isMixing();
+
+        std::vector<int16_t> data;
+        int channels;
+        int sampleRate;
+        int frameCount;
+
+        // voices that may still read the data: added by the caller thread
+        // when the sample is attached, removed by the audio thread on detach
+        volatile int32_t voiceRefs;
+    };
+
+    struct AudioVoice {
+        AudioSample* sample;
+        AudioStream* stream;
+        int      state;
+        bool     looping;
+        float    gain;
+        float    currentGain; // gain applied at the end of the last mix, ramps towards gain
+        uint64_t position; // frame position in 32.32 fixed point
+        uint64_t step;
+        uint64_t playTime; // audioNow() of play() until the first frames are mixed
+    };
+
+    /*
+     * the voice as the caller thread sees it
+     */
+    struct AudioVoiceControl {
+        AudioSample* sample;
+        AudioStream* stream;
+        int      state;  // state after the posted commands are applied
+        bool     looping;
+        float    gain;
+        uint32_t posted; // sequence number of the last posted command
+    };
+
+    /*
+     * the voice as published by the audio thread
+     */
+    struct AudioVoiceStatus {
+        volatile int32_t  state;
+        volatile uint32_t applied; // sequence number of the last applied command
+    };
+
+    struct AudioCommand {
+        int      type;
+        int      index;
+        uint32_t sequence;
+        AudioSample* sample;
+        AudioStream* stream;
+        float    gain;
+        int      value;
+        uint64_t time;
+    };
+
+    class AudioMixer {
+    public:
+        AudioMixer(int voiceCount, int sampleRate);
+        ~AudioMixer();
+
+        int getVoiceCount();
+        int getSampleRate();
+
+        void setSample(int index, AudioSample* sample);
+        AudioSample* getSample(int index);
+        void setStream(int index, AudioStream* stream);
+        AudioStream* getStream(int index);
+
+        bool play(int index);
+        bool resume(int index);
+        bool pause(int index);
+        bool stop(int index);
+        bool seek(int index, int millis);
+        int  getState(int index);
+
+        void  setGain(int index, float gain);
+        float getGain(int index);
+        void  setLooping(int index, bool looping);
+        bool  isLooping(int index);
+
+        void setResampler(int resampler);
+        int  getResampler();
+
+        // audio thread
+        void mix(int16_t* out, int frameCount);
+
+        // results of the last mix(), read by the audio thread
+        const std::vector<uint64_t>& getStartedTimes();
+        float    getStreamFill();
+        uint32_t getStreamUnderrunCount();
+    protected:
+        enum CommandType {
+            COMMAND_SET_SOURCE,
+            COMMAND_PLAY,
+            COMMAND_RESUME,
+            COMMAND_PAUSE,
+            COMMAND_STOP,
+            COMMAND_SEEK,
+            COMMAND_SET_GAIN,
+            COMMAND_SET_LOOPING
+        };
+
+        std::vector<AudioVoice> voices;
+        std::vector<AudioVoiceControl> controls;
+        AudioVoiceStatus* status;
+
+        AudioCommand* queue;
+        volatile uint32_t queueWrite;
+        volatile uint32_t queueRead;
+
+        std::vector<float> mixBuffer;
+        std::vector<float> voiceBuffer;
+        std::vector<int16_t> streamBuffer;
+        std::vector<uint64_t> startedTimes;
+        float    streamFill;
+        uint32_t streamUnderrunCount;
+        int sampleRate;
+        int resampler;
+
+        bool post(AudioCommand* command);
+        void drainCommands();
+        void applyCommand(const AudioCommand* command);
+        void detachVoice(AudioVoice* voice);
+
+        int  resampleVoice(AudioVoice* voice, float* out, int frameCount);
+        int  pullStream(AudioVoice* voice, float* out, int frameCount);
+        void mixVoice(AudioVoice* voice, float* out, int frameCount);
+        void mixFrames(int16_t* out, int frameCount);
+    };
+
+    typedef void (*AudioEnqueueFunc)(void* context, int16_t* buffer, int size);
+
+    /*
+     * buffers of the mixer output. the platform buffer queue (OpenSL ES
+     * on Android) calls onBufferDone() when a buffer has been played and
+     * the output mixes the next one, enqueues it and records the metrics.
+     */
+    class AudioMixerOutput {
+    public:
+        AudioMixerOutput(AudioMixer* mixer, AudioMetrics* metrics, AudioEnqueueFunc enqueue, void* context);
+        ~AudioMixerOutput();
+
+        void start();
+        void onBufferDone();
+    protected:
+        AudioMixer*   mixer;
+        AudioMetrics* metrics;
+        AudioEnqueueFunc enqueue;
+        void*    context;
+        int16_t* buffers[AUDIO_MIXER_QUEUE_BUFFERS];
+        int      bufferIndex;
+    };
+}
+#endif
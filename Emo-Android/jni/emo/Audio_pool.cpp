@@ -0,0 +1,254 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Constants.h"
+#include "Audio_pool.h"
+
+namespace emo {
+
+    AudioVoicePool::AudioVoicePool(AudioMixer* mixer, AudioSampleBank* bank, int firstVoice, int voiceCount) {
+        this->mixer       = mixer;
+        this->bank        = bank;
+        this->firstVoice  = firstVoice;
+        this->stealPolicy = AUDIO_STEAL_OLDEST;
+        this->sequence    = 0;
+        this->playCount   = 0;
+        this->stealCount  = 0;
+        this->rejectCount = 0;
+
+        PoolVoice voice;
+        voice.active     = false;
+        voice.sample     = NULL;
+        voice.priority   = 0;
+        voice.gain       = 1;
+        voice.looping    = false;
+        voice.generation = 0;
+        voice.startSeq   = 0;
+        this->voices.resize(voiceCount, voice);
+    }
+
+    AudioVoicePool::~AudioVoicePool() {
+        for (size_t i = 0; i < this->voices.size(); i++) {
+            if (this->voices[i].active) {
+                this->freeVoice(i);
+            }
+        }
+    }
+
+    /*
+     * handle = generation * AUDIO_POOL_MAX_VOICES + slot.
+     * returns the slot or -1 if the handle is stale.
+     */
+    int AudioVoicePool::findVoice(int handle) {
+        if (handle < 0) return -1;
+        int slot = handle % AUDIO_POOL_MAX_VOICES;
+        uint32_t generation = handle / AUDIO_POOL_MAX_VOICES;
+        if (slot >= (int)this->voices.size()) return -1;
+        PoolVoice* voice = &this->voices[slot];
+        if (!voice->active || voice->generation != generation) return -1;
+        return slot;
+    }
+
+    void AudioVoicePool::freeVoice(int slot) {
+        PoolVoice* voice = &this->voices[slot];
+        this->mixer->setSample(this->firstVoice + slot, NULL);
+        this->bank->release(voice->sample);
+
+        CategoryMap::iterator it = this->categories.find(voice->category);
+        if (it != this->categories.end()) {
+            it->second.active--;
+        }
+
+        voice->active = false;
+        voice->sample = NULL;
+        voice->category.clear();
+    }
+
+    /*
+     * free the one-shot voices that finished playing
+     */
+    void AudioVoicePool::recycle() {
+        for (size_t i = 0; i < this->voices.size(); i++) {
+            PoolVoice* voice = &this->voices[i];
+            if (!voice->active || voice->looping) continue;
+            if (this->mixer->getState(this->firstVoice + i) == AUDIO_CHANNEL_STOPPED) {
+                this->freeVoice(i);
+            }
+        }
+    }
+
+    /*
+     * pick the voice to steal among the voices of lower or equal priority,
+     * limited to the category if given. returns -1 if none.
+     */
+    int AudioVoicePool::selectVictim(const std::string* category, int priority) {
+        if (this->stealPolicy == AUDIO_STEAL_NONE) return -1;
+
+        int victim = -1;
+        for (size_t i = 0; i < this->voices.size(); i++) {
+            const PoolVoice* voice = &this->voices[i];
+            if (!voice->active || voice->priority > priority) continue;
+            if (category != NULL && voice->category != *category) continue;
+            if (victim < 0) {
+                victim = i;
+                continue;
+            }
+            const PoolVoice* best = &this->voices[victim];
+            // lower priority voices go first
+            if (voice->priority != best->priority) {
+                if (voice->priority < best->priority) victim = i;
+                continue;
+            }
+            if (this->stealPolicy == AUDIO_STEAL_QUIETEST && voice->gain != best->gain) {
+                if (voice->gain < best->gain) victim = i;
+            } else if ((int32_t)(voice->startSeq - best->startSeq) < 0) {
+                victim = i;
+            }
+        }
+        return victim;
+    }
+
+    int AudioVoicePool::selectVoice(const std::string& category, int priority) {
+        this->recycle();
+
+        CategoryMap::iterator it = this->categories.find(category);
+        if (it != this->categories.end() && it->second.limit > 0 && it->second.active >= it->second.limit) {
+            return this->selectVictim(&category, priority);
+        }
+
+        for (size_t i = 0; i < this->voices.size(); i++) {
+            if (!this->voices[i].active) return i;
+        }
+        return this->selectVictim(NULL, priority);
+    }
+
+    /*
+     * play the sample on a free or stolen voice.
+     * returns the voice handle or AUDIO_VOICE_INVALID.
+     */
+    int AudioVoicePool::play(const std::string& name, const std::string& category, int priority, float gain, bool looping) {
+        AudioSample* sample = this->bank->acquire(name);
+        if (sample == NULL) return AUDIO_VOICE_INVALID;
+
+        int slot = this->selectVoice(category, priority);
+        if (slot < 0) {
+            this->bank->release(sample);
+            this->rejectCount++;
+            return AUDIO_VOICE_INVALID;
+        }
+
+        PoolVoice* voice = &this->voices[slot];
+        if (voice->active) {
+            this->freeVoice(slot);
+            this->stealCount++;
+        }
+
+        voice->active     = true;
+        voice->sample     = sample;
+        voice->category   = category;
+        voice->priority   = priority;
+        voice->gain       = gain;
+        voice->looping    = looping;
+        voice->generation = (voice->generation + 1) & 0x7FFFFF;
+        voice->startSeq   = ++this->sequence;
+
+        CategoryMap::iterator it = this->categories.find(category);
+        if (it != this->categories.end()) {
+            it->second.active++;
+        }
+
+        int index = this->firstVoice + slot;
+        this->mixer->setSample(index, sample);
+        this->mixer->setGain(index, gain);
+        this->mixer->setLooping(index, looping);
+        this->mixer->play(index);
+        this->playCount++;
+
+        return voice->generation * AUDIO_POOL_MAX_VOICES + slot;
+    }
+
+    bool AudioVoicePool::stop(int handle) {
+        int slot = this->findVoice(handle);
+        if (slot < 0) return false;
+        this->freeVoice(slot);
+        return true;
+    }
+
+    bool AudioVoicePool::setGain(int handle, float gain) {
+        int slot = this->findVoice(handle);
+        if (slot < 0) return false;
+        this->voices[slot].gain = gain;
+        this->mixer->setGain(this->firstVoice + slot, gain);
+        return true;
+    }
+
+    bool AudioVoicePool::isPlaying(int handle) {
+        int slot = this->findVoice(handle);
+        if (slot < 0) return false;
+        return this->mixer->getState(this->firstVoice + slot) == AUDIO_CHANNEL_PLAYING;
+    }
+
+    /*
+     * limit the voices of the category. zero removes the limit.
+     */
+    void AudioVoicePool::setCategoryLimit(const std::string& category, int maxVoices) {
+        CategoryMap::iterator it = this->categories.find(category);
+        if (it == this->categories.end()) {
+            Category entry;
+            entry.limit  = maxVoices;
+            entry.active = 0;
+            for (size_t i = 0; i < this->voices.size(); i++) {
+                if (this->voices[i].active && this->voices[i].category == category) {
+                    entry.active++;
+                }
+            }
+            this->categories[category] = entry;
+        } else {
+            it->second.limit = maxVoices;
+        }
+    }
+
+    void AudioVoicePool::setStealPolicy(int policy) {
+        this->stealPolicy = policy;
+    }
+
+    int AudioVoicePool::getStealPolicy() {
+        return this->stealPolicy;
+    }
+
+    void AudioVoicePool::getStats(AudioVoicePoolStats* stats) {
+        this->recycle();
+        stats->voiceCount  = this->voices.size();
+        stats->activeCount = 0;
+        for (size_t i = 0; i < this->voices.size(); i++) {
+            if (this->voices[i].active) stats->activeCount++;
+        }
+        stats->playCount   = this->playCount;
+        stats->stealCount  = this->stealCount;
+        stats->rejectCount = this->rejectCount;
+    }
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_AUDIO_POOL_H
+#define EMO_AUDIO_POOL_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "Audio_mixer.h"
+#include "Audio_bank.h"
+
+#define AUDIO_POOL_DEFAULT_VOICES 8
+#define AUDIO_POOL_MAX_VOICES     256
+
+#define AUDIO_VOICE_INVALID -1
+
+#define AUDIO_STEAL_OLDEST   0
+#define AUDIO_STEAL_QUIETEST 1
+#define AUDIO_STEAL_NONE     2
+
+/*
+ * Voice allocator on top of the mixer voices after the script channels.
+ * Sounds are played by sample name and addressed by a handle that
+ * becomes invalid when the voice is recycled or stolen. One-shot voices
+ * are recycled when they finish. When no voice is free, or the category
+ * reached its limit, a voice of lower or equal priority is stolen
+ * according to the steal policy.
+ * The pool is used from the main thread only.
+ */
+namespace emo {
+    struct AudioVoicePoolStats {
+        uint32_t voiceCount;
+        uint32_t activeCount;
+        uint32_t playCount;
+        uint32_t stealCount;
+        uint32_t rejectCount;
+    };
+
+    class AudioVoicePool {
+    public:
+        AudioVoicePool(AudioMixer* mixer, AudioSampleBank* bank, int firstVoice, int voiceCount);
+        ~AudioVoicePool();
+
+        int  play(const std::string& name, const std::string& category, int priority, float gain, bool looping);
+        bool stop(int handle);
+        bool setGain(int handle, float gain);
+        bool isPlaying(int handle);
+
+        void setCategoryLimit(const std::string& category, int maxVoices);
+        void setStealPolicy(int policy);
+        int  getStealPolicy();
+
+        void recycle();
+        void getStats(AudioVoicePoolStats* stats);
+    protected:
+        struct PoolVoice {
+            bool         active;
+            AudioSample* sample;
+            std::string  category;
+            int          priority;
+            float        gain;
+            bool         looping;
+            uint32_t     generation;
+            uint32_t     startSeq;
+        };
+
+        struct Category {
+            int limit;
+            int active;
+        };
+
+        typedef std::map<std::string, Category> CategoryMap;
+
+        AudioMixer*      mixer;
+        AudioSampleBank* bank;
+        int firstVoice;
+        int stealPolicy;
+        uint32_t sequence;
+
+        std::vector<PoolVoice> voices;
+        CategoryMap categories;
+
+        uint32_t playCount;
+        uint32_t stealCount;
+        uint32_t rejectCount;
+
+        int  findVoice(int handle);
+        int  selectVoice(const std::string& category, int priority);
+        int  selectVictim(const std::string* category, int priority);
+        void freeVoice(int slot);
+    };
+}
+#endif
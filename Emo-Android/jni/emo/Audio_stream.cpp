@@ -0,0 +1,484 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include <string.h>
+#include "Audio_stream.h"
+
+static uint32_t readUint32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t readUint16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t roundUpPowerOfTwo(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+namespace emo {
+
+    AudioRingBuffer::AudioRingBuffer(int frameCount) {
+        this->capacity = roundUpPowerOfTwo(frameCount);
+        this->mask     = this->capacity - 1;
+        this->data     = new int16_t[this->capacity * 2];
+        this->writePos = 0;
+        this->readPos  = 0;
+        this->flushPos = 0;
+        this->flushSeq = 0;
+        this->appliedFlushSeq = 0;
+    }
+
+    AudioRingBuffer::~AudioRingBuffer() {
+        delete[] this->data;
+    }
+
+    int AudioRingBuffer::getCapacity() {
+        return this->capacity;
+    }
+
+    /*
+     * producer: free frames
+     */
+    int AudioRingBuffer::getWritable() {
+        uint32_t read = this->readPos;
+        __sync_synchronize();
+        return this->capacity - (this->writePos - read);
+    }
+
+    /*
+     * producer: copy frames and publish them to the consumer
+     */
+    int AudioRingBuffer::write(const int16_t* frames, int count) {
+        int writable = this->getWritable();
+        if (count > writable) count = writable;
+
+        uint32_t start = this->writePos & this->mask;
+        uint32_t first = this->capacity - start;
+        if (first > (uint32_t)count) first = count;
+        memcpy(this->data + start * 2, frames, first * 2 * sizeof(int16_t));
+        memcpy(this->data, frames + first * 2, (count - first) * 2 * sizeof(int16_t));
+
+        __sync_synchronize();
+        this->writePos += count;
+        return count;
+    }
+
+    /*
+     * producer: drop all frames written so far.
+     * the consumer skips them on its next read.
+     */
+    void AudioRingBuffer::flush() {
+        this->flushPos = this->writePos;
+        __sync_synchronize();
+        this->flushSeq++;
+    }
+
+    /*
+     * consumer: apply the pending flush. returns true if frames were dropped.
+     */
+    bool AudioRingBuffer::applyFlush() {
+        uint32_t seq = this->flushSeq;
+        if (seq == this->appliedFlushSeq) return false;
+        __sync_synchronize();
+        uint32_t pos = this->flushPos;
+        // the read position only moves forward
+        if ((int32_t)(pos - this->readPos) > 0) {
+            this->readPos = pos;
+        }
+        this->appliedFlushSeq = seq;
+        return true;
+    }
+
+    /*
+     * consumer: buffered frames
+     */
+    int AudioRingBuffer::getReadable() {
+        uint32_t write = this->writePos;
+        __sync_synchronize();
+        return write - this->readPos;
+    }
+
+    /*
+     * consumer: copy frames and release the space to the producer
+     */
+    int AudioRingBuffer::read(int16_t* frames, int count) {
+        int readable = this->getReadable();
+        if (count > readable) count = readable;
+
+        uint32_t start = this->readPos & this->mask;
+        uint32_t first = this->capacity - start;
+        if (first > (uint32_t)count) first = count;
+        memcpy(frames, this->data + start * 2, first * 2 * sizeof(int16_t));
+        memcpy(frames + first * 2, this->data, (count - first) * 2 * sizeof(int16_t));
+
+        __sync_synchronize();
+        this->readPos += count;
+        return count;
+    }
+
+    AudioStream::AudioStream(AudioStreamSource* source, int outputRate) : ring(AUDIO_STREAM_RING_FRAMES) {
+        this->source     = source;
+        this->outputRate = outputRate;
+        this->channels   = 0;
+        this->sampleRate = 0;
+        this->frameCount = 0;
+        this->voiceRefs  = 0;
+        this->bytesPerSample = 0;
+
+        this->dataStart     = 0;
+        this->dataSize      = 0;
+        this->dataRemaining = 0;
+
+        this->threadStarted = false;
+        this->quit    = false;
+        this->looping = false;
+        this->ended   = false;
+
+        this->seekFrame     = 0;
+        this->seekSeq       = 0;
+        this->servedSeekSeq = 0;
+
+        this->primed         = false;
+        this->underrunCount  = 0;
+        this->underrunFrames = 0;
+
+        this->readBuffer       = NULL;
+        this->readFill         = 0;
+        this->sourceFrames     = NULL;
+        this->sourceFrameCount = 0;
+        this->outputFrames     = NULL;
+        this->position         = 0;
+        this->step             = 0;
+
+        sem_init(&this->wakeup, 0, 0);
+    }
+
+    AudioStream::~AudioStream() {
+        if (this->threadStarted) {
+            this->quit = true;
+            sem_post(&this->wakeup);
+            pthread_join(this->thread, NULL);
+        }
+        sem_destroy(&this->wakeup);
+
+        delete[] this->readBuffer;
+        delete[] this->sourceFrames;
+        delete[] this->outputFrames;
+        delete this->source;
+    }
+
+    /*
+     * read the wav header and start the decode thread,
+     * which buffers the beginning of the stream right away
+     */
+    bool AudioStream::open() {
+        if (!this->readHeader()) return false;
+
+        this->step = ((uint64_t)this->sampleRate << 32) / this->outputRate;
+
+        this->readBuffer   = new unsigned char[AUDIO_STREAM_READ_BYTES];
+        this->sourceFrames = new int16_t[AUDIO_STREAM_CHUNK_FRAMES * 2];
+        this->outputFrames = new int16_t[AUDIO_STREAM_CHUNK_FRAMES * 2];
+
+        if (!this->seekSource(0)) return false;
+
+        if (pthread_create(&this->thread, NULL, decodeThread, this) != 0) {
+            return false;
+        }
+        this->threadStarted = true;
+        return true;
+    }
+
+    bool AudioStream::readFully(void* buffer, int size) {
+        unsigned char* bytes = (unsigned char*)buffer;
+        while (size > 0) {
+            int count = this->source->read(bytes, size);
+            if (count <= 0) return false;
+            bytes += count;
+            size  -= count;
+        }
+        return true;
+    }
+
+    bool AudioStream::readHeader() {
+        unsigned char header[16];
+        if (!this->readFully(header, 12)) return false;
+        if (memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+            return false;
+        }
+
+        long offset = 12;
+        int bitsPerSample = 0;
+        while (true) {
+            if (!this->readFully(header, 8)) return false;
+            offset += 8;
+            uint32_t chunkSize = readUint32(header + 4);
+
+            if (memcmp(header, "data", 4) == 0) {
+                this->dataStart = offset;
+                this->dataSize  = chunkSize;
+                break;
+            }
+
+            if (memcmp(header, "fmt ", 4) == 0 && chunkSize >= 16) {
+                if (!this->readFully(header, 16)) return false;
+                uint16_t formatTag = readUint16(header);
+                if (formatTag != 1 && formatTag != 0xFFFE) return false;
+                this->channels   = readUint16(header + 2);
+                this->sampleRate = readUint32(header + 4);
+                bitsPerSample    = readUint16(header + 14);
+            }
+            // chunks are word aligned
+            offset += chunkSize + (chunkSize & 1);
+            if (!this->source->seek(offset)) return false;
+        }
+
+        if (this->sampleRate <= 0) return false;
+        if (this->channels < 1 || this->channels > 2) return false;
+        if (bitsPerSample != 8 && bitsPerSample != 16) return false;
+
+        this->bytesPerSample = bitsPerSample / 8;
+        this->frameCount = this->dataSize / (this->bytesPerSample * this->channels);
+        return true;
+    }
+
+    /*
+     * request to continue playback from the given position.
+     * the decode thread drops the buffered frames and refills the buffer.
+     * called by the mixer on the audio thread, so there is one writer at a time.
+     */
+    void AudioStream::seek(int millis) {
+        if (millis < 0) millis = 0;
+        this->seekFrame = (uint64_t)millis * this->sampleRate / 1000;
+        __sync_synchronize();
+        this->seekSeq++;
+        sem_post(&this->wakeup);
+    }
+
+    void AudioStream::setLooping(bool looping) {
+        this->looping = looping;
+        sem_post(&this->wakeup);
+    }
+
+    bool AudioStream::isLooping() {
+        return this->looping;
+    }
+
+    /*
+     * audio thread: take the decoded frames without blocking.
+     * returns the number of frames copied, which is less than frameCount
+     * on underrun, while a seek is pending or at the end of the stream.
+     */
+    int AudioStream::pull(int16_t* out, int frameCount) {
+        int count = 0;
+        if (this->seekSeq == this->servedSeekSeq) {
+            __sync_synchronize();
+            if (this->ring.applyFlush()) {
+                this->primed = false;
+            }
+            count = this->ring.read(out, frameCount);
+            if (count == frameCount) {
+                this->primed = true;
+            } else if (this->primed && !this->ended) {
+                this->underrunCount++;
+                this->underrunFrames += frameCount - count;
+            }
+        }
+        sem_post(&this->wakeup);
+        return count;
+    }
+
+    /*
+     * audio thread: true if all frames of the stream have been played
+     */
+    bool AudioStream::isEnded() {
+        if (this->seekSeq != this->servedSeekSeq) return false;
+        __sync_synchronize();
+        return this->ended && this->ring.getReadable() == 0;
+    }
+
+    void AudioStream::getStats(AudioStreamStats* stats) {
+        stats->underrunCount  = this->underrunCount;
+        stats->underrunFrames = this->underrunFrames;
+        stats->bufferedFrames = this->ring.getReadable();
+        stats->capacityFrames = this->ring.getCapacity();
+        stats->memoryBytes    = this->ring.getCapacity() * 2 * sizeof(int16_t)
+                              + AUDIO_STREAM_READ_BYTES
+                              + AUDIO_STREAM_CHUNK_FRAMES * 2 * sizeof(int16_t) * 2;
+    }
+
+    /*
+     * true while a mixer voice may pull the stream
+     */
+    bool AudioStream::isMixing() {
+        __sync_synchronize();
+        return this->voiceRefs > 0;
+    }
+
+    bool AudioStream::seekSource(uint32_t frame) {
+        if (frame > (uint32_t)this->frameCount) frame = this->frameCount;
+        long offset = (long)frame * this->bytesPerSample * this->channels;
+
+        this->dataRemaining    = this->dataSize - offset;
+        this->readFill         = 0;
+        this->sourceFrameCount = 0;
+        this->position         = 0;
+        return this->source->seek(this->dataStart + offset);
+    }
+
+    /*
+     * read the next block of the source into sourceFrames as stereo 16bit.
+     * the frames from keepFrom are kept for interpolation.
+     * wraps to the beginning when looping. returns false at the end.
+     */
+    bool AudioStream::fillSource(uint32_t keepFrom) {
+        int keep = this->sourceFrameCount - keepFrom;
+        memmove(this->sourceFrames, this->sourceFrames + keepFrom * 2, keep * 2 * sizeof(int16_t));
+        this->sourceFrameCount = keep;
+        this->position -= (uint64_t)keepFrom << 32;
+
+        const int frameBytes = this->bytesPerSample * this->channels;
+        bool rewound = false;
+        while (true) {
+            if (this->dataRemaining <= 0) {
+                // give up if the data chunk is empty even after rewinding
+                if (!this->looping || rewound) return false;
+                this->dataRemaining = this->dataSize;
+                this->readFill = 0;
+                if (!this->source->seek(this->dataStart)) return false;
+                rewound = true;
+            }
+
+            int size = (AUDIO_STREAM_CHUNK_FRAMES - this->sourceFrameCount) * frameBytes - this->readFill;
+            if (size > this->dataRemaining) size = this->dataRemaining;
+            int count = this->source->read(this->readBuffer + this->readFill, size);
+            if (count <= 0) {
+                this->dataRemaining = 0;
+                continue;
+            }
+            this->dataRemaining -= count;
+            this->readFill += count;
+
+            int frames = this->readFill / frameBytes;
+            if (frames == 0) continue;
+
+            const unsigned char* src = this->readBuffer;
+            int16_t* dst = this->sourceFrames + this->sourceFrameCount * 2;
+            for (int i = 0; i < frames; i++) {
+                int16_t left, right;
+                if (this->bytesPerSample == 2) {
+                    left  = (int16_t)readUint16(src);
+                    right = (this->channels == 2) ? (int16_t)readUint16(src + 2) : left;
+                } else {
+                    left  = (int16_t)((src[0] - 128) << 8);
+                    right = (this->channels == 2) ? (int16_t)((src[1] - 128) << 8) : left;
+                }
+                dst[i * 2]     = left;
+                dst[i * 2 + 1] = right;
+                src += frameBytes;
+            }
+            this->sourceFrameCount += frames;
+
+            // keep the partial frame for the next read
+            this->readFill -= frames * frameBytes;
+            memmove(this->readBuffer, src, this->readFill);
+            return true;
+        }
+    }
+
+    /*
+     * resample linearly into outputFrames. returns the number of frames
+     * and sets finished if the source has no more data.
+     */
+    int AudioStream::decode(int maxFrames, bool* finished) {
+        *finished = false;
+        int produced = 0;
+        while (produced < maxFrames) {
+            uint32_t index = this->position >> 32;
+            if (index + 1 >= (uint32_t)this->sourceFrameCount) {
+                uint32_t keepFrom = index;
+                if (keepFrom > (uint32_t)this->sourceFrameCount) keepFrom = this->sourceFrameCount;
+                if (!this->fillSource(keepFrom)) {
+                    *finished = true;
+                    break;
+                }
+                continue;
+            }
+
+            int frac = (uint32_t)this->position >> 17;
+            const int16_t* src = this->sourceFrames + index * 2;
+            this->outputFrames[produced * 2]     = src[0] + (((src[2] - src[0]) * frac) >> 15);
+            this->outputFrames[produced * 2 + 1] = src[1] + (((src[3] - src[1]) * frac) >> 15);
+
+            this->position += this->step;
+            produced++;
+        }
+        return produced;
+    }
+
+    void AudioStream::decodeLoop() {
+        while (!this->quit) {
+            uint32_t seq = this->seekSeq;
+            if (seq != this->servedSeekSeq) {
+                __sync_synchronize();
+                this->seekSource(this->seekFrame);
+                this->ring.flush();
+                this->ended = false;
+                __sync_synchronize();
+                this->servedSeekSeq = seq;
+                continue;
+            }
+
+            // looping enabled after the end was reached: continue from the beginning
+            if (this->ended && this->looping) {
+                this->ended = false;
+            }
+
+            if (!this->ended && this->ring.getWritable() >= AUDIO_STREAM_CHUNK_FRAMES) {
+                bool finished;
+                int frames = this->decode(AUDIO_STREAM_CHUNK_FRAMES, &finished);
+                this->ring.write(this->outputFrames, frames);
+                if (finished) {
+                    // publish the last frames before the end
+                    __sync_synchronize();
+                    this->ended = true;
+                }
+                continue;
+            }
+
+            sem_wait(&this->wakeup);
+        }
+    }
+
+    void* AudioStream::decodeThread(void* arg) {
+        ((AudioStream*)arg)->decodeLoop();
+        return NULL;
+    }
+}
@@ -0,0 +1,166 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_AUDIO_STREAM_H
+#define EMO_AUDIO_STREAM_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#define AUDIO_STREAM_RING_FRAMES  8192
+#define AUDIO_STREAM_CHUNK_FRAMES 1024
+#define AUDIO_STREAM_READ_BYTES   4096
+
+/*
+ * Streaming playback for long sounds such as music.
+ * A decode thread reads the source incrementally and fills a lock-free
+ * ring buffer that the mixer drains from the audio callback.
+ * This file does not depend on the platform: the source is provided
+ * by the caller (an asset on Android).
+ */
+namespace emo {
+    class AudioStreamSource {
+    public:
+        virtual ~AudioStreamSource() {}
+        // returns the number of bytes read, 0 at the end or negative on error
+        virtual int  read(void* buffer, int size) = 0;
+        // seek to the absolute byte offset
+        virtual bool seek(long offset) = 0;
+    };
+
+    /*
+     * single producer / single consumer ring of interleaved stereo 16bit frames.
+     * the decode thread writes and flushes, the audio thread reads.
+     */
+    class AudioRingBuffer {
+    public:
+        AudioRingBuffer(int frameCount);
+        ~AudioRingBuffer();
+
+        int getCapacity();
+
+        int  getWritable();
+        int  write(const int16_t* frames, int count);
+        void flush();
+
+        bool applyFlush();
+        int  getReadable();
+        int  read(int16_t* frames, int count);
+    protected:
+        int16_t* data;
+        uint32_t capacity;
+        uint32_t mask;
+        volatile uint32_t writePos;
+        volatile uint32_t readPos;
+        volatile uint32_t flushPos;
+        volatile uint32_t flushSeq;
+        uint32_t appliedFlushSeq;
+    };
+
+    struct AudioStreamStats {
+        uint32_t underrunCount;
+        uint32_t underrunFrames;
+        uint32_t bufferedFrames;
+        uint32_t capacityFrames;
+        uint32_t memoryBytes;
+    };
+
+    /*
+     * streaming 8bit or 16bit PCM wav, resampled to the output rate
+     * on the decode thread
+     */
+    class AudioStream {
+    public:
+        AudioStream(AudioStreamSource* source, int outputRate);
+        ~AudioStream();
+
+        bool open();
+
+        void seek(int millis);
+        void setLooping(bool looping);
+        bool isLooping();
+
+        int  pull(int16_t* out, int frameCount);
+        bool isEnded();
+
+        void getStats(AudioStreamStats* stats);
+        bool isMixing();
+
+        int channels;
+        int sampleRate;
+        int frameCount;
+
+        // voices that may still pull the stream, see AudioSample::voiceRefs
+        volatile int32_t voiceRefs;
+    protected:
+        AudioStreamSource* source;
+        AudioRingBuffer ring;
+        int outputRate;
+        int bytesPerSample;
+
+        long dataStart;
+        long dataSize;
+        long dataRemaining;
+
+        pthread_t thread;
+        sem_t wakeup;
+        bool threadStarted;
+        volatile bool quit;
+        volatile bool looping;
+        volatile bool ended;
+
+        // seek requests: written by the caller, served by the decode thread
+        volatile uint32_t seekFrame;
+        volatile uint32_t seekSeq;
+        volatile uint32_t servedSeekSeq;
+
+        // consumer state
+        bool primed;
+        volatile uint32_t underrunCount;
+        volatile uint32_t underrunFrames;
+
+        // decoder state
+        unsigned char* readBuffer;
+        int       readFill;
+        int16_t*  sourceFrames;
+        int       sourceFrameCount;
+        int16_t*  outputFrames;
+        uint64_t  position;
+        uint64_t  step;
+
+        bool readHeader();
+        bool readFully(void* buffer, int size);
+        bool seekSource(uint32_t frame);
+        bool fillSource(uint32_t keepFrom);
+        int  decode(int maxFrames, bool* finished);
+        void decodeLoop();
+
+        static void* decodeThread(void* arg);
+    };
+}
+#endif
@@ -68,6 +68,8 @@
 #define EMO_FUNC_KEYEVENT       "_onKeyEvent"
 #define EMO_FUNC_SENSOREVENT    "_onSensorEvent"
 #define EMO_FUNC_ONCALLBACK     "_onNetCallback"
+#define EMO_FUNC_ONDATABASE_CALLBACK "_onDatabaseCallback"
+#define EMO_FUNC_ONCAPTURE_CALLBACK  "_onCaptureCallback"
 #define EMO_FUNC_ON_UPDATE      "_onUpdate"
 #define EMO_FUNC_ON_FPS         "_onFps"
 #define EMO_FUNC_ONSTOP_OFFSCREEN   "_onStopOffScreen"
@@ -127,6 +129,11 @@
 #define OPT_ORIENTATION_UNSPECIFIED     0x1008
 #define OPT_ORIENTATION_LANDSCAPE_LEFT  0x1009
 #define OPT_ORIENTATION_LANDSCAPE_RIGHT 0x1010
+#define OPT_ENABLE_PREMULTIPLIED_ALPHA  0x1011
+#define OPT_DISABLE_PREMULTIPLIED_ALPHA 0x1012
+#define OPT_ENABLE_MIPMAP               0x1013
+#define OPT_AUTO_MIPMAP                 0x1014
+#define OPT_DISABLE_MIPMAP              0x1015
 
 #define MOTION_EVENT_ACTION_DOWN            0
 #define MOTION_EVENT_ACTION_UP              1
@@ -200,6 +207,23 @@
 #define PHYSICS_STATE_PERSIST 1
 #define PHYSICS_STATE_REMOVE  2
 
+/*
+ * record layout of packed body data (float32 values)
+ * type, x, y, angle, shape, hx or radius, hy, density, friction, restitution
+ */
+#define PHYSICS_BATCH_STRIDE 10
+
+#define PHYSICS_DEBUGDRAW_SHAPE          0x0001
+#define PHYSICS_DEBUGDRAW_JOINT          0x0002
+#define PHYSICS_DEBUGDRAW_AABB           0x0004
+#define PHYSICS_DEBUGDRAW_PAIR           0x0008
+#define PHYSICS_DEBUGDRAW_CENTER_OF_MASS 0x0010
+#define PHYSICS_DEBUGDRAW_CONTACT        0x0020
+
+#define PHYSICS_PROFILE_LOG_NONE    0
+#define PHYSICS_PROFILE_LOG_STEP    1
+#define PHYSICS_PROFILE_LOG_AVERAGE 2
+
 #define RETINA_SCALE_FACTOR 2
 
 #define POINTS_2D_SIZE 2
@@ -48,6 +48,22 @@ void initDatabaseFunctions() {
     registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "getLastError", emoDatabaseGetLastError);
     registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "getLastErrorMessage", emoDatabaseGetLastErrorMessage);
     registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "deleteDatabase", emoDatabaseDeleteDatabase);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "exec",         emoDatabaseExec);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "prepareStatement",  emoDatabasePrepareStatement);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "bind",         emoDatabaseBindStatement);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "step",         emoDatabaseStepStatement);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "fetch",        emoDatabaseFetchStatement);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "getColumns",   emoDatabaseGetStatementColumns);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "resetStatement",    emoDatabaseResetStatement);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "finalizeStatement", emoDatabaseFinalizeStatement);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "begin",        emoDatabaseBeginTransaction);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "commit",       emoDatabaseCommitTransaction);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "rollback",     emoDatabaseRollbackTransaction);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "getChanges",   emoDatabaseGetChanges);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "getLastInsertRowId", emoDatabaseGetLastInsertRowId);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "submit",       emoDatabaseSubmit);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "submitBatch",  emoDatabaseSubmitBatch);
+    registerClassFunc(engine->sqvm, EMO_DATABASE_CLASS, "getExecutorStats", emoDatabaseGetExecutorStats);
 
     registerClassFunc(engine->sqvm, EMO_PREFERENCE_CLASS, "open",         emoDatabaseOpenPreference);
     registerClassFunc(engine->sqvm, EMO_PREFERENCE_CLASS, "openOrCreate", emoDatabaseOpenOrCreatePreference);
@@ -56,12 +72,8 @@ void initDatabaseFunctions() {
     registerClassFunc(engine->sqvm, EMO_PREFERENCE_CLASS, "del",          emoDatabaseDeletePreference);
     registerClassFunc(engine->sqvm, EMO_PREFERENCE_CLASS, "keys",         emoDatabaseGetPreferenceKeys);
     registerClassFunc(engine->sqvm, EMO_PREFERENCE_CLASS, "close",        emoDatabaseClose);
-}
-
-static int database_preference_callback(void *arg, int argc, char **argv, char **column)  {
-    std::string* value = (std::string*)arg;
-    if (argc > 0) *value = argv[0];
-    return SQLITE_OK;
+    registerClassFunc(engine->sqvm, EMO_PREFERENCE_CLASS, "flush",        emoDatabaseFlushPreference);
+    registerClassFunc(engine->sqvm, EMO_PREFERENCE_CLASS, "setFlushInterval", emoDatabaseSetPreferenceFlushInterval);
 }
 
 static int database_count_callback(void *arg, int argc, char **argv, char **column)  {
@@ -80,15 +92,106 @@ static int database_query_vector_callback(void *arg, int argc, char **argv, char
     return SQLITE_OK;
 }
 
+/*
+ * convert the squirrel value at the stack index to a database value
+ */
+static bool getDatabaseValue(HSQUIRRELVM v, SQInteger idx, emo::DatabaseValue* value) {
+    switch (sq_gettype(v, idx)) {
+    case OT_INTEGER: {
+        SQInteger i;
+        sq_getinteger(v, idx, &i);
+        value->type = SQLITE_INTEGER;
+        value->integer = i;
+        return true;
+    }
+    case OT_FLOAT: {
+        SQFloat f;
+        sq_getfloat(v, idx, &f);
+        value->type = SQLITE_FLOAT;
+        value->real = f;
+        return true;
+    }
+    case OT_BOOL: {
+        SQBool b;
+        sq_getbool(v, idx, &b);
+        value->type = SQLITE_INTEGER;
+        value->integer = b ? 1 : 0;
+        return true;
+    }
+    case OT_STRING: {
+        const SQChar* str;
+        sq_getstring(v, idx, &str);
+        value->type = SQLITE_TEXT;
+        value->text.assign(str, sq_getsize(v, idx));
+        return true;
+    }
+    case OT_NULL:
+        value->type = SQLITE_NULL;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ * convert the squirrel array at the stack index to database values
+ */
+static bool getDatabaseRow(HSQUIRRELVM v, SQInteger idx, emo::DatabaseRow* row) {
+    bool result = true;
+    sq_push(v, idx);
+    sq_pushnull(v);
+    while (SQ_SUCCEEDED(sq_next(v, -2))) {
+        emo::DatabaseValue value;
+        if (!getDatabaseValue(v, -1, &value)) result = false;
+        row->push_back(value);
+        sq_pop(v, 2);
+    }
+    sq_pop(v, 2);
+    return result;
+}
+
+static void pushDatabaseRow(HSQUIRRELVM v, const emo::DatabaseRow& row) {
+    sq_newarray(v, 0);
+    for (size_t i = 0; i < row.size(); i++) {
+        const emo::DatabaseValue& value = row[i];
+        switch (value.type) {
+        case SQLITE_INTEGER:
+            sq_pushinteger(v, (SQInteger)value.integer);
+            break;
+        case SQLITE_FLOAT:
+            sq_pushfloat(v, (SQFloat)value.real);
+            break;
+        case SQLITE_TEXT:
+            sq_pushstring(v, value.text.data(), value.text.size());
+            break;
+        default:
+            sq_pushnull(v);
+            break;
+        }
+        sq_arrayappend(v, -2);
+    }
+}
+
 namespace emo {
 
     Database::Database() {
         this->isOpen = false;
         this->lastError = SQLITE_OK;
+        this->preferenceStore = NULL;
+        this->nextStatementId = 0;
+        this->executor = NULL;
     }
 
     Database::~Database() {
-
+        if (this->executor != NULL) {
+            delete this->executor;
+        }
+        for (size_t i = 0; i < this->completedTasks.size(); i++) {
+            delete this->completedTasks[i];
+        }
+        if (this->preferenceStore != NULL) {
+            delete this->preferenceStore;
+        }
     }
 
     std::string Database::getPath(std::string name) {
@@ -144,6 +247,13 @@ namespace emo {
     }
 
     bool Database::deleteDatabase(std::string name) {
+        // the store would keep serving and writing the deleted file.
+        // it is opened again on the next preference access.
+        if (name == DEFAULT_DATABASE_NAME && this->preferenceStore != NULL) {
+            delete this->preferenceStore;
+            this->preferenceStore = NULL;
+        }
+
         JNIEnv* env;
         JavaVM* vm = engine->app->activity->vm;
         
@@ -162,12 +272,16 @@ namespace emo {
         if (this->isOpen) return false;
         
         std::string path = this->create(name, mode);
+        this->path = path;
         
         int rcode = sqlite3_open(path.c_str(), &this->db);
         
         if (rcode != SQLITE_OK) {
             this->lastError = rcode;
             this->lastErrorMessage =  sqlite3_errmsg(this->db);
+        } else {
+            // wait while the executor thread holds the write lock
+            sqlite3_busy_timeout(this->db, DATABASE_BUSY_TIMEOUT);
         }
         
         this->isOpen = true;
@@ -178,12 +292,16 @@ namespace emo {
         if (this->isOpen) return false;
 
         std::string path = this->getPath(name);
+        this->path = path;
 
         int rcode = sqlite3_open(path.c_str(), &this->db);
         
         if (rcode != SQLITE_OK) {
             this->lastError = rcode;
             this->lastErrorMessage =  sqlite3_errmsg(this->db);
+        } else {
+            // wait while the executor thread holds the write lock
+            sqlite3_busy_timeout(this->db, DATABASE_BUSY_TIMEOUT);
         }
         
         this->isOpen = true;
@@ -193,6 +311,15 @@ namespace emo {
     bool Database::close() {
         if (!this->isOpen) return false;
 
+        // queued tasks finish and their callbacks are dispatched on the next frame
+        if (this->executor != NULL) {
+            this->executor->stop();
+            this->executor->takeCompleted(&this->completedTasks);
+            delete this->executor;
+            this->executor = NULL;
+        }
+
+        this->finalizeStatements();
         sqlite3_close(this->db);
 
         this->isOpen = false;
@@ -232,111 +359,260 @@ namespace emo {
         return rcode;
     }
 
-    bool Database::openOrCreatePreference() {
-        bool result = this->openOrCreate(DEFAULT_DATABASE_NAME, FILE_MODE_PRIVATE);
-        if (!result) return false;
-
-        char* sql = sqlite3_mprintf("CREATE TABLE IF NOT EXISTS %q (KEY TEXT PRIMARY KEY, VALUE TEXT)", PREFERENCE_TABLE_NAME);
-        int rcode = this->exec(sql);
-        sqlite3_free(sql);
+    bool Database::execute(std::string sql) {
+        if (!this->isOpen) return false;
+        return this->exec(sql) == SQLITE_OK;
+    }
 
-        return rcode == SQLITE_OK;
+    void Database::setStatementError(int rcode) {
+        this->lastError = rcode;
+        this->lastErrorMessage = sqlite3_errmsg(this->db);
     }
 
-    bool Database::openPreference() {
-        return this->open(DEFAULT_DATABASE_NAME);
+    /*
+     * prepare the statement and returns its id.
+     * the statement lives until it is finalized or the database is closed.
+     *
+     * @return statement id, -1 if fails
+     */
+    int Database::prepareStatement(std::string sql) {
+        if (!this->isOpen) return -1;
+
+        sqlite3_stmt* stmt = NULL;
+        int rcode = sqlite3_prepare_v2(this->db, sql.c_str(), sql.size(), &stmt, NULL);
+        if (rcode != SQLITE_OK) {
+            this->setStatementError(rcode);
+            sqlite3_finalize(stmt);
+            return -1;
+        }
+        if (stmt == NULL) {
+            this->lastError = SQLITE_MISUSE;
+            this->lastErrorMessage = "empty statement";
+            return -1;
+        }
+
+        int id = this->nextStatementId++;
+        this->statements[id] = stmt;
+        return id;
     }
 
-    std::string Database::getPreference(std::string key) {
-        bool forceClose = false;
+    sqlite3_stmt* Database::getStatement(int id) {
+        std::map<int, sqlite3_stmt*>::iterator it = this->statements.find(id);
+        if (it == this->statements.end()) return NULL;
+        return it->second;
+    }
 
-        if (!this->isOpen) {
-            this->openOrCreatePreference();
-            forceClose = true;
+    /*
+     * advance the statement to the next row
+     *
+     * @return SQLITE_ROW, SQLITE_DONE or the error code
+     */
+    int Database::stepStatement(int id) {
+        sqlite3_stmt* stmt = this->getStatement(id);
+        if (stmt == NULL) return SQLITE_MISUSE;
+
+        int rcode = sqlite3_step(stmt);
+        if (rcode != SQLITE_ROW && rcode != SQLITE_DONE) {
+            this->setStatementError(rcode);
         }
+        return rcode;
+    }
 
-        std::string value;
-        char* sql = sqlite3_mprintf("SELECT VALUE FROM %q WHERE KEY=%Q", PREFERENCE_TABLE_NAME, key.c_str());
+    bool Database::resetStatement(int id) {
+        sqlite3_stmt* stmt = this->getStatement(id);
+        if (stmt == NULL) return false;
 
-        char* error;
-        int rcode = sqlite3_exec(this->db, sql, database_preference_callback, &value, &error);
-        if (rcode != SQLITE_OK) {
-            this->lastError = rcode;
-            this->lastErrorMessage = error;
-            sqlite3_free(error);
-        }
-        sqlite3_free(sql);
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        return true;
+    }
 
-        if (forceClose) {
-            this->close();
+    bool Database::finalizeStatement(int id) {
+        std::map<int, sqlite3_stmt*>::iterator it = this->statements.find(id);
+        if (it == this->statements.end()) return false;
+
+        sqlite3_finalize(it->second);
+        this->statements.erase(it);
+        return true;
+    }
+
+    void Database::finalizeStatements() {
+        for (std::map<int, sqlite3_stmt*>::iterator it = this->statements.begin(); it != this->statements.end(); it++) {
+            sqlite3_finalize(it->second);
         }
-        return value;
+        this->statements.clear();
     }
 
-    bool Database::setPreference(std::string key, std::string value) {
+    bool Database::beginTransaction() {
+        return this->execute("BEGIN");
+    }
 
-        bool forceClose = false;
-        if (!this->isOpen) {
-            this->openOrCreatePreference();
-            forceClose = true;
-        }
+    bool Database::commitTransaction() {
+        return this->execute("COMMIT");
+    }
+
+    bool Database::rollbackTransaction() {
+        return this->execute("ROLLBACK");
+    }
 
-        int count;
-        char *csql = sqlite3_mprintf("SELECT COUNT(*) FROM %q WHERE KEY=%Q", PREFERENCE_TABLE_NAME, key.c_str());
-        exec_count(csql, &count);
-        sqlite3_free(csql);
+    int Database::getChanges() {
+        if (!this->isOpen) return 0;
+        return sqlite3_changes(this->db);
+    }
 
-        int rcode = SQLITE_OK;
-        if (count == 0) {
-            char* sql = sqlite3_mprintf("INSERT INTO %q(KEY,VALUE) VALUES(%Q,%Q)", PREFERENCE_TABLE_NAME, key.c_str(), value.c_str());
-            rcode = this->exec(sql);
-            sqlite3_free(sql);
-        } else {
-            char* sql = sqlite3_mprintf("UPDATE %q SET VALUE=%Q WHERE KEY=%Q", PREFERENCE_TABLE_NAME, value.c_str(), key.c_str());
-            rcode = this->exec(sql);
-            sqlite3_free(sql);
+    sqlite3_int64 Database::getLastInsertRowId() {
+        if (!this->isOpen) return 0;
+        return sqlite3_last_insert_rowid(this->db);
+    }
+
+    /*
+     * queue the task to the executor thread of this database.
+     * the executor is started by the first task.
+     * the task is deleted if it can not be queued.
+     */
+    bool Database::submitTask(DatabaseTask* task) {
+        if (this->isOpen && this->executor == NULL) {
+            DatabaseExecutor* executor = new DatabaseExecutor();
+            if (!executor->open(this->path)) {
+                this->lastError = executor->lastError;
+                this->lastErrorMessage = executor->lastErrorMessage;
+                delete executor;
+            } else {
+                this->executor = executor;
+            }
+        }
+        if (this->executor == NULL) {
+            delete task;
+            return false;
         }
+        this->executor->submit(task);
+        return true;
+    }
 
-        if (forceClose) {
-            this->close();
+    /*
+     * call the database callback of the script for each completed task.
+     * called on the main thread at the start of the frame.
+     */
+    void Database::dispatchCallbacks(HSQUIRRELVM v) {
+        if (this->executor != NULL) {
+            this->executor->takeCompleted(&this->completedTasks);
         }
+        if (this->completedTasks.empty()) return;
+
+        std::vector<DatabaseTask*> tasks;
+        tasks.swap(this->completedTasks);
+
+        for (size_t i = 0; i < tasks.size(); i++) {
+            DatabaseTask* task = tasks[i];
+
+            SQInteger top = sq_gettop(v);
+            sq_pushroottable(v);
+            sq_pushstring(v, EMO_NAMESPACE, -1);
+            if (SQ_SUCCEEDED(sq_get(v, -2))) {
+                sq_pushstring(v, EMO_FUNC_ONDATABASE_CALLBACK, -1);
+                if (SQ_SUCCEEDED(sq_get(v, -2))) {
+                    sq_pushroottable(v);
+                    sq_pushstring(v, task->name.c_str(), -1);
+                    sq_newarray(v, 0);
+                    for (size_t j = 0; j < task->rows.size(); j++) {
+                        pushDatabaseRow(v, task->rows[j]);
+                        sq_arrayappend(v, -2);
+                    }
+                    sq_pushinteger(v, task->error);
+                    sq_pushstring(v, task->errorMessage.c_str(), -1);
+                    sq_call(v, 5, SQFalse, SQTrue);
+                }
+            }
+            sq_settop(v, top);
 
-        return rcode == SQLITE_OK;
+            delete task;
+        }
     }
 
-    std::vector<std::string> Database::getPreferenceKeys() {
-        bool forceClose = false;
-        if (!this->isOpen) {
-            this->openOrCreatePreference();
-            forceClose = true;
+    bool Database::getExecutorStats(DatabaseExecutorStats* stats) {
+        if (this->executor == NULL) return false;
+        this->executor->getStats(stats);
+        return true;
+    }
+
+    /*
+     * open the write-behind preference store.
+     * all preference values are loaded into memory once and
+     * changes are written to the database by the flush thread.
+     */
+    bool Database::loadPreferenceStore() {
+        if (this->preferenceStore != NULL) return true;
+
+        std::string path = this->create(DEFAULT_DATABASE_NAME, FILE_MODE_PRIVATE);
+
+        PreferenceStore* store = new PreferenceStore();
+        if (!store->open(path)) {
+            this->lastError = store->getLastError();
+            this->lastErrorMessage = store->getLastErrorMessage();
+            delete store;
+            return false;
         }
+        this->preferenceStore = store;
+        return true;
+    }
 
-        std::vector<std::string> keys;
-        char *sql = sqlite3_mprintf("SELECT KEY FROM %q", PREFERENCE_TABLE_NAME);
-        query_vector(sql, &keys);
+    bool Database::openOrCreatePreference() {
+        bool result = this->openOrCreate(DEFAULT_DATABASE_NAME, FILE_MODE_PRIVATE);
+        if (!result) return false;
+
+        char* sql = sqlite3_mprintf("CREATE TABLE IF NOT EXISTS %q (KEY TEXT PRIMARY KEY, VALUE TEXT)", PREFERENCE_TABLE_NAME);
+        int rcode = this->exec(sql);
         sqlite3_free(sql);
 
-        if (forceClose) {
-            this->close();
-        }
-        return keys;
+        return rcode == SQLITE_OK && this->loadPreferenceStore();
     }
 
-    bool Database::deletePreference(std::string key) {
-        bool forceClose = false;
-        if (!this->isOpen) {
-            this->openOrCreatePreference();
-            forceClose = true;
+    bool Database::openPreference() {
+        return this->open(DEFAULT_DATABASE_NAME) && this->loadPreferenceStore();
+    }
+
+    std::string Database::getPreference(std::string key) {
+        std::string value;
+        if (this->loadPreferenceStore()) {
+            this->preferenceStore->get(key, &value);
         }
+        return value;
+    }
 
-        char *sql = sqlite3_mprintf("DELETE FROM %q WHERE KEY=%Q", PREFERENCE_TABLE_NAME, key.c_str());
-        int rcode = this->exec(sql);
-        sqlite3_free(sql);
+    bool Database::setPreference(std::string key, std::string value) {
+        if (!this->loadPreferenceStore()) return false;
+        this->preferenceStore->set(key, value);
+        return true;
+    }
+
+    std::vector<std::string> Database::getPreferenceKeys() {
+        if (!this->loadPreferenceStore()) return std::vector<std::string>();
+        return this->preferenceStore->getKeys();
+    }
 
-        if (forceClose) {
-            this->close();
+    bool Database::deletePreference(std::string key) {
+        if (!this->loadPreferenceStore()) return false;
+        this->preferenceStore->remove(key);
+        return true;
+    }
+
+    /*
+     * write the pending preference changes.
+     * if wait is true, blocks until the changes are on disk and
+     * returns false if they could not be written.
+     */
+    bool Database::flushPreference(bool wait) {
+        if (this->preferenceStore == NULL) return true;
+        if (!this->preferenceStore->flush(wait)) {
+            this->lastError = this->preferenceStore->getLastError();
+            this->lastErrorMessage = this->preferenceStore->getLastErrorMessage();
+            return false;
         }
-        return rcode == SQLITE_OK;
+        return true;
+    }
+
+    PreferenceStore* Database::getPreferenceStore() {
+        return this->preferenceStore;
     }
 
 }
@@ -619,3 +895,544 @@ SQInteger emoDatabaseGetPreferenceKeys(HSQUIRRELVM v) {
     return 1;
 }
 
+
+/*
+ * write the pending preference changes to the database
+ *
+ * @param wait until the changes are written (default false)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDatabaseFlushPreference(HSQUIRRELVM v) {
+    SQBool wait = SQFalse;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 2 && sq_gettype(v, 2) == OT_BOOL) {
+        sq_getbool(v, 2, &wait);
+    }
+
+    if (engine->database->getPreferenceStore() == NULL) {
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    if (!engine->database->flushPreference(wait)) {
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * set the interval of the background preference flush
+ * zero disables the timer and flushes only on request
+ *
+ * @param interval in milliseconds
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDatabaseSetPreferenceFlushInterval(HSQUIRRELVM v) {
+    SQInteger interval;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 2 && sq_gettype(v, 2) == OT_INTEGER) {
+        sq_getinteger(v, 2, &interval);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (engine->database->getPreferenceStore() == NULL) {
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    engine->database->getPreferenceStore()->setFlushInterval(interval < 0 ? 0 : interval);
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * bind the squirrel value at the stack index to the statement parameter
+ */
+static int bindStatementValue(HSQUIRRELVM v, sqlite3_stmt* stmt, int param, SQInteger idx) {
+    switch (sq_gettype(v, idx)) {
+    case OT_INTEGER: {
+        SQInteger value;
+        sq_getinteger(v, idx, &value);
+        return sqlite3_bind_int64(stmt, param, value);
+    }
+    case OT_FLOAT: {
+        SQFloat value;
+        sq_getfloat(v, idx, &value);
+        return sqlite3_bind_double(stmt, param, value);
+    }
+    case OT_BOOL: {
+        SQBool value;
+        sq_getbool(v, idx, &value);
+        return sqlite3_bind_int(stmt, param, value ? 1 : 0);
+    }
+    case OT_STRING: {
+        const SQChar* value;
+        sq_getstring(v, idx, &value);
+        return sqlite3_bind_text(stmt, param, value, sq_getsize(v, idx), SQLITE_TRANSIENT);
+    }
+    case OT_NULL:
+        return sqlite3_bind_null(stmt, param);
+    default:
+        return SQLITE_MISMATCH;
+    }
+}
+
+/*
+ * push the current row of the statement as an array of typed values.
+ * text and blob columns are pushed as strings without conversion.
+ */
+static void pushStatementRow(HSQUIRRELVM v, sqlite3_stmt* stmt) {
+    int count = sqlite3_column_count(stmt);
+    sq_newarray(v, 0);
+    for (int i = 0; i < count; i++) {
+        switch (sqlite3_column_type(stmt, i)) {
+        case SQLITE_INTEGER:
+            sq_pushinteger(v, (SQInteger)sqlite3_column_int64(stmt, i));
+            break;
+        case SQLITE_FLOAT:
+            sq_pushfloat(v, (SQFloat)sqlite3_column_double(stmt, i));
+            break;
+        case SQLITE_TEXT:
+            sq_pushstring(v, (const SQChar*)sqlite3_column_text(stmt, i), sqlite3_column_bytes(stmt, i));
+            break;
+        case SQLITE_BLOB:
+            sq_pushstring(v, (const SQChar*)sqlite3_column_blob(stmt, i), sqlite3_column_bytes(stmt, i));
+            break;
+        default:
+            sq_pushnull(v);
+            break;
+        }
+        sq_arrayappend(v, -2);
+    }
+}
+
+static bool getStatementId(HSQUIRRELVM v, SQInteger* id) {
+    if (sq_gettop(v) >= 2 && sq_gettype(v, 2) == OT_INTEGER) {
+        sq_getinteger(v, 2, id);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * execute the sql statements without results
+ *
+ * @param sql
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDatabaseExec(HSQUIRRELVM v) {
+    const SQChar* sql;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 2 && sq_gettype(v, 2) == OT_STRING) {
+        sq_getstring(v, 2, &sql);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!engine->database->execute(sql)) {
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * prepare the sql statement
+ *
+ * @param sql
+ * @return statement id, -1 if fails
+ */
+SQInteger emoDatabasePrepareStatement(HSQUIRRELVM v) {
+    const SQChar* sql;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 2 && sq_gettype(v, 2) == OT_STRING) {
+        sq_getstring(v, 2, &sql);
+    } else {
+        sq_pushinteger(v, -1);
+        return 1;
+    }
+
+    sq_pushinteger(v, engine->database->prepareStatement(sql));
+    return 1;
+}
+
+/*
+ * bind the parameters of the statement.
+ * bind(id, index, value) binds one parameter (index starts at 1),
+ * bind(id, array) binds the array from the first parameter.
+ *
+ * @param statement id
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDatabaseBindStatement(HSQUIRRELVM v) {
+    SQInteger id;
+    if (!getStatementId(v, &id)) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    sqlite3_stmt* stmt = engine->database->getStatement(id);
+    if (stmt == NULL) {
+        sq_pushinteger(v, ERR_INVALID_ID);
+        return 1;
+    }
+
+    int rcode = SQLITE_OK;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 3 && sq_gettype(v, 3) == OT_ARRAY) {
+        int param = 1;
+        sq_push(v, 3);
+        sq_pushnull(v);
+        while (SQ_SUCCEEDED(sq_next(v, -2))) {
+            if (rcode == SQLITE_OK) {
+                rcode = bindStatementValue(v, stmt, param++, -1);
+            }
+            sq_pop(v, 2);
+        }
+        sq_pop(v, 2);
+    } else if (nargs >= 4 && sq_gettype(v, 3) == OT_INTEGER) {
+        SQInteger param;
+        sq_getinteger(v, 3, &param);
+        rcode = bindStatementValue(v, stmt, param, 4);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (rcode != SQLITE_OK) {
+        engine->database->lastError = rcode;
+        engine->database->lastErrorMessage = sqlite3_errmsg(sqlite3_db_handle(stmt));
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * step the statement to the next row
+ *
+ * @param statement id
+ * @return array of column values, null if there are no more rows or fails
+ */
+SQInteger emoDatabaseStepStatement(HSQUIRRELVM v) {
+    SQInteger id;
+    if (!getStatementId(v, &id)) {
+        return 0;
+    }
+
+    if (engine->database->stepStatement(id) != SQLITE_ROW) {
+        return 0;
+    }
+
+    pushStatementRow(v, engine->database->getStatement(id));
+    return 1;
+}
+
+/*
+ * fetch the next rows of the statement
+ *
+ * @param statement id
+ * @param maximum row count
+ * @return array of rows, each row is an array of column values
+ */
+SQInteger emoDatabaseFetchStatement(HSQUIRRELVM v) {
+    SQInteger id;
+    if (!getStatementId(v, &id)) {
+        return 0;
+    }
+
+    SQInteger count;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 3 && sq_gettype(v, 3) == OT_INTEGER) {
+        sq_getinteger(v, 3, &count);
+    } else {
+        return 0;
+    }
+
+    sqlite3_stmt* stmt = engine->database->getStatement(id);
+    if (stmt == NULL) {
+        return 0;
+    }
+
+    sq_newarray(v, 0);
+    for (SQInteger i = 0; i < count; i++) {
+        if (engine->database->stepStatement(id) != SQLITE_ROW) break;
+        pushStatementRow(v, stmt);
+        sq_arrayappend(v, -2);
+    }
+
+    return 1;
+}
+
+/*
+ * returns column names of the statement
+ *
+ * @param statement id
+ * @return array of column names
+ */
+SQInteger emoDatabaseGetStatementColumns(HSQUIRRELVM v) {
+    SQInteger id;
+    if (!getStatementId(v, &id)) {
+        return 0;
+    }
+
+    sqlite3_stmt* stmt = engine->database->getStatement(id);
+    if (stmt == NULL) {
+        return 0;
+    }
+
+    int count = sqlite3_column_count(stmt);
+    sq_newarray(v, 0);
+    for (int i = 0; i < count; i++) {
+        sq_pushstring(v, sqlite3_column_name(stmt, i), -1);
+        sq_arrayappend(v, -2);
+    }
+
+    return 1;
+}
+
+/*
+ * reset the statement and clear its bindings
+ *
+ * @param statement id
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDatabaseResetStatement(HSQUIRRELVM v) {
+    SQInteger id;
+    if (!getStatementId(v, &id)) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!engine->database->resetStatement(id)) {
+        sq_pushinteger(v, ERR_INVALID_ID);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * finalize the statement
+ *
+ * @param statement id
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDatabaseFinalizeStatement(HSQUIRRELVM v) {
+    SQInteger id;
+    if (!getStatementId(v, &id)) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!engine->database->finalizeStatement(id)) {
+        sq_pushinteger(v, ERR_INVALID_ID);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * begin transaction
+ */
+SQInteger emoDatabaseBeginTransaction(HSQUIRRELVM v) {
+    if (!engine->database->beginTransaction()) {
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * commit transaction
+ */
+SQInteger emoDatabaseCommitTransaction(HSQUIRRELVM v) {
+    if (!engine->database->commitTransaction()) {
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * rollback transaction
+ */
+SQInteger emoDatabaseRollbackTransaction(HSQUIRRELVM v) {
+    if (!engine->database->rollbackTransaction()) {
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * returns the number of rows changed by the latest statement
+ */
+SQInteger emoDatabaseGetChanges(HSQUIRRELVM v) {
+    sq_pushinteger(v, engine->database->getChanges());
+    return 1;
+}
+
+/*
+ * returns the rowid of the latest inserted row
+ */
+SQInteger emoDatabaseGetLastInsertRowId(HSQUIRRELVM v) {
+    sq_pushinteger(v, (SQInteger)engine->database->getLastInsertRowId());
+    return 1;
+}
+
+/*
+ * run the sql statement on the executor thread.
+ * the result is passed to emo.onDatabaseCallback(name, rows, error)
+ * at the start of the next frame.
+ *
+ * @param task name
+ * @param sql
+ * @param array of parameters (optional)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDatabaseSubmit(HSQUIRRELVM v) {
+    SQInteger nargs = sq_gettop(v);
+    if (nargs < 3 || sq_gettype(v, 2) != OT_STRING || sq_gettype(v, 3) != OT_STRING) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    const SQChar* name;
+    const SQChar* sql;
+    sq_getstring(v, 2, &name);
+    sq_getstring(v, 3, &sql);
+
+    emo::DatabaseTask* task = new emo::DatabaseTask();
+    task->name = name;
+    task->sql.push_back(sql);
+
+    if (nargs >= 4 && sq_gettype(v, 4) == OT_ARRAY) {
+        task->params.resize(1);
+        if (!getDatabaseRow(v, 4, &task->params[0])) {
+            delete task;
+            sq_pushinteger(v, ERR_INVALID_PARAM);
+            return 1;
+        }
+    }
+
+    if (!engine->database->submitTask(task)) {
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * run the sql statements in one transaction on the executor thread.
+ * the rows of the last statement are passed to the callback.
+ *
+ * @param task name
+ * @param array of sql
+ * @param array of parameter arrays (optional)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDatabaseSubmitBatch(HSQUIRRELVM v) {
+    SQInteger nargs = sq_gettop(v);
+    if (nargs < 3 || sq_gettype(v, 2) != OT_STRING || sq_gettype(v, 3) != OT_ARRAY) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    const SQChar* name;
+    sq_getstring(v, 2, &name);
+
+    emo::DatabaseTask* task = new emo::DatabaseTask();
+    task->name = name;
+
+    bool valid = true;
+    sq_push(v, 3);
+    sq_pushnull(v);
+    while (SQ_SUCCEEDED(sq_next(v, -2))) {
+        if (sq_gettype(v, -1) == OT_STRING) {
+            const SQChar* sql;
+            sq_getstring(v, -1, &sql);
+            task->sql.push_back(sql);
+        } else {
+            valid = false;
+        }
+        sq_pop(v, 2);
+    }
+    sq_pop(v, 2);
+
+    if (valid && nargs >= 4 && sq_gettype(v, 4) == OT_ARRAY) {
+        sq_push(v, 4);
+        sq_pushnull(v);
+        while (SQ_SUCCEEDED(sq_next(v, -2))) {
+            task->params.push_back(emo::DatabaseRow());
+            if (sq_gettype(v, -1) == OT_ARRAY) {
+                if (!getDatabaseRow(v, sq_gettop(v), &task->params.back())) valid = false;
+            } else if (sq_gettype(v, -1) != OT_NULL) {
+                valid = false;
+            }
+            sq_pop(v, 2);
+        }
+        sq_pop(v, 2);
+    }
+
+    if (!valid || task->sql.empty()) {
+        delete task;
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!engine->database->submitTask(task)) {
+        sq_pushinteger(v, ERR_DATABASE);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * returns statistics of the executor thread.
+ * latency is the time from submit to completion in microseconds.
+ *
+ * @return table {queued, maxQueued, completed, failed, lastLatency, averageLatency, maxLatency, lastExecTime}
+ */
+SQInteger emoDatabaseGetExecutorStats(HSQUIRRELVM v) {
+    emo::DatabaseExecutorStats stats;
+    if (!engine->database->getExecutorStats(&stats)) {
+        return 0;
+    }
+
+    sq_newtable(v);
+    newSlotInteger(v, "queued",         stats.queued);
+    newSlotInteger(v, "maxQueued",      stats.maxQueued);
+    newSlotInteger(v, "completed",      stats.completed);
+    newSlotInteger(v, "failed",         stats.failed);
+    newSlotInteger(v, "lastLatency",    stats.lastLatency);
+    newSlotInteger(v, "averageLatency", stats.averageLatency);
+    newSlotInteger(v, "maxLatency",     stats.maxLatency);
+    newSlotInteger(v, "lastExecTime",   stats.lastExecTime);
+
+    return 1;
+}
@@ -30,9 +30,12 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <jni.h>
 #include "sqlite3.h"
 #include "squirrel.h"
+#include "Database_preference.h"
+#include "Database_executor.h"
 
 void initDatabaseFunctions();
 
@@ -55,9 +58,34 @@ namespace emo {
         bool setPreference(std::string key, std::string value);
         std::vector<std::string> getPreferenceKeys();
         bool deletePreference(std::string key);
+        bool flushPreference(bool wait);
+        PreferenceStore* getPreferenceStore();
+        bool execute(std::string sql);
+        int  prepareStatement(std::string sql);
+        sqlite3_stmt* getStatement(int id);
+        int  stepStatement(int id);
+        bool resetStatement(int id);
+        bool finalizeStatement(int id);
+        bool beginTransaction();
+        bool commitTransaction();
+        bool rollbackTransaction();
+        int  getChanges();
+        sqlite3_int64 getLastInsertRowId();
+        bool submitTask(DatabaseTask* task);
+        bool getExecutorStats(DatabaseExecutorStats* stats);
+        void dispatchCallbacks(HSQUIRRELVM v);
     protected:
         sqlite3* db;
         bool isOpen;
+        PreferenceStore* preferenceStore;
+        std::map<int, sqlite3_stmt*> statements;
+        int nextStatementId;
+        std::string path;
+        DatabaseExecutor* executor;
+        std::vector<DatabaseTask*> completedTasks;
+        bool loadPreferenceStore();
+        void finalizeStatements();
+        void setStatementError(int rcode);
         int  exec(std::string sql);
         int  exec_count(std::string sql, int* count);
         int  query_vector(std::string sql, std::vector<std::string>* values);
@@ -77,4 +105,22 @@ SQInteger emoDatabaseSetPreference(HSQUIRRELVM v);
 SQInteger emoDatabaseDeletePreference(HSQUIRRELVM v);
 SQInteger emoDatabaseGetPreferenceKeys(HSQUIRRELVM v);
 SQInteger emoDatabaseDeleteDatabase(HSQUIRRELVM v);
+SQInteger emoDatabaseFlushPreference(HSQUIRRELVM v);
+SQInteger emoDatabaseSetPreferenceFlushInterval(HSQUIRRELVM v);
+SQInteger emoDatabaseExec(HSQUIRRELVM v);
+SQInteger emoDatabasePrepareStatement(HSQUIRRELVM v);
+SQInteger emoDatabaseBindStatement(HSQUIRRELVM v);
+SQInteger emoDatabaseStepStatement(HSQUIRRELVM v);
+SQInteger emoDatabaseFetchStatement(HSQUIRRELVM v);
+SQInteger emoDatabaseGetStatementColumns(HSQUIRRELVM v);
+SQInteger emoDatabaseResetStatement(HSQUIRRELVM v);
+SQInteger emoDatabaseFinalizeStatement(HSQUIRRELVM v);
+SQInteger emoDatabaseBeginTransaction(HSQUIRRELVM v);
+SQInteger emoDatabaseCommitTransaction(HSQUIRRELVM v);
+SQInteger emoDatabaseRollbackTransaction(HSQUIRRELVM v);
+SQInteger emoDatabaseGetChanges(HSQUIRRELVM v);
+SQInteger emoDatabaseGetLastInsertRowId(HSQUIRRELVM v);
+SQInteger emoDatabaseSubmit(HSQUIRRELVM v);
+SQInteger emoDatabaseSubmitBatch(HSQUIRRELVM v);
+SQInteger emoDatabaseGetExecutorStats(HSQUIRRELVM v);
 #endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Database_executor.h"
+
+#include <time.h>
+
+namespace emo {
+
+    /*
+     * monotonic time in microseconds
+     */
+    uint64_t databaseNow() {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    }
+
+    DatabaseExecutor::DatabaseExecutor() {
+        this->lastError      = SQLITE_OK;
+        this->db             = NULL;
+        this->maxQueued      = 0;
+        this->completedCount = 0;
+        this->failedCount    = 0;
+        this->lastLatency    = 0;
+        this->maxLatency     = 0;
+        this->lastExecTime   = 0;
+        this->totalLatency   = 0;
+        this->running        = false;
+        this->stopping       = false;
+
+        pthread_mutex_init(&this->mutex, NULL);
+        pthread_cond_init(&this->wakeup, NULL);
+    }
+
+    /*
+     * completed tasks that are not taken yet are deleted.
+     */
+    DatabaseExecutor::~DatabaseExecutor() {
+        this->stop();
+
+        for (size_t i = 0; i < this->completed.size(); i++) {
+            delete this->completed[i];
+        }
+        this->completed.clear();
+
+        if (this->db != NULL) sqlite3_close(this->db);
+
+        pthread_cond_destroy(&this->wakeup);
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    bool DatabaseExecutor::open(const std::string& path) {
+        if (this->db != NULL) return false;
+
+        int rcode = sqlite3_open(path.c_str(), &this->db);
+        if (rcode != SQLITE_OK) {
+            this->lastError = rcode;
+            this->lastErrorMessage = sqlite3_errmsg(this->db);
+            sqlite3_close(this->db);
+            this->db = NULL;
+            return false;
+        }
+
+        sqlite3_busy_timeout(this->db, DATABASE_BUSY_TIMEOUT);
+        // a file left in WAL mode by an earlier build is converted back
+        sqlite3_exec(this->db, "PRAGMA journal_mode=DELETE", NULL, NULL, NULL);
+        sqlite3_exec(this->db, "PRAGMA synchronous=NORMAL", NULL, NULL, NULL);
+
+        if (pthread_create(&this->thread, NULL, executeThread, this) != 0) {
+            this->lastErrorMessage = "failed to start the database executor thread";
+            return false;
+        }
+        this->running = true;
+        return true;
+    }
+
+    /*
+     * runs the queued tasks and stops the thread.
+     * the completed tasks can be taken after the executor stops.
+     */
+    void DatabaseExecutor::stop() {
+        if (!this->running) return;
+
+        pthread_mutex_lock(&this->mutex);
+        this->stopping = true;
+        pthread_cond_signal(&this->wakeup);
+        pthread_mutex_unlock(&this->mutex);
+        pthread_join(this->thread, NULL);
+
+        this->running = false;
+    }
+
+    /*
+     * queue the task. the executor owns the task until it is taken back as completed.
+     */
+    void DatabaseExecutor::submit(DatabaseTask* task) {
+        task->error = SQLITE_OK;
+        task->changes = 0;
+        task->lastInsertRowId = 0;
+        task->submitTime = databaseNow();
+
+        pthread_mutex_lock(&this->mutex);
+        this->queue.push_back(task);
+        if (this->queue.size() > this->maxQueued) {
+            this->maxQueued = this->queue.size();
+        }
+        pthread_cond_signal(&this->wakeup);
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    /*
+     * move the completed tasks to the given vector. the caller deletes them.
+     */
+    void DatabaseExecutor::takeCompleted(std::vector<DatabaseTask*>* tasks) {
+        pthread_mutex_lock(&this->mutex);
+        tasks->insert(tasks->end(), this->completed.begin(), this->completed.end());
+        this->completed.clear();
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void DatabaseExecutor::getStats(DatabaseExecutorStats* stats) {
+        pthread_mutex_lock(&this->mutex);
+        uint32_t count = this->completedCount + this->failedCount;
+        stats->queued         = this->queue.size();
+        stats->maxQueued      = this->maxQueued;
+        stats->completed      = this->completedCount;
+        stats->failed         = this->failedCount;
+        stats->lastLatency    = this->lastLatency;
+        stats->averageLatency = count > 0 ? this->totalLatency / count : 0;
+        stats->maxLatency     = this->maxLatency;
+        stats->lastExecTime   = this->lastExecTime;
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    /*
+     * bind, step and collect the rows of one statement.
+     * rows of the last statement are kept as the result of the task.
+     */
+    int DatabaseExecutor::executeStatement(DatabaseTask* task, size_t index) {
+        sqlite3_stmt* stmt = NULL;
+        const std::string& sql = task->sql[index];
+        int rcode = sqlite3_prepare_v2(this->db, sql.c_str(), sql.size(), &stmt, NULL);
+        if (rcode != SQLITE_OK || stmt == NULL) {
+            sqlite3_finalize(stmt);
+            return rcode;
+        }
+
+        if (index < task->params.size()) {
+            const DatabaseRow& params = task->params[index];
+            for (size_t i = 0; i < params.size() && rcode == SQLITE_OK; i++) {
+                const DatabaseValue& value = params[i];
+                switch (value.type) {
+                case SQLITE_INTEGER:
+                    rcode = sqlite3_bind_int64(stmt, i + 1, value.integer);
+                    break;
+                case SQLITE_FLOAT:
+                    rcode = sqlite3_bind_double(stmt, i + 1, value.real);
+                    break;
+                case SQLITE_TEXT:
+                    rcode = sqlite3_bind_text(stmt, i + 1, value.text.c_str(), value.text.size(), SQLITE_STATIC);
+                    break;
+                default:
+                    rcode = sqlite3_bind_null(stmt, i + 1);
+                    break;
+                }
+            }
+            if (rcode != SQLITE_OK) {
+                sqlite3_finalize(stmt);
+                return rcode;
+            }
+        }
+
+        bool last = index + 1 == task->sql.size();
+        while ((rcode = sqlite3_step(stmt)) == SQLITE_ROW) {
+            if (!last) continue;
+
+            int count = sqlite3_column_count(stmt);
+            task->rows.push_back(DatabaseRow(count));
+            DatabaseRow& row = task->rows.back();
+            for (int i = 0; i < count; i++) {
+                DatabaseValue& value = row[i];
+                value.type = sqlite3_column_type(stmt, i);
+                switch (value.type) {
+                case SQLITE_INTEGER:
+                    value.integer = sqlite3_column_int64(stmt, i);
+                    break;
+                case SQLITE_FLOAT:
+                    value.real = sqlite3_column_double(stmt, i);
+                    break;
+                case SQLITE_TEXT:
+                case SQLITE_BLOB: {
+                    const char* data = (const char*)sqlite3_column_blob(stmt, i);
+                    if (data != NULL) value.text.assign(data, sqlite3_column_bytes(stmt, i));
+                    value.type = SQLITE_TEXT;
+                    break;
+                }
+                }
+            }
+        }
+        sqlite3_finalize(stmt);
+
+        return rcode == SQLITE_DONE ? SQLITE_OK : rcode;
+    }
+
+    /*
+     * run the statements of the task. batches run in one transaction.
+     */
+    void DatabaseExecutor::execute(DatabaseTask* task) {
+        bool batch = task->sql.size() > 1;
+        int rcode = SQLITE_OK;
+
+        if (batch) {
+            rcode = sqlite3_exec(this->db, "BEGIN IMMEDIATE", NULL, NULL, NULL);
+        }
+
+        int changes = sqlite3_total_changes(this->db);
+        for (size_t i = 0; i < task->sql.size() && rcode == SQLITE_OK; i++) {
+            rcode = this->executeStatement(task, i);
+        }
+
+        if (batch && rcode == SQLITE_OK) {
+            rcode = sqlite3_exec(this->db, "COMMIT", NULL, NULL, NULL);
+        }
+
+        if (rcode != SQLITE_OK) {
+            task->error = rcode;
+            task->errorMessage = sqlite3_errmsg(this->db);
+            task->rows.clear();
+            if (batch) sqlite3_exec(this->db, "ROLLBACK", NULL, NULL, NULL);
+        } else {
+            task->changes = sqlite3_total_changes(this->db) - changes;
+            task->lastInsertRowId = sqlite3_last_insert_rowid(this->db);
+        }
+    }
+
+    void DatabaseExecutor::executeLoop() {
+        pthread_mutex_lock(&this->mutex);
+        while (true) {
+            while (this->queue.empty() && !this->stopping) {
+                pthread_cond_wait(&this->wakeup, &this->mutex);
+            }
+            if (this->queue.empty()) break;
+
+            DatabaseTask* task = this->queue.front();
+            this->queue.pop_front();
+            pthread_mutex_unlock(&this->mutex);
+
+            task->startTime = databaseNow();
+            this->execute(task);
+            task->completeTime = databaseNow();
+
+            pthread_mutex_lock(&this->mutex);
+            uint32_t latency = task->completeTime - task->submitTime;
+            this->lastLatency  = latency;
+            this->lastExecTime = task->completeTime - task->startTime;
+            this->totalLatency += latency;
+            if (latency > this->maxLatency) this->maxLatency = latency;
+            if (task->error == SQLITE_OK) {
+                this->completedCount++;
+            } else {
+                this->failedCount++;
+            }
+            this->completed.push_back(task);
+        }
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void* DatabaseExecutor::executeThread(void* arg) {
+        ((DatabaseExecutor*)arg)->executeLoop();
+        return NULL;
+    }
+}
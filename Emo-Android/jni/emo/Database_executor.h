@@ -0,0 +1,126 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_DATABASE_EXECUTOR_H
+#define EMO_DATABASE_EXECUTOR_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include "sqlite3.h"
+
+#define DATABASE_BUSY_TIMEOUT 2000
+
+/*
+ * Runs database tasks on a dedicated thread with its own connection.
+ * The database keeps the rollback journal, which the platform SQLite that
+ * also opens the file understands, and waits up to DATABASE_BUSY_TIMEOUT
+ * when the connection of the main thread holds a lock. Parameters and
+ * result rows are plain values: they are converted from and to squirrel
+ * objects on the main thread, which polls the completed tasks at the
+ * start of each frame.
+ */
+namespace emo {
+    struct DatabaseValue {
+        int type;
+        sqlite3_int64 integer;
+        double real;
+        std::string text;
+    };
+
+    typedef std::vector<DatabaseValue> DatabaseRow;
+
+    struct DatabaseTask {
+        std::string name;
+        std::vector<std::string> sql;
+        std::vector<DatabaseRow> params;
+        std::vector<DatabaseRow> rows;
+        int error;
+        std::string errorMessage;
+        int changes;
+        sqlite3_int64 lastInsertRowId;
+        uint64_t submitTime;
+        uint64_t startTime;
+        uint64_t completeTime;
+    };
+
+    struct DatabaseExecutorStats {
+        uint32_t queued;
+        uint32_t maxQueued;
+        uint32_t completed;
+        uint32_t failed;
+        uint32_t lastLatency;
+        uint32_t averageLatency;
+        uint32_t maxLatency;
+        uint32_t lastExecTime;
+    };
+
+    class DatabaseExecutor {
+    public:
+        DatabaseExecutor();
+        ~DatabaseExecutor();
+
+        bool open(const std::string& path);
+        void submit(DatabaseTask* task);
+        void stop();
+        void takeCompleted(std::vector<DatabaseTask*>* tasks);
+        void getStats(DatabaseExecutorStats* stats);
+
+        int lastError;
+        std::string lastErrorMessage;
+    protected:
+        sqlite3* db;
+
+        std::deque<DatabaseTask*> queue;
+        std::vector<DatabaseTask*> completed;
+
+        uint32_t maxQueued;
+        uint32_t completedCount;
+        uint32_t failedCount;
+        uint32_t lastLatency;
+        uint32_t maxLatency;
+        uint32_t lastExecTime;
+        uint64_t totalLatency;
+        bool     running;
+        bool     stopping;
+
+        pthread_t       thread;
+        pthread_mutex_t mutex;
+        pthread_cond_t  wakeup;
+
+        void execute(DatabaseTask* task);
+        int  executeStatement(DatabaseTask* task, size_t index);
+        void executeLoop();
+
+        static void* executeThread(void* arg);
+    };
+
+    uint64_t databaseNow();
+}
+#endif
@@ -0,0 +1,361 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Database_preference.h"
+
+#include <errno.h>
+#include <sys/time.h>
+
+#include "Constants.h"
+
+namespace emo {
+
+    static uint32_t preferenceMillis() {
+        timeval now;
+        gettimeofday(&now, NULL);
+        return now.tv_sec * 1000 + now.tv_usec / 1000;
+    }
+
+    PreferenceStore::PreferenceStore() {
+        this->lastError       = SQLITE_OK;
+        this->db              = NULL;
+        this->setStatement    = NULL;
+        this->deleteStatement = NULL;
+        this->flushInterval   = PREFERENCE_FLUSH_INTERVAL;
+        this->flushRequested  = 0;
+        this->flushCompleted  = 0;
+        this->flushSucceeded  = true;
+        this->flushCount      = 0;
+        this->flushedRows     = 0;
+        this->errorCount      = 0;
+        this->lastFlushMillis = 0;
+        this->running         = false;
+        this->stopping        = false;
+
+        pthread_mutex_init(&this->mutex, NULL);
+        pthread_cond_init(&this->wakeup, NULL);
+        pthread_cond_init(&this->flushed, NULL);
+    }
+
+    /*
+     * stops the flush thread after it has written the pending changes
+     */
+    PreferenceStore::~PreferenceStore() {
+        if (this->running) {
+            pthread_mutex_lock(&this->mutex);
+            this->stopping = true;
+            pthread_cond_signal(&this->wakeup);
+            pthread_mutex_unlock(&this->mutex);
+            pthread_join(this->thread, NULL);
+        }
+
+        if (this->setStatement != NULL) sqlite3_finalize(this->setStatement);
+        if (this->deleteStatement != NULL) sqlite3_finalize(this->deleteStatement);
+        if (this->db != NULL) sqlite3_close(this->db);
+
+        pthread_cond_destroy(&this->flushed);
+        pthread_cond_destroy(&this->wakeup);
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    /*
+     * called without holding the lock, on the flush thread or while opening
+     */
+    void PreferenceStore::setError(int rcode) {
+        pthread_mutex_lock(&this->mutex);
+        this->lastError = rcode;
+        this->lastErrorMessage = sqlite3_errmsg(this->db);
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    int PreferenceStore::getLastError() {
+        pthread_mutex_lock(&this->mutex);
+        int error = this->lastError;
+        pthread_mutex_unlock(&this->mutex);
+        return error;
+    }
+
+    std::string PreferenceStore::getLastErrorMessage() {
+        pthread_mutex_lock(&this->mutex);
+        std::string message = this->lastErrorMessage;
+        pthread_mutex_unlock(&this->mutex);
+        return message;
+    }
+
+    /*
+     * open the preference database, load all rows and start the flush thread
+     */
+    bool PreferenceStore::open(const std::string& path) {
+        if (this->db != NULL) return false;
+
+        int rcode = sqlite3_open(path.c_str(), &this->db);
+        if (rcode != SQLITE_OK) {
+            this->setError(rcode);
+            sqlite3_close(this->db);
+            this->db = NULL;
+            return false;
+        }
+        // wait for the script connection instead of failing with SQLITE_BUSY
+        sqlite3_busy_timeout(this->db, PREFERENCE_BUSY_TIMEOUT);
+
+        if (!this->load()) return false;
+
+        if (pthread_create(&this->thread, NULL, flushThread, this) != 0) {
+            pthread_mutex_lock(&this->mutex);
+            this->lastErrorMessage = "failed to start the preference flush thread";
+            pthread_mutex_unlock(&this->mutex);
+            return false;
+        }
+        this->running = true;
+        return true;
+    }
+
+    bool PreferenceStore::load() {
+        char* sql = sqlite3_mprintf("CREATE TABLE IF NOT EXISTS %q (KEY TEXT PRIMARY KEY, VALUE TEXT)", PREFERENCE_TABLE_NAME);
+        int rcode = sqlite3_exec(this->db, sql, NULL, NULL, NULL);
+        sqlite3_free(sql);
+        if (rcode != SQLITE_OK) {
+            this->setError(rcode);
+            return false;
+        }
+
+        sqlite3_stmt* stmt = NULL;
+        sql = sqlite3_mprintf("SELECT KEY, VALUE FROM %q", PREFERENCE_TABLE_NAME);
+        rcode = sqlite3_prepare_v2(this->db, sql, -1, &stmt, NULL);
+        sqlite3_free(sql);
+        if (rcode != SQLITE_OK) {
+            this->setError(rcode);
+            sqlite3_finalize(stmt);
+            return false;
+        }
+        while ((rcode = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const char* key   = (const char*)sqlite3_column_text(stmt, 0);
+            const char* value = (const char*)sqlite3_column_text(stmt, 1);
+            if (key == NULL) continue;
+            this->values[key] = value != NULL ? value : "";
+        }
+        sqlite3_finalize(stmt);
+        if (rcode != SQLITE_DONE) {
+            this->setError(rcode);
+            return false;
+        }
+
+        sql = sqlite3_mprintf("INSERT OR REPLACE INTO %q(KEY,VALUE) VALUES(?,?)", PREFERENCE_TABLE_NAME);
+        rcode = sqlite3_prepare_v2(this->db, sql, -1, &this->setStatement, NULL);
+        sqlite3_free(sql);
+        if (rcode != SQLITE_OK) {
+            this->setError(rcode);
+            return false;
+        }
+
+        sql = sqlite3_mprintf("DELETE FROM %q WHERE KEY=?", PREFERENCE_TABLE_NAME);
+        rcode = sqlite3_prepare_v2(this->db, sql, -1, &this->deleteStatement, NULL);
+        sqlite3_free(sql);
+        if (rcode != SQLITE_OK) {
+            this->setError(rcode);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool PreferenceStore::get(const std::string& key, std::string* value) {
+        pthread_mutex_lock(&this->mutex);
+        ValueMap::iterator it = this->values.find(key);
+        bool found = it != this->values.end();
+        if (found) *value = it->second;
+        pthread_mutex_unlock(&this->mutex);
+        return found;
+    }
+
+    void PreferenceStore::set(const std::string& key, const std::string& value) {
+        pthread_mutex_lock(&this->mutex);
+        this->values[key] = value;
+        Change& change = this->changes[key];
+        change.value   = value;
+        change.deleted = false;
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void PreferenceStore::remove(const std::string& key) {
+        pthread_mutex_lock(&this->mutex);
+        this->values.erase(key);
+        Change& change = this->changes[key];
+        change.value.clear();
+        change.deleted = true;
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    std::vector<std::string> PreferenceStore::getKeys() {
+        std::vector<std::string> keys;
+        pthread_mutex_lock(&this->mutex);
+        keys.reserve(this->values.size());
+        for (ValueMap::iterator it = this->values.begin(); it != this->values.end(); it++) {
+            keys.push_back(it->first);
+        }
+        pthread_mutex_unlock(&this->mutex);
+        return keys;
+    }
+
+    /*
+     * request the flush thread to write the pending changes.
+     * if wait is true, blocks until the flush has completed and
+     * returns false if the changes could not be written.
+     * the failed changes stay pending for the next flush.
+     */
+    bool PreferenceStore::flush(bool wait) {
+        if (!this->running) return true;
+
+        pthread_mutex_lock(&this->mutex);
+        uint32_t request = ++this->flushRequested;
+        pthread_cond_signal(&this->wakeup);
+        while (wait && (int32_t)(this->flushCompleted - request) < 0) {
+            pthread_cond_wait(&this->flushed, &this->mutex);
+        }
+        bool result = !wait || this->flushSucceeded;
+        pthread_mutex_unlock(&this->mutex);
+        return result;
+    }
+
+    void PreferenceStore::setFlushInterval(int32_t msec) {
+        pthread_mutex_lock(&this->mutex);
+        this->flushInterval = msec;
+        pthread_cond_signal(&this->wakeup);
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void PreferenceStore::getStats(PreferenceStoreStats* stats) {
+        pthread_mutex_lock(&this->mutex);
+        stats->keyCount        = this->values.size();
+        stats->pendingCount    = this->changes.size();
+        stats->flushCount      = this->flushCount;
+        stats->flushedRows     = this->flushedRows;
+        stats->errorCount      = this->errorCount;
+        stats->lastFlushMillis = this->lastFlushMillis;
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    /*
+     * write the changes in one transaction. called without holding the lock.
+     */
+    bool PreferenceStore::write(ChangeMap& pending) {
+        int rcode = sqlite3_exec(this->db, "BEGIN IMMEDIATE", NULL, NULL, NULL);
+        if (rcode != SQLITE_OK) {
+            this->setError(rcode);
+            return false;
+        }
+
+        for (ChangeMap::iterator it = pending.begin(); it != pending.end(); it++) {
+            sqlite3_stmt* stmt = it->second.deleted ? this->deleteStatement : this->setStatement;
+            sqlite3_reset(stmt);
+            sqlite3_bind_text(stmt, 1, it->first.c_str(), it->first.size(), SQLITE_STATIC);
+            if (!it->second.deleted) {
+                sqlite3_bind_text(stmt, 2, it->second.value.c_str(), it->second.value.size(), SQLITE_STATIC);
+            }
+            rcode = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            if (rcode != SQLITE_DONE) {
+                this->setError(rcode);
+                sqlite3_exec(this->db, "ROLLBACK", NULL, NULL, NULL);
+                return false;
+            }
+        }
+
+        rcode = sqlite3_exec(this->db, "COMMIT", NULL, NULL, NULL);
+        if (rcode != SQLITE_OK) {
+            this->setError(rcode);
+            sqlite3_exec(this->db, "ROLLBACK", NULL, NULL, NULL);
+            return false;
+        }
+        return true;
+    }
+
+    /*
+     * wakes up on the flush interval or on request and writes the changes.
+     * failed changes are merged back unless the key has been changed again.
+     */
+    void PreferenceStore::flushLoop() {
+        pthread_mutex_lock(&this->mutex);
+        while (true) {
+            if (this->flushRequested == this->flushCompleted && !this->stopping) {
+                if (this->flushInterval > 0) {
+                    timeval now;
+                    gettimeofday(&now, NULL);
+                    timespec timeout;
+                    int64_t nsec = (int64_t)now.tv_usec * 1000 + (int64_t)(this->flushInterval % 1000) * 1000000;
+                    timeout.tv_sec  = now.tv_sec + this->flushInterval / 1000 + nsec / 1000000000;
+                    timeout.tv_nsec = nsec % 1000000000;
+                    pthread_cond_timedwait(&this->wakeup, &this->mutex, &timeout);
+                } else {
+                    pthread_cond_wait(&this->wakeup, &this->mutex);
+                }
+            }
+
+            uint32_t request = this->flushRequested;
+            bool stop = this->stopping;
+            bool succeeded = true;
+
+            if (!this->changes.empty()) {
+                ChangeMap pending;
+                pending.swap(this->changes);
+                pthread_mutex_unlock(&this->mutex);
+
+                uint32_t start = preferenceMillis();
+                bool written = this->write(pending);
+                uint32_t elapsed = preferenceMillis() - start;
+
+                pthread_mutex_lock(&this->mutex);
+                if (written) {
+                    this->flushCount++;
+                    this->flushedRows += pending.size();
+                    this->lastFlushMillis = elapsed;
+                } else {
+                    succeeded = false;
+                    this->errorCount++;
+                    for (ChangeMap::iterator it = pending.begin(); it != pending.end(); it++) {
+                        if (this->changes.find(it->first) == this->changes.end()) {
+                            this->changes.insert(*it);
+                        }
+                    }
+                }
+            }
+
+            this->flushCompleted = request;
+            this->flushSucceeded = succeeded;
+            pthread_cond_broadcast(&this->flushed);
+
+            if (stop) break;
+        }
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void* PreferenceStore::flushThread(void* arg) {
+        ((PreferenceStore*)arg)->flushLoop();
+        return NULL;
+    }
+}
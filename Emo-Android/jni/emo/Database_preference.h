@@ -0,0 +1,120 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_DATABASE_PREFERENCE_H
+#define EMO_DATABASE_PREFERENCE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <hash_map>
+#include "sqlite3.h"
+
+#define PREFERENCE_FLUSH_INTERVAL 3000
+#define PREFERENCE_BUSY_TIMEOUT   2000
+
+/*
+ * Write-behind store of the preference table.
+ * All rows are loaded into memory when the store opens, so reads and
+ * writes never touch the disk on the calling thread. Changed keys are
+ * written by a background thread in a single transaction, every flush
+ * interval or when flush() is called. The store has its own connection
+ * so the flush never interleaves with statements of the script database.
+ */
+namespace emo {
+    struct PreferenceStoreStats {
+        uint32_t keyCount;
+        uint32_t pendingCount;
+        uint32_t flushCount;
+        uint32_t flushedRows;
+        uint32_t errorCount;
+        uint32_t lastFlushMillis;
+    };
+
+    class PreferenceStore {
+    public:
+        PreferenceStore();
+        ~PreferenceStore();
+
+        bool open(const std::string& path);
+        bool get(const std::string& key, std::string* value);
+        void set(const std::string& key, const std::string& value);
+        void remove(const std::string& key);
+        std::vector<std::string> getKeys();
+
+        bool flush(bool wait);
+        void setFlushInterval(int32_t msec);
+        void getStats(PreferenceStoreStats* stats);
+
+        int getLastError();
+        std::string getLastErrorMessage();
+    protected:
+        struct Change {
+            std::string value;
+            bool deleted;
+        };
+
+        typedef std::hash_map<std::string, std::string> ValueMap;
+        typedef std::hash_map<std::string, Change> ChangeMap;
+
+        // written by the flush thread, guarded by the mutex
+        int lastError;
+        std::string lastErrorMessage;
+
+        sqlite3* db;
+        sqlite3_stmt* setStatement;
+        sqlite3_stmt* deleteStatement;
+
+        ValueMap  values;
+        ChangeMap changes;
+
+        int32_t  flushInterval;
+        uint32_t flushRequested;
+        uint32_t flushCompleted;
+        bool     flushSucceeded; // result of the last completed flush
+        uint32_t flushCount;
+        uint32_t flushedRows;
+        uint32_t errorCount;
+        uint32_t lastFlushMillis;
+        bool     running;
+        bool     stopping;
+
+        pthread_t       thread;
+        pthread_mutex_t mutex;
+        pthread_cond_t  wakeup;
+        pthread_cond_t  flushed;
+
+        bool load();
+        bool write(ChangeMap& pending);
+        void setError(int rcode);
+        void flushLoop();
+
+        static void* flushThread(void* arg);
+    };
+}
+#endif
@@ -36,7 +36,6 @@
 #include "Util.h"
 
 #include <GLES/glext.h>
-#include <rapidxml/rapidxml.hpp>
 
 extern emo::Engine* engine;
 
@@ -108,17 +107,6 @@ namespace emo {
         }
     }
 
-    ImagePackInfo::ImagePackInfo() {
-        this->x = 0;
-        this->y = 0;
-        this->width  = 1;
-        this->height = 1;
-    }
-
-    ImagePackInfo::~ImagePackInfo() {
-
-    }
-
     Drawable::Drawable() {
         this->hasTexture = false;
         this->hasBuffer  = false;
@@ -130,6 +118,9 @@ namespace emo {
         this->independent = true;
         this->needTexture = false;
         this->isPackedAtlas = false;
+        this->atlas = NULL;
+        this->packable = false;
+        this->mipmapMode = engine->mipmapMode;
 
         // color param RGBA
         this->param_color[0] = 1.0f;
@@ -164,8 +155,6 @@ namespace emo {
         this->margin      = 0;
 
         this->animations = new animations_t();
-        this->imagepacks = new imagepack_t();
-        this->imagepacks_names = new std::vector<std::string>;
 
         this->useMesh = false;
         this->orthFactorX = 1.0;
@@ -180,12 +169,15 @@ namespace emo {
 
     Drawable::~Drawable() {
         this->deleteAnimations();
-        this->deleteImagePacks();
+        if (this->atlas != NULL) {
+            engine->releaseTextureAtlas(this->atlas);
+        }
         this->deleteBuffer(false);
         if (this->hasTexture) {
             this->texture->referenceCount--;
             if (this->texture->referenceCount <= 0) {
-                engine->removeCachedImage(this->name);
+                engine->removeCachedImage(this->name, this->texture);
+                engine->packer->remove(this->texture);
                 delete this->texture;
             }
         }
@@ -193,8 +185,6 @@ namespace emo {
             delete[] this->frames_vbos;
         }
         delete this->animations;
-        delete this->imagepacks;
-        delete this->imagepacks_names;
     }
 
     void Drawable::load() {
@@ -216,7 +206,7 @@ namespace emo {
         if (this->hasBuffer) return;
         this->generateBuffers();
 
-        if (this->hasTexture) {
+        if (this->hasTexture && this->texture->page == NULL) {
             this->texture->genTextures();
         }
 
@@ -225,7 +215,10 @@ namespace emo {
             if (this->useFont) {
                 engine->javaGlue->loadTextBitmap(this, this->texture, false);
             } else {
-                loadPngFromAsset(this->name.c_str(), this->texture, false);
+                loadImageFromAsset(this->name.c_str(), this->texture, false);
+                if (this->mipmapMode == MIPMAP_ALWAYS) {
+                    this->texture->generateMipmaps();
+                }
             }
         }
 
@@ -242,15 +235,12 @@ namespace emo {
 
     void Drawable::deleteBuffer(bool force) {
         if (!this->hasBuffer) return;
-        if (this->hasTexture && this->texture->textureId > 0) {
+        // the page texture of packed image is deleted by the packer
+        if (this->hasTexture && this->texture->page == NULL && this->texture->textureId > 0) {
             if (!force && this->texture->referenceCount > 1) {
                 // skip 
             } else {
-                if (engine->hasDisplay()) {
-                    glDeleteTextures(1, &this->texture->textureId);
-                }
-                this->texture->textureId = 0;
-                this->texture->loaded    = false;
+                this->texture->deleteTextures(engine->hasDisplay());
             }
         }
 
@@ -268,7 +258,7 @@ namespace emo {
 
     int Drawable::tex_coord_frame_startX() {
         if (this->isPackedAtlas) {
-            return this->getImagePack(this->imagepacks_names->at(frame_index))->x;
+            return this->atlas->frames[frame_index].x;
         }
         int xcount = (int)round((this->texture->width - (this->margin * 2) + this->border) / (float)(this->frameWidth  + this->border));
         int xindex = this->frame_index % xcount;
@@ -277,7 +267,7 @@ namespace emo {
 
     int Drawable::tex_coord_frame_startY() {
         if (this->isPackedAtlas) {
-            return this->texture->height - this->frameHeight - this->getImagePack(this->imagepacks_names->at(frame_index))->y;
+            return this->texture->height - this->frameHeight - this->atlas->frames[frame_index].y;
         }
         int xcount = (int)round((this->texture->width - (this->margin * 2) + this->border) / (float)(this->frameWidth  + this->border));
         int ycount = (int)round((this->texture->height - (this->margin * 2) + this->border) / (float)(this->frameHeight + this->border));
@@ -301,9 +291,15 @@ namespace emo {
         }
     }
 
+    /*
+     * texture coordinates are offset by the position in the page
+     * when the image is packed.
+     */
     float Drawable::getTexCoordStartX() {
         if (this->hasSheet) {
-            return this->tex_coord_frame_startX() / (float)this->texture->glWidth + this->getTexelHalfX();
+            return (this->texture->pageX + this->tex_coord_frame_startX()) / (float)this->texture->glWidth + this->getTexelHalfX();
+        } else if (this->hasTexture && this->texture->page != NULL) {
+            return this->texture->pageX / (float)this->texture->glWidth + this->getTexelHalfX();
         } else {
             return 0;
         }
@@ -313,9 +309,9 @@ namespace emo {
         if (!this->hasTexture) {
             return 1 - this->getTexelHalfX();
         } else if (this->hasSheet) {
-            return (float)(this->tex_coord_frame_startX() + this->frameWidth) / (float)this->texture->glWidth - this->getTexelHalfX();
+            return (float)(this->texture->pageX + this->tex_coord_frame_startX() + this->frameWidth) / (float)this->texture->glWidth - this->getTexelHalfX();
         } else {
-            return (float)this->texture->width / (float)this->texture->glWidth - this->getTexelHalfX();
+            return (float)(this->texture->pageX + this->texture->width) / (float)this->texture->glWidth - this->getTexelHalfX();
         }
     }
 
@@ -323,18 +319,32 @@ namespace emo {
         if (!this->hasTexture) {
             return 1 - this->getTexelHalfY();
         } else if (this->hasSheet) {
-            return (float)(this->tex_coord_frame_startY() + this->frameHeight) / (float)this->texture->glHeight - this->getTexelHalfY();
+            return this->orientTexCoordY((float)(this->texture->pageY + this->tex_coord_frame_startY() + this->frameHeight) / (float)this->texture->glHeight - this->getTexelHalfY());
         } else {
-            return (float)this->texture->height / (float)this->texture->glHeight - this->getTexelHalfY();
+            return this->orientTexCoordY((float)(this->texture->pageY + this->texture->height) / (float)this->texture->glHeight - this->getTexelHalfY());
         }
     }
 
     float Drawable::getTexCoordEndY() {
         if (this->hasSheet) {
-            return this->tex_coord_frame_startY() / (float)this->texture->glHeight + getTexelHalfY();
+            return this->orientTexCoordY((this->texture->pageY + this->tex_coord_frame_startY()) / (float)this->texture->glHeight + getTexelHalfY());
+        } else if (this->hasTexture && this->texture->page != NULL) {
+            return this->texture->pageY / (float)this->texture->glHeight + this->getTexelHalfY();
         } else {
-            return 0;
+            return this->orientTexCoordY(0);
+        }
+    }
+
+    /*
+     * compressed textures keep the top-down rows of their blocks
+     * while the decoded images are stored bottom-up.
+     * compressed textures are never padded nor packed.
+     */
+    float Drawable::orientTexCoordY(float y) {
+        if (this->hasTexture && this->texture->compressedFormat != 0) {
+            return 1 - y;
         }
+        return y;
     }
 
     bool Drawable::bindVertex() {
@@ -365,33 +375,10 @@ namespace emo {
 
         printGLErrors("Could not create OpenGL vertex");
 
-        if (this->hasTexture && this->texture->hasData && !this->texture->loaded) {
-            glEnable(GL_TEXTURE_2D);
-            glBindTexture   (GL_TEXTURE_2D, this->texture->textureId);
-
-            glPixelStorei   (GL_UNPACK_ALIGNMENT, 1);
-            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-            if (this->texture->hasAlpha) {
-                GLubyte* holder = (GLubyte*)malloc(sizeof(GLubyte) * this->texture->glWidth * this->texture->glHeight * 4);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->texture->glWidth, this->texture->glHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, holder);
-                glTexSubImage2D(GL_TEXTURE_2D, 0, 
-                      0, 0, this->texture->width, this->texture->height, GL_RGBA, GL_UNSIGNED_BYTE, this->texture->data);
-                free(holder);
-            } else {
-                GLubyte* holder = (GLubyte*)malloc(sizeof(GLubyte) * this->texture->glWidth * this->texture->glHeight * 3);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, this->texture->glWidth, this->texture->glHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, holder);
-                glTexSubImage2D(GL_TEXTURE_2D, 0, 
-                       0, 0, this->texture->width, this->texture->height, GL_RGB, GL_UNSIGNED_BYTE, this->texture->data);
-                free(holder);
-            }
-            this->texture->loaded = true;
-            printGLErrors("Could not bind OpenGL textures");
-
-            glBindTexture(GL_TEXTURE_2D, 0);
+        if (this->hasTexture && this->texture->page != NULL) {
+            engine->packer->bind(this->texture);
+        } else if (this->hasTexture && this->texture->hasData && !this->texture->loaded) {
+            this->texture->upload();
         }
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -428,26 +415,10 @@ namespace emo {
         glLoadIdentity (); 
 
         // update colors
-        glColor4f(this->param_color[0], this->param_color[1], this->param_color[2], this->param_color[3]);
+        this->applyColor();
 
-        // update position
-        glTranslatef(this->x * this->orthFactorX, this->y * this->orthFactorY, 0);
-
-        // rotate
-        glTranslatef(this->param_rotate[1], this->param_rotate[2], 0);
-        if (this->param_rotate[3] == AXIS_X) {
-            glRotatef(this->param_rotate[0], 1, 0, 0);
-        } else if (this->param_rotate[3] == AXIS_Y) {
-            glRotatef(this->param_rotate[0], 0, 1, 0);
-        } else {
-            glRotatef(this->param_rotate[0], 0, 0, 1);
-        }
-        glTranslatef(-this->param_rotate[1], -this->param_rotate[2], 0);
-
-        // scale
-        glTranslatef(this->param_scale[2], this->param_scale[3], 0);
-        glScalef(this->param_scale[0], this->param_scale[1], 1);
-        glTranslatef(-this->param_scale[2], -this->param_scale[3], 0);
+        // update position, rotation and scale
+        this->applyTransform();
 
         // update width and height
         glScalef(this->width, this->height, 1);
@@ -456,6 +427,11 @@ namespace emo {
         glBindBuffer(GL_ARRAY_BUFFER, engine->stage->vbo[0]);
         glVertexPointer(3, GL_FLOAT, 0, 0);
 
+        // generate mipmaps when the sprite is drawn minified
+        if (this->hasTexture && this->mipmapMode == MIPMAP_AUTO && this->texture->mipmapLevels == 0) {
+            this->updateMipmap();
+        }
+
         // bind a texture
         if (this->hasTexture) {
             glEnable(GL_TEXTURE_2D);
@@ -464,6 +440,7 @@ namespace emo {
             // bind texture coords
             glBindBuffer(GL_ARRAY_BUFFER, this->getCurrentBufferId());
             glTexCoordPointer(2, GL_FLOAT, 0, 0);
+            this->texture->bindAlphaPlane(0);
         } else {
             glDisable(GL_TEXTURE_2D);
         }
@@ -474,12 +451,37 @@ namespace emo {
         // draw sprite
         glDrawElements(GL_TRIANGLE_FAN, 4, GL_UNSIGNED_SHORT, 0);
 
+        if (this->hasTexture) {
+            this->texture->unbindAlphaPlane();
+        }
+
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    void Drawable::applyTransform() {
+        // update position
+        glTranslatef(this->x * this->orthFactorX, this->y * this->orthFactorY, 0);
+
+        // rotate
+        glTranslatef(this->param_rotate[1], this->param_rotate[2], 0);
+        if (this->param_rotate[3] == AXIS_X) {
+            glRotatef(this->param_rotate[0], 1, 0, 0);
+        } else if (this->param_rotate[3] == AXIS_Y) {
+            glRotatef(this->param_rotate[0], 0, 1, 0);
+        } else {
+            glRotatef(this->param_rotate[0], 0, 0, 1);
+        }
+        glTranslatef(-this->param_rotate[1], -this->param_rotate[2], 0);
+
+        // scale
+        glTranslatef(this->param_scale[2], this->param_scale[3], 0);
+        glScalef(this->param_scale[0], this->param_scale[1], 1);
+        glTranslatef(-this->param_scale[2], -this->param_scale[3], 0);
+    }
+
     void Drawable::setFrameCount(int count) {
         if (this->frameCountLoaded) {
             delete[] this->frames_vbos;
@@ -504,11 +506,11 @@ namespace emo {
         this->frameIndexChanged = true;
 
         if (this->isPackedAtlas) {
-            ImagePackInfo* info = this->getImagePack(this->imagepacks_names->at(index));
-            this->width  = info->width;
-            this->height = info->height;
-            this->frameWidth  = info->width;
-            this->frameHeight = info->height;
+            const TextureAtlasFrame& frame = this->atlas->frames[index];
+            this->width  = frame.width;
+            this->height = frame.height;
+            this->frameWidth  = frame.width;
+            this->frameHeight = frame.height;
         }
 
         return true;
@@ -530,6 +532,41 @@ namespace emo {
 
     void Drawable::setTexture(Image* image) {
         this->texture = image;
+
+        // premultiplied texture must not be multiplied by its alpha again
+        if (image->premultiplied && this->srcBlendFactor == GL_SRC_ALPHA) {
+            this->srcBlendFactor = GL_ONE;
+        }
+    }
+
+    /*
+     * set the drawable color to the current state.
+     * the color is premultiplied when the texture is.
+     */
+    void Drawable::applyColor() {
+        if (this->hasTexture && this->texture->premultiplied) {
+            float alpha = this->param_color[3];
+            glColor4f(this->param_color[0] * alpha, this->param_color[1] * alpha, this->param_color[2] * alpha, alpha);
+        } else {
+            glColor4f(this->param_color[0], this->param_color[1], this->param_color[2], this->param_color[3]);
+        }
+    }
+
+    /*
+     * generate the mipmap chain of the texture when the sprite is
+     * scaled below the threshold. the chain is kept once generated.
+     */
+    void Drawable::updateMipmap() {
+        if (this->frameWidth <= 0 || this->frameHeight <= 0) return;
+
+        float scaleX = this->getScaledWidth()  / this->frameWidth;
+        float scaleY = this->getScaledHeight() / this->frameHeight;
+        float scale  = scaleX < scaleY ? scaleX : scaleY;
+        if (scale >= engine->mipmapThreshold) return;
+
+        if (this->texture->generateMipmaps()) {
+            this->texture->upload();
+        }
     }
 
     Image* Drawable::getTexture() {
@@ -552,46 +589,11 @@ namespace emo {
         return this->child;
     }
 
-    void Drawable::addImagePack(ImagePackInfo* info) {
-        this->deleteImagePack(info->name);
-        this->imagepacks->insert(std::make_pair(info->name, info)); 
-        this->imagepacks_names->push_back(info->name);
-    }
-
-    ImagePackInfo* Drawable::getImagePack(std::string name) {
-        imagepack_t::iterator iter = this->imagepacks->find(name);
-        if (iter != this->imagepacks->end()) {
-            return iter->second;
-        }
-        return NULL;
-    }
-
     bool Drawable::selectFrame(std::string name) {
-        ImagePackInfo* info = this->getImagePack(name);
-        if (info == NULL) return false;
-        return this->setFrameIndex(info->index);
-    }
-
-    bool Drawable::deleteImagePack(std::string name) {
-        imagepack_t::iterator iter = this->imagepacks->find(name);
-        if (iter != this->imagepacks->end()) {
-            ImagePackInfo* info = iter->second;
-            if (this->imagepacks->erase(iter->first)){
-                delete info;
-            }
-            return true;
-        }
-        return false;
-    }
-
-    void Drawable::deleteImagePacks() {
-        imagepack_t::iterator iter;
-        for(iter = this->imagepacks->begin(); iter != this->imagepacks->end(); iter++) {
-            ImagePackInfo* info = iter->second;
-            delete info;
-        }
-        this->imagepacks->clear();
-        this->imagepacks_names->clear();
+        if (this->atlas == NULL) return false;
+        int index = this->atlas->find(name);
+        if (index < 0) return false;
+        return this->setFrameIndex(index);
     }
 
     void Drawable::addAnimation(AnimationFrame* animation) {
@@ -668,63 +670,27 @@ namespace emo {
         // check if the length is shorter than the length of ".xml"
         if (this->name.length() <= 4) return false;
 
-        std::string data = loadContentFromAsset(this->name);
-        unsigned int pos = this->name.find_last_of("/");
-        
-        std::string base_dir = "";
-        if (pos != std::string::npos) base_dir = this->name.substr(0, pos + 1);
-
-        rapidxml::xml_document<char> doc;
-        doc.parse<0>((char*)data.c_str());
+        TextureAtlas* atlas = engine->loadTextureAtlas(this->name);
+        if (atlas == NULL) return false;
 
-        if (doc.first_node() == 0) {
+        if (initialFrameIndex < 0 || initialFrameIndex >= (int)atlas->frames.size()) {
+            engine->releaseTextureAtlas(atlas);
             return false;
         }
 
-        int itemCount = 0;
-        ImagePackInfo* selectedItem = NULL;
-
-        for (rapidxml::xml_node<> *node = doc.first_node(); node; node = node->next_sibling()) {
-            if (strcmp(node->name(), "Imageset") != 0 && strcmp(node->name(), "TextureAtlas") != 0) continue;
-            for (rapidxml::xml_attribute<> *attr = node->first_attribute(); attr; attr = attr->next_attribute()) {
-                if (strcmp(attr->name(), "Imagefile") == 0 || strcmp(attr->name(), "imagePath") == 0) {
-                    this->name = base_dir + attr->value();
-                }
-            }
-            for (rapidxml::xml_node<> *child  = node->first_node(); child; child = child->next_sibling()) {
-                if (strcmp(child->name(), "Image") != 0 && strcmp(child->name(), "SubTexture") != 0) continue;
-
-                ImagePackInfo* info = new ImagePackInfo();
-                for (rapidxml::xml_attribute<> *attr = child->first_attribute(); attr; attr = attr->next_attribute()) {
-                    if (strcmp(attr->name(), "name") == 0 || strcmp(attr->name(), "Name") == 0) {
-                        info->name = attr->value();
-                    } else if (strcmp(attr->name(), "x") == 0 || strcmp(attr->name(), "XPos") == 0) {
-                        info->x = atoi(attr->value());
-                    } else if (strcmp(attr->name(), "y") == 0 || strcmp(attr->name(), "YPos") == 0) {
-                        info->y = atoi(attr->value());
-                    } else if (strcmp(attr->name(), "width") == 0 || strcmp(attr->name(), "Width") == 0) {
-                        info->width = atoi(attr->value());
-                    } else if (strcmp(attr->name(), "height") == 0 || strcmp(attr->name(), "Height") == 0) {
-                        info->height = atoi(attr->value());
-                    }
-                }
-                if (!info->name.empty()) {
-                    if (itemCount == initialFrameIndex) selectedItem = info;
-                    info->index = itemCount;
-                    this->addImagePack(info);
-                    itemCount++;
-                }
-            }
+        if (this->atlas != NULL) {
+            engine->releaseTextureAtlas(this->atlas);
         }
+        this->atlas = atlas;
+        this->name  = atlas->imageName;
 
-        if (selectedItem == NULL) return false;
-
-        this->width       = selectedItem->width;
-        this->height      = selectedItem->height;
-        this->frameWidth  = selectedItem->width;
-        this->frameHeight = selectedItem->height;
+        const TextureAtlasFrame& selected = atlas->frames[initialFrameIndex];
+        this->width       = selected.width;
+        this->height      = selected.height;
+        this->frameWidth  = selected.width;
+        this->frameHeight = selected.height;
 
-        this->setFrameCount(itemCount);
+        this->setFrameCount(atlas->frames.size());
         this->margin = 0;
         this->border = 0;
 
@@ -993,7 +959,7 @@ namespace emo {
             glLoadIdentity (); 
         
             // update colors
-            glColor4f(param_color[0], param_color[1], param_color[2], param_color[3]);
+            this->applyColor();
         
             // update position
             glTranslatef(x, y, 0);
@@ -1010,6 +976,7 @@ namespace emo {
                 // bind texture coords
                 glBindBuffer(GL_ARRAY_BUFFER, mesh_vbos[2]);
                 glTexCoordPointer(2, GL_FLOAT, 0, 0);
+                child->getTexture()->bindAlphaPlane(0);
             } else {
                 glDisable(GL_TEXTURE_2D);
             }
@@ -1019,6 +986,10 @@ namespace emo {
         
             // draw sprite
             glDrawElements(GL_TRIANGLES, meshIndiceCount, GL_UNSIGNED_SHORT, 0);
+
+            if (child->hasTexture) {
+                child->getTexture()->unbindAlphaPlane();
+            }
         
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
             glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -1090,7 +1061,7 @@ namespace emo {
         glLineWidth(this->width);
     
         // update colors
-        glColor4f(this->param_color[0], this->param_color[1], this->param_color[2], this->param_color[3]);
+        this->applyColor();
         glVertexPointer(2, GL_FLOAT, 0, this->vertex_tex_coords);
         glDrawArrays(GL_LINES, 0, 2);
 
@@ -1213,10 +1184,192 @@ namespace emo {
     FontDrawable::FontDrawable() {
         this->isBold   = false;
         this->isItalic = false;
+
+        this->glyphAtlas   = NULL;
+        this->text_vbos[0] = 0;
+        this->text_vbos[1] = 0;
+        this->textCapacity = 0;
+        this->textWidth    = 0;
+        this->textHeight   = 0;
+        this->textChanged  = false;
     }
 
     FontDrawable::~FontDrawable() {
+        this->deleteTextBuffers();
+        if (this->glyphAtlas != NULL) {
+            engine->releaseGlyphAtlas(this->glyphAtlas);
+        }
+    }
+
+    /*
+     * rasterize the missing glyphs and lay out the text.
+     * the quads are grouped by the atlas page so that the text is drawn
+     * with one draw call per page. the buffers are updated on the next draw.
+     */
+    bool FontDrawable::setText(std::string text) {
+        if (this->glyphAtlas == NULL) return false;
 
+        this->text = text;
+        engine->loadGlyphs(this->glyphAtlas, text);
+        this->glyphAtlas->layout(text, &this->textQuads, &this->textWidth, &this->textHeight);
+
+        this->textRuns.clear();
+        this->textVertices.resize(this->textQuads.size() * POINTS_RECTANGLE * 4);
+
+        int index = 0;
+        int first = 0;
+        for (int page = 0; page < GLYPH_MAX_PAGES && first < (int)this->textQuads.size(); page++) {
+            GlyphRun run;
+            run.page  = page;
+            run.first = first;
+            run.count = 0;
+            for (size_t i = 0; i < this->textQuads.size(); i++) {
+                const GlyphQuad& quad = this->textQuads[i];
+                if (quad.page != page) continue;
+
+                float* v = &this->textVertices[index];
+                v[0]  = quad.x0; v[1]  = quad.y0; v[2]  = quad.s0; v[3]  = quad.t0;
+                v[4]  = quad.x0; v[5]  = quad.y1; v[6]  = quad.s0; v[7]  = quad.t1;
+                v[8]  = quad.x1; v[9]  = quad.y0; v[10] = quad.s1; v[11] = quad.t0;
+                v[12] = quad.x1; v[13] = quad.y1; v[14] = quad.s1; v[15] = quad.t1;
+                index += POINTS_RECTANGLE * 4;
+                run.count++;
+            }
+            if (run.count > 0) {
+                this->textRuns.push_back(run);
+                first += run.count;
+            }
+        }
+
+        this->width  = this->textWidth  > 0 ? this->textWidth  : 1;
+        this->height = this->textHeight > 0 ? this->textHeight : 1;
+        this->frameWidth  = this->width;
+        this->frameHeight = this->height;
+
+        this->textChanged = true;
+        return true;
+    }
+
+    /*
+     * upload the vertices of the text. the buffers are reused while the
+     * text fits, so changing the text costs one glBufferSubData.
+     */
+    void FontDrawable::updateTextBuffers() {
+        int quadCount = this->textQuads.size();
+
+        if (this->text_vbos[0] == 0) {
+            glGenBuffers(2, this->text_vbos);
+            this->textCapacity = 0;
+        }
+
+        if (quadCount > this->textCapacity) {
+            int capacity = max(max(quadCount, this->textCapacity * 2), 16);
+            capacity = min(capacity, GLYPH_MAX_QUADS);
+
+            short* indices = (short*)malloc(sizeof(short) * capacity * 6);
+            for (int i = 0; i < capacity; i++) {
+                indices[i * 6 + 0] = (short)(i * 4 + 0);
+                indices[i * 6 + 1] = (short)(i * 4 + 1);
+                indices[i * 6 + 2] = (short)(i * 4 + 2);
+                indices[i * 6 + 3] = (short)(i * 4 + 2);
+                indices[i * 6 + 4] = (short)(i * 4 + 1);
+                indices[i * 6 + 5] = (short)(i * 4 + 3);
+            }
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->text_vbos[1]);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(short) * capacity * 6, indices, GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            free(indices);
+
+            glBindBuffer(GL_ARRAY_BUFFER, this->text_vbos[0]);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(float) * capacity * POINTS_RECTANGLE * 4, NULL, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            this->textCapacity = capacity;
+        }
+
+        if (quadCount > 0) {
+            glBindBuffer(GL_ARRAY_BUFFER, this->text_vbos[0]);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * quadCount * POINTS_RECTANGLE * 4, &this->textVertices[0]);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        printGLErrors("Could not update text buffer");
+
+        this->textChanged = false;
+    }
+
+    void FontDrawable::deleteTextBuffers() {
+        if (this->text_vbos[0] != 0 && engine->hasDisplay()) {
+            glDeleteBuffers(2, this->text_vbos);
+        }
+        this->text_vbos[0] = 0;
+        this->text_vbos[1] = 0;
+        this->textCapacity = 0;
+        this->textChanged  = true;
+    }
+
+    bool FontDrawable::bindVertex() {
+        if (this->glyphAtlas == NULL) return Drawable::bindVertex();
+
+        clearGLErrors("FontDrawable::bindVertex");
+        this->updateTextBuffers();
+        this->loaded = true;
+
+        return true;
+    }
+
+    void FontDrawable::deleteBuffer(bool force) {
+        Drawable::deleteBuffer(force);
+        this->deleteTextBuffers();
+    }
+
+    void FontDrawable::onDrawFrame() {
+        if (this->glyphAtlas == NULL) {
+            Drawable::onDrawFrame();
+            return;
+        }
+        if (!this->loaded) return;
+
+        if (this->textChanged) {
+            this->updateTextBuffers();
+        }
+        if (this->textRuns.empty()) return;
+
+        glMatrixMode (GL_MODELVIEW);
+        glLoadIdentity (); 
+
+        // update colors
+        this->applyColor();
+
+        // update position, rotation and scale
+        this->applyTransform();
+
+        // stretch the text when the size is changed after the layout
+        if (this->width != this->textWidth || this->height != this->textHeight) {
+            glScalef(this->width  / (float)max(this->textWidth,  1),
+                     this->height / (float)max(this->textHeight, 1), 1);
+        }
+
+        // bind interleaved positions and texture coords
+        glBindBuffer(GL_ARRAY_BUFFER, this->text_vbos[0]);
+        glVertexPointer(2, GL_FLOAT, sizeof(float) * 4, 0);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(float) * 4, (GLvoid*)(sizeof(float) * 2));
+
+        // bind indices
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->text_vbos[1]);
+
+        glEnable(GL_TEXTURE_2D);
+        for (size_t i = 0; i < this->textRuns.size(); i++) {
+            const GlyphRun& run = this->textRuns[i];
+            this->glyphAtlas->bindPage(run.page);
+            glDrawElements(GL_TRIANGLES, run.count * 6, GL_UNSIGNED_SHORT,
+                           (GLvoid*)(sizeof(short) * run.first * 6));
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
     }
 
     LiquidDrawable::LiquidDrawable() {
@@ -1254,19 +1407,24 @@ namespace emo {
         glLoadIdentity();
 
         // update colors
-        glColor4f(param_color[0], param_color[1], param_color[2], param_color[3]);
+        this->applyColor();
 
         if (this->hasTexture) {
             glEnable(GL_TEXTURE_2D);
             glBindTexture(GL_TEXTURE_2D, this->texture->textureId);
 
             glTexCoordPointer(2, GL_FLOAT, 0, this->textureCoords);
+            this->texture->bindAlphaPlane(this->textureCoords);
         } else {
             glDisable(GL_TEXTURE_2D);
         }
 
         glVertexPointer(2, GL_FLOAT, 0,  this->segmentCoords);
         glDrawArrays(GL_TRIANGLE_FAN, 0, this->segmentCount);
+
+        if (this->hasTexture) {
+            this->texture->unbindAlphaPlane();
+        }
     }
 
     bool LiquidDrawable::updateTextureCoords(int index, float tx, float ty) {
@@ -1274,7 +1432,7 @@ namespace emo {
 
         int realIndex = index * 2;
         this->textureCoords[realIndex]     = tx;
-        this->textureCoords[realIndex + 1] = ty;
+        this->textureCoords[realIndex + 1] = this->orientTexCoordY(ty);
 
         return true;
     }
@@ -1340,7 +1498,7 @@ namespace emo {
         glLoadIdentity ();
 	
         // update colors
-        glColor4f(param_color[0], param_color[1], param_color[2], param_color[3]);
+        this->applyColor();
     
         if (this->hasTexture) {
             glEnable(GL_POINT_SPRITE_OES);
@@ -37,6 +37,8 @@
 #include <vector>
 #include <squirrel.h>
 #include "Image.h"
+#include "Drawable_atlas.h"
+#include "Image_glyph.h"
 #include "Util.h"
 
 namespace emo {
@@ -65,21 +67,7 @@ namespace emo {
         void setFrame(int index, int value);
     };
 
-    class ImagePackInfo {
-    public:
-        ImagePackInfo();
-        ~ImagePackInfo();
-
-        std::string name;
-        int x;
-        int y;
-        int width;
-        int height;
-        int index;
-    };
-
     typedef std::hash_map <std::string, emo::AnimationFrame *> animations_t;
-    typedef std::hash_map <std::string, emo::ImagePackInfo *> imagepack_t;
 
     class Drawable {
     public:
@@ -110,6 +98,9 @@ namespace emo {
 
         void setTexture(Image* image);
         Image* getTexture();
+        void applyColor();
+        void applyTransform();
+        void updateMipmap();
 
         float getScaledWidth();
         float getScaledHeight();
@@ -122,6 +113,8 @@ namespace emo {
         bool independent;
         bool needTexture;
         bool isPackedAtlas;
+        bool packable;
+        int  mipmapMode;
 
         int border;
         int margin;
@@ -151,9 +144,12 @@ namespace emo {
         virtual Drawable* getChild();
 
         bool loadPackedAtlasXml(int initialFrameIndex);
-        void addImagePack(ImagePackInfo* info);
-        bool deleteImagePack(std::string name);
-        ImagePackInfo* getImagePack(std::string name);
+        TextureAtlas* atlas;
+
+        /*
+         * whether the image can be packed into a shared texture page
+         */
+        virtual bool supportsPacking() { return true; }
 
         /* 
          * virtual methods for MapDrawable
@@ -165,10 +161,16 @@ namespace emo {
         virtual std::vector<int> getTileIndexAtCoord(float x, float y) { std::vector<int> p; return p; }
         virtual std::vector<float> getTilePositionAtCoord(float x, float y) { std::vector<float> p; return p; }
 
+        /*
+         * virtual methods for FontDrawable
+         */
+        virtual bool setText(std::string text) { return false; }
+
         float getTexCoordStartX();
         float getTexCoordEndX();
         float getTexCoordStartY();
         float getTexCoordEndY();
+        float orientTexCoordY(float y);
 
         float getTexelHalfX();
         float getTexelHalfY();
@@ -208,10 +210,6 @@ namespace emo {
 
         std::string animationName;
         AnimationFrame* currentAnimation;
-
-        void deleteImagePacks();
-        imagepack_t* imagepacks;
-        std::vector<std::string>* imagepacks_names;
     };
 
     class MapDrawable : public Drawable {
@@ -224,6 +222,7 @@ namespace emo {
         virtual bool bindVertex();
         virtual void onDrawFrame();
         virtual void deleteBuffer(bool force);
+        virtual bool supportsPacking() { return false; }
 
         virtual void setChild(Drawable* child);
         virtual Drawable* getChild();
@@ -286,6 +285,11 @@ namespace emo {
         FontDrawable();
         virtual ~FontDrawable();
 
+        virtual bool bindVertex();
+        virtual void onDrawFrame();
+        virtual void deleteBuffer(bool force);
+        virtual bool setText(std::string text);
+
         int fontSize;
         std::string fontFace;
         SQBool isBold;
@@ -297,6 +301,25 @@ namespace emo {
         std::string param4;
         std::string param5;
         std::string param6;
+
+        /*
+         * glyph sprites lay out the text with the shared glyph atlas
+         * instead of rasterizing the whole string to a texture
+         */
+        GlyphAtlas* glyphAtlas;
+        std::string text;
+    protected:
+        std::vector<GlyphQuad> textQuads;
+        std::vector<GlyphRun>  textRuns;
+        std::vector<float>     textVertices;
+        GLuint text_vbos[2];
+        int    textCapacity;
+        int    textWidth;
+        int    textHeight;
+        bool   textChanged;
+
+        void updateTextBuffers();
+        void deleteTextBuffers();
     };
 
     class LiquidDrawable : public Drawable {
@@ -306,6 +329,7 @@ namespace emo {
 
         virtual bool bindVertex();
         virtual void onDrawFrame();
+        virtual bool supportsPacking() { return false; }
 
         bool updateTextureCoords(int index, float tx, float ty);
         bool updateSegmentCoords(int index, float sx, float sy);
@@ -324,6 +348,7 @@ namespace emo {
         virtual ~PointDrawable();
         virtual bool bindVertex();
         virtual void onDrawFrame();
+        virtual bool supportsPacking() { return false; }
 
         bool updatePointCoords(int index, float px, float py);
         bool updatePointCount(GLsizei count);
@@ -0,0 +1,322 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Constants.h"
+#include "Drawable_atlas.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+#include <rapidxml/rapidxml.hpp>
+
+#define TEXTURE_ATLAS_MAX_SEED      0x100000
+#define TEXTURE_ATLAS_MAX_HASH_SEED 16
+
+namespace emo {
+
+    /*
+     * FNV-1a of the name. the bucket is taken from this hash
+     * and the slot from its mix with the bucket seed, so the name
+     * is scanned only once per probe. the hash seed changes the
+     * offset basis.
+     */
+    uint32_t textureAtlasHash(const char* name, size_t length, uint32_t seed) {
+        uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char)name[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static uint32_t textureAtlasMix(uint32_t hash, uint32_t seed) {
+        hash += seed * 0x9e3779b9u;
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35u;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    TextureAtlas::TextureAtlas() {
+        this->imageWidth  = 0;
+        this->imageHeight = 0;
+        this->hashSeed    = 0;
+        this->referenceCount = 0;
+    }
+
+    static bool isAttribute(rapidxml::xml_attribute<>* attr, const char* name1, const char* name2) {
+        return strcmp(attr->name(), name1) == 0 || strcmp(attr->name(), name2) == 0;
+    }
+
+    /*
+     * parse the atlas xml. the xml is copied because rapidxml
+     * parses in place.
+     */
+    bool TextureAtlas::parse(const char* xml, size_t length, const std::string& baseDir) {
+        std::vector<char> buffer(xml, xml + length);
+        buffer.push_back(0);
+
+        rapidxml::xml_document<char> doc;
+        doc.parse<0>(&buffer[0]);
+
+        if (doc.first_node() == 0) {
+            return false;
+        }
+
+        this->frames.clear();
+        this->names.clear();
+
+        for (rapidxml::xml_node<> *node = doc.first_node(); node; node = node->next_sibling()) {
+            if (strcmp(node->name(), "Imageset") != 0 && strcmp(node->name(), "TextureAtlas") != 0) continue;
+            for (rapidxml::xml_attribute<> *attr = node->first_attribute(); attr; attr = attr->next_attribute()) {
+                if (isAttribute(attr, "Imagefile", "imagePath")) {
+                    this->imageName = baseDir + attr->value();
+                }
+            }
+            for (rapidxml::xml_node<> *child  = node->first_node(); child; child = child->next_sibling()) {
+                if (strcmp(child->name(), "Image") != 0 && strcmp(child->name(), "SubTexture") != 0) continue;
+
+                TextureAtlasFrame frame;
+                memset(&frame, 0, sizeof(frame));
+                frame.width  = 1;
+                frame.height = 1;
+
+                const char* frameName = NULL;
+                for (rapidxml::xml_attribute<> *attr = child->first_attribute(); attr; attr = attr->next_attribute()) {
+                    if (isAttribute(attr, "name", "Name")) {
+                        frameName = attr->value();
+                    } else if (isAttribute(attr, "x", "XPos")) {
+                        frame.x = atoi(attr->value());
+                    } else if (isAttribute(attr, "y", "YPos")) {
+                        frame.y = atoi(attr->value());
+                    } else if (isAttribute(attr, "width", "Width")) {
+                        frame.width = atoi(attr->value());
+                    } else if (isAttribute(attr, "height", "Height")) {
+                        frame.height = atoi(attr->value());
+                    }
+                }
+                if (frameName == NULL || frameName[0] == 0) continue;
+
+                frame.nameOffset = this->names.size();
+                frame.nameLength = strlen(frameName);
+                this->names.append(frameName, frame.nameLength);
+                this->frames.push_back(frame);
+            }
+        }
+
+        return !this->frames.empty() && this->buildIndex();
+    }
+
+    /*
+     * build the minimal perfect hash of the frame names.
+     * when a name appears twice the last frame wins. names with equal
+     * hashes can not be separated by any bucket seed, so the names are
+     * hashed again with the next hash seed until all hashes differ.
+     */
+    bool TextureAtlas::buildIndex() {
+        std::map<std::string, uint32_t> unique;
+        for (uint32_t i = 0; i < this->frames.size(); i++) {
+            unique[this->names.substr(this->frames[i].nameOffset, this->frames[i].nameLength)] = i;
+        }
+
+        std::vector<uint32_t> keys;
+        for (std::map<std::string, uint32_t>::iterator it = unique.begin(); it != unique.end(); it++) {
+            keys.push_back(it->second);
+        }
+
+        for (uint32_t hashSeed = 0; hashSeed < TEXTURE_ATLAS_MAX_HASH_SEED; hashSeed++) {
+            std::vector<uint32_t> hashes(keys.size());
+            for (size_t k = 0; k < keys.size(); k++) {
+                const TextureAtlasFrame& frame = this->frames[keys[k]];
+                hashes[k] = textureAtlasHash(this->names.data() + frame.nameOffset, frame.nameLength, hashSeed);
+            }
+
+            std::vector<uint32_t> sorted(hashes);
+            std::sort(sorted.begin(), sorted.end());
+            if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) continue;
+
+            this->hashSeed = hashSeed;
+            if (this->buildIndex(keys, hashes)) return true;
+        }
+        return false;
+    }
+
+    /*
+     * keys are grouped into buckets, the largest buckets are placed first
+     * by searching a seed that moves all of their keys to free slots.
+     */
+    bool TextureAtlas::buildIndex(const std::vector<uint32_t>& keys, const std::vector<uint32_t>& hashes) {
+        uint32_t keyCount = keys.size();
+
+        for (uint32_t bucketCount = (keyCount + 3) / 4; bucketCount <= keyCount * 2; bucketCount *= 2) {
+            std::vector<std::vector<uint32_t> > buckets(bucketCount);
+            for (uint32_t k = 0; k < keyCount; k++) {
+                buckets[hashes[k] % bucketCount].push_back(k);
+            }
+
+            std::vector<std::pair<size_t, uint32_t> > order;
+            for (uint32_t b = 0; b < bucketCount; b++) {
+                order.push_back(std::make_pair(buckets[b].size(), b));
+            }
+            std::sort(order.rbegin(), order.rend());
+
+            this->seeds.assign(bucketCount, 0);
+            this->slots.assign(keyCount, 0xffffffff);
+
+            bool placed = true;
+            for (uint32_t i = 0; i < bucketCount && placed; i++) {
+                std::vector<uint32_t>& bucket = buckets[order[i].second];
+                if (bucket.empty()) break;
+
+                placed = false;
+                std::vector<uint32_t> targets(bucket.size());
+                for (uint32_t seed = 1; seed < TEXTURE_ATLAS_MAX_SEED && !placed; seed++) {
+                    placed = true;
+                    for (size_t k = 0; k < bucket.size() && placed; k++) {
+                        uint32_t slot = textureAtlasMix(hashes[bucket[k]], seed) % keyCount;
+                        if (this->slots[slot] != 0xffffffff) placed = false;
+                        for (size_t j = 0; j < k && placed; j++) {
+                            if (targets[j] == slot) placed = false;
+                        }
+                        targets[k] = slot;
+                    }
+                    if (placed) {
+                        this->seeds[order[i].second] = seed;
+                        for (size_t k = 0; k < bucket.size(); k++) {
+                            this->slots[targets[k]] = keys[bucket[k]];
+                        }
+                    }
+                }
+            }
+            if (placed) return true;
+        }
+        return false;
+    }
+
+    /*
+     * returns the frame index of the name or -1
+     */
+    int TextureAtlas::find(const char* name, size_t length) {
+        if (this->slots.empty()) return -1;
+
+        uint32_t hash  = textureAtlasHash(name, length, this->hashSeed);
+        uint32_t seed  = this->seeds[hash % this->seeds.size()];
+        uint32_t index = this->slots[textureAtlasMix(hash, seed) % this->slots.size()];
+        if (index >= this->frames.size()) return -1;
+
+        const TextureAtlasFrame& frame = this->frames[index];
+        if (frame.nameLength != length || memcmp(this->names.data() + frame.nameOffset, name, length) != 0) {
+            return -1;
+        }
+        return index;
+    }
+
+    int TextureAtlas::find(const std::string& name) {
+        return this->find(name.data(), name.size());
+    }
+
+    /*
+     * load the binary atlas written by save
+     */
+    bool TextureAtlas::load(const unsigned char* data, size_t length) {
+        TextureAtlasHeader header;
+        if (length < sizeof(header)) return false;
+        memcpy(&header, data, sizeof(header));
+
+        if (header.magic != TEXTURE_ATLAS_MAGIC || header.version != TEXTURE_ATLAS_VERSION) {
+            return false;
+        }
+
+        // sizes are summed in 64bit so that they can not wrap a 32bit size_t
+        uint64_t framesSize = (uint64_t)header.frameCount  * sizeof(TextureAtlasFrame);
+        uint64_t seedsSize  = (uint64_t)header.bucketCount * sizeof(uint32_t);
+        uint64_t slotsSize  = (uint64_t)header.slotCount   * sizeof(uint32_t);
+        if (length < sizeof(header) + framesSize + seedsSize + slotsSize +
+                (uint64_t)header.imageNameLength + header.namesSize) {
+            return false;
+        }
+
+        const unsigned char* p = data + sizeof(header);
+        this->frames.resize(header.frameCount);
+        if (framesSize > 0) memcpy(&this->frames[0], p, framesSize);
+        p += framesSize;
+        this->seeds.resize(header.bucketCount);
+        if (seedsSize > 0) memcpy(&this->seeds[0], p, seedsSize);
+        p += seedsSize;
+        this->slots.resize(header.slotCount);
+        if (slotsSize > 0) memcpy(&this->slots[0], p, slotsSize);
+        p += slotsSize;
+        this->imageName.assign((const char*)p, header.imageNameLength);
+        p += header.imageNameLength;
+        this->names.assign((const char*)p, header.namesSize);
+
+        for (size_t i = 0; i < this->frames.size(); i++) {
+            if ((uint64_t)this->frames[i].nameOffset + this->frames[i].nameLength > this->names.size()) {
+                return false;
+            }
+        }
+
+        this->imageWidth  = header.imageWidth;
+        this->imageHeight = header.imageHeight;
+        this->hashSeed    = header.hashSeed;
+
+        return !this->frames.empty() && !this->seeds.empty() && !this->slots.empty();
+    }
+
+    /*
+     * write the binary atlas
+     */
+    void TextureAtlas::save(std::vector<unsigned char>* data) {
+        TextureAtlasHeader header;
+        header.magic       = TEXTURE_ATLAS_MAGIC;
+        header.version     = TEXTURE_ATLAS_VERSION;
+        header.frameCount  = this->frames.size();
+        header.bucketCount = this->seeds.size();
+        header.slotCount   = this->slots.size();
+        header.imageWidth  = this->imageWidth;
+        header.imageHeight = this->imageHeight;
+        header.imageNameLength = this->imageName.size();
+        header.namesSize   = this->names.size();
+        header.hashSeed    = this->hashSeed;
+
+        data->clear();
+        const unsigned char* p = (const unsigned char*)&header;
+        data->insert(data->end(), p, p + sizeof(header));
+        p = (const unsigned char*)&this->frames[0];
+        data->insert(data->end(), p, p + this->frames.size() * sizeof(TextureAtlasFrame));
+        p = (const unsigned char*)&this->seeds[0];
+        data->insert(data->end(), p, p + this->seeds.size() * sizeof(uint32_t));
+        p = (const unsigned char*)&this->slots[0];
+        data->insert(data->end(), p, p + this->slots.size() * sizeof(uint32_t));
+        data->insert(data->end(), this->imageName.begin(), this->imageName.end());
+        data->insert(data->end(), this->names.begin(), this->names.end());
+    }
+}
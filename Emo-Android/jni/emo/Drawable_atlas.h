@@ -0,0 +1,102 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_DRAWABLE_ATLAS_H
+#define EMO_DRAWABLE_ATLAS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#define TEXTURE_ATLAS_MAGIC   0x4c544145 // 'EATL'
+#define TEXTURE_ATLAS_VERSION 2
+#define TEXTURE_ATLAS_SUFFIX  ".atlas"
+
+/*
+ * Compiled texture atlas (CEGUI Imageset or Sparrow TextureAtlas).
+ * Frames are stored in the order of the xml and looked up by name
+ * through a minimal perfect hash (hash and displace), so every probe
+ * touches one seed and one slot. Names whose hashes collide are separated
+ * by hashing all names again with another hash seed. The atlas is shared read-only by all
+ * drawables created from it. The binary form is written by emopack
+ * as "<atlas>.atlas" and loaded without parsing the xml.
+ */
+namespace emo {
+    struct TextureAtlasHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t frameCount;
+        uint32_t bucketCount;
+        uint32_t slotCount;
+        int32_t  imageWidth;
+        int32_t  imageHeight;
+        uint32_t imageNameLength;
+        uint32_t namesSize;
+        uint32_t hashSeed;
+    };
+
+    struct TextureAtlasFrame {
+        int32_t  x;
+        int32_t  y;
+        int32_t  width;
+        int32_t  height;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+    };
+
+    class TextureAtlas {
+    public:
+        TextureAtlas();
+
+        bool parse(const char* xml, size_t length, const std::string& baseDir);
+        bool load(const unsigned char* data, size_t length);
+        void save(std::vector<unsigned char>* data);
+
+        int find(const char* name, size_t length);
+        int find(const std::string& name);
+
+        std::string name;
+        std::string imageName;
+        int imageWidth;
+        int imageHeight;
+
+        std::vector<TextureAtlasFrame> frames;
+        std::vector<uint32_t> seeds;
+        std::vector<uint32_t> slots;
+        std::string names;
+        uint32_t hashSeed;
+
+        int referenceCount;
+    protected:
+        bool buildIndex();
+        bool buildIndex(const std::vector<uint32_t>& keys, const std::vector<uint32_t>& hashes);
+    };
+
+    uint32_t textureAtlasHash(const char* name, size_t length, uint32_t seed = 0);
+}
+#endif
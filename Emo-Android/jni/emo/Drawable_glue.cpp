@@ -59,11 +59,16 @@ void initDrawableFunctions() {
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "useMeshMapSprite", emoDrawableUseMeshMapSprite);
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "setFontSpriteParam",  emoDrawableSetFontSpriteParam);
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "reloadFontSprite",  emoDrawableReloadFontSprite);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "createGlyphSprite", emoDrawableCreateGlyphSprite);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "setText",           emoDrawableSetText);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "getGlyphStats",     emoStageGetGlyphStats);
 
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "createSnapshot",   emoDrawableCreateSnapshot);
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "loadSnapshot",     emoDrawableLoadSnapshot);
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "stopSnapshot",     emoDrawableDisableSnapshot);
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "removeSnapshot",   emoDrawableRemoveSnapshot);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "captureSnapshot",  emoDrawableCaptureSnapshot);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "getCaptureStats",  emoStageGetCaptureStats);
 
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "getX",           emoDrawableGetX);
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "getY",           emoDrawableGetY);
@@ -119,12 +124,27 @@ void initDrawableFunctions() {
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "isOffscreenSupported",            emoStageIsOffscreenSupported);
 
     registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "blendFunc",      emoDrawableBlendFunc);
+
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "preload",            emoStagePreload);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "getPreloadProgress", emoStageGetPreloadProgress);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "finishPreload",      emoStageFinishPreload);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "unloadPreload",      emoStageUnloadPreload);
+
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "setPackable",        emoDrawableSetPackable);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "getPackerStats",     emoStageGetPackerStats);
+
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "getTextureSize",     emoDrawableGetTextureSize);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "getTextureMemory",   emoStageGetTextureMemory);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "isETC1Supported",    emoStageIsETC1Supported);
+
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "setMipmap",          emoDrawableSetMipmap);
+    registerClassFunc(engine->sqvm, EMO_STAGE_CLASS,    "mipmapThreshold",    emoStageSetMipmapThreshold);
 }
 
 /*
  * create drawable instance (single sprite)
  * 
- * @param image file name (only png can be used)
+ * @param image file name (png, or ETC1 texture in pkm or ktx)
  * @return drawable id
  */
 SQInteger emoDrawableCreateSprite(HSQUIRRELVM v) {
@@ -151,7 +171,7 @@ SQInteger emoDrawableCreateSprite(HSQUIRRELVM v) {
     int width  = 0;
     int height = 0;
     if (name != NULL && strlen(name) > 0) {
-        if (!loadPngSizeFromAsset(name, &width, &height)) {
+        if (!loadImageSizeFromAsset(name, &width, &height)) {
             delete drawable;
             return 0;
         }
@@ -254,7 +274,7 @@ SQInteger emoDrawableCreateSnapshot(HSQUIRRELVM v) {
 /*
  * create liquid drawable instance (single sprite)
  * 
- * @param image file name (only png can be used)
+ * @param image file name (png, or ETC1 texture in pkm or ktx)
  * @return drawable id
  */
 SQInteger emoDrawableCreateLiquidSprite(HSQUIRRELVM v) {
@@ -281,7 +301,7 @@ SQInteger emoDrawableCreateLiquidSprite(HSQUIRRELVM v) {
     int width  = 0;
     int height = 0;
     if (name != NULL && strlen(name) > 0) {
-        if (!loadPngSizeFromAsset(name, &width, &height)) {
+        if (!loadImageSizeFromAsset(name, &width, &height)) {
             delete drawable;
             return 0;
         }
@@ -305,7 +325,7 @@ SQInteger emoDrawableCreateLiquidSprite(HSQUIRRELVM v) {
 /*
  * create point drawable instance (single sprite)
  * 
- * @param image file name (only png can be used)
+ * @param image file name (png, or ETC1 texture in pkm or ktx)
  * @return drawable id
  */
 SQInteger emoDrawableCreatePointSprite(HSQUIRRELVM v) {
@@ -332,7 +352,7 @@ SQInteger emoDrawableCreatePointSprite(HSQUIRRELVM v) {
     int width  = 0;
     int height = 0;
     if (name != NULL && strlen(name) > 0) {
-        if (!loadPngSizeFromAsset(name, &width, &height)) {
+        if (!loadImageSizeFromAsset(name, &width, &height)) {
             delete drawable;
             return 0;
         }
@@ -429,6 +449,70 @@ SQInteger emoDrawableDisableSnapshot(HSQUIRRELVM v) {
     return 1;
 }
 
+/*
+ * capture the snapshot to a png file in the document directory.
+ * the pixels are read back at the start of the next frame and encoded
+ * on the capture thread. emo.onCapture(name, path, err) is called
+ * when the file is written.
+ *
+ * @param drawable id
+ * @param file name
+ * @param capture name passed to the callback (default: file name)
+ * @return EMO_NO_ERROR if the capture is queued
+ */
+SQInteger emoDrawableCaptureSnapshot(HSQUIRRELVM v) {
+    const SQChar* id;
+    const SQChar* fileName;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 3 && sq_gettype(v, 2) == OT_STRING && sq_gettype(v, 3) == OT_STRING) {
+        sq_tostring(v, 2);
+        sq_getstring(v, -1, &id);
+        sq_poptop(v);
+        sq_getstring(v, 3, &fileName);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    std::string name = fileName;
+    if (nargs >= 4 && sq_gettype(v, 4) == OT_STRING) {
+        const SQChar* captureName;
+        sq_getstring(v, 4, &captureName);
+        name = captureName;
+    }
+
+    std::string path = engine->javaGlue->getDataFilePath(fileName);
+    sq_pushinteger(v, engine->captureSnapshot(id, name, path));
+    return 1;
+}
+
+/*
+ * returns the statistics of the snapshot captures.
+ * stall times are the readback of the main thread in microseconds,
+ * encode times are the png encoding of the capture thread in microseconds.
+ *
+ * @return table {queued, completed, failed, lastStall, averageStall, maxStall,
+ *                lastEncodeTime, averageEncodeTime, lastFileSize, pixelsPerSecond}
+ */
+SQInteger emoStageGetCaptureStats(HSQUIRRELVM v) {
+    emo::ImageCaptureStats stats;
+    engine->getCaptureStats(&stats);
+
+    sq_newtable(v);
+    newSlotInteger(v, "queued",            stats.queued);
+    newSlotInteger(v, "completed",         stats.completed);
+    newSlotInteger(v, "failed",            stats.failed);
+    newSlotInteger(v, "lastStall",         stats.lastStall);
+    newSlotInteger(v, "averageStall",      stats.averageStall);
+    newSlotInteger(v, "maxStall",          stats.maxStall);
+    newSlotInteger(v, "lastEncodeTime",    stats.lastEncodeTime);
+    newSlotInteger(v, "averageEncodeTime", stats.averageEncodeTime);
+    newSlotInteger(v, "lastFileSize",      stats.lastFileSize);
+    newSlotInteger(v, "pixelsPerSecond",   stats.pixelsPerSecond);
+
+    return 1;
+}
+
 /*
  * create line instance
  *
@@ -541,8 +625,12 @@ SQInteger emoDrawableCreateSpriteSheet(HSQUIRRELVM v) {
     int width  = 0;
     int height = 0;
 
-    if (name != NULL && strlen(name) > 0) {
-         if (!loadPngSizeFromAsset(name, &width, &height)) {
+    if (drawable->isPackedAtlas) {
+        // the atlas knows the size of its image
+        width  = drawable->atlas->imageWidth;
+        height = drawable->atlas->imageHeight;
+    } else if (name != NULL && strlen(name) > 0) {
+         if (!loadImageSizeFromAsset(name, &width, &height)) {
             delete drawable;
             return 0;
         }
@@ -681,8 +769,9 @@ SQInteger emoDrawableReloadFontSprite(HSQUIRRELVM v) {
         sq_tostring(v, 3);
         sq_getstring(v, -1, &name);
 
-        engine->removeCachedImage(drawable->name);
-        engine->addCachedImage(name, drawable->getTexture());
+        emo::Image* texture = drawable->getTexture();
+        engine->removeCachedImage(drawable->name, texture);
+        engine->addCachedImage(engine->getImageCacheKey(name, texture->page != NULL), texture);
 
         drawable->name = name;
     }
@@ -711,6 +800,129 @@ SQInteger emoDrawableReloadFontSprite(HSQUIRRELVM v) {
     return 1;
 }
 
+/*
+ * create glyph sprite. the glyphs are rasterized once per font face
+ * and size into the shared glyph atlas, and the text is drawn with
+ * one quad per glyph. changing the text updates the vertices only.
+ *
+ * @param text (UTF-8)
+ * @param font size
+ * @param font face
+ * @param bold
+ * @param italic
+ * @return drawable id
+ */
+SQInteger emoDrawableCreateGlyphSprite(HSQUIRRELVM v) {
+    const SQChar* text;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 2 && sq_gettype(v, 2) == OT_STRING) {
+        sq_getstring(v, 2, &text);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    emo::FontDrawable* drawable = new emo::FontDrawable();
+    drawable->setFrameCount(1);
+    drawable->load();
+
+    SQInteger fontSize = 0;
+    if (nargs >= 3 && sq_gettype(v, 3) == OT_INTEGER) {
+        sq_getinteger(v, 3, &fontSize);
+    }
+    if (nargs >= 4 && sq_gettype(v, 4) == OT_STRING) {
+        const SQChar* fontFace;
+        sq_getstring(v, 4, &fontFace);
+        drawable->fontFace = fontFace;
+    }
+    if (nargs >= 5 && sq_gettype(v, 5) == OT_BOOL) {
+        sq_getbool(v, 5, &drawable->isBold);
+    }
+    if (nargs >= 6 && sq_gettype(v, 6) == OT_BOOL) {
+        sq_getbool(v, 6, &drawable->isItalic);
+    }
+    drawable->fontSize = fontSize;
+
+    drawable->glyphAtlas = engine->loadGlyphAtlas(drawable->fontFace, drawable->fontSize,
+                                                  drawable->isBold, drawable->isItalic);
+    drawable->setText(text);
+
+    char key[DRAWABLE_KEY_LENGTH];
+    sprintf(key, "%ld%d-%d", 
+                engine->uptime.time, engine->uptime.millitm, drawable->getCurrentBufferId());
+
+    engine->addDrawable(key, drawable);
+
+    sq_pushstring(v, key, strlen(key));
+
+    return 1;
+}
+
+/*
+ * change the text of the glyph sprite. the glyphs that are not in
+ * the atlas yet are rasterized, the size of the sprite is updated.
+ *
+ * @param drawable id
+ * @param text (UTF-8)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDrawableSetText(HSQUIRRELVM v) {
+    const SQChar* id;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 2 && sq_gettype(v, 2) == OT_STRING) {
+        sq_tostring(v, 2);
+        sq_getstring(v, -1, &id);
+        sq_poptop(v);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    emo::Drawable* drawable = engine->getDrawable(id);
+
+    if (drawable == NULL) {
+        sq_pushinteger(v, ERR_INVALID_ID);
+        return 1;
+    }
+
+    const SQChar* text;
+    if (nargs >= 3 && sq_gettype(v, 3) == OT_STRING) {
+        sq_getstring(v, 3, &text);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    if (!drawable->setText(text)) {
+        sq_pushinteger(v, ERR_NOT_SUPPORTED);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * returns the statistics of the glyph atlases
+ *
+ * @return table {atlasCount, pageCount, glyphCount, pageBytes,
+ *                rasterizeCount, uploadCount}
+ */
+SQInteger emoStageGetGlyphStats(HSQUIRRELVM v) {
+    emo::GlyphAtlasStats stats;
+    engine->getGlyphStats(&stats);
+
+    sq_newtable(v);
+    newSlotInteger(v, "atlasCount",     stats.atlasCount);
+    newSlotInteger(v, "pageCount",      stats.pageCount);
+    newSlotInteger(v, "glyphCount",     stats.glyphCount);
+    newSlotInteger(v, "pageBytes",      stats.pageBytes);
+    newSlotInteger(v, "rasterizeCount", stats.rasterizeCount);
+    newSlotInteger(v, "uploadCount",    stats.uploadCount);
+
+    return 1;
+}
+
 /*
  * load drawable
  *
@@ -742,9 +954,10 @@ SQInteger emoDrawableLoad(HSQUIRRELVM v) {
 
     if (!drawable->name.empty()) {
          emo::Image* image = NULL;
+         std::string key = engine->getImageCacheKey(drawable->name, drawable->packable && drawable->supportsPacking());
 
-        if (engine->hasCachedImage(drawable->name)) {
-            image = engine->getCachedImage(drawable->name);
+        if (engine->hasCachedImage(key)) {
+            image = engine->getCachedImage(key);
         } else if (drawable->useFont) {
             image = new emo::Image();
             if (engine->javaGlue->loadTextBitmap(drawable, image, true)) {
@@ -761,7 +974,7 @@ SQInteger emoDrawableLoad(HSQUIRRELVM v) {
 
                 image->genTextures();
 
-                engine->addCachedImage(drawable->name, image);
+                engine->addCachedImage(key, image);
             } else {
                 delete image;
                 sq_pushinteger(v, ERR_ASSET_LOAD);
@@ -769,16 +982,20 @@ SQInteger emoDrawableLoad(HSQUIRRELVM v) {
             }
         } else {
             image = new emo::Image();
-            if (loadPngFromAsset(drawable->name.c_str(), image, true)) {
+            if (loadImageFromAsset(drawable->name.c_str(), image, true)) {
 
-                // calculate the size of power of two
-                image->glWidth  = nextPowerOfTwo(image->width);
-                image->glHeight = nextPowerOfTwo(image->height);
+                // texture size is set by the decoder
                 image->loaded   = false;
 
-                image->genTextures();
+                bool moved = false;
+                if (drawable->packable && drawable->supportsPacking() && engine->packer->pack(image, &moved)) {
+                    // the other images in the page have moved
+                    if (moved) engine->rebindPackedDrawables();
+                } else {
+                    image->genTextures();
+                }
 
-                engine->addCachedImage(drawable->name, image);
+                engine->addCachedImage(key, image);
             } else {
                 delete image;
                 sq_pushinteger(v, ERR_ASSET_LOAD);
@@ -787,6 +1004,9 @@ SQInteger emoDrawableLoad(HSQUIRRELVM v) {
         }
 
         if (image != NULL) {
+            if (drawable->mipmapMode == MIPMAP_ALWAYS) {
+                image->generateMipmaps();
+            }
             drawable->setTexture(image);
             drawable->hasTexture = true;
 
@@ -922,21 +1142,20 @@ SQInteger emoDrawableLoadMapSprite(HSQUIRRELVM v) {
     // load drawable texture
     if (!drawable->name.empty()) {
          emo::Image* image = NULL;
+         std::string key = engine->getImageCacheKey(drawable->name, false);
 
-        if (engine->hasCachedImage(drawable->name)) {
-            image = engine->getCachedImage(drawable->name);
+        if (engine->hasCachedImage(key)) {
+            image = engine->getCachedImage(key);
         } else {
             image = new emo::Image();
-            if (loadPngFromAsset(drawable->name.c_str(), image, true)) {
+            if (loadImageFromAsset(drawable->name.c_str(), image, true)) {
 
-                // calculate the size of power of two
-                image->glWidth  = nextPowerOfTwo(image->width);
-                image->glHeight = nextPowerOfTwo(image->height);
+                // texture size is set by the decoder
                 image->loaded   = false;
 
                 image->genTextures();
 
-                engine->addCachedImage(drawable->name, image);
+                engine->addCachedImage(key, image);
             } else {
                 delete image;
                 sq_pushinteger(v, ERR_ASSET_LOAD);
@@ -945,6 +1164,9 @@ SQInteger emoDrawableLoadMapSprite(HSQUIRRELVM v) {
         }
 
         if (image != NULL) {
+            if (drawable->mipmapMode == MIPMAP_ALWAYS) {
+                image->generateMipmaps();
+            }
             drawable->setTexture(image);
             drawable->hasTexture = true;
 
@@ -2399,9 +2621,9 @@ SQInteger emoDrawableAnimate(HSQUIRRELVM v) {
             } else if(sq_gettype(v, -1) == OT_STRING) {
                 const SQChar *value;
                 sq_getstring(v, -1, &value);
-                emo::ImagePackInfo* info = drawable->getImagePack(value);
-                if (info == NULL) continue;
-                animation->setFrame(idx, info->index);
+                int index = drawable->atlas != NULL ? drawable->atlas->find(value) : -1;
+                if (index < 0) continue;
+                animation->setFrame(idx, index);
             }
             idx++;
             sq_pop(v, 2);
@@ -3070,3 +3292,360 @@ SQInteger emoDrawableBlendFunc(HSQUIRRELVM v) {
     return 1;
 }
 
+
+/*
+ * start loading the assets of the scene on worker threads.
+ * png images are decoded, other assets are read into memory.
+ *
+ * @param group name
+ * @param array of asset names
+ * @param worker count (optional)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoStagePreload(HSQUIRRELVM v) {
+    if (sq_gettype(v, 2) != OT_STRING || sq_gettype(v, 3) != OT_ARRAY) {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    const SQChar* group;
+    sq_getstring(v, 2, &group);
+
+    SQInteger workers = emo::getAssetPreloadWorkers();
+    if (sq_gettop(v) >= 4 && sq_gettype(v, 4) == OT_INTEGER) {
+        sq_getinteger(v, 4, &workers);
+    }
+
+    std::vector<std::string> names;
+    sq_push(v, 3);
+    sq_pushnull(v);
+    while(SQ_SUCCEEDED(sq_next(v, -2))) {
+        if (sq_gettype(v, -1) == OT_STRING) {
+            const SQChar* name;
+            sq_getstring(v, -1, &name);
+            names.push_back(name);
+        }
+        sq_pop(v, 2);
+    }
+    sq_pop(v, 2);
+
+    if (!engine->preloader->preload(group, names, workers)) {
+        sq_pushinteger(v, ERR_ASSET_LOAD);
+        return 1;
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * returns the preload progress of the group
+ *
+ * @param group name
+ * @return table {total, loaded, failed, done}
+ */
+SQInteger emoStageGetPreloadProgress(HSQUIRRELVM v) {
+    if (sq_gettype(v, 2) != OT_STRING) {
+        return 0;
+    }
+
+    const SQChar* group;
+    sq_getstring(v, 2, &group);
+
+    emo::AssetPreloadProgress progress;
+    if (!engine->preloader->getProgress(group, &progress)) {
+        return 0;
+    }
+
+    sq_newtable(v);
+    newSlotInteger(v, "total",  progress.total);
+    newSlotInteger(v, "loaded", progress.loaded);
+    newSlotInteger(v, "failed", progress.failed);
+    sq_pushstring(v, "done", -1);
+    sq_pushbool(v, progress.loaded + progress.failed >= progress.total);
+    sq_newslot(v, -3, SQFalse);
+
+    return 1;
+}
+
+/*
+ * wait for the preload workers and upload the decoded images
+ * to textures in one pass. the images are added to the image cache
+ * and stay there until the group is unloaded.
+ *
+ * @param group name
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoStageFinishPreload(HSQUIRRELVM v) {
+    if (sq_gettype(v, 2) != OT_STRING) {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    const SQChar* group;
+    sq_getstring(v, 2, &group);
+
+    std::vector<std::pair<std::string, emo::Image*> > images;
+    if (!engine->preloader->takeImages(group, &images)) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    for (size_t i = 0; i < images.size(); i++) {
+        emo::Image* image = images[i].second;
+        if (engine->hasCachedImage(images[i].first)) {
+            // already loaded by a drawable: just pin it
+            engine->getCachedImage(images[i].first)->referenceCount++;
+            delete image;
+            continue;
+        }
+        image->genTextures();
+        if (engine->hasDisplay()) {
+            image->upload();
+        }
+        image->referenceCount = 1;
+        engine->addCachedImage(images[i].first, image);
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * unpin the assets of the group. images that no drawable uses
+ * are removed from the image cache.
+ *
+ * @param group name
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoStageUnloadPreload(HSQUIRRELVM v) {
+    if (sq_gettype(v, 2) != OT_STRING) {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    const SQChar* group;
+    sq_getstring(v, 2, &group);
+
+    std::vector<std::string> names;
+    if (!engine->preloader->unload(group, &names)) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    for (size_t i = 0; i < names.size(); i++) {
+        if (!engine->hasCachedImage(names[i])) continue;
+        emo::Image* image = engine->getCachedImage(names[i]);
+        image->referenceCount--;
+        if (image->referenceCount <= 0) {
+            // a drawable may have packed the image before it was pinned
+            engine->packer->remove(image);
+            image->deleteTextures(engine->hasDisplay());
+            engine->removeCachedImage(names[i]);
+            delete image;
+        }
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * pack the image of the sprite into a shared texture page.
+ * must be called before the sprite is loaded.
+ *
+ * @param drawable id
+ * @param packable or not
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDrawableSetPackable(HSQUIRRELVM v) {
+    const SQChar* id;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 2 && sq_gettype(v, 2) == OT_STRING) {
+        sq_tostring(v, 2);
+        sq_getstring(v, -1, &id);
+        sq_poptop(v);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    emo::Drawable* drawable = engine->getDrawable(id);
+
+    if (drawable == NULL) {
+        sq_pushinteger(v, ERR_INVALID_ID);
+        return 1;
+    }
+
+    if (!drawable->supportsPacking()) {
+        sq_pushinteger(v, ERR_NOT_SUPPORTED);
+        return 1;
+    }
+
+    SQBool packable = true;
+    if (nargs >= 3 && sq_gettype(v, 3) == OT_BOOL) {
+        sq_getbool(v, 3, &packable);
+    }
+    drawable->packable = packable;
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * returns the statistics of the texture packer
+ *
+ * @return table {pageCount, imageCount, usedPixels, pagePixels,
+ *                unpackedPixels, grows, repacks, efficiency, textureSwitches}
+ */
+SQInteger emoStageGetPackerStats(HSQUIRRELVM v) {
+    emo::TexturePackerStats stats;
+    engine->packer->getStats(&stats);
+
+    sq_newtable(v);
+    newSlotInteger(v, "pageCount",      stats.pageCount);
+    newSlotInteger(v, "imageCount",     stats.imageCount);
+    newSlotInteger(v, "usedPixels",     stats.usedPixels);
+    newSlotInteger(v, "pagePixels",     stats.pagePixels);
+    newSlotInteger(v, "unpackedPixels", stats.unpackedPixels);
+    newSlotInteger(v, "grows",          stats.grows);
+    newSlotInteger(v, "repacks",        stats.repacks);
+    newSlotFloat(v,   "efficiency",     stats.efficiency);
+    newSlotInteger(v, "textureSwitches", engine->textureSwitches);
+
+    return 1;
+}
+
+/*
+ * returns the bytes that the texture of the sprite takes in the GPU memory.
+ * compressed textures are counted by their compressed size and
+ * packed images are counted by the pages (see getTextureMemory).
+ *
+ * @param drawable id
+ * @return texture size in bytes
+ */
+SQInteger emoDrawableGetTextureSize(HSQUIRRELVM v) {
+    const SQChar* id;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 2 && sq_gettype(v, 2) == OT_STRING) {
+        sq_tostring(v, 2);
+        sq_getstring(v, -1, &id);
+        sq_poptop(v);
+    } else {
+        return 0;
+    }
+
+    emo::Drawable* drawable = engine->getDrawable(id);
+
+    if (drawable == NULL || !drawable->hasTexture) {
+        return 0;
+    }
+
+    sq_pushinteger(v, drawable->getTexture()->getTextureSize());
+    return 1;
+}
+
+/*
+ * returns the GPU memory of the cached textures
+ *
+ * @return table {textureCount, textureBytes, compressedCount,
+ *                compressedBytes, uncompressedBytes, pageBytes, glyphBytes}
+ */
+SQInteger emoStageGetTextureMemory(HSQUIRRELVM v) {
+    emo::TextureMemoryStats stats;
+    engine->getTextureMemory(&stats);
+
+    sq_newtable(v);
+    newSlotInteger(v, "textureCount",      stats.textureCount);
+    newSlotInteger(v, "textureBytes",      stats.textureBytes);
+    newSlotInteger(v, "compressedCount",   stats.compressedCount);
+    newSlotInteger(v, "compressedBytes",   stats.compressedBytes);
+    newSlotInteger(v, "uncompressedBytes", stats.uncompressedBytes);
+    newSlotInteger(v, "pageBytes",         stats.pageBytes);
+    newSlotInteger(v, "glyphBytes",        stats.glyphBytes);
+
+    return 1;
+}
+
+/*
+ * returns whether ETC1 textures are uploaded without decoding
+ */
+SQInteger emoStageIsETC1Supported(HSQUIRRELVM v) {
+    sq_pushbool(v, engine->canUseETC1);
+    return 1;
+}
+
+/*
+ * set the mipmap mode of the sprite. MIPMAP_ALWAYS generates the
+ * mipmap chain when the sprite is loaded, MIPMAP_AUTO generates it
+ * when the sprite is drawn below the mipmap threshold scale.
+ * compressed and packed images do not have mipmaps.
+ *
+ * @param drawable id
+ * @param mipmap mode (MIPMAP_NONE, MIPMAP_ALWAYS or MIPMAP_AUTO)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoDrawableSetMipmap(HSQUIRRELVM v) {
+    const SQChar* id;
+    SQInteger nargs = sq_gettop(v);
+    if (nargs >= 2 && sq_gettype(v, 2) == OT_STRING) {
+        sq_tostring(v, 2);
+        sq_getstring(v, -1, &id);
+        sq_poptop(v);
+    } else {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    emo::Drawable* drawable = engine->getDrawable(id);
+
+    if (drawable == NULL) {
+        sq_pushinteger(v, ERR_INVALID_ID);
+        return 1;
+    }
+
+    SQInteger mode = MIPMAP_ALWAYS;
+    if (nargs >= 3 && sq_gettype(v, 3) == OT_INTEGER) {
+        sq_getinteger(v, 3, &mode);
+    }
+    if (mode != MIPMAP_NONE && mode != MIPMAP_ALWAYS && mode != MIPMAP_AUTO) {
+        sq_pushinteger(v, ERR_INVALID_PARAM);
+        return 1;
+    }
+
+    drawable->mipmapMode = mode;
+
+    // tiles of the map sprite are drawn by its child
+    if (drawable->getChild() != NULL) {
+        drawable->getChild()->mipmapMode = mode;
+    }
+
+    // upload the chain when the sprite is already loaded
+    if (mode == MIPMAP_ALWAYS && drawable->hasTexture && drawable->getTexture()->mipmapLevels == 0 &&
+            drawable->getTexture()->generateMipmaps() && engine->hasDisplay()) {
+        drawable->getTexture()->upload();
+    }
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
+
+/*
+ * set the scale below which the sprites of MIPMAP_AUTO mode use mipmaps
+ *
+ * @param scale threshold (default 0.5)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoStageSetMipmapThreshold(HSQUIRRELVM v) {
+    if (sq_gettype(v, 2) != OT_FLOAT && sq_gettype(v, 2) != OT_INTEGER) {
+        sq_pushinteger(v, ERR_INVALID_PARAM_TYPE);
+        return 1;
+    }
+
+    SQFloat threshold;
+    sq_getfloat(v, 2, &threshold);
+    engine->mipmapThreshold = threshold;
+
+    sq_pushinteger(v, EMO_NO_ERROR);
+    return 1;
+}
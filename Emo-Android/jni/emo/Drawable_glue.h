@@ -101,6 +101,8 @@ SQInteger emoDrawableCreateSnapshot(HSQUIRRELVM v);
 SQInteger emoDrawableLoadSnapshot(HSQUIRRELVM v); 
 SQInteger emoDrawableRemoveSnapshot(HSQUIRRELVM v); 
 SQInteger emoDrawableDisableSnapshot(HSQUIRRELVM v); 
+SQInteger emoDrawableCaptureSnapshot(HSQUIRRELVM v);
+SQInteger emoStageGetCaptureStats(HSQUIRRELVM v);
 
 SQInteger emoDrawableUpdateLiquidTextureCoords(HSQUIRRELVM v); 
 SQInteger emoDrawableUpdateLiquidSegmentCoords(HSQUIRRELVM v); 
@@ -113,4 +115,20 @@ SQInteger emoPointDrawableGetPointCount(HSQUIRRELVM v);
 SQInteger emoStageIsOffscreenSupported(HSQUIRRELVM v);
 
 SQInteger emoDrawableBlendFunc(HSQUIRRELVM v);
+
+SQInteger emoStagePreload(HSQUIRRELVM v);
+SQInteger emoStageGetPreloadProgress(HSQUIRRELVM v);
+SQInteger emoStageFinishPreload(HSQUIRRELVM v);
+SQInteger emoStageUnloadPreload(HSQUIRRELVM v);
+
+SQInteger emoDrawableSetPackable(HSQUIRRELVM v);
+SQInteger emoStageGetPackerStats(HSQUIRRELVM v);
+SQInteger emoDrawableGetTextureSize(HSQUIRRELVM v);
+SQInteger emoStageGetTextureMemory(HSQUIRRELVM v);
+SQInteger emoStageIsETC1Supported(HSQUIRRELVM v);
+SQInteger emoDrawableSetMipmap(HSQUIRRELVM v);
+SQInteger emoStageSetMipmapThreshold(HSQUIRRELVM v);
+SQInteger emoDrawableCreateGlyphSprite(HSQUIRRELVM v);
+SQInteger emoDrawableSetText(HSQUIRRELVM v);
+SQInteger emoStageGetGlyphStats(HSQUIRRELVM v);
 #endif
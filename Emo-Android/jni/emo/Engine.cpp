@@ -29,7 +29,9 @@
 #include "Runtime.h"
 #include "VmFunc.h"
 #include "Physics.h"
+#include "Physics_debugdraw.h"
 
+#include <stdlib.h>
 #include <android/window.h>
 #include <jni.h>
 #include <GLES/glext.h>
@@ -64,12 +66,18 @@ namespace emo {
         this->useOffscreen = false;
         this->stopOffscreenRequested = false;
         this->canUseOffscreen = true;
+        this->canUseETC1 = false;
 
         this->srcBlendFactor = GL_SRC_ALPHA;
         this->dstBlendFactor = GL_ONE_MINUS_SRC_ALPHA;
 
 
         this->useANR = false;
+        this->usePremultipliedAlpha = false;
+        this->mipmapMode = MIPMAP_NONE;
+        this->mipmapThreshold = MIPMAP_DEFAULT_THRESHOLD;
+        this->textureSwitches = 0;
+        this->physicsDebugDraw = NULL;
 
         this->sqvm = sq_open(SQUIRREL_VM_INITIAL_STACK_SIZE);
     }
@@ -77,12 +85,25 @@ namespace emo {
     Engine::~Engine() {
         delete this->stage;
         delete this->audio;
+        delete this->preloader;
+        delete this->packer;
+        delete this->captureEncoder;
+        delete this->assets;
         delete this->drawables;
         delete this->drawablesToRemove;
         delete this->database;
         delete this->javaGlue;
         delete this->sortedDrawables;
         delete this->imageCache;
+        delete this->atlasCache;
+        delete this->glyphAtlasCache;
+        for (size_t i = 0; i < this->pendingCaptures->size(); i++) {
+            deleteCaptureTask(this->pendingCaptures->at(i));
+        }
+        delete this->pendingCaptures;
+        if (this->physicsDebugDraw != NULL) {
+            delete this->physicsDebugDraw;
+        }
     }
 
     void Engine::initScriptFunctions() {
@@ -171,6 +192,23 @@ namespace emo {
         // force fullscreen
         this->updateOptions(OPT_WINDOW_FORCE_FULLSCREEN);
 
+        // create asset store instance
+        assets = new AssetStore(new AndroidAssetBackend(this->app->activity->assetManager));
+        if (assets->openArchive(ASSET_ARCHIVE_NAME)) {
+            LOGI("using packed asset archive");
+            if (!assets->isArchiveMapped()) {
+                LOGW("emo.pak is compressed in the package, store it uncompressed (aapt -0 pak)");
+            }
+        }
+        initMipmapKernels();
+        preloader = new AssetPreloader(assets, decodeImageFromAsset);
+
+        // create texture packer instance
+        packer = new TexturePacker();
+
+        // create snapshot capture encoder (the thread starts on the first capture)
+        captureEncoder = new ImageCaptureEncoder();
+
         // create stage instance
         stage = new Stage();
 
@@ -194,6 +232,9 @@ namespace emo {
         this->sortedDrawables = new std::vector<Drawable*>;
 
         this->imageCache = new images_t();
+        this->atlasCache = new atlases_t();
+        this->glyphAtlasCache = new glyph_atlases_t();
+        this->pendingCaptures = new std::vector<ImageCaptureTask*>;
 
         // init Squirrel VM
         initSQVM(this->sqvm);
@@ -260,6 +301,10 @@ namespace emo {
             this->canUseOffscreen = false;
         }
 
+        // ETC1 textures are decoded by the cpu when the extension is not available
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+        this->canUseETC1 = extensions != NULL && strstr(extensions, "GL_OES_compressed_ETC1_RGB8_texture") != NULL;
+
         if (!this->scriptLoaded) {
             // register class and functions for script
             this->initScriptFunctions();
@@ -410,8 +455,13 @@ namespace emo {
             }
             this->updateUptime();
             callSqFunction(this->sqvm, EMO_NAMESPACE, EMO_FUNC_ONDISPOSE);
+            if (!this->database->flushPreference(true)) {
+                LOGE("emo_database: failed to write the preferences");
+                LOGE(this->database->lastErrorMessage.c_str());
+            }
             sq_close(this->sqvm);
             this->sqvm = NULL;
+            clearPhysicsWorldPool();
 
             this->unloadDrawables();
             this->stage->deleteBuffer();
@@ -439,6 +489,10 @@ namespace emo {
 
         this->updateUptime();
         callSqFunction(this->sqvm, EMO_NAMESPACE, EMO_FUNC_ONLOST_FOCUS);
+        if (!this->database->flushPreference(true)) {
+            LOGE("emo_database: failed to write the preferences");
+            LOGE(this->database->lastErrorMessage.c_str());
+        }
         this->animating = false;
     }
 
@@ -585,7 +639,12 @@ namespace emo {
 
             if (this->loaded) {
                 this->deleteDrawableBuffers();
+                this->packer->deleteTextures(true);
+                this->deleteGlyphTextures(true);
                 this->stage->deleteBuffer();
+                if (this->physicsDebugDraw != NULL) {
+                    this->physicsDebugDraw->deleteBuffer();
+                }
             }
 
             eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
@@ -617,6 +676,10 @@ namespace emo {
 
         this->updateUptime();
 
+        this->readCaptures();
+        this->database->dispatchCallbacks(this->sqvm);
+        this->dispatchCaptureCallbacks();
+
         if (this->enableOnUpdate) {
             int32_t _delta = this->getLastOnDrawDrawablesDelta();
             callSqFunction_Bool_Float(this->sqvm, EMO_NAMESPACE, EMO_FUNC_ON_UPDATE, _delta, SQFalse);
@@ -649,6 +712,7 @@ namespace emo {
 
         if (likely(!this->useOffscreen)) this->stage->onDrawFrame();
         this->onDrawDrawables(delta);
+        if (unlikely(this->physicsDebugDraw != NULL)) this->physicsDebugDraw->onDrawFrame();
 
         eglSwapBuffers(this->display, this->surface);
 
@@ -724,6 +788,8 @@ namespace emo {
                       this->sortedDrawables->end(), drawable_z_compare);
             this->sortOrderDirty = false;
         }
+        GLuint lastTextureId = 0;
+        this->textureSwitches = 0;
         for (unsigned int i = 0; i < this->sortedDrawables->size(); i++) {
             Drawable* drawable = this->sortedDrawables->at(i);
             if (unlikely(useOffscreen) && i == 0 && !drawable->isScreenEntity) {
@@ -739,6 +805,12 @@ namespace emo {
                     glBlendFunc(this->srcBlendFactor, this->dstBlendFactor);
                 }
 
+                // count the texture switches of the frame
+                if (drawable->hasTexture && drawable->getTexture()->textureId != lastTextureId) {
+                    lastTextureId = drawable->getTexture()->textureId;
+                    this->textureSwitches++;
+                }
+
                 drawable->onDrawFrame();
             }
         }
@@ -785,6 +857,20 @@ namespace emo {
         }
     }
 
+    /*
+     * rebuild the texture coordinates of the packed sprites
+     * after their page has grown or has been repacked
+     */
+    void Engine::rebindPackedDrawables() {
+        drawables_t::iterator iter;
+        for(iter = this->drawables->begin(); iter != this->drawables->end(); iter++) {
+            Drawable* drawable = iter->second;
+            if (drawable->loaded && drawable->hasTexture && drawable->getTexture()->page != NULL) {
+                drawable->bindVertex();
+            }
+        }
+    }
+
     void Engine::unloadDrawables() {
         this->sortedDrawables->clear();
         this->sortOrderDirty = true;
@@ -824,6 +910,21 @@ namespace emo {
         case OPT_DISABLE_BACK_KEY:
             this->enableBackKey = false;
             break;
+        case OPT_ENABLE_PREMULTIPLIED_ALPHA:
+            this->usePremultipliedAlpha = true;
+            break;
+        case OPT_DISABLE_PREMULTIPLIED_ALPHA:
+            this->usePremultipliedAlpha = false;
+            break;
+        case OPT_ENABLE_MIPMAP:
+            this->mipmapMode = MIPMAP_ALWAYS;
+            break;
+        case OPT_AUTO_MIPMAP:
+            this->mipmapMode = MIPMAP_AUTO;
+            break;
+        case OPT_DISABLE_MIPMAP:
+            this->mipmapMode = MIPMAP_NONE;
+            break;
         case OPT_ORIENTATION_PORTRAIT:
             this->javaGlue->setOrientationPortrait();
             break;
@@ -1035,6 +1136,37 @@ namespace emo {
         return this->imageCache->erase(key);
     }
 
+    /*
+     * remove the image from the cache whether it is stored
+     * under its name or under the key of its unpacked copy
+     */
+    bool Engine::removeCachedImage(std::string name, Image* image) {
+        if (this->getCachedImage(name) == image) {
+            return this->removeCachedImage(name);
+        }
+        std::string key = name + TEXTURE_PAGE_UNPACKED_KEY;
+        if (this->getCachedImage(key) == image) {
+            return this->removeCachedImage(key);
+        }
+        return false;
+    }
+
+    /*
+     * returns the cache key of the image for the drawable.
+     * drawables that can not be packed use 0..1 texture coordinates,
+     * so they must not share an image that lives in a texture page.
+     */
+    std::string Engine::getImageCacheKey(std::string name, bool packable) {
+        if (packable) return name;
+
+        std::string key = name + TEXTURE_PAGE_UNPACKED_KEY;
+        if (this->hasCachedImage(key)) return key;
+
+        Image* image = this->getCachedImage(name);
+        if (image != NULL && image->page != NULL) return key;
+        return name;
+    }
+
     void Engine::clearCachedImage() {
         images_t::iterator iter;
         for(iter = this->imageCache->begin(); iter != this->imageCache->end(); iter++) {
@@ -1043,6 +1175,298 @@ namespace emo {
         }
     }
 
+    /*
+     * sum up the GPU memory of the cached textures. compressed textures
+     * are counted by their compressed size, packed images by their pages.
+     */
+    void Engine::getTextureMemory(TextureMemoryStats* stats) {
+        memset(stats, 0, sizeof(TextureMemoryStats));
+
+        images_t::iterator iter;
+        for(iter = this->imageCache->begin(); iter != this->imageCache->end(); iter++) {
+            Image* image = iter->second;
+            if (image->page != NULL || (image->textureId == 0 && !image->hasData)) continue;
+
+            int size = image->getTextureSize();
+            stats->textureCount++;
+            stats->textureBytes += size;
+            if (image->compressedFormat != 0) {
+                stats->compressedCount++;
+                stats->compressedBytes += size;
+                stats->uncompressedBytes += image->glWidth * image->glHeight * (image->hasAlpha ? 4 : 3);
+            }
+        }
+
+        TexturePackerStats packerStats;
+        this->packer->getStats(&packerStats);
+        stats->pageBytes = packerStats.pagePixels * 4;
+        stats->textureBytes += stats->pageBytes;
+
+        GlyphAtlasStats glyphStats;
+        this->getGlyphStats(&glyphStats);
+        stats->glyphBytes = glyphStats.pageBytes;
+        stats->textureBytes += stats->glyphBytes;
+    }
+
+    /*
+     * returns the shared atlas of the xml. the compiled atlas
+     * (<name>.atlas) is used if exists, otherwise the xml is parsed
+     * once and kept until the last drawable releases it.
+     */
+    TextureAtlas* Engine::loadTextureAtlas(std::string name) {
+        atlases_t::iterator iter = this->atlasCache->find(name);
+        if (iter != this->atlasCache->end()) {
+            iter->second->referenceCount++;
+            return iter->second;
+        }
+
+        TextureAtlas* atlas = new TextureAtlas();
+        bool loaded = false;
+
+        AssetView* view = this->assets->acquire(name + TEXTURE_ATLAS_SUFFIX);
+        if (view != NULL) {
+            loaded = atlas->load(view->data, view->length);
+            this->assets->release(view);
+        }
+
+        if (!loaded) {
+            view = this->assets->acquire(name);
+            if (view == NULL) {
+                this->setLastError(ERR_ASSET_OPEN);
+                LOGW("loadTextureAtlas: failed to open asset");
+                LOGW(name.c_str());
+                delete atlas;
+                return NULL;
+            }
+
+            size_t pos = name.find_last_of("/");
+            std::string baseDir = "";
+            if (pos != std::string::npos) baseDir = name.substr(0, pos + 1);
+
+            loaded = atlas->parse((const char*)view->data, view->length, baseDir);
+            this->assets->release(view);
+            if (!loaded) {
+                LOGW("loadTextureAtlas: no frames or the frame index could not be built");
+                LOGW(name.c_str());
+            }
+
+            if (loaded && !loadImageSizeFromAsset(atlas->imageName.c_str(), &atlas->imageWidth, &atlas->imageHeight)) {
+                loaded = false;
+            }
+        }
+
+        if (!loaded) {
+            delete atlas;
+            return NULL;
+        }
+
+        atlas->name = name;
+        atlas->referenceCount = 1;
+        this->atlasCache->insert(std::make_pair(name, atlas));
+
+        return atlas;
+    }
+
+    void Engine::releaseTextureAtlas(TextureAtlas* atlas) {
+        atlas->referenceCount--;
+        if (atlas->referenceCount <= 0) {
+            this->atlasCache->erase(atlas->name);
+            delete atlas;
+        }
+    }
+
+    /*
+     * returns the shared glyph atlas of the font face and size.
+     * the atlas is kept until the last glyph sprite releases it.
+     */
+    GlyphAtlas* Engine::loadGlyphAtlas(std::string fontFace, int fontSize, bool isBold, bool isItalic) {
+        char suffix[32];
+        sprintf(suffix, ":%d:%d:%d", fontSize, isBold ? 1 : 0, isItalic ? 1 : 0);
+        std::string key = fontFace + suffix;
+
+        glyph_atlases_t::iterator iter = this->glyphAtlasCache->find(key);
+        if (iter != this->glyphAtlasCache->end()) {
+            iter->second->referenceCount++;
+            return iter->second;
+        }
+
+        GlyphAtlas* atlas = new GlyphAtlas();
+        atlas->key      = key;
+        atlas->fontFace = fontFace;
+        atlas->fontSize = fontSize;
+        atlas->isBold   = isBold;
+        atlas->isItalic = isItalic;
+        atlas->referenceCount = 1;
+        this->glyphAtlasCache->insert(std::make_pair(key, atlas));
+
+        return atlas;
+    }
+
+    void Engine::releaseGlyphAtlas(GlyphAtlas* atlas) {
+        atlas->referenceCount--;
+        if (atlas->referenceCount <= 0) {
+            atlas->deleteTextures(this->hasDisplay());
+            this->glyphAtlasCache->erase(atlas->key);
+            delete atlas;
+        }
+    }
+
+    /*
+     * rasterize the glyphs of the text that are not in the atlas yet.
+     * text that has only known glyphs does not call the Java side.
+     */
+    bool Engine::loadGlyphs(GlyphAtlas* atlas, const std::string& text) {
+        std::vector<uint32_t> missing;
+        if (!atlas->findMissing(text, &missing)) return true;
+
+        bool loaded = this->javaGlue->loadGlyphBitmaps(atlas, missing);
+
+        // keep the glyphs that failed as empty glyphs not to rasterize them every time
+        std::vector<uint32_t> failed;
+        if (atlas->findMissing(text, &failed)) {
+            for (size_t i = 0; i < failed.size(); i++) {
+                atlas->addGlyph(failed[i], 0, 0, 0, 0, 0, NULL);
+            }
+            LOGW("loadGlyphs: failed to rasterize glyphs");
+        }
+        return loaded;
+    }
+
+    void Engine::deleteGlyphTextures(bool hasContext) {
+        glyph_atlases_t::iterator iter;
+        for(iter = this->glyphAtlasCache->begin(); iter != this->glyphAtlasCache->end(); iter++) {
+            iter->second->deleteTextures(hasContext);
+        }
+    }
+
+    void Engine::getGlyphStats(GlyphAtlasStats* stats) {
+        memset(stats, 0, sizeof(GlyphAtlasStats));
+
+        glyph_atlases_t::iterator iter;
+        for(iter = this->glyphAtlasCache->begin(); iter != this->glyphAtlasCache->end(); iter++) {
+            iter->second->getStats(stats);
+        }
+    }
+
+    /*
+     * queue the capture of the snapshot texture. the pixels are read back
+     * at the start of the next frame and encoded by the capture encoder.
+     */
+    int32_t Engine::captureSnapshot(std::string drawableId, std::string name, std::string path) {
+        if (!this->canUseOffscreen) return ERR_NOT_SUPPORTED;
+
+        Drawable* drawable = this->getDrawable(drawableId);
+        if (drawable == NULL || !drawable->hasTexture) return ERR_INVALID_ID;
+
+        if (!this->captureEncoder->start()) return EMO_ERROR;
+
+        ImageCaptureTask* task = new ImageCaptureTask();
+        task->name       = name;
+        task->drawableId = drawableId;
+        task->path       = path;
+        task->pixels     = NULL;
+        task->width      = 0;
+        task->height     = 0;
+        task->error      = EMO_NO_ERROR;
+        task->stallTime  = 0;
+
+        this->pendingCaptures->push_back(task);
+        return EMO_NO_ERROR;
+    }
+
+    /*
+     * read back the pending captures and hand them to the encoder.
+     * this runs before the drawables of the frame are drawn: the previous
+     * frame is already submitted by eglSwapBuffers, so the read waits for
+     * that frame only and does not flush a half-built one.
+     */
+    void Engine::readCaptures() {
+        if (likely(this->pendingCaptures->empty())) return;
+
+        for (size_t i = 0; i < this->pendingCaptures->size(); i++) {
+            ImageCaptureTask* task = this->pendingCaptures->at(i);
+            Drawable* drawable = this->getDrawable(task->drawableId);
+            if (drawable == NULL || !drawable->hasTexture || !drawable->getTexture()->loaded) {
+                task->error = ERR_INVALID_ID;
+                task->errorMessage = "snapshot is not loaded";
+            } else {
+                this->readCapturePixels(task, drawable->getTexture());
+            }
+            this->captureEncoder->submit(task);
+        }
+        this->pendingCaptures->clear();
+    }
+
+    /*
+     * read the snapshot texture through a temporary framebuffer so that
+     * stopped snapshots can be captured as well as running ones.
+     */
+    void Engine::readCapturePixels(ImageCaptureTask* task, Image* image) {
+        clearGLErrors("emo::Engine::readCapturePixels");
+
+        GLuint captureFramebuffer = 0;
+        glGenFramebuffersOES(1, &captureFramebuffer);
+        glBindFramebufferOES(GL_FRAMEBUFFER_OES, captureFramebuffer);
+        glFramebufferTexture2DOES(GL_FRAMEBUFFER_OES, GL_COLOR_ATTACHMENT0_OES, GL_TEXTURE_2D, image->textureId, 0);
+
+        if (glCheckFramebufferStatusOES(GL_FRAMEBUFFER_OES) != GL_FRAMEBUFFER_COMPLETE_OES) {
+            task->error = ERR_NOT_SUPPORTED;
+            task->errorMessage = "failed to bind the snapshot framebuffer";
+        } else {
+            task->width  = image->width;
+            task->height = image->height;
+            task->pixels = (unsigned char*)malloc(task->width * task->height * 4);
+            if (task->pixels == NULL) {
+                task->error = EMO_ERROR;
+                task->errorMessage = "failed to allocate the capture buffer";
+            } else {
+                uint64_t start = captureNow();
+                glReadPixels(0, 0, task->width, task->height, GL_RGBA, GL_UNSIGNED_BYTE, task->pixels);
+                task->stallTime = captureNow() - start;
+            }
+        }
+
+        glBindFramebufferOES(GL_FRAMEBUFFER_OES, this->framebuffer);
+        glDeleteFramebuffersOES(1, &captureFramebuffer);
+
+        printGLErrors("emo::Engine::readCapturePixels");
+    }
+
+    /*
+     * call the script callback of the completed captures
+     */
+    void Engine::dispatchCaptureCallbacks() {
+        std::vector<ImageCaptureTask*> tasks;
+        this->captureEncoder->takeCompleted(&tasks);
+
+        for (size_t i = 0; i < tasks.size(); i++) {
+            ImageCaptureTask* task = tasks[i];
+
+            SQInteger top = sq_gettop(this->sqvm);
+            sq_pushroottable(this->sqvm);
+            sq_pushstring(this->sqvm, EMO_NAMESPACE, -1);
+            if (SQ_SUCCEEDED(sq_get(this->sqvm, -2))) {
+                sq_pushstring(this->sqvm, EMO_FUNC_ONCAPTURE_CALLBACK, -1);
+                if (SQ_SUCCEEDED(sq_get(this->sqvm, -2))) {
+                    sq_pushroottable(this->sqvm);
+                    sq_pushstring(this->sqvm, task->name.c_str(), -1);
+                    sq_pushstring(this->sqvm, task->path.c_str(), -1);
+                    sq_pushinteger(this->sqvm, task->error);
+                    sq_pushstring(this->sqvm, task->errorMessage.c_str(), -1);
+                    sq_call(this->sqvm, 5, SQFalse, SQTrue);
+                }
+            }
+            sq_settop(this->sqvm, top);
+
+            deleteCaptureTask(task);
+        }
+    }
+
+    void Engine::getCaptureStats(ImageCaptureStats* stats) {
+        this->captureEncoder->getStats(stats);
+        stats->queued += this->pendingCaptures->size();
+    }
+
     /*
      * enable offscreen rendering
      */
@@ -48,8 +48,15 @@
 #include "Audio.h"
 #include "Database.h"
 #include "JavaGlue.h"
+#include "Asset.h"
+#include "Asset_preload.h"
+#include "Image_packer.h"
+#include "Image_mipmap.h"
+#include "Image_capture.h"
 
 namespace emo {
+    class PhysicsDebugDraw;
+
     class Engine {
 
     public:
@@ -108,6 +115,7 @@ namespace emo {
         void onDrawDrawables(int32_t delta);
         
         void rebindDrawableBuffers();
+        void rebindPackedDrawables();
 
         void loadDrawables();
         void unloadDrawables();
@@ -122,12 +130,21 @@ namespace emo {
         bool finishing;
         bool sortOrderDirty;
         bool useANR;
+        bool usePremultipliedAlpha;
+        int  mipmapMode;
+        float mipmapThreshold;
+        int  textureSwitches;
 
         android_app* app;
         Audio* audio;
         Stage* stage;
         Database* database;
+        AssetStore* assets;
+        AssetPreloader* preloader;
+        TexturePacker* packer;
+        ImageCaptureEncoder* captureEncoder;
         JavaGlue* javaGlue;
+        PhysicsDebugDraw* physicsDebugDraw;
         timeb uptime;
 
         int32_t onDrawFrameInterval;
@@ -144,7 +161,24 @@ namespace emo {
         Image* getCachedImage(std::string key);
         void addCachedImage(std::string key, Image* image);
         bool removeCachedImage(std::string key);
+        bool removeCachedImage(std::string name, Image* image);
+        std::string getImageCacheKey(std::string name, bool packable);
         void clearCachedImage();
+        void getTextureMemory(TextureMemoryStats* stats);
+
+        int32_t captureSnapshot(std::string drawableId, std::string name, std::string path);
+        void readCaptures();
+        void dispatchCaptureCallbacks();
+        void getCaptureStats(ImageCaptureStats* stats);
+
+        TextureAtlas* loadTextureAtlas(std::string name);
+        void releaseTextureAtlas(TextureAtlas* atlas);
+
+        GlyphAtlas* loadGlyphAtlas(std::string fontFace, int fontSize, bool isBold, bool isItalic);
+        void releaseGlyphAtlas(GlyphAtlas* atlas);
+        bool loadGlyphs(GlyphAtlas* atlas, const std::string& text);
+        void deleteGlyphTextures(bool hasContext);
+        void getGlyphStats(GlyphAtlasStats* stats);
 
         int logLevel;
 
@@ -156,6 +190,7 @@ namespace emo {
         void stopOffscreenDrawable(Drawable* drawable);
 
         bool canUseOffscreen;
+        bool canUseETC1;
         bool useOffscreen;
         bool stopOffscreenRequested;
         GLuint offscreenFramebuffer;
@@ -207,6 +242,9 @@ namespace emo {
         drawables_t* drawablesToRemove;
         std::vector<Drawable*>* sortedDrawables;
         images_t* imageCache;
+        atlases_t* atlasCache;
+        glyph_atlases_t* glyphAtlasCache;
+        std::vector<ImageCaptureTask*>* pendingCaptures;
 
         ASensorManager* sensorManager;
         ASensorEventQueue* sensorEventQueue;
@@ -218,6 +256,7 @@ namespace emo {
         const ASensor* proximitySensor;
 
         void initScriptFunctions();
+        void readCapturePixels(ImageCaptureTask* task, Image* image);
 
         std::string getRuntimeScriptName();
         std::string getMainScriptName();
@@ -31,17 +31,32 @@
 #include "Engine.h"
 #include "Runtime.h"
 #include "Image.h"
+#include "Image_etc1.h"
+#include "Image_mipmap.h"
+#include "Util.h"
 #include "png.h"
 
+#include <GLES/glext.h>
+
 extern emo::Engine* engine;
 
 namespace emo {
     Image::Image() {
         this->data       = NULL;
+        this->dataSize   = 0;
+        this->compressedFormat = 0;
+        this->alphaData      = NULL;
+        this->alphaTextureId = 0;
+        this->mipmapData     = NULL;
+        this->mipmapLevels   = 0;
         this->hasData    = false;
         this->mustReload = false;
         this->textureId  = 0;
         this->referenceCount = 0;
+        this->premultiplied  = false;
+        this->page  = NULL;
+        this->pageX = 0;
+        this->pageY = 0;
     }
     Image::~Image() {
         this->clearTexture();
@@ -50,28 +65,169 @@ namespace emo {
         if (textureId == 0) {
             glGenTextures(1, &this->textureId);
         }
+        if (alphaData != NULL && alphaTextureId == 0) {
+            glGenTextures(1, &this->alphaTextureId);
+        }
+    }
+
+    void Image::deleteTextures(bool hasContext) {
+        if (hasContext) {
+            if (this->textureId > 0) glDeleteTextures(1, &this->textureId);
+            if (this->alphaTextureId > 0) glDeleteTextures(1, &this->alphaTextureId);
+        }
+        this->textureId      = 0;
+        this->alphaTextureId = 0;
+        this->loaded         = false;
     }
 
     void Image::clearTexture() {
         if (this->hasData) {
             free(this->data);
-            this->data    = NULL;
+            free(this->alphaData);
+            free(this->mipmapData);
+            this->data      = NULL;
+            this->alphaData = NULL;
+            this->mipmapData   = NULL;
+            this->mipmapLevels = 0;
             this->hasData = false;
             this->mustReload = true;
         }
     }
-}
 
-/*
- * callback function to read png image
- */
-static void png_asset_read(png_structp png_ptr, png_bytep data, png_size_t length) {
-    AAsset* asset = (AAsset*)png_get_io_ptr(png_ptr);
-    AAsset_read(asset, data, length);
+    /*
+     * upload the image data to the texture. texture must be generated.
+     * the data must be glWidth x glHeight as the png decoder stores it.
+     */
+    void Image::upload() {
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture   (GL_TEXTURE_2D, this->textureId);
+
+        glPixelStorei   (GL_UNPACK_ALIGNMENT, 1);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->mipmapData != NULL ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // the data is already padded to the power of two size
+        if (this->compressedFormat != 0) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, 0, this->compressedFormat,
+                        this->glWidth, this->glHeight, 0, this->dataSize, this->data);
+        } else {
+            GLenum format = this->hasAlpha ? GL_RGBA : GL_RGB;
+            glTexImage2D(GL_TEXTURE_2D, 0, format, this->glWidth, this->glHeight, 0, format, GL_UNSIGNED_BYTE, this->data);
+
+            const GLubyte* level = this->mipmapData;
+            int width  = this->glWidth;
+            int height = this->glHeight;
+            for (int i = 1; i <= this->mipmapLevels; i++) {
+                width  = width  > 1 ? width  / 2 : 1;
+                height = height > 1 ? height / 2 : 1;
+                glTexImage2D(GL_TEXTURE_2D, i, format, width, height, 0, format, GL_UNSIGNED_BYTE, level);
+                level += width * height * (this->hasAlpha ? 4 : 3);
+            }
+        }
+
+        if (this->alphaData != NULL) {
+            // the data may have been reloaded after the textures are generated
+            if (this->alphaTextureId == 0) glGenTextures(1, &this->alphaTextureId);
+            glBindTexture   (GL_TEXTURE_2D, this->alphaTextureId);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, this->glWidth, this->glHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE, this->alphaData);
+        }
+        this->loaded = true;
+        printGLErrors("Could not bind OpenGL textures");
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    /*
+     * generate the mipmap chain of the image data on the cpu.
+     * the texture is uploaded again with the chain.
+     * compressed and packed images can not have mipmaps.
+     */
+    bool Image::generateMipmaps() {
+        if (this->mipmapData != NULL) return true;
+        if (!this->hasData || this->compressedFormat != 0 || this->page != NULL) return false;
+
+        int pixelSize = this->hasAlpha ? 4 : 3;
+        int size = emo::getMipmapChainSize(this->glWidth, this->glHeight, pixelSize);
+        if (size <= 0) return false;
+
+        this->mipmapData = (GLubyte*)malloc(size);
+        if (this->mipmapData == NULL) return false;
+
+        emo::generateMipmapChain(this->mipmapData, this->data, this->glWidth, this->glHeight, pixelSize);
+        this->mipmapLevels = emo::getMipmapLevelCount(this->glWidth, this->glHeight);
+        this->loaded = false;
+
+        return true;
+    }
+
+    /*
+     * bind the alpha plane of compressed texture to the second texture unit.
+     * the color comes from the first unit and the alpha is multiplied by the plane.
+     * coords are the texture coords of the first unit.
+     */
+    void Image::bindAlphaPlane(const GLvoid* coords) {
+        if (this->alphaTextureId == 0) return;
+
+        glActiveTexture(GL_TEXTURE1);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, this->alphaTextureId);
+
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+        glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB,      GL_REPLACE);
+        glTexEnvi(GL_TEXTURE_ENV, GL_SRC0_RGB,         GL_PREVIOUS);
+        glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_RGB,     GL_SRC_COLOR);
+        glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA,    GL_MODULATE);
+        glTexEnvi(GL_TEXTURE_ENV, GL_SRC0_ALPHA,       GL_PREVIOUS);
+        glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_ALPHA,   GL_SRC_ALPHA);
+        glTexEnvi(GL_TEXTURE_ENV, GL_SRC1_ALPHA,       GL_TEXTURE);
+        glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_ALPHA,   GL_SRC_ALPHA);
+
+        glClientActiveTexture(GL_TEXTURE1);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, 0, coords);
+        glClientActiveTexture(GL_TEXTURE0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void Image::unbindAlphaPlane() {
+        if (this->alphaTextureId == 0) return;
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+
+        glClientActiveTexture(GL_TEXTURE1);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glClientActiveTexture(GL_TEXTURE0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    /*
+     * returns the bytes that the texture takes in the GPU memory
+     */
+    int Image::getTextureSize() {
+        if (this->page != NULL) return 0;
+
+        int pixels = this->glWidth * this->glHeight;
+        if (this->compressedFormat != 0) {
+            return this->dataSize + (this->alphaData != NULL || this->alphaTextureId > 0 ? pixels : 0);
+        }
+        int pixelSize = this->hasAlpha ? 4 : 3;
+        if (this->mipmapLevels > 0) {
+            return pixels * pixelSize + emo::getMipmapChainSize(this->glWidth, this->glHeight, pixelSize);
+        }
+        return pixels * pixelSize;
+    }
 }
 
 struct png_data {
-    unsigned char* data;
+    const unsigned char* data;
     unsigned long  length;
     unsigned long  offset;
 };
@@ -87,15 +243,30 @@ static void png_data_read(png_structp png_ptr, png_bytep data, png_size_t length
 }
 
 /*
- * load png from byte array
+ * premultiply the color channels of the rgba row by its alpha
  */
-bool loadPngFromBytes(unsigned char* data, int data_size, emo::Image* imageInfo, bool forcePropertyUpdate) {
-    struct png_data png_data;
-    png_data.data = data;
-    png_data.offset = 0;
-    png_data.length = data_size;
+static void premultiplyRow(unsigned char* row, int width) {
+    for (int i = 0; i < width; i++, row += 4) {
+        unsigned int a = row[3];
+        if (a == 255) continue;
+        for (int c = 0; c < 3; c++) {
+            unsigned int t = row[c] * a + 128;
+            row[c] = (t + (t >> 8)) >> 8;
+        }
+    }
+}
 
+/*
+ * decode png row by row into the final texture buffer.
+ * palette and gray images are expanded to rgb(a), rows are stored
+ * bottom-up and the buffer is padded to the power of two size
+ * so that it can be uploaded as it is.
+ */
+static bool decodePng(struct png_data* png_data, emo::Image* imageInfo, bool forcePropertyUpdate) {
     png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (png_ptr == NULL) {
+        return false;
+    }
     png_infop info_ptr = png_create_info_struct(png_ptr);
 
     if (info_ptr == NULL) {
@@ -103,85 +274,156 @@ bool loadPngFromBytes(unsigned char* data, int data_size, emo::Image* imageInfo,
         return false;
     }
 
+    unsigned char* volatile pixels = NULL;
+
     if (setjmp(png_jmpbuf(png_ptr))) {
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        free(pixels);
         return false;
     }
 
-    png_set_read_fn(png_ptr, (void *)&png_data, png_data_read);
+    png_set_read_fn(png_ptr, (void *)png_data, png_data_read);
 
     unsigned int sig_read = 0;
     png_set_sig_bytes(png_ptr, sig_read);
 
-    png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_EXPAND, NULL);
+    png_read_info(png_ptr, info_ptr);
 
-    if (forcePropertyUpdate) {
-        imageInfo->textureId = 0;
-        imageInfo->width  = info_ptr->width;
-        imageInfo->height = info_ptr->height;
+    png_uint_32 width, height;
+    int bit_depth, color_type, interlace_type;
+    png_get_IHDR(png_ptr, info_ptr, &width, &height, &bit_depth, &color_type, &interlace_type, NULL, NULL);
+
+    if (color_type == PNG_COLOR_TYPE_PALETTE) {
+        png_set_palette_to_rgb(png_ptr);
+    }
+    if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) {
+        png_set_expand_gray_1_2_4_to_8(png_ptr);
+    }
+    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
+        png_set_tRNS_to_alpha(png_ptr);
+    }
+    if (bit_depth == 16) {
+        png_set_strip_16(png_ptr);
+    }
+    if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
+        png_set_gray_to_rgb(png_ptr);
     }
+    int passes = png_set_interlace_handling(png_ptr);
 
-    switch (info_ptr->color_type) {
-        case PNG_COLOR_TYPE_RGBA:
-            imageInfo->hasAlpha = true;
-            break;
-        case PNG_COLOR_TYPE_RGB:
-            imageInfo->hasAlpha = false;
-            break;
-        default:
-            LOGE("loadPngFromAsset: unsupported color type");
-            png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-            return false;
+    png_read_update_info(png_ptr, info_ptr);
+
+    int channels = png_get_channels(png_ptr, info_ptr);
+    if ((channels != 3 && channels != 4) || width == 0 || height == 0) {
+        LOGE("loadPngFromAsset: unsupported color type");
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return false;
     }
-    unsigned int row_bytes = png_get_rowbytes(png_ptr, info_ptr);
-    imageInfo->data = (unsigned char*) malloc(row_bytes * imageInfo->height);
 
-    png_bytepp row_pointers = png_get_rows(png_ptr, info_ptr);
+    bool hasAlpha = channels == 4;
+    bool premultiply = hasAlpha && engine->usePremultipliedAlpha;
+
+    int glWidth  = nextPowerOfTwo(width);
+    int glHeight = nextPowerOfTwo(height);
+    unsigned int row_bytes = width * channels;
+    unsigned int stride    = glWidth * channels;
 
-    for (int i = 0; i < imageInfo->height; i++) {
-        memcpy(imageInfo->data+(row_bytes * (imageInfo->height-1-i)), row_pointers[i], row_bytes);
+    pixels = (unsigned char*)malloc(stride * glHeight);
+    if (pixels == NULL) {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        return false;
+    }
+
+    for (int pass = 0; pass < passes; pass++) {
+        bool lastPass = pass == passes - 1;
+        for (unsigned int y = 0; y < height; y++) {
+            unsigned char* row = pixels + stride * (height - 1 - y);
+            png_read_row(png_ptr, row, NULL);
+            if (lastPass) {
+                if (premultiply) premultiplyRow(row, width);
+                memset(row + row_bytes, 0, stride - row_bytes);
+            }
+        }
     }
+    memset(pixels + stride * height, 0, stride * (glHeight - height));
 
     png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 
+    if (forcePropertyUpdate) {
+        imageInfo->textureId = 0;
+        imageInfo->width  = width;
+        imageInfo->height = height;
+    }
+    if (imageInfo->hasData) {
+        free(imageInfo->data);
+    }
+    free(imageInfo->alphaData);
+    free(imageInfo->mipmapData);
+    imageInfo->mipmapData   = NULL;
+    imageInfo->mipmapLevels = 0;
+    imageInfo->glWidth  = glWidth;
+    imageInfo->glHeight = glHeight;
+    imageInfo->hasAlpha = hasAlpha;
+    imageInfo->premultiplied = premultiply;
+    imageInfo->data = pixels;
+    imageInfo->dataSize  = stride * glHeight;
+    imageInfo->compressedFormat = 0;
+    imageInfo->alphaData = NULL;
     imageInfo->hasData = true;
     imageInfo->mustReload = false;
 
+    return true;
+}
+
+/*
+ * load png from byte array
+ */
+bool loadPngFromBytes(unsigned char* data, int data_size, emo::Image* imageInfo, bool forcePropertyUpdate) {
+    struct png_data png_data;
+    png_data.data = data;
+    png_data.offset = 0;
+    png_data.length = data_size;
+
+    if (!decodePng(&png_data, imageInfo, forcePropertyUpdate)) {
+        return false;
+    }
+
     return imageInfo->width > 0 && imageInfo->height > 0;
 }
 
 bool loadPngSizeFromAsset(const char *fname, int *width, int *height) {
-    AAssetManager* mgr = engine->app->activity->assetManager;
-    if (mgr == NULL) {
-    	engine->setLastError(ERR_ASSET_LOAD);
-    	LOGE("loadPngSizeFromAsset: failed to load AAssetManager");
-    	return false;
+    if (engine->assets->getImageInfo(fname, width, height, NULL)) {
+        return true;
     }
 
-    AAsset* asset = AAssetManager_open(mgr, fname, AASSET_MODE_UNKNOWN);
-    if (asset == NULL) {
+    emo::AssetView* view = engine->assets->acquire(fname);
+    if (view == NULL) {
     	engine->setLastError(ERR_ASSET_OPEN);
     	LOGW("loadPngSizeFromAsset: failed to open asset");
         LOGW(fname);
     	return false;
     }
 
+    struct png_data png_data;
+    png_data.data   = view->data;
+    png_data.offset = 0;
+    png_data.length = view->length;
+
     png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     png_infop info_ptr = png_create_info_struct(png_ptr);
 
     if (info_ptr == NULL) {
-        AAsset_close(asset);
+        engine->assets->release(view);
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
         return false;
     }
 
     if (setjmp(png_jmpbuf(png_ptr))) {
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-        AAsset_close(asset);
+        engine->assets->release(view);
         return false;
     }
 
-    png_set_read_fn(png_ptr, (void *)asset, png_asset_read);
+    png_set_read_fn(png_ptr, (void *)&png_data, png_data_read);
 
     unsigned int sig_read = 0;
     png_set_sig_bytes(png_ptr, sig_read);
@@ -192,7 +434,7 @@ bool loadPngSizeFromAsset(const char *fname, int *width, int *height) {
     *height = info_ptr->height;
 
     png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    AAsset_close(asset);
+    engine->assets->release(view);
 
     return width > 0 && height > 0;
 }
@@ -201,77 +443,210 @@ bool loadPngSizeFromAsset(const char *fname, int *width, int *height) {
  * load png image from asset
  */
 bool loadPngFromAsset(const char *fname, emo::Image* imageInfo, bool forcePropertyUpdate) {
-    AAssetManager* mgr = engine->app->activity->assetManager;
-    if (mgr == NULL) {
-    	engine->setLastError(ERR_ASSET_LOAD);
-    	LOGE("loadPngFromAsset: failed to load AAssetManager");
+    emo::AssetView* view = engine->assets->acquire(fname);
+    if (view == NULL) {
+    	engine->setLastError(ERR_ASSET_OPEN);
+    	LOGW("loadPngFromAsset: failed to open asset");
+        LOGW(fname);
     	return false;
     }
 
-    AAsset* asset = AAssetManager_open(mgr, fname, AASSET_MODE_UNKNOWN);
-    if (asset == NULL) {
+    struct png_data png_data;
+    png_data.data   = view->data;
+    png_data.offset = 0;
+    png_data.length = view->length;
+
+    bool result = decodePng(&png_data, imageInfo, forcePropertyUpdate);
+    engine->assets->release(view);
+
+    if (result && forcePropertyUpdate) {
+        imageInfo->filename = fname;
+    }
+
+    return result;
+}
+
+/*
+ * returns whether the asset is an ETC1 texture (.pkm or .ktx)
+ */
+static bool isEtc1Asset(const char* fname) {
+    const char* ext = strrchr(fname, '.');
+    return ext != NULL && (strcasecmp(ext, ".pkm") == 0 || strcasecmp(ext, ".ktx") == 0);
+}
+
+/*
+ * load ETC1 texture from asset. the alpha plane is read from the
+ * sidecar asset with "_alpha" suffix (foo.pkm and foo_alpha.pkm).
+ * the blocks are uploaded as they are when the device supports ETC1
+ * and the size is power of two, otherwise they are decoded to rgb(a).
+ * uploaded blocks keep their top-down rows, the drawables flip the
+ * texture coords for them. point sprites can not flip the coords
+ * that GL generates and draw them upside down.
+ */
+bool loadEtc1FromAsset(const char *fname, emo::Image* imageInfo, bool forcePropertyUpdate) {
+    emo::AssetView* view = engine->assets->acquire(fname);
+    if (view == NULL) {
     	engine->setLastError(ERR_ASSET_OPEN);
-    	LOGW("loadPngFromAsset: failed to open asset");
+    	LOGW("loadEtc1FromAsset: failed to open asset");
         LOGW(fname);
     	return false;
     }
 
-    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    png_infop info_ptr = png_create_info_struct(png_ptr);
-
-    if (info_ptr == NULL) {
-        AAsset_close(asset);
-        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+    emo::Etc1Texture color;
+    if (!emo::parseEtc1Texture(view->data, view->length, &color)) {
+        LOGE("loadEtc1FromAsset: unsupported texture format");
+        LOGE(fname);
+        engine->assets->release(view);
         return false;
     }
 
-    if (setjmp(png_jmpbuf(png_ptr))) {
-        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-        AAsset_close(asset);
-        return false;
+    std::string alphaName = fname;
+    alphaName.insert(alphaName.rfind('.'), ETC1_ALPHA_SUFFIX);
+
+    emo::Etc1Texture alpha;
+    emo::AssetView* alphaView = engine->assets->acquire(alphaName);
+    if (alphaView != NULL && (!emo::parseEtc1Texture(alphaView->data, alphaView->length, &alpha) ||
+            alpha.width != color.width || alpha.height != color.height)) {
+        LOGW("loadEtc1FromAsset: alpha plane does not match the texture");
+        LOGW(alphaName.c_str());
+        engine->assets->release(alphaView);
+        alphaView = NULL;
     }
+    bool hasAlpha = alphaView != NULL;
 
-    png_set_read_fn(png_ptr, (void *)asset, png_asset_read);
+    bool compressed = engine->canUseETC1 &&
+            color.width  == color.encodedWidth  && isPowerOfTwo(color.width) &&
+            color.height == color.encodedHeight && isPowerOfTwo(color.height);
 
-    unsigned int sig_read = 0;
-    png_set_sig_bytes(png_ptr, sig_read);
+    int glWidth  = compressed ? color.width  : nextPowerOfTwo(color.width);
+    int glHeight = compressed ? color.height : nextPowerOfTwo(color.height);
+
+    unsigned char* pixels = NULL;
+    unsigned char* alphaPixels = NULL;
+    int dataSize = 0;
+    bool premultiply = false;
+
+    if (compressed) {
+        dataSize = color.dataSize;
+        pixels = (unsigned char*)malloc(dataSize);
+        if (pixels != NULL) {
+            memcpy(pixels, color.data, dataSize);
+        }
+        if (pixels != NULL && hasAlpha) {
+            alphaPixels = (unsigned char*)malloc(glWidth * glHeight);
+            if (alphaPixels == NULL) {
+                free(pixels);
+                pixels = NULL;
+            } else {
+                // top-down as the color blocks, they share the texture coords
+                emo::decodeEtc1Plane(alpha, alphaPixels + glWidth * (glHeight - 1), -glWidth, 1);
+            }
+        }
+    } else {
+        int pixelSize = hasAlpha ? 4 : 3;
+        int stride    = glWidth * pixelSize;
+        dataSize = stride * glHeight;
+        pixels = (unsigned char*)calloc(dataSize, 1);
+        if (pixels != NULL) {
+            emo::decodeEtc1Image(color, pixels, stride, pixelSize);
+            if (hasAlpha) {
+                emo::decodeEtc1Plane(alpha, pixels + 3, stride, 4);
+                premultiply = engine->usePremultipliedAlpha;
+                if (premultiply) {
+                    for (int y = 0; y < color.height; y++) {
+                        premultiplyRow(pixels + stride * y, color.width);
+                    }
+                }
+            }
+        }
+    }
 
-    png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_EXPAND, NULL);
+    if (alphaView != NULL) engine->assets->release(alphaView);
+    engine->assets->release(view);
+
+    if (pixels == NULL) {
+        LOGE("loadEtc1FromAsset: out of memory");
+        return false;
+    }
 
     if (forcePropertyUpdate) {
         imageInfo->textureId = 0;
+        imageInfo->width  = color.width;
+        imageInfo->height = color.height;
         imageInfo->filename = fname;
-        imageInfo->width  = info_ptr->width;
-        imageInfo->height = info_ptr->height;
     }
-
-    switch (info_ptr->color_type) {
-        case PNG_COLOR_TYPE_RGBA:
-            imageInfo->hasAlpha = true;
-            break;
-        case PNG_COLOR_TYPE_RGB:
-            imageInfo->hasAlpha = false;
-            break;
-        default:
-            LOGE("loadPngFromAsset: unsupported color type");
-            png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-            AAsset_close(asset);
-            return false;
+    if (imageInfo->hasData) {
+        free(imageInfo->data);
     }
-    unsigned int row_bytes = png_get_rowbytes(png_ptr, info_ptr);
-    imageInfo->data = (unsigned char*) malloc(row_bytes * imageInfo->height);
+    free(imageInfo->alphaData);
+    free(imageInfo->mipmapData);
+    imageInfo->mipmapData   = NULL;
+    imageInfo->mipmapLevels = 0;
+    imageInfo->glWidth  = glWidth;
+    imageInfo->glHeight = glHeight;
+    imageInfo->hasAlpha = hasAlpha;
+    imageInfo->premultiplied = premultiply;
+    imageInfo->data = pixels;
+    imageInfo->dataSize  = dataSize;
+    imageInfo->compressedFormat = compressed ? GL_ETC1_RGB8_OES : 0;
+    imageInfo->alphaData = alphaPixels;
+    imageInfo->hasData = true;
+    imageInfo->mustReload = false;
 
-    png_bytepp row_pointers = png_get_rows(png_ptr, info_ptr);
+    return true;
+}
 
-    for (int i = 0; i < imageInfo->height; i++) {
-        memcpy(imageInfo->data+(row_bytes * (imageInfo->height-1-i)), row_pointers[i], row_bytes);
+/*
+ * load the size of png or ETC1 image from asset
+ */
+bool loadImageSizeFromAsset(const char *fname, int *width, int *height) {
+    if (!isEtc1Asset(fname)) {
+        return loadPngSizeFromAsset(fname, width, height);
     }
 
-    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    AAsset_close(asset);
+    emo::AssetView* view = engine->assets->acquire(fname);
+    if (view == NULL) {
+    	engine->setLastError(ERR_ASSET_OPEN);
+    	LOGW("loadImageSizeFromAsset: failed to open asset");
+        LOGW(fname);
+    	return false;
+    }
 
-    imageInfo->hasData = true;
-    imageInfo->mustReload = false;
+    emo::Etc1Texture texture;
+    bool result = emo::parseEtc1Texture(view->data, view->length, &texture);
+    engine->assets->release(view);
 
-    return true;
+    if (result) {
+        *width  = texture.width;
+        *height = texture.height;
+    }
+    return result;
+}
+
+/*
+ * load png or ETC1 image from asset by its extension
+ */
+bool loadImageFromAsset(const char *fname, emo::Image* imageInfo, bool forcePropertyUpdate) {
+    if (isEtc1Asset(fname)) {
+        return loadEtc1FromAsset(fname, imageInfo, forcePropertyUpdate);
+    }
+    return loadPngFromAsset(fname, imageInfo, forcePropertyUpdate);
+}
+
+/*
+ * decode image from asset without touching GL.
+ * used by the preload workers, the mipmap chain is also
+ * generated here when mipmaps are enabled for every image.
+ */
+emo::Image* decodeImageFromAsset(const char* fname) {
+    emo::Image* image = new emo::Image();
+    if (!loadImageFromAsset(fname, image, true)) {
+        delete image;
+        return NULL;
+    }
+    if (engine->mipmapMode == MIPMAP_ALWAYS) {
+        image->generateMipmaps();
+    }
+    image->loaded = false;
+    return image;
 }
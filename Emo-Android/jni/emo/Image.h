@@ -31,13 +31,31 @@
 #include <string>
 
 namespace emo {
+    class TexturePage;
+
+    struct TextureMemoryStats {
+        int textureCount;
+        int textureBytes;
+        int compressedCount;
+        int compressedBytes;
+        int uncompressedBytes;
+        int pageBytes;
+        int glyphBytes;
+    };
+
     class Image {
     public:
         Image();
         ~Image();
 
         void genTextures();
+        void deleteTextures(bool hasContext);
         void clearTexture();
+        void upload();
+        bool generateMipmaps();
+        void bindAlphaPlane(const GLvoid* coords);
+        void unbindAlphaPlane();
+        int  getTextureSize();
 
         std::string filename;
         GLuint   textureId;
@@ -48,17 +66,35 @@ namespace emo {
         int      glHeight;
 
         GLubyte* data;
+        int      dataSize;
+        GLenum   compressedFormat;
+
+        GLubyte* alphaData;
+        GLuint   alphaTextureId;
+
+        GLubyte* mipmapData;
+        int      mipmapLevels;
+
         bool     hasData;
         bool     mustReload;
         bool     hasAlpha;
+        bool     premultiplied;
         bool     loaded;
 
         int      referenceCount;
+
+        TexturePage* page;
+        int      pageX;
+        int      pageY;
     };
 }
 
 bool loadPngSizeFromAsset(const char *fname, int *width, int *height);
 bool loadPngFromAsset(const char *fname, emo::Image* image, bool forcePropertyUpdate);
 bool loadPngFromBytes(unsigned char* data, int data_size, emo::Image* imageInfo, bool forcePropertyUpdate);
+bool loadEtc1FromAsset(const char *fname, emo::Image* image, bool forcePropertyUpdate);
+bool loadImageSizeFromAsset(const char *fname, int *width, int *height);
+bool loadImageFromAsset(const char *fname, emo::Image* image, bool forcePropertyUpdate);
+emo::Image* decodeImageFromAsset(const char* fname);
 
 #endif
@@ -0,0 +1,277 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Image_capture.h"
+#include "Constants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "png.h"
+
+namespace emo {
+
+    /*
+     * monotonic time in microseconds
+     */
+    uint64_t captureNow() {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    }
+
+    void deleteCaptureTask(ImageCaptureTask* task) {
+        if (task->pixels != NULL) free(task->pixels);
+        delete task;
+    }
+
+    /*
+     * write the RGBA pixels as RGB png. the rows are stored from bottom
+     * to top like glReadPixels returns them, so they are written in
+     * reverse order and no flipped copy is made.
+     * the file is written to a temporary name and renamed on success.
+     */
+    bool encodeCapturePng(const std::string& path, const unsigned char* pixels,
+                          int width, int height, uint32_t* fileSize, std::string* errorMessage) {
+        std::string tempPath = path + CAPTURE_TEMP_SUFFIX;
+        FILE* fp = fopen(tempPath.c_str(), "wb");
+        if (fp == NULL) {
+            *errorMessage = "failed to open " + tempPath;
+            return false;
+        }
+
+        png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        png_infop info_ptr = png_ptr != NULL ? png_create_info_struct(png_ptr) : NULL;
+        if (info_ptr == NULL) {
+            png_destroy_write_struct(&png_ptr, NULL);
+            fclose(fp);
+            remove(tempPath.c_str());
+            *errorMessage = "failed to create png writer";
+            return false;
+        }
+
+        if (setjmp(png_jmpbuf(png_ptr))) {
+            png_destroy_write_struct(&png_ptr, &info_ptr);
+            fclose(fp);
+            remove(tempPath.c_str());
+            *errorMessage = "failed to encode " + path;
+            return false;
+        }
+
+        png_init_io(png_ptr, fp);
+
+        // screenshots are written for speed rather than for size
+        png_set_compression_level(png_ptr, CAPTURE_COMPRESSION_LEVEL);
+        png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB);
+
+        png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB,
+                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png_ptr, info_ptr);
+
+        // the alpha of the framebuffer is not meaningful for the screenshot
+        png_set_filler(png_ptr, 0, PNG_FILLER_AFTER);
+
+        size_t stride = width * 4;
+        for (int y = height - 1; y >= 0; y--) {
+            png_write_row(png_ptr, (png_bytep)(pixels + y * stride));
+        }
+        png_write_end(png_ptr, info_ptr);
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+
+        *fileSize = ftell(fp);
+        if (fclose(fp) != 0 || rename(tempPath.c_str(), path.c_str()) != 0) {
+            remove(tempPath.c_str());
+            *errorMessage = "failed to write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    ImageCaptureEncoder::ImageCaptureEncoder() {
+        this->completedCount  = 0;
+        this->failedCount     = 0;
+        this->lastStall       = 0;
+        this->maxStall        = 0;
+        this->lastEncodeTime  = 0;
+        this->lastFileSize    = 0;
+        this->totalStall      = 0;
+        this->totalEncodeTime = 0;
+        this->totalPixels     = 0;
+        this->running         = false;
+        this->stopping        = false;
+
+        pthread_mutex_init(&this->mutex, NULL);
+        pthread_cond_init(&this->wakeup, NULL);
+    }
+
+    /*
+     * completed tasks that are not taken yet are deleted.
+     */
+    ImageCaptureEncoder::~ImageCaptureEncoder() {
+        this->stop();
+
+        for (size_t i = 0; i < this->completed.size(); i++) {
+            deleteCaptureTask(this->completed[i]);
+        }
+        this->completed.clear();
+
+        pthread_cond_destroy(&this->wakeup);
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    bool ImageCaptureEncoder::start() {
+        if (this->running) return true;
+
+        this->stopping = false;
+        if (pthread_create(&this->thread, NULL, encodeThread, this) != 0) {
+            return false;
+        }
+        this->running = true;
+        return true;
+    }
+
+    /*
+     * encodes the queued tasks and stops the thread.
+     * the completed tasks can be taken after the encoder stops.
+     */
+    void ImageCaptureEncoder::stop() {
+        if (!this->running) return;
+
+        pthread_mutex_lock(&this->mutex);
+        this->stopping = true;
+        pthread_cond_signal(&this->wakeup);
+        pthread_mutex_unlock(&this->mutex);
+        pthread_join(this->thread, NULL);
+
+        this->running = false;
+    }
+
+    /*
+     * queue the task. the encoder owns the task until it is taken back as completed.
+     * tasks that failed to read back (no pixels) are completed without encoding.
+     */
+    void ImageCaptureEncoder::submit(ImageCaptureTask* task) {
+        task->fileSize   = 0;
+        task->submitTime = captureNow();
+
+        pthread_mutex_lock(&this->mutex);
+        if (task->pixels == NULL || !this->running) {
+            if (task->error == EMO_NO_ERROR) {
+                task->error = EMO_ERROR;
+                task->errorMessage = "capture encoder is not running";
+            }
+            task->startTime    = task->submitTime;
+            task->completeTime = task->submitTime;
+            this->complete(task);
+        } else {
+            this->queue.push_back(task);
+            pthread_cond_signal(&this->wakeup);
+        }
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    /*
+     * move the completed tasks to the given vector. the caller deletes them.
+     */
+    void ImageCaptureEncoder::takeCompleted(std::vector<ImageCaptureTask*>* tasks) {
+        pthread_mutex_lock(&this->mutex);
+        tasks->insert(tasks->end(), this->completed.begin(), this->completed.end());
+        this->completed.clear();
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void ImageCaptureEncoder::getStats(ImageCaptureStats* stats) {
+        pthread_mutex_lock(&this->mutex);
+        stats->queued            = this->queue.size();
+        stats->completed         = this->completedCount;
+        stats->failed            = this->failedCount;
+        stats->lastStall         = this->lastStall;
+        stats->averageStall      = this->completedCount > 0 ? this->totalStall / this->completedCount : 0;
+        stats->maxStall          = this->maxStall;
+        stats->lastEncodeTime    = this->lastEncodeTime;
+        stats->averageEncodeTime = this->completedCount > 0 ? this->totalEncodeTime / this->completedCount : 0;
+        stats->lastFileSize      = this->lastFileSize;
+        stats->pixelsPerSecond   = this->totalEncodeTime > 0 ?
+                                        this->totalPixels * 1000000 / this->totalEncodeTime : 0;
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    /*
+     * record the task as completed. the mutex must be locked.
+     */
+    void ImageCaptureEncoder::complete(ImageCaptureTask* task) {
+        if (task->pixels != NULL) {
+            free(task->pixels);
+            task->pixels = NULL;
+        }
+
+        if (task->error == EMO_NO_ERROR) {
+            uint32_t encodeTime = task->completeTime - task->startTime;
+            this->completedCount++;
+            this->lastStall       = task->stallTime;
+            this->lastEncodeTime  = encodeTime;
+            this->lastFileSize    = task->fileSize;
+            this->totalStall      += task->stallTime;
+            this->totalEncodeTime += encodeTime;
+            this->totalPixels     += (uint64_t)task->width * task->height;
+            if (task->stallTime > this->maxStall) this->maxStall = task->stallTime;
+        } else {
+            this->failedCount++;
+        }
+        this->completed.push_back(task);
+    }
+
+    void ImageCaptureEncoder::encodeLoop() {
+        pthread_mutex_lock(&this->mutex);
+        while (true) {
+            while (this->queue.empty() && !this->stopping) {
+                pthread_cond_wait(&this->wakeup, &this->mutex);
+            }
+            if (this->queue.empty()) break;
+
+            ImageCaptureTask* task = this->queue.front();
+            this->queue.pop_front();
+            pthread_mutex_unlock(&this->mutex);
+
+            task->startTime = captureNow();
+            if (!encodeCapturePng(task->path, task->pixels, task->width, task->height,
+                                  &task->fileSize, &task->errorMessage)) {
+                task->error = ERR_FILE_OPEN;
+            }
+            task->completeTime = captureNow();
+
+            pthread_mutex_lock(&this->mutex);
+            this->complete(task);
+        }
+        pthread_mutex_unlock(&this->mutex);
+    }
+
+    void* ImageCaptureEncoder::encodeThread(void* arg) {
+        ((ImageCaptureEncoder*)arg)->encodeLoop();
+        return NULL;
+    }
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_IMAGE_CAPTURE_H
+#define EMO_IMAGE_CAPTURE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <deque>
+
+#define CAPTURE_COMPRESSION_LEVEL 1
+#define CAPTURE_TEMP_SUFFIX       ".tmp"
+
+/*
+ * Encodes captured snapshots to PNG files on a dedicated thread.
+ * The pixels are read back on the GL thread as RGBA rows from bottom
+ * to top. The encoder flips the rows, drops the alpha channel and
+ * writes the file next to a temporary name, which is renamed when the
+ * file is complete. The main thread polls the completed tasks at the
+ * start of each frame. The encoder does not touch GL or the engine.
+ */
+namespace emo {
+    struct ImageCaptureTask {
+        std::string name;
+        std::string drawableId;
+        std::string path;
+        unsigned char* pixels;
+        int width;
+        int height;
+        int error;
+        std::string errorMessage;
+        uint32_t fileSize;
+        uint32_t stallTime;
+        uint64_t submitTime;
+        uint64_t startTime;
+        uint64_t completeTime;
+    };
+
+    struct ImageCaptureStats {
+        uint32_t queued;
+        uint32_t completed;
+        uint32_t failed;
+        uint32_t lastStall;
+        uint32_t averageStall;
+        uint32_t maxStall;
+        uint32_t lastEncodeTime;
+        uint32_t averageEncodeTime;
+        uint32_t lastFileSize;
+        uint32_t pixelsPerSecond;
+    };
+
+    class ImageCaptureEncoder {
+    public:
+        ImageCaptureEncoder();
+        ~ImageCaptureEncoder();
+
+        bool start();
+        void submit(ImageCaptureTask* task);
+        void stop();
+        void takeCompleted(std::vector<ImageCaptureTask*>* tasks);
+        void getStats(ImageCaptureStats* stats);
+    protected:
+        std::deque<ImageCaptureTask*> queue;
+        std::vector<ImageCaptureTask*> completed;
+
+        uint32_t completedCount;
+        uint32_t failedCount;
+        uint32_t lastStall;
+        uint32_t maxStall;
+        uint32_t lastEncodeTime;
+        uint32_t lastFileSize;
+        uint64_t totalStall;
+        uint64_t totalEncodeTime;
+        uint64_t totalPixels;
+        bool     running;
+        bool     stopping;
+
+        pthread_t       thread;
+        pthread_mutex_t mutex;
+        pthread_cond_t  wakeup;
+
+        void complete(ImageCaptureTask* task);
+        void encodeLoop();
+
+        static void* encodeThread(void* arg);
+    };
+
+    bool encodeCapturePng(const std::string& path, const unsigned char* pixels,
+                          int width, int height, uint32_t* fileSize, std::string* errorMessage);
+    void deleteCaptureTask(ImageCaptureTask* task);
+    uint64_t captureNow();
+}
+#endif
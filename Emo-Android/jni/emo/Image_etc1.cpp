@@ -0,0 +1,239 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Image_etc1.h"
+
+#include <string.h>
+
+#define PKM_HEADER_SIZE 16
+#define KTX_HEADER_SIZE 64
+#define KTX_ENDIANNESS  0x04030201
+
+namespace emo {
+
+    static const unsigned char pkmMagic[4]  = { 'P', 'K', 'M', ' ' };
+    static const unsigned char ktxMagic[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    static const int etc1Modifiers[8][2] = {
+        {  2,   8 }, {  5,  17 }, {  9,  29 }, { 13,  42 },
+        { 18,  60 }, { 24,  80 }, { 33, 106 }, { 47, 183 }
+    };
+
+    static uint16_t readBigEndian16(const unsigned char* p) {
+        return (p[0] << 8) | p[1];
+    }
+
+    static uint32_t readKtx32(const unsigned char* p, bool swap) {
+        if (swap) {
+            return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+        }
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    static bool setEtc1Size(Etc1Texture* texture, int width, int height, int encodedWidth, int encodedHeight) {
+        if (width <= 0 || height <= 0 || width > encodedWidth || height > encodedHeight) return false;
+        if ((encodedWidth & 3) != 0 || (encodedHeight & 3) != 0) return false;
+
+        texture->width  = width;
+        texture->height = height;
+        texture->encodedWidth  = encodedWidth;
+        texture->encodedHeight = encodedHeight;
+        texture->dataSize = (encodedWidth / 4) * (encodedHeight / 4) * ETC1_BLOCK_SIZE;
+        return true;
+    }
+
+    /*
+     * PKM 1.0: magic, version "10", format 0 (ETC1_RGB_NO_MIPMAPS),
+     * the encoded size and the original size, all big endian.
+     */
+    static bool parsePkm(const unsigned char* bytes, size_t length, Etc1Texture* texture) {
+        if (length < PKM_HEADER_SIZE) return false;
+        if (bytes[4] != '1' || bytes[5] != '0' || readBigEndian16(bytes + 6) != 0) return false;
+
+        if (!setEtc1Size(texture, readBigEndian16(bytes + 12), readBigEndian16(bytes + 14),
+                                  readBigEndian16(bytes + 8),  readBigEndian16(bytes + 10))) {
+            return false;
+        }
+        if (length - PKM_HEADER_SIZE < texture->dataSize) return false;
+
+        texture->data = bytes + PKM_HEADER_SIZE;
+        return true;
+    }
+
+    /*
+     * KTX 1.1 with one ETC1 2D image. only the first mipmap level is used.
+     */
+    static bool parseKtx(const unsigned char* bytes, size_t length, Etc1Texture* texture) {
+        if (length < KTX_HEADER_SIZE) return false;
+
+        const unsigned char* header = bytes + sizeof(ktxMagic);
+        bool swap = readKtx32(header, false) != KTX_ENDIANNESS;
+        if (swap && readKtx32(header, true) != KTX_ENDIANNESS) return false;
+
+        uint32_t fields[13];
+        for (int i = 0; i < 13; i++) {
+            fields[i] = readKtx32(header + i * 4, swap);
+        }
+        // glType, glFormat, glInternalFormat, pixelDepth, arrayElements, faces
+        if (fields[1] != 0 || fields[3] != 0 || fields[4] != ETC1_RGB8_OES) return false;
+        if (fields[8] != 0 || fields[9] != 0 || fields[10] != 1) return false;
+
+        int width  = fields[6];
+        int height = fields[7];
+        if (width > 0xFFFF || height > 0xFFFF) return false;
+        if (!setEtc1Size(texture, width, height, (width + 3) & ~3, (height + 3) & ~3)) return false;
+
+        size_t offset = KTX_HEADER_SIZE;
+        if (fields[12] > length - offset || length - offset - fields[12] < 4) return false;
+        offset += fields[12];
+
+        uint32_t imageSize = readKtx32(bytes + offset, swap);
+        offset += 4;
+        if (imageSize < texture->dataSize || length - offset < texture->dataSize) return false;
+
+        texture->data = bytes + offset;
+        return true;
+    }
+
+    /*
+     * parse the container header. texture data points into the bytes.
+     */
+    bool parseEtc1Texture(const unsigned char* bytes, size_t length, Etc1Texture* texture) {
+        if (length >= sizeof(pkmMagic) && memcmp(bytes, pkmMagic, sizeof(pkmMagic)) == 0) {
+            return parsePkm(bytes, length, texture);
+        }
+        if (length >= sizeof(ktxMagic) && memcmp(bytes, ktxMagic, sizeof(ktxMagic)) == 0) {
+            return parseKtx(bytes, length, texture);
+        }
+        return false;
+    }
+
+    static inline unsigned char clampColor(int value) {
+        return value < 0 ? 0 : (value > 255 ? 255 : value);
+    }
+
+    /*
+     * decode one block into 4x4 rgb pixels, stored top-down.
+     * the four colors of each subblock are computed once and
+     * the pixels pick them by their 2 bit index.
+     */
+    static void decodeEtc1Block(const unsigned char* block, unsigned char pixels[16][3]) {
+        unsigned char colors[2][4][3];
+        bool differential = (block[3] & 2) != 0;
+        bool flipped      = (block[3] & 1) != 0;
+
+        for (int c = 0; c < 3; c++) {
+            int base1, base2;
+            if (differential) {
+                int delta = (block[c] & 7) - ((block[c] & 4) << 1);
+                base1 = block[c] >> 3;
+                base2 = (base1 + delta) & 31;
+                base1 = (base1 << 3) | (base1 >> 2);
+                base2 = (base2 << 3) | (base2 >> 2);
+            } else {
+                base1 = (block[c] >> 4) * 0x11;
+                base2 = (block[c] & 15) * 0x11;
+            }
+            int table1 = (block[3] >> 5) & 7;
+            int table2 = (block[3] >> 2) & 7;
+            for (int i = 0; i < 4; i++) {
+                int modifier1 = etc1Modifiers[table1][i & 1];
+                int modifier2 = etc1Modifiers[table2][i & 1];
+                if (i & 2) {
+                    modifier1 = -modifier1;
+                    modifier2 = -modifier2;
+                }
+                colors[0][i][c] = clampColor(base1 + modifier1);
+                colors[1][i][c] = clampColor(base2 + modifier2);
+            }
+        }
+
+        // pixel indices are column major, most significant bits first
+        unsigned int msb = (block[4] << 8) | block[5];
+        unsigned int lsb = (block[6] << 8) | block[7];
+        for (int x = 0; x < 4; x++) {
+            for (int y = 0; y < 4; y++) {
+                int bit = x * 4 + y;
+                int index = (((msb >> bit) & 1) << 1) | ((lsb >> bit) & 1);
+                int subblock = flipped ? (y >> 1) : (x >> 1);
+                const unsigned char* color = colors[subblock][index];
+                unsigned char* pixel = pixels[y * 4 + x];
+                pixel[0] = color[0];
+                pixel[1] = color[1];
+                pixel[2] = color[2];
+            }
+        }
+    }
+
+    /*
+     * decode the blocks cropped to the original size. rows are stored
+     * bottom-up as the png decoder does, a negative stride from the last
+     * row stores them top-down as the blocks are.
+     */
+    static void decodeEtc1(const Etc1Texture& texture, unsigned char* pixels, int stride, int pixelSize, bool plane) {
+        unsigned char block[16][3];
+        const unsigned char* src = texture.data;
+
+        for (int by = 0; by < texture.encodedHeight; by += 4) {
+            for (int bx = 0; bx < texture.encodedWidth; bx += 4, src += ETC1_BLOCK_SIZE) {
+                decodeEtc1Block(src, block);
+
+                int width  = texture.width  - bx < 4 ? texture.width  - bx : 4;
+                int height = texture.height - by < 4 ? texture.height - by : 4;
+                for (int y = 0; y < height; y++) {
+                    unsigned char* dst = pixels + stride * (texture.height - 1 - by - y) + bx * pixelSize;
+                    for (int x = 0; x < width; x++, dst += pixelSize) {
+                        const unsigned char* color = block[y * 4 + x];
+                        if (plane) {
+                            dst[0] = color[1];
+                            continue;
+                        }
+                        dst[0] = color[0];
+                        dst[1] = color[1];
+                        dst[2] = color[2];
+                        if (pixelSize == 4) dst[3] = 0xFF;
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+     * decode to rgb (pixelSize 3) or opaque rgba (pixelSize 4)
+     */
+    void decodeEtc1Image(const Etc1Texture& texture, unsigned char* pixels, int stride, int pixelSize) {
+        decodeEtc1(texture, pixels, stride, pixelSize, false);
+    }
+
+    /*
+     * decode the green channel of an alpha plane into one byte
+     * of each pixel, e.g. the alpha of an rgba buffer.
+     */
+    void decodeEtc1Plane(const Etc1Texture& texture, unsigned char* plane, int stride, int pixelSize) {
+        decodeEtc1(texture, plane, stride, pixelSize, true);
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_IMAGE_ETC1_H
+#define EMO_IMAGE_ETC1_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ETC1_BLOCK_SIZE    8
+#define ETC1_RGB8_OES      0x8D64
+#define ETC1_ALPHA_SUFFIX  "_alpha"
+
+/*
+ * ETC1 textures in PKM and KTX containers. The functions do not touch
+ * GL or the engine so that they can be used on Linux builds as well.
+ * ETC1 has no alpha channel: the alpha is read from the green channel
+ * of a second ETC1 plane stored as a sidecar file (foo_alpha.pkm).
+ */
+namespace emo {
+    struct Etc1Texture {
+        const unsigned char* data;
+        uint32_t dataSize;
+        int width;
+        int height;
+        int encodedWidth;
+        int encodedHeight;
+    };
+
+    bool parseEtc1Texture(const unsigned char* bytes, size_t length, Etc1Texture* texture);
+    void decodeEtc1Image(const Etc1Texture& texture, unsigned char* pixels, int stride, int pixelSize);
+    void decodeEtc1Plane(const Etc1Texture& texture, unsigned char* plane, int stride, int pixelSize);
+}
+#endif
@@ -0,0 +1,366 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Image_glyph.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+/*
+ * big-endian 32bit integer of the glyph bitmaps from the Java side
+ */
+static int32_t readInt32(const unsigned char* data) {
+    return (int32_t)(((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                     ((uint32_t)data[2] << 8)  |  (uint32_t)data[3]);
+}
+
+namespace emo {
+
+    /*
+     * decode one codepoint of the UTF-8 text and advance the position.
+     * malformed sequences are decoded as the replacement character.
+     */
+    uint32_t decodeUtf8(const std::string& text, size_t* pos) {
+        const unsigned char* s = (const unsigned char*)text.data();
+        size_t length = text.size();
+        size_t i = *pos;
+
+        uint32_t c = s[i];
+        int extra;
+        uint32_t minimum;
+        if (c < 0x80) {
+            *pos = i + 1;
+            return c;
+        } else if ((c & 0xE0) == 0xC0) {
+            c &= 0x1F; extra = 1; minimum = 0x80;
+        } else if ((c & 0xF0) == 0xE0) {
+            c &= 0x0F; extra = 2; minimum = 0x800;
+        } else if ((c & 0xF8) == 0xF0) {
+            c &= 0x07; extra = 3; minimum = 0x10000;
+        } else {
+            *pos = i + 1;
+            return GLYPH_REPLACEMENT;
+        }
+
+        if (i + extra >= length) {
+            *pos = i + 1;
+            return GLYPH_REPLACEMENT;
+        }
+        for (int n = 1; n <= extra; n++) {
+            if ((s[i + n] & 0xC0) != 0x80) {
+                *pos = i + 1;
+                return GLYPH_REPLACEMENT;
+            }
+            c = (c << 6) | (s[i + n] & 0x3F);
+        }
+        *pos = i + extra + 1;
+
+        if (c < minimum || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+            return GLYPH_REPLACEMENT;
+        }
+        return c;
+    }
+
+    GlyphPage::GlyphPage(int size) {
+        this->size        = size;
+        this->textureId   = 0;
+        this->pixels      = (unsigned char*)calloc(size * size, 1);
+        this->shelfX      = GLYPH_PAGE_PADDING;
+        this->shelfY      = GLYPH_PAGE_PADDING;
+        this->shelfHeight = 0;
+        this->dirtyTop    = size;
+        this->dirtyBottom = 0;
+    }
+
+    GlyphPage::~GlyphPage() {
+        free(this->pixels);
+    }
+
+    /*
+     * place the glyph on the current shelf, or open a new shelf below it
+     */
+    bool GlyphPage::place(int width, int height, int* x, int* y) {
+        int paddedWidth  = width  + GLYPH_PAGE_PADDING;
+        int paddedHeight = height + GLYPH_PAGE_PADDING;
+
+        if (this->shelfX + paddedWidth > this->size) {
+            this->shelfY += this->shelfHeight;
+            this->shelfX = GLYPH_PAGE_PADDING;
+            this->shelfHeight = 0;
+        }
+        if (this->shelfX + paddedWidth > this->size || this->shelfY + paddedHeight > this->size) {
+            return false;
+        }
+
+        *x = this->shelfX;
+        *y = this->shelfY;
+        this->shelfX += paddedWidth;
+        if (paddedHeight > this->shelfHeight) this->shelfHeight = paddedHeight;
+        return true;
+    }
+
+    GlyphAtlas::GlyphAtlas() {
+        this->fontSize       = 0;
+        this->isBold         = false;
+        this->isItalic       = false;
+        this->referenceCount = 0;
+        this->ascent         = 0;
+        this->descent        = 0;
+        this->lineHeight     = 0;
+        this->rasterizeCount = 0;
+        this->uploadCount    = 0;
+    }
+
+    /*
+     * the page textures should be deleted by deleteTextures before
+     * the atlas is deleted while the GL context is alive.
+     */
+    GlyphAtlas::~GlyphAtlas() {
+        for (size_t i = 0; i < this->pages.size(); i++) {
+            delete this->pages[i];
+        }
+        this->pages.clear();
+    }
+
+    /*
+     * collect the codepoints of the text that are not rasterized yet
+     */
+    bool GlyphAtlas::findMissing(const std::string& text, std::vector<uint32_t>* missing) {
+        size_t pos = 0;
+        while (pos < text.size()) {
+            uint32_t codepoint = decodeUtf8(text, &pos);
+            if (codepoint == '\n') continue;
+            if (this->glyphs.find(codepoint) != this->glyphs.end()) continue;
+            if (std::find(missing->begin(), missing->end(), codepoint) != missing->end()) continue;
+            missing->push_back(codepoint);
+        }
+        return !missing->empty();
+    }
+
+    /*
+     * add the glyph bitmaps rasterized by the Java side.
+     * all values are big-endian 32bit integers:
+     *   count, ascent, descent, line height (26.6 fixed point)
+     *   count x {codepoint, advance (26.6), left, top, width, height,
+     *            width * height bytes of alpha}
+     */
+    bool GlyphAtlas::loadBitmaps(const unsigned char* data, size_t length) {
+        if (data == NULL || length < 16) return false;
+
+        int32_t count    = readInt32(data);
+        this->ascent     = readInt32(data + 4)  / 64.0f;
+        this->descent    = readInt32(data + 8)  / 64.0f;
+        this->lineHeight = readInt32(data + 12) / 64.0f;
+        this->rasterizeCount++;
+
+        size_t offset = 16;
+        for (int32_t i = 0; i < count; i++) {
+            if (offset + 24 > length) return false;
+
+            uint32_t codepoint = readInt32(data + offset);
+            float    advance   = readInt32(data + offset + 4) / 64.0f;
+            int32_t  left      = readInt32(data + offset + 8);
+            int32_t  top       = readInt32(data + offset + 12);
+            int32_t  width     = readInt32(data + offset + 16);
+            int32_t  height    = readInt32(data + offset + 20);
+            offset += 24;
+
+            if (width < 0 || height < 0 || (uint64_t)width * height > length - offset) return false;
+
+            this->addGlyph(codepoint, advance, left, top, width, height, data + offset);
+            offset += width * height;
+        }
+        return true;
+    }
+
+    /*
+     * copy the glyph into the first page that has room for it.
+     * glyphs that do not fit are kept without pixels so that
+     * they are not rasterized again. a glyph larger than an empty
+     * page is rejected before any page is created for it.
+     */
+    bool GlyphAtlas::addGlyph(uint32_t codepoint, float advance, int left, int top,
+                              int width, int height, const unsigned char* alpha) {
+        Glyph glyph;
+        glyph.advance = advance;
+        glyph.left    = left;
+        glyph.top     = top;
+        glyph.width   = 0;
+        glyph.height  = 0;
+        glyph.x       = 0;
+        glyph.y       = 0;
+        glyph.page    = -1;
+
+        bool placed = width <= 0 || height <= 0;
+        bool fits   = width  <= GLYPH_PAGE_SIZE - 2 * GLYPH_PAGE_PADDING &&
+                      height <= GLYPH_PAGE_SIZE - 2 * GLYPH_PAGE_PADDING;
+        if (!placed && fits) {
+            int x, y;
+            for (size_t i = 0; i <= this->pages.size() && !placed; i++) {
+                if (i == this->pages.size()) {
+                    if (this->pages.size() >= GLYPH_MAX_PAGES) break;
+                    this->pages.push_back(new GlyphPage(GLYPH_PAGE_SIZE));
+                }
+                GlyphPage* page = this->pages[i];
+                if (!page->place(width, height, &x, &y)) continue;
+
+                for (int row = 0; row < height; row++) {
+                    memcpy(page->pixels + (y + row) * page->size + x, alpha + row * width, width);
+                }
+                if (y < page->dirtyTop) page->dirtyTop = y;
+                if (y + height > page->dirtyBottom) page->dirtyBottom = y + height;
+
+                glyph.width  = width;
+                glyph.height = height;
+                glyph.x      = x;
+                glyph.y      = y;
+                glyph.page   = i;
+                placed = true;
+            }
+        }
+
+        this->glyphs[codepoint] = glyph;
+        return placed;
+    }
+
+    /*
+     * lay out the text into quads of the glyphs that have pixels.
+     * the pen starts at the top-left, lines are separated by '\n'.
+     */
+    void GlyphAtlas::layout(const std::string& text, std::vector<GlyphQuad>* quads, int* width, int* height) {
+        quads->clear();
+
+        float baseline = ceilf(this->ascent);
+        float penX  = 0;
+        float lineWidth = 0;
+        int   lines = 1;
+
+        size_t pos = 0;
+        while (pos < text.size()) {
+            uint32_t codepoint = decodeUtf8(text, &pos);
+            if (codepoint == '\n') {
+                if (penX > lineWidth) lineWidth = penX;
+                penX = 0;
+                baseline += this->lineHeight;
+                lines++;
+                continue;
+            }
+
+            glyphs_t::iterator iter = this->glyphs.find(codepoint);
+            if (iter == this->glyphs.end()) {
+                iter = this->glyphs.find(GLYPH_REPLACEMENT);
+                if (iter == this->glyphs.end()) continue;
+            }
+            const Glyph& glyph = iter->second;
+
+            if (glyph.page >= 0 && quads->size() < GLYPH_MAX_QUADS) {
+                float scale = 1.0f / this->pages[glyph.page]->size;
+
+                GlyphQuad quad;
+                quad.page = glyph.page;
+                quad.x0 = floorf(penX + 0.5f) + glyph.left;
+                quad.y0 = baseline + glyph.top;
+                quad.x1 = quad.x0 + glyph.width;
+                quad.y1 = quad.y0 + glyph.height;
+                quad.s0 = glyph.x * scale;
+                quad.t0 = glyph.y * scale;
+                quad.s1 = (glyph.x + glyph.width)  * scale;
+                quad.t1 = (glyph.y + glyph.height) * scale;
+                quads->push_back(quad);
+            }
+            penX += glyph.advance;
+        }
+        if (penX > lineWidth) lineWidth = penX;
+
+        *width  = (int)ceilf(lineWidth);
+        *height = (int)(ceilf(this->ascent) + ceilf(this->descent) + ceilf(this->lineHeight * (lines - 1)));
+    }
+
+    /*
+     * bind the page texture. the texture is created on the first bind and
+     * the rows of the glyphs added since the last bind are uploaded.
+     */
+    GLuint GlyphAtlas::bindPage(int index) {
+        GlyphPage* page = this->pages[index];
+
+        if (page->textureId == 0) {
+            glGenTextures(1, &page->textureId);
+            glBindTexture   (GL_TEXTURE_2D, page->textureId);
+
+            glPixelStorei   (GL_UNPACK_ALIGNMENT, 1);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, page->size, page->size, 0, GL_ALPHA, GL_UNSIGNED_BYTE, page->pixels);
+
+            page->dirtyTop    = page->size;
+            page->dirtyBottom = 0;
+            this->uploadCount++;
+        } else {
+            glBindTexture(GL_TEXTURE_2D, page->textureId);
+            if (page->dirtyTop < page->dirtyBottom) {
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, page->dirtyTop, page->size, page->dirtyBottom - page->dirtyTop,
+                                GL_ALPHA, GL_UNSIGNED_BYTE, page->pixels + page->dirtyTop * page->size);
+
+                page->dirtyTop    = page->size;
+                page->dirtyBottom = 0;
+                this->uploadCount++;
+            }
+        }
+        return page->textureId;
+    }
+
+    /*
+     * forget the page textures when the GL context is lost.
+     * the textures are created again from the pixels on the next bind.
+     */
+    void GlyphAtlas::deleteTextures(bool hasContext) {
+        for (size_t i = 0; i < this->pages.size(); i++) {
+            GlyphPage* page = this->pages[i];
+            if (page->textureId != 0 && hasContext) {
+                glDeleteTextures(1, &page->textureId);
+            }
+            page->textureId = 0;
+        }
+    }
+
+    void GlyphAtlas::getStats(GlyphAtlasStats* stats) {
+        stats->atlasCount++;
+        stats->pageCount      += this->pages.size();
+        stats->glyphCount     += this->glyphs.size();
+        stats->rasterizeCount += this->rasterizeCount;
+        stats->uploadCount    += this->uploadCount;
+        for (size_t i = 0; i < this->pages.size(); i++) {
+            stats->pageBytes += this->pages[i]->size * this->pages[i]->size;
+        }
+    }
+}
@@ -0,0 +1,145 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_IMAGE_GLYPH_H
+#define EMO_IMAGE_GLYPH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <GLES/gl.h>
+#include <string>
+#include <vector>
+#include <hash_map>
+
+#define GLYPH_PAGE_SIZE      512
+#define GLYPH_PAGE_PADDING   1
+#define GLYPH_MAX_PAGES      8
+#define GLYPH_MAX_QUADS      16383
+#define GLYPH_REPLACEMENT    0xFFFD
+
+/*
+ * Glyph atlas of a font face and size. Each glyph is rasterized once
+ * (by the Java side) and copied into shared GL_ALPHA pages with shelf
+ * packing, the text is laid out natively into quads. The pages keep
+ * a CPU copy of the pixels: new glyphs upload only the changed rows
+ * and the textures are restored from the copy after the GL context
+ * is lost. Positions are in pixels from the top-left of the text.
+ */
+namespace emo {
+    struct Glyph {
+        float advance;
+        short left;
+        short top;
+        short width;
+        short height;
+        short x;
+        short y;
+        int   page;
+    };
+
+    struct GlyphQuad {
+        int   page;
+        float x0;
+        float y0;
+        float x1;
+        float y1;
+        float s0;
+        float t0;
+        float s1;
+        float t1;
+    };
+
+    struct GlyphRun {
+        int page;
+        int first;
+        int count;
+    };
+
+    struct GlyphAtlasStats {
+        int atlasCount;
+        int pageCount;
+        int glyphCount;
+        int pageBytes;
+        int rasterizeCount;
+        int uploadCount;
+    };
+
+    class GlyphPage {
+    public:
+        GlyphPage(int size);
+        ~GlyphPage();
+
+        bool place(int width, int height, int* x, int* y);
+
+        int    size;
+        GLuint textureId;
+        unsigned char* pixels;
+        int    shelfX;
+        int    shelfY;
+        int    shelfHeight;
+        int    dirtyTop;
+        int    dirtyBottom;
+    };
+
+    typedef std::hash_map<uint32_t, Glyph> glyphs_t;
+
+    class GlyphAtlas {
+    public:
+        GlyphAtlas();
+        ~GlyphAtlas();
+
+        std::string key;
+        std::string fontFace;
+        int  fontSize;
+        bool isBold;
+        bool isItalic;
+        int  referenceCount;
+
+        float ascent;
+        float descent;
+        float lineHeight;
+
+        bool findMissing(const std::string& text, std::vector<uint32_t>* missing);
+        bool loadBitmaps(const unsigned char* data, size_t length);
+        bool addGlyph(uint32_t codepoint, float advance, int left, int top,
+                      int width, int height, const unsigned char* alpha);
+        void layout(const std::string& text, std::vector<GlyphQuad>* quads, int* width, int* height);
+
+        GLuint bindPage(int index);
+        void deleteTextures(bool hasContext);
+        void getStats(GlyphAtlasStats* stats);
+
+        int rasterizeCount;
+        int uploadCount;
+    protected:
+        glyphs_t glyphs;
+        std::vector<GlyphPage*> pages;
+    };
+
+    uint32_t decodeUtf8(const std::string& text, size_t* pos);
+}
+#endif
@@ -0,0 +1,195 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include <stdint.h>
+#include <string.h>
+#include "Image_mipmap.h"
+
+#if defined(EMO_IMAGE_NEON)
+#include <cpu-features.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace emo {
+
+    static bool mipmapKernelsInitialized = false;
+    static const char* mipmapKernelsName = "scalar";
+
+    MipmapDownsampleFunc mipmapDownsampleRGBA = mipmapDownsampleRGBAScalar;
+
+    /*
+     * select the kernels for this CPU. called once before any image is decoded.
+     */
+    void initMipmapKernels() {
+        if (mipmapKernelsInitialized) return;
+        mipmapKernelsInitialized = true;
+
+#if defined(EMO_IMAGE_NEON)
+        if (android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+                (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
+            mipmapDownsampleRGBA = mipmapDownsampleRGBANeon;
+            mipmapKernelsName = "neon";
+        }
+#elif defined(__SSE2__)
+        mipmapDownsampleRGBA = mipmapDownsampleRGBASSE2;
+        mipmapKernelsName = "sse2";
+#endif
+    }
+
+    const char* getMipmapKernelsName() {
+        return mipmapKernelsName;
+    }
+
+    /*
+     * returns the number of levels after level 0
+     */
+    int getMipmapLevelCount(int width, int height) {
+        int levels = 0;
+        while (width > 1 || height > 1) {
+            width  = width  > 1 ? width  / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+            levels++;
+        }
+        return levels;
+    }
+
+    int getMipmapChainSize(int width, int height, int pixelSize) {
+        int size = 0;
+        while (width > 1 || height > 1) {
+            width  = width  > 1 ? width  / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+            size += width * height * pixelSize;
+        }
+        return size;
+    }
+
+    /*
+     * generate every level from the previous one.
+     */
+    void generateMipmapChain(unsigned char* chain, const unsigned char* src, int width, int height, int pixelSize) {
+        while (width > 1 || height > 1) {
+            if (pixelSize == 4 && width > 1 && height > 1) {
+                mipmapDownsampleRGBA(chain, src, width, height);
+            } else {
+                mipmapDownsampleScalar(chain, src, width, height, pixelSize);
+            }
+            src = chain;
+            width  = width  > 1 ? width  / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+            chain += width * height * pixelSize;
+        }
+    }
+
+    /*
+     * scalar reference implementation for any pixel size.
+     * levels of 1 pixel width or height average two pixels.
+     */
+    void mipmapDownsampleScalar(unsigned char* dst, const unsigned char* src, int width, int height, int pixelSize) {
+        int dstWidth  = width  > 1 ? width  / 2 : 1;
+        int dstHeight = height > 1 ? height / 2 : 1;
+        int stride = width * pixelSize;
+        int dx = width  > 1 ? pixelSize : 0;
+        int dy = height > 1 ? stride    : 0;
+        int shift = (dx != 0 && dy != 0) ? 2 : 1;
+
+        for (int y = 0; y < dstHeight; y++) {
+            const unsigned char* row = src + (height > 1 ? y * 2 : 0) * stride;
+            for (int x = 0; x < dstWidth; x++) {
+                const unsigned char* p = row + (width > 1 ? x * 2 : 0) * pixelSize;
+                for (int c = 0; c < pixelSize; c++) {
+                    unsigned int sum = p[c] + p[c + dx];
+                    if (shift == 2) sum += p[c + dy] + p[c + dx + dy];
+                    *dst++ = (sum + (1 << (shift - 1))) >> shift;
+                }
+            }
+        }
+    }
+
+    /*
+     * average four rgba pixels: even and odd bytes are summed in the
+     * 16bit halves of a word so that two channels are done at once.
+     */
+    static inline uint32_t averageRGBA(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        uint32_t even = (a & 0x00FF00FF) + (b & 0x00FF00FF) + (c & 0x00FF00FF) + (d & 0x00FF00FF);
+        uint32_t odd  = ((a >> 8) & 0x00FF00FF) + ((b >> 8) & 0x00FF00FF) +
+                        ((c >> 8) & 0x00FF00FF) + ((d >> 8) & 0x00FF00FF);
+        even = ((even + 0x00020002) >> 2) & 0x00FF00FF;
+        odd  = ((odd  + 0x00020002) >> 2) & 0x00FF00FF;
+        return even | (odd << 8);
+    }
+
+    void mipmapDownsampleRGBAScalar(unsigned char* dst, const unsigned char* src, int width, int height) {
+        int dstWidth = width / 2;
+        for (int y = 0; y < height / 2; y++) {
+            const uint32_t* row0 = (const uint32_t*)(src + y * 2 * width * 4);
+            const uint32_t* row1 = row0 + width;
+            uint32_t* out = (uint32_t*)(dst + y * dstWidth * 4);
+            for (int x = 0; x < dstWidth; x++) {
+                out[x] = averageRGBA(row0[x * 2], row0[x * 2 + 1], row1[x * 2], row1[x * 2 + 1]);
+            }
+        }
+    }
+
+#if defined(__SSE2__)
+    /*
+     * sum the pixel pairs of two rows in 16bit lanes: four output pixels
+     * from eight input pixels of each row.
+     */
+    void mipmapDownsampleRGBASSE2(unsigned char* dst, const unsigned char* src, int width, int height) {
+        if (width < 8) {
+            mipmapDownsampleRGBAScalar(dst, src, width, height);
+            return;
+        }
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two  = _mm_set1_epi16(2);
+        int dstWidth = width / 2;
+
+        for (int y = 0; y < height / 2; y++) {
+            const unsigned char* row0 = src + y * 2 * width * 4;
+            const unsigned char* row1 = row0 + width * 4;
+            unsigned char* out = dst + y * dstWidth * 4;
+
+            for (int x = 0; x < dstWidth; x += 4) {
+                __m128i sums[2];
+                for (int i = 0; i < 2; i++) {
+                    __m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + i * 16));
+                    __m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + i * 16));
+                    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                    __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+                    sums[i] = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+                }
+                _mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(sums[0], sums[1]));
+            }
+        }
+    }
+#endif
+}
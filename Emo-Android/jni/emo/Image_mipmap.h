@@ -0,0 +1,71 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_IMAGE_MIPMAP_H
+#define EMO_IMAGE_MIPMAP_H
+
+#define MIPMAP_NONE   0
+#define MIPMAP_ALWAYS 1
+#define MIPMAP_AUTO   2
+
+#define MIPMAP_DEFAULT_THRESHOLD 0.5f
+
+/*
+ * Mipmap chain generation with 2x2 box filter.
+ *
+ * The chain holds the levels after level 0 one after another, each
+ * level is half the size of the previous one down to 1x1. The images
+ * are power of two sized rgb or rgba buffers as the decoders store them.
+ *
+ * The dispatched rgba kernel points to the NEON or SSE2 implementation
+ * when the CPU supports it, or to the scalar implementation that averages
+ * two channels at once in a 32bit word. All of them round the same way.
+ */
+namespace emo {
+    typedef void (*MipmapDownsampleFunc)(unsigned char* dst, const unsigned char* src, int width, int height);
+
+    void initMipmapKernels();
+    const char* getMipmapKernelsName();
+
+    extern MipmapDownsampleFunc mipmapDownsampleRGBA;
+
+    int  getMipmapLevelCount(int width, int height);
+    int  getMipmapChainSize(int width, int height, int pixelSize);
+    void generateMipmapChain(unsigned char* chain, const unsigned char* src, int width, int height, int pixelSize);
+
+    void mipmapDownsampleScalar(unsigned char* dst, const unsigned char* src, int width, int height, int pixelSize);
+    void mipmapDownsampleRGBAScalar(unsigned char* dst, const unsigned char* src, int width, int height);
+
+#if defined(EMO_IMAGE_NEON)
+    void mipmapDownsampleRGBANeon(unsigned char* dst, const unsigned char* src, int width, int height);
+#endif
+
+#if defined(__SSE2__)
+    void mipmapDownsampleRGBASSE2(unsigned char* dst, const unsigned char* src, int width, int height);
+#endif
+}
+#endif
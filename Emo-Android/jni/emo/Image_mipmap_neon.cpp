@@ -0,0 +1,68 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Image_mipmap.h"
+
+/*
+ * NEON kernels. This file is compiled with NEON enabled only on armeabi-v7a,
+ * and the kernels are selected at runtime by initMipmapKernels().
+ */
+#if defined(EMO_IMAGE_NEON) && defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+namespace emo {
+
+    /*
+     * deinterleave sixteen pixels of each row, add the pixel pairs of
+     * each channel and narrow with rounding: eight output pixels.
+     */
+    void mipmapDownsampleRGBANeon(unsigned char* dst, const unsigned char* src, int width, int height) {
+        if (width < 16) {
+            mipmapDownsampleRGBAScalar(dst, src, width, height);
+            return;
+        }
+
+        int dstWidth = width / 2;
+        for (int y = 0; y < height / 2; y++) {
+            const unsigned char* row0 = src + y * 2 * width * 4;
+            const unsigned char* row1 = row0 + width * 4;
+            unsigned char* out = dst + y * dstWidth * 4;
+
+            for (int x = 0; x < dstWidth; x += 8) {
+                uint8x16x4_t a = vld4q_u8(row0 + x * 8);
+                uint8x16x4_t b = vld4q_u8(row1 + x * 8);
+                uint8x8x4_t result;
+                result.val[0] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[0]), vpaddlq_u8(b.val[0])), 2);
+                result.val[1] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[1]), vpaddlq_u8(b.val[1])), 2);
+                result.val[2] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[2]), vpaddlq_u8(b.val[2])), 2);
+                result.val[3] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[3]), vpaddlq_u8(b.val[3])), 2);
+                vst4_u8(out + x * 4, result);
+            }
+        }
+    }
+}
+#endif
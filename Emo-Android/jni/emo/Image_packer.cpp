@@ -0,0 +1,464 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include "Image_packer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "Image.h"
+#include "Util.h"
+
+namespace emo {
+
+    TexturePage::TexturePage(int size) {
+        this->size      = size;
+        this->textureId = 0;
+        this->dirty     = true;
+        this->usedPixels = 0;
+        this->pixels = (unsigned char*)calloc(size * size, 4);
+        this->resetSkyline();
+    }
+
+    TexturePage::~TexturePage() {
+        free(this->pixels);
+    }
+
+    void TexturePage::resetSkyline() {
+        SkylineNode node;
+        node.x = 0;
+        node.y = 0;
+        node.width = this->size;
+        this->skyline.clear();
+        this->skyline.push_back(node);
+    }
+
+    /*
+     * find the bottom-left position of the rect on the skyline
+     */
+    bool TexturePage::findPosition(int width, int height, int* x, int* y, int* nodeIndex) {
+        int bestTop   = this->size + 1;
+        int bestWidth = this->size + 1;
+        bool found = false;
+
+        for (size_t i = 0; i < this->skyline.size(); i++) {
+            int left = this->skyline[i].x;
+            if (left + width > this->size) break;
+
+            int top = this->skyline[i].y;
+            int remaining = width;
+            for (size_t j = i; remaining > 0 && j < this->skyline.size(); j++) {
+                if (this->skyline[j].y > top) top = this->skyline[j].y;
+                remaining -= this->skyline[j].width;
+            }
+            if (top + height > this->size) continue;
+
+            if (top + height < bestTop || (top + height == bestTop && this->skyline[i].width < bestWidth)) {
+                bestTop   = top + height;
+                bestWidth = this->skyline[i].width;
+                *x = left;
+                *y = top;
+                *nodeIndex = i;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    /*
+     * raise the skyline over the placed rect
+     */
+    void TexturePage::addSkyline(int nodeIndex, int x, int y, int width, int height) {
+        SkylineNode node;
+        node.x = x;
+        node.y = y + height;
+        node.width = width;
+        this->skyline.insert(this->skyline.begin() + nodeIndex, node);
+
+        for (size_t i = nodeIndex + 1; i < this->skyline.size(); i++) {
+            SkylineNode& prev = this->skyline[i - 1];
+            SkylineNode& current = this->skyline[i];
+            int right = prev.x + prev.width;
+            if (current.x >= right) break;
+
+            int shrink = right - current.x;
+            current.x     += shrink;
+            current.width -= shrink;
+            if (current.width > 0) break;
+
+            this->skyline.erase(this->skyline.begin() + i);
+            i--;
+        }
+
+        for (size_t i = 0; i + 1 < this->skyline.size(); i++) {
+            if (this->skyline[i].y == this->skyline[i + 1].y) {
+                this->skyline[i].width += this->skyline[i + 1].width;
+                this->skyline.erase(this->skyline.begin() + i + 1);
+                i--;
+            }
+        }
+    }
+
+    TexturePacker::TexturePacker() {
+        this->maxSize = 0;
+        this->grows   = 0;
+        this->repacks = 0;
+    }
+
+    TexturePacker::~TexturePacker() {
+        for (size_t i = 0; i < this->pages.size(); i++) {
+            delete this->pages[i];
+        }
+        this->pages.clear();
+    }
+
+    /*
+     * pack the decoded image into a page and free its own data.
+     * moved is set when the layout of a page has changed, then the
+     * texture coordinates of the other images in the page must be rebuilt.
+     * returns false if the image can not be packed.
+     */
+    bool TexturePacker::pack(Image* image, bool* moved) {
+        *moved = false;
+        if (!image->hasData || image->page != NULL) return false;
+        // compressed blocks can not be copied into the rgba page
+        if (image->compressedFormat != 0) return false;
+
+        if (this->maxSize == 0) {
+            GLint size = 0;
+            glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+            this->maxSize = size >= TEXTURE_PAGE_MAX_SIZE ? TEXTURE_PAGE_MAX_SIZE : TEXTURE_PAGE_SIZE;
+        }
+
+        int width  = image->width  + TEXTURE_PAGE_PADDING;
+        int height = image->height + TEXTURE_PAGE_PADDING;
+        if (width > this->maxSize || height > this->maxSize) return false;
+
+        for (size_t i = 0; i < this->pages.size(); i++) {
+            if (this->place(this->pages[i], image)) return true;
+        }
+
+        for (size_t i = 0; i < this->pages.size(); i++) {
+            TexturePage* page = this->pages[i];
+            if (page->usedPixels < page->size * page->size * TEXTURE_PAGE_REPACK_EFFICIENCY && this->repack(page, image)) {
+                *moved = true;
+                return true;
+            }
+        }
+
+        for (size_t i = 0; i < this->pages.size(); i++) {
+            if (this->grow(this->pages[i]) && this->place(this->pages[i], image)) {
+                *moved = true;
+                return true;
+            }
+        }
+
+        int size = TEXTURE_PAGE_SIZE;
+        while (size < width || size < height) size *= 2;
+
+        TexturePage* page = new TexturePage(size);
+        this->pages.push_back(page);
+        return this->place(page, image);
+    }
+
+    bool TexturePacker::place(TexturePage* page, Image* image) {
+        int x, y, nodeIndex;
+        int width  = image->width  + TEXTURE_PAGE_PADDING;
+        int height = image->height + TEXTURE_PAGE_PADDING;
+        if (!page->findPosition(width, height, &x, &y, &nodeIndex)) return false;
+
+        page->addSkyline(nodeIndex, x, y, width, height);
+        this->attach(page, image, x + TEXTURE_PAGE_BORDER, y + TEXTURE_PAGE_BORDER);
+
+        if (page->textureId != 0 && !page->dirty) {
+            this->uploadRows(page, y, height);
+        } else {
+            page->dirty = true;
+        }
+        return true;
+    }
+
+    /*
+     * copy the image to the page and release its data.
+     * the decoders store bottom-up rows of glWidth pixels.
+     */
+    void TexturePacker::attach(TexturePage* page, Image* image, int x, int y) {
+        int channels = image->hasAlpha ? 4 : 3;
+        this->copyRect(page, x, y, image->width, image->height, image->data, image->glWidth * channels, channels);
+        this->extrude(page, x, y, image->width, image->height);
+
+        image->page  = page;
+        image->pageX = x;
+        image->pageY = y;
+
+        free(image->data);
+        image->data    = NULL;
+        image->hasData = false;
+        image->mustReload = false;
+        image->hasAlpha   = true;
+        image->textureId  = page->textureId;
+        image->glWidth    = page->size;
+        image->glHeight   = page->size;
+        image->loaded     = false;
+
+        page->images.push_back(image);
+        page->usedPixels += image->width * image->height;
+    }
+
+    /*
+     * double the size of the page. images keep their position.
+     */
+    bool TexturePacker::grow(TexturePage* page) {
+        int size = page->size * 2;
+        if (size > this->maxSize) return false;
+
+        unsigned char* pixels = (unsigned char*)calloc(size * size, 4);
+        if (pixels == NULL) return false;
+        for (int y = 0; y < page->size; y++) {
+            memcpy(pixels + y * size * 4, page->pixels + y * page->size * 4, page->size * 4);
+        }
+        free(page->pixels);
+        page->pixels = pixels;
+
+        SkylineNode node;
+        node.x = page->size;
+        node.y = 0;
+        node.width = size - page->size;
+        page->skyline.push_back(node);
+
+        page->size  = size;
+        page->dirty = true;
+        for (size_t i = 0; i < page->images.size(); i++) {
+            page->images[i]->glWidth  = size;
+            page->images[i]->glHeight = size;
+        }
+        this->grows++;
+        return true;
+    }
+
+    static bool compareImageHeight(const Image* a, const Image* b) {
+        if (a->height != b->height) return a->height > b->height;
+        return a->width > b->width;
+    }
+
+    /*
+     * place the images of the page again, tallest first, together
+     * with the new image. the page is unchanged if they do not fit.
+     */
+    bool TexturePacker::repack(TexturePage* page, Image* image) {
+        std::vector<Image*> images = page->images;
+        images.push_back(image);
+        std::sort(images.begin(), images.end(), compareImageHeight);
+
+        std::vector<SkylineNode> skyline = page->skyline;
+        page->resetSkyline();
+
+        std::vector<int> positions(images.size() * 2);
+        for (size_t i = 0; i < images.size(); i++) {
+            int x, y, nodeIndex;
+            int width  = images[i]->width  + TEXTURE_PAGE_PADDING;
+            int height = images[i]->height + TEXTURE_PAGE_PADDING;
+            if (!page->findPosition(width, height, &x, &y, &nodeIndex)) {
+                page->skyline = skyline;
+                return false;
+            }
+            page->addSkyline(nodeIndex, x, y, width, height);
+            positions[i * 2]     = x + TEXTURE_PAGE_BORDER;
+            positions[i * 2 + 1] = y + TEXTURE_PAGE_BORDER;
+        }
+
+        unsigned char* old = page->pixels;
+        page->pixels = (unsigned char*)calloc(page->size * page->size, 4);
+        if (page->pixels == NULL) {
+            page->pixels  = old;
+            page->skyline = skyline;
+            return false;
+        }
+
+        for (size_t i = 0; i < images.size(); i++) {
+            Image* current = images[i];
+            if (current == image) continue;
+            const unsigned char* source = old + (current->pageY * page->size + current->pageX) * 4;
+            this->copyRect(page, positions[i * 2], positions[i * 2 + 1], current->width, current->height, source, page->size * 4, 4);
+            this->extrude(page, positions[i * 2], positions[i * 2 + 1], current->width, current->height);
+            current->pageX = positions[i * 2];
+            current->pageY = positions[i * 2 + 1];
+        }
+        free(old);
+
+        for (size_t i = 0; i < images.size(); i++) {
+            if (images[i] == image) {
+                this->attach(page, image, positions[i * 2], positions[i * 2 + 1]);
+                break;
+            }
+        }
+
+        page->dirty = true;
+        this->repacks++;
+        return true;
+    }
+
+    void TexturePacker::copyRect(TexturePage* page, int x, int y, int width, int height,
+                                 const unsigned char* data, int stride, int channels) {
+        for (int row = 0; row < height; row++) {
+            unsigned char* dst = page->pixels + ((y + row) * page->size + x) * 4;
+            const unsigned char* src = data + row * stride;
+            if (channels == 4) {
+                memcpy(dst, src, width * 4);
+            } else {
+                for (int i = 0; i < width; i++, dst += 4, src += 3) {
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                    dst[2] = src[2];
+                    dst[3] = 255;
+                }
+            }
+        }
+    }
+
+    /*
+     * repeat the edge pixels of the image into its border, corners included.
+     * the border rows are built from the extruded columns.
+     */
+    void TexturePacker::extrude(TexturePage* page, int x, int y, int width, int height) {
+        if (width <= 0 || height <= 0) return;
+        int pitch = page->size * 4;
+        for (int row = 0; row < height; row++) {
+            unsigned char* line = page->pixels + (y + row) * pitch;
+            for (int i = 1; i <= TEXTURE_PAGE_BORDER; i++) {
+                memcpy(line + (x - i) * 4, line + x * 4, 4);
+                memcpy(line + (x + width - 1 + i) * 4, line + (x + width - 1) * 4, 4);
+            }
+        }
+        int left  = (x - TEXTURE_PAGE_BORDER) * 4;
+        int bytes = (width + TEXTURE_PAGE_PADDING) * 4;
+        for (int i = 1; i <= TEXTURE_PAGE_BORDER; i++) {
+            memcpy(page->pixels + (y - i) * pitch + left, page->pixels + y * pitch + left, bytes);
+            memcpy(page->pixels + (y + height - 1 + i) * pitch + left, page->pixels + (y + height - 1) * pitch + left, bytes);
+        }
+    }
+
+    /*
+     * remove the image from its page. empty pages are deleted.
+     * the space is reclaimed by the next repack.
+     */
+    void TexturePacker::remove(Image* image) {
+        TexturePage* page = image->page;
+        if (page == NULL) return;
+
+        std::vector<Image*>::iterator it = std::find(page->images.begin(), page->images.end(), image);
+        if (it != page->images.end()) {
+            page->images.erase(it);
+            page->usedPixels -= image->width * image->height;
+        }
+        image->page = NULL;
+        image->textureId = 0;
+
+        if (page->images.empty()) {
+            if (page->textureId != 0) {
+                glDeleteTextures(1, &page->textureId);
+            }
+            this->pages.erase(std::find(this->pages.begin(), this->pages.end(), page));
+            delete page;
+        }
+    }
+
+    /*
+     * create or update the page texture of the image
+     */
+    void TexturePacker::bind(Image* image) {
+        TexturePage* page = image->page;
+        if (page == NULL) return;
+
+        if (page->textureId == 0) {
+            glGenTextures(1, &page->textureId);
+            page->dirty = true;
+        }
+
+        if (page->dirty) {
+            glEnable(GL_TEXTURE_2D);
+            glBindTexture   (GL_TEXTURE_2D, page->textureId);
+
+            glPixelStorei   (GL_UNPACK_ALIGNMENT, 1);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page->size, page->size, 0, GL_RGBA, GL_UNSIGNED_BYTE, page->pixels);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            page->dirty = false;
+        }
+
+        image->textureId = page->textureId;
+        image->glWidth   = page->size;
+        image->glHeight  = page->size;
+        image->loaded    = true;
+    }
+
+    void TexturePacker::uploadRows(TexturePage* page, int y, int height) {
+        glBindTexture(GL_TEXTURE_2D, page->textureId);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, page->size, height, GL_RGBA, GL_UNSIGNED_BYTE, page->pixels + y * page->size * 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    /*
+     * forget the page textures when the GL context is lost.
+     * the textures are created again from the pixels on the next bind.
+     */
+    void TexturePacker::deleteTextures(bool hasContext) {
+        for (size_t i = 0; i < this->pages.size(); i++) {
+            TexturePage* page = this->pages[i];
+            if (page->textureId != 0 && hasContext) {
+                glDeleteTextures(1, &page->textureId);
+            }
+            page->textureId = 0;
+            page->dirty = true;
+        }
+    }
+
+    void TexturePacker::getStats(TexturePackerStats* stats) {
+        memset(stats, 0, sizeof(TexturePackerStats));
+        for (size_t i = 0; i < this->pages.size(); i++) {
+            TexturePage* page = this->pages[i];
+            stats->pageCount++;
+            stats->imageCount += page->images.size();
+            stats->usedPixels += page->usedPixels;
+            stats->pagePixels += page->size * page->size;
+            for (size_t j = 0; j < page->images.size(); j++) {
+                Image* image = page->images[j];
+                stats->unpackedPixels += nextPowerOfTwo(image->width) * nextPowerOfTwo(image->height);
+            }
+        }
+        stats->grows   = this->grows;
+        stats->repacks = this->repacks;
+        stats->efficiency = stats->pagePixels > 0 ? stats->usedPixels / (float)stats->pagePixels : 0;
+    }
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_IMAGE_PACKER_H
+#define EMO_IMAGE_PACKER_H
+
+#include <GLES/gl.h>
+#include <vector>
+
+#define TEXTURE_PAGE_SIZE     1024
+#define TEXTURE_PAGE_MAX_SIZE 2048
+#define TEXTURE_PAGE_BORDER   1
+#define TEXTURE_PAGE_PADDING  (TEXTURE_PAGE_BORDER * 2)
+#define TEXTURE_PAGE_REPACK_EFFICIENCY 0.75f
+#define TEXTURE_PAGE_UNPACKED_KEY "#unpacked"
+
+/*
+ * Packs the images of packable sprites into shared RGBA pages with
+ * the skyline bottom-left algorithm. A page starts at 1024x1024 and
+ * grows to 2048x2048 when it is full, fragmented pages are repacked.
+ * The page keeps a CPU copy of its pixels for repacking and for
+ * restoring the texture after the GL context is lost.
+ * Every image is surrounded by a border of its own edge pixels so
+ * that linear filtering never samples the neighbouring images.
+ */
+namespace emo {
+    class Image;
+
+    struct TexturePackerStats {
+        int   pageCount;
+        int   imageCount;
+        int   usedPixels;
+        int   pagePixels;
+        int   unpackedPixels;
+        int   grows;
+        int   repacks;
+        float efficiency;
+    };
+
+    struct SkylineNode {
+        int x;
+        int y;
+        int width;
+    };
+
+    class TexturePage {
+    public:
+        TexturePage(int size);
+        ~TexturePage();
+
+        bool findPosition(int width, int height, int* x, int* y, int* nodeIndex);
+        void addSkyline(int nodeIndex, int x, int y, int width, int height);
+        void resetSkyline();
+
+        int    size;
+        GLuint textureId;
+        bool   dirty;
+        unsigned char* pixels;
+        std::vector<SkylineNode> skyline;
+        std::vector<Image*> images;
+        int    usedPixels;
+    };
+
+    class TexturePacker {
+    public:
+        TexturePacker();
+        ~TexturePacker();
+
+        bool pack(Image* image, bool* moved);
+        void remove(Image* image);
+        void bind(Image* image);
+        void deleteTextures(bool hasContext);
+        void getStats(TexturePackerStats* stats);
+    protected:
+        std::vector<TexturePage*> pages;
+        int maxSize;
+        int grows;
+        int repacks;
+
+        bool place(TexturePage* page, Image* image);
+        void attach(TexturePage* page, Image* image, int x, int y);
+        bool grow(TexturePage* page);
+        bool repack(TexturePage* page, Image* image);
+        void copyRect(TexturePage* page, int x, int y, int width, int height,
+                      const unsigned char* data, int stride, int channels);
+        void extrude(TexturePage* page, int x, int y, int width, int height);
+        void uploadRows(TexturePage* page, int y, int height);
+    };
+}
+#endif
@@ -348,6 +348,39 @@ namespace emo {
 
         return image->width > 0 && image->height > 0;
     }
+
+    /*
+     * rasterize the glyphs of the codepoints with one call.
+     * the Java side returns the glyph bitmaps in the format of GlyphAtlas::loadBitmaps.
+     */
+    bool JavaGlue::loadGlyphBitmaps(GlyphAtlas* atlas, const std::vector<uint32_t>& codepoints) {
+        JNIEnv* env;
+        JavaVM* vm = engine->app->activity->vm;
+
+        vm->AttachCurrentThread(&env, NULL);
+
+        jintArray chars = env->NewIntArray(codepoints.size());
+        env->SetIntArrayRegion(chars, 0, codepoints.size(), (const jint*)&codepoints[0]);
+
+        jclass clazz = env->GetObjectClass(engine->app->activity->clazz);
+        jmethodID methodj = env->GetMethodID(clazz, "loadGlyphBitmaps", "(Ljava/lang/String;IZZ[I)[B");
+        jbyteArray src = (jbyteArray)env->CallObjectMethod(engine->app->activity->clazz, methodj,
+                                 env->NewStringUTF(atlas->fontFace.c_str()),
+                                 (jint)atlas->fontSize,
+                                 atlas->isBold   ? JNI_TRUE : JNI_FALSE,
+                                 atlas->isItalic ? JNI_TRUE : JNI_FALSE,
+                                 chars);
+        bool loaded = false;
+        if (src != NULL) {
+            jsize size = env->GetArrayLength(src);
+            jbyte* data = env->GetByteArrayElements(src, NULL);
+            loaded = atlas->loadBitmaps((const unsigned char*)data, size);
+            env->ReleaseByteArrayElements(src, data, JNI_ABORT);
+        }
+        vm->DetachCurrentThread();
+
+        return loaded;
+    }
 }
 
 
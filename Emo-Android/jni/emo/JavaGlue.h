@@ -64,6 +64,7 @@ namespace emo {
         void vibrate();
         std::string getDataFilePath(std::string name);
         bool loadTextBitmap(Drawable* drawable, Image* image, bool forceUpdate);
+        bool loadGlyphBitmaps(GlyphAtlas* atlas, const std::vector<uint32_t>& codepoints);
     };
 }
 
@@ -38,6 +38,7 @@ void initPhysicsFunctions() {
     registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "newShape",      emoPhysicsNewShape);
     registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "createBody",    emoPhysicsCreateBody);
     registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "createGroundBody",    emoPhysicsCreateGroundBody);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "createBodies",  emoPhysicsCreateBodies);
     registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "destroyBody",   emoPhysicsDestroyBody);
     registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "createJoint",   emoPhysicsCreateJoint);
     registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "destroyJoint",  emoPhysicsDestroyJoint);
@@ -142,4 +143,16 @@ void initPhysicsFunctions() {
     registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "initPulleyJointDef",       emoPhysicsInitPulleyJointDef);
     registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "initRevoluteJointDef",     emoPhysicsInitRevoluteJointDef);
     registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "initWeldJointDef",         emoPhysicsInitWeldJointDef);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "world_snapshot",   emoPhysicsWorld_Snapshot);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "world_restore",    emoPhysicsWorld_Restore);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "snapshot_save",    emoPhysicsSnapshot_Save);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "snapshot_load",    emoPhysicsSnapshot_Load);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "snapshot_size",    emoPhysicsSnapshot_Size);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "world_enableDebugDraw",   emoPhysicsWorld_EnableDebugDraw);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "world_disableDebugDraw",  emoPhysicsWorld_DisableDebugDraw);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "world_getDebugDrawStats", emoPhysicsWorld_GetDebugDrawStats);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "world_enableProfiler",    emoPhysicsWorld_EnableProfiler);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "world_disableProfiler",   emoPhysicsWorld_DisableProfiler);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "world_getProfile",        emoPhysicsWorld_GetProfile);
+    registerClassFunc(engine->sqvm, EMO_PHYSICS_CLASS, "world_getAllocatorStats", emoPhysicsWorld_GetAllocatorStats);
 }
@@ -26,3 +26,4 @@
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // 
 void initPhysicsFunctions();
+void clearPhysicsWorldPool();
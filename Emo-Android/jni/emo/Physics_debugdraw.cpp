@@ -0,0 +1,187 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include <time.h>
+#include "Constants.h"
+#include "Physics_debugdraw.h"
+
+static GLubyte toColorByte(float32 value) {
+	if (value <= 0) return 0;
+	if (value >= 1) return 255;
+	return (GLubyte)(value * 255.0f);
+}
+
+static float elapsedMillis(const timespec& start, const timespec& end) {
+	return (end.tv_sec - start.tv_sec) * 1000.0f + (end.tv_nsec - start.tv_nsec) / 1000000.0f;
+}
+
+namespace emo {
+	PhysicsDebugDraw::PhysicsDebugDraw(b2World* world) {
+		this->world = world;
+		this->scale = 1;
+		this->lineWidth = 1;
+		this->vertexCount = 0;
+		this->drawTime = 0;
+		this->vbo = 0;
+	}
+
+	PhysicsDebugDraw::~PhysicsDebugDraw() {
+		this->deleteBuffer();
+	}
+
+	void PhysicsDebugDraw::addLine(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color) {
+		PhysicsDebugVertex vertex;
+		vertex.r = toColorByte(color.r);
+		vertex.g = toColorByte(color.g);
+		vertex.b = toColorByte(color.b);
+		vertex.a = 255;
+
+		vertex.x = p1.x;
+		vertex.y = p1.y;
+		this->vertices.push_back(vertex);
+
+		vertex.x = p2.x;
+		vertex.y = p2.y;
+		this->vertices.push_back(vertex);
+	}
+
+	void PhysicsDebugDraw::DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) {
+		for (int32 i = 0; i < vertexCount; i++) {
+			this->addLine(vertices[i], vertices[(i + 1) % vertexCount], color);
+		}
+	}
+
+	void PhysicsDebugDraw::DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) {
+		this->DrawPolygon(vertices, vertexCount, color);
+	}
+
+	void PhysicsDebugDraw::DrawCircle(const b2Vec2& center, float32 radius, const b2Color& color) {
+		const float32 increment = 2.0f * b2_pi / PHYSICS_DEBUGDRAW_CIRCLE_SEGMENTS;
+		b2Vec2 prev = center + radius * b2Vec2(1.0f, 0.0f);
+		for (int32 i = 1; i <= PHYSICS_DEBUGDRAW_CIRCLE_SEGMENTS; i++) {
+			float32 theta = increment * i;
+			b2Vec2 next = center + radius * b2Vec2(cosf(theta), sinf(theta));
+			this->addLine(prev, next, color);
+			prev = next;
+		}
+	}
+
+	void PhysicsDebugDraw::DrawSolidCircle(const b2Vec2& center, float32 radius, const b2Vec2& axis, const b2Color& color) {
+		this->DrawCircle(center, radius, color);
+		this->addLine(center, center + radius * axis, color);
+	}
+
+	void PhysicsDebugDraw::DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color) {
+		this->addLine(p1, p2, color);
+	}
+
+	void PhysicsDebugDraw::DrawTransform(const b2Transform& xf) {
+		this->addLine(xf.position, xf.position + PHYSICS_DEBUGDRAW_AXIS_LENGTH * xf.R.col1, b2Color(1, 0, 0));
+		this->addLine(xf.position, xf.position + PHYSICS_DEBUGDRAW_AXIS_LENGTH * xf.R.col2, b2Color(0, 1, 0));
+	}
+
+	/*
+	 * draw world contact points as small crosses
+	 */
+	void PhysicsDebugDraw::drawContacts() {
+		const b2Color color(1.0f, 0.9f, 0.2f);
+		const float32 size = 4.0f / this->scale;
+		for (b2Contact* c = this->world->GetContactList(); c; c = c->GetNext()) {
+			if (!c->IsTouching()) continue;
+
+			b2WorldManifold manifold;
+			c->GetWorldManifold(&manifold);
+
+			int32 pointCount = c->GetManifold()->pointCount;
+			for (int32 i = 0; i < pointCount; i++) {
+				const b2Vec2& p = manifold.points[i];
+				this->addLine(b2Vec2(p.x - size, p.y), b2Vec2(p.x + size, p.y), color);
+				this->addLine(b2Vec2(p.x, p.y - size), b2Vec2(p.x, p.y + size), color);
+			}
+		}
+	}
+
+	/*
+	 * build the vertex stream from the world and draw it in one pass.
+	 * this is called after all drawables are rendered.
+	 */
+	void PhysicsDebugDraw::onDrawFrame() {
+		timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		this->vertices.clear();
+		this->world->DrawDebugData();
+		if (this->GetFlags() & PHYSICS_DEBUGDRAW_CONTACT) {
+			this->drawContacts();
+		}
+		this->vertexCount = this->vertices.size();
+
+		if (this->vertexCount > 0) {
+			if (this->vbo == 0) {
+				glGenBuffers(1, &this->vbo);
+			}
+
+			glMatrixMode(GL_MODELVIEW);
+			glLoadIdentity();
+			glScalef(this->scale, this->scale, 1);
+
+			glDisable(GL_TEXTURE_2D);
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+			glEnableClientState(GL_COLOR_ARRAY);
+			glLineWidth(this->lineWidth);
+
+			// GLES 1.x has no stream usage hint: respecify the whole store every frame
+			glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(PhysicsDebugVertex) * this->vertexCount,
+					&this->vertices[0], GL_DYNAMIC_DRAW);
+
+			glVertexPointer(2, GL_FLOAT, sizeof(PhysicsDebugVertex), 0);
+			glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(PhysicsDebugVertex),
+					(GLvoid*)(2 * sizeof(GLfloat)));
+			glDrawArrays(GL_LINES, 0, this->vertexCount);
+
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glDisableClientState(GL_COLOR_ARRAY);
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			glEnable(GL_TEXTURE_2D);
+			glColor4f(1, 1, 1, 1);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		this->drawTime = elapsedMillis(start, end);
+	}
+
+	/*
+	 * delete the vertex buffer (called when the GL context is lost)
+	 */
+	void PhysicsDebugDraw::deleteBuffer() {
+		if (this->vbo != 0) {
+			glDeleteBuffers(1, &this->vbo);
+			this->vbo = 0;
+		}
+	}
+}
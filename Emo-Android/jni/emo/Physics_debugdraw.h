@@ -0,0 +1,84 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_PHYSICS_DEBUGDRAW_H
+#define EMO_PHYSICS_DEBUGDRAW_H
+
+#include <vector>
+#include <GLES/gl.h>
+#include "Box2D/Box2D.h"
+
+#define PHYSICS_DEBUGDRAW_CIRCLE_SEGMENTS 16
+#define PHYSICS_DEBUGDRAW_AXIS_LENGTH     0.4f
+
+namespace emo {
+	/*
+	 * interleaved line vertex (position in meters and color)
+	 */
+	struct PhysicsDebugVertex {
+		GLfloat x;
+		GLfloat y;
+		GLubyte r;
+		GLubyte g;
+		GLubyte b;
+		GLubyte a;
+	};
+
+	/*
+	 * Box2D debug renderer that collects every primitive of a step
+	 * into one vertex stream and draws it with a single GL_LINES call
+	 */
+	class PhysicsDebugDraw : public b2DebugDraw {
+	public:
+		PhysicsDebugDraw(b2World* world);
+		virtual ~PhysicsDebugDraw();
+
+		virtual void DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color);
+		virtual void DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color);
+		virtual void DrawCircle(const b2Vec2& center, float32 radius, const b2Color& color);
+		virtual void DrawSolidCircle(const b2Vec2& center, float32 radius, const b2Vec2& axis, const b2Color& color);
+		virtual void DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color);
+		virtual void DrawTransform(const b2Transform& xf);
+
+		void onDrawFrame();
+		void deleteBuffer();
+
+		b2World* world;
+		float scale;
+		float lineWidth;
+
+		int vertexCount;
+		float drawTime;
+	protected:
+		GLuint vbo;
+		std::vector<PhysicsDebugVertex> vertices;
+
+		void addLine(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color);
+		void drawContacts();
+	};
+}
+#endif
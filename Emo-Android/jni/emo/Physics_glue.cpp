@@ -34,22 +34,65 @@
 #include "stdio.h"
 #include "Physics_util.h"
 #include "Physics_contact.h"
+#include "Physics_snapshot.h"
+#include "Physics_debugdraw.h"
+#include "Physics_profiler.h"
+#include "Engine.h"
+#include "sqstdblob.h"
+
+extern emo::Engine* engine;
 
 extern void LOGI(const char* msg);
 extern void LOGW(const char* msg);
 extern void LOGE(const char* msg);
 
-emo::EmoPhysicsContactListener* emoPhysicsContactListener = NULL;	
+emo::EmoPhysicsContactListener* emoPhysicsContactListener = NULL;
+emo::PhysicsProfiler* emoPhysicsProfiler = NULL;
+
+/*
+ * released world kept for reuse, so a level restart gets the
+ * allocator memory of the previous world back
+ */
+b2World* emoPhysicsWorldPool = NULL;	
 
 static SQInteger b2WorldReleaseHook(SQUserPointer ptr, SQInteger size) {
+	b2World* world = reinterpret_cast<b2World*>(ptr);
+	// the world ends its remaining contacts through the listener
+	// when it is cleared, so detach the listener before deleting it
+	world->SetContactListener(NULL);
 	if (emoPhysicsContactListener != NULL) {
 		delete emoPhysicsContactListener;
 		emoPhysicsContactListener = NULL;
 	}
-	delete reinterpret_cast<b2World*>(ptr);
+	if (emoPhysicsProfiler != NULL && emoPhysicsProfiler->world == ptr) {
+		delete emoPhysicsProfiler;
+		emoPhysicsProfiler = NULL;
+	}
+	if (engine->physicsDebugDraw != NULL && engine->physicsDebugDraw->world == ptr) {
+		delete engine->physicsDebugDraw;
+		engine->physicsDebugDraw = NULL;
+	}
+	// only worlds with the default chunk size are pooled, and only
+	// when every allocator block has been freed
+	if (emoPhysicsWorldPool == NULL &&
+			world->GetAllocatorStats().chunkSize == b2_chunkSize && world->Clear()) {
+		emoPhysicsWorldPool = world;
+	} else {
+		delete world;
+	}
 	return 0;
 }
 
+/*
+ * delete the pooled world (called when the engine is disposed)
+ */
+void clearPhysicsWorldPool() {
+	if (emoPhysicsWorldPool != NULL) {
+		delete emoPhysicsWorldPool;
+		emoPhysicsWorldPool = NULL;
+	}
+}
+
 static SQInteger b2ShapeReleaseHook(SQUserPointer ptr, SQInteger size) {
 	delete reinterpret_cast<b2Shape*>(ptr);
 	return 0;
@@ -59,12 +102,19 @@ static SQInteger b2JointDefReleaseHook(SQUserPointer ptr, SQInteger size) {
 	delete reinterpret_cast<b2JointDef*>(ptr);
 	return 0;
 }
+
+static SQInteger physicsSnapshotReleaseHook(SQUserPointer ptr, SQInteger size) {
+	delete reinterpret_cast<emo::PhysicsSnapshot*>(ptr);
+	return 0;
+}
 	
 /*
  * create new physics world
  *
  * @param gravity (vec2 instance)
  * @param sleep objects or not
+ * @param stack allocator size in bytes (optional)
+ * @param block allocator chunk size in bytes (optional)
  * @return b2World instance
  */
 SQInteger emoPhysicsNewWorld(HSQUIRRELVM v) {
@@ -77,7 +127,32 @@ SQInteger emoPhysicsNewWorld(HSQUIRRELVM v) {
 	SQBool doSleep = true;
 	getBool(v, 3, &doSleep);
 	
-	b2World* world = new b2World(gravity, doSleep);
+	SQInteger stackSize = 0;
+	if (sq_gettop(v) >= 4 && sq_gettype(v, 4) == OT_INTEGER) {
+		sq_getinteger(v, 4, &stackSize);
+	}
+	SQInteger chunkSize = 0;
+	if (sq_gettop(v) >= 5 && sq_gettype(v, 5) == OT_INTEGER) {
+		sq_getinteger(v, 5, &chunkSize);
+	}
+	if (stackSize < 0 || (chunkSize != 0 && chunkSize < b2_maxBlockSize)) {
+		return 0;
+	}
+	
+	b2World* world = NULL;
+	if (emoPhysicsWorldPool != NULL && (chunkSize == 0 || chunkSize == b2_chunkSize)) {
+		// Clear() already reset the flags and callbacks of the pooled world
+		world = emoPhysicsWorldPool;
+		world->SetGravity(gravity);
+		world->SetAllowSleeping(doSleep);
+		world->SetStackSize(stackSize > 0 ? stackSize : b2_stackSize);
+		emoPhysicsWorldPool = NULL;
+	}
+	if (world == NULL) {
+		world = new b2World(gravity, doSleep);
+		if (chunkSize > 0) world->SetChunkSize(chunkSize);
+	}
+	if (stackSize > 0) world->SetStackSize(stackSize);
 	
 	SQInteger result = createSQObject(v, 
 				"emo", "Instance", world, b2WorldReleaseHook);
@@ -309,6 +384,12 @@ SQInteger emoPhysicsWorld_Step(HSQUIRRELVM v) {
 	
 	world->Step(timeStep, velocityIter, positionIter);
 	
+#ifdef B2_PROFILE
+	if (emoPhysicsProfiler != NULL && emoPhysicsProfiler->world == world) {
+		emoPhysicsProfiler->onStep();
+	}
+#endif
+	
 	sq_pushinteger(v, EMO_NO_ERROR);
 	return 1;
 }
@@ -2832,3 +2913,641 @@ SQInteger emoPhysicsInitWeldJointDef(HSQUIRRELVM v) {
 	sq_pushinteger(v, EMO_NO_ERROR);
 	return 1;
 }
+
+/*
+ * push restored objects as a new table slot
+ */
+static void pushSnapshotIds(HSQUIRRELVM v, const char* name, std::vector<emo::PhysicsSnapshotId>& ids) {
+	sq_pushstring(v, name, -1);
+	sq_newarray(v, 0);
+	for (unsigned int i = 0; i < ids.size(); i++) {
+		sq_pushuserpointer(v, ids[i].object);
+		sq_arrayappend(v, -2);
+	}
+	sq_newslot(v, -3, SQFalse);
+}
+
+/*
+ * map old ids in the snapshot to restored objects
+ */
+static void pushSnapshotIdMap(HSQUIRRELVM v, std::vector<emo::PhysicsSnapshotId>& ids) {
+	for (unsigned int i = 0; i < ids.size(); i++) {
+		sq_pushuserpointer(v, (SQUserPointer)(size_t)ids[i].oldId);
+		sq_pushuserpointer(v, ids[i].object);
+		sq_newslot(v, -3, SQFalse);
+	}
+}
+
+/*
+ * take a snapshot of the physics world
+ *
+ * @param physics world instance
+ * @return snapshot instance
+ */
+SQInteger emoPhysicsWorld_Snapshot(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE) {
+		return 0;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	emo::PhysicsSnapshot* snapshot = new emo::PhysicsSnapshot();
+	snapshot->save(world);
+	
+	SQInteger result = createSQObject(v, 
+				"emo", "Instance", snapshot, physicsSnapshotReleaseHook);
+	if (result == 0) {
+		delete snapshot;
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * restore the physics world from the snapshot
+ * all bodies and joints in the world are destroyed before restore
+ * unless third parameter equals false.
+ *
+ * returned table contains restored bodies, fixtures and joints
+ * in snapshot order and "ids" table that maps
+ * the id at the time of snapshot to the restored one.
+ *
+ * @param physics world instance
+ * @param snapshot instance
+ * @param clear the world or not
+ * @return table of restored objects
+ */
+SQInteger emoPhysicsWorld_Restore(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE || sq_gettype(v, 3) != OT_INSTANCE) {
+		return 0;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	emo::PhysicsSnapshot* snapshot = NULL;
+	sq_getinstanceup(v, 3, (SQUserPointer*)&snapshot, 0);
+	
+	SQBool clear = true;
+	getBool(v, 4, &clear);
+	
+	if (!snapshot->restore(world, clear)) {
+		return 0;
+	}
+	
+	sq_newtable(v);
+	pushSnapshotIds(v, "bodies",   snapshot->bodies);
+	pushSnapshotIds(v, "fixtures", snapshot->fixtures);
+	pushSnapshotIds(v, "joints",   snapshot->joints);
+	
+	sq_pushstring(v, "ids", -1);
+	sq_newtable(v);
+	pushSnapshotIdMap(v, snapshot->bodies);
+	pushSnapshotIdMap(v, snapshot->fixtures);
+	pushSnapshotIdMap(v, snapshot->joints);
+	sq_newslot(v, -3, SQFalse);
+	
+	return 1;
+}
+
+/*
+ * save the snapshot to the document directory
+ *
+ * @param snapshot instance
+ * @param file name
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoPhysicsSnapshot_Save(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE || sq_gettype(v, 3) != OT_STRING) {
+		sq_pushinteger(v, ERR_INVALID_PARAM);
+		return 1;
+	}
+	emo::PhysicsSnapshot* snapshot = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&snapshot, 0);
+	
+	const SQChar* name;
+	sq_tostring(v, 3);
+	sq_getstring(v, -1, &name);
+	sq_poptop(v);
+	
+	if (!snapshot->saveToFile(engine->javaGlue->getDataFilePath(name))) {
+		sq_pushinteger(v, ERR_FILE_OPEN);
+		return 1;
+	}
+	
+	sq_pushinteger(v, EMO_NO_ERROR);
+	return 1;
+}
+
+/*
+ * load the snapshot from asset or document directory
+ *
+ * @param file name
+ * @param TYPE_ASSET or TYPE_DOCUMENT
+ * @return snapshot instance
+ */
+SQInteger emoPhysicsSnapshot_Load(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_STRING) {
+		return 0;
+	}
+	const SQChar* name;
+	sq_tostring(v, 2);
+	sq_getstring(v, -1, &name);
+	sq_poptop(v);
+	
+	SQInteger type = TYPE_ASSET;
+	if (sq_gettop(v) > 2 && sq_gettype(v, 3) == OT_INTEGER) {
+		sq_getinteger(v, 3, &type);
+	}
+	
+	emo::PhysicsSnapshot* snapshot = new emo::PhysicsSnapshot();
+	bool loaded = false;
+	
+	if (type == TYPE_DOCUMENT) {
+		loaded = snapshot->loadFromFile(engine->javaGlue->getDataFilePath(name));
+	} else {
+		emo::AssetView* view = engine->assets->acquire(name);
+		if (view != NULL) {
+			if (view->length > 0) {
+				loaded = snapshot->loadFromBytes(view->data, view->length);
+			}
+			engine->assets->release(view);
+		}
+	}
+	
+	if (!loaded) {
+		LOGW("emoPhysicsSnapshot_Load: failed to load snapshot");
+		LOGW(name);
+		delete snapshot;
+		return 0;
+	}
+	
+	SQInteger result = createSQObject(v, 
+				"emo", "Instance", snapshot, physicsSnapshotReleaseHook);
+	if (result == 0) {
+		delete snapshot;
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * returns size of the snapshot in bytes
+ *
+ * @param snapshot instance
+ * @return size of the snapshot
+ */
+SQInteger emoPhysicsSnapshot_Size(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE) {
+		sq_pushinteger(v, 0);
+		return 1;
+	}
+	emo::PhysicsSnapshot* snapshot = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&snapshot, 0);
+	
+	sq_pushinteger(v, snapshot->data.size());
+	return 1;
+}
+
+/*
+ * create physics bodies and fixtures at once from packed data
+ *
+ * packed data is a blob of float records (PHYSICS_BATCH_STRIDE values per body:
+ * type, x, y, angle, shape, hx or radius, hy, density, friction, restitution)
+ * or a table of arrays that has an array for each property:
+ * x, y, type, angle, shape, hx, hy, radius, density, friction, restitution,
+ * isSensor, linearDamping, angularDamping, fixedRotation, bullet, allowSleep, awake,
+ * categoryBits, maskBits, groupIndex and sprite.
+ * a single value instead of an array applies to all bodies.
+ * if sprite column (array of drawable ids) exists, position, angle and
+ * size of the body are taken from the drawable unless specified.
+ *
+ * @param physics world instance
+ * @param blob or table of arrays
+ * @param pixel to meter ratio for sprite column
+ * @return table of created bodies and fixtures
+ */
+SQInteger emoPhysicsCreateBodies(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE) {
+		return 0;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	if (world->IsLocked()) {
+		LOGE("emoPhysicsCreateBodies: world is locked");
+		return 0;
+	}
+	
+	SQFloat scale = 1;
+	if (sq_gettop(v) > 3 && (sq_gettype(v, 4) == OT_FLOAT || sq_gettype(v, 4) == OT_INTEGER)) {
+		sq_getfloat(v, 4, &scale);
+		if (scale <= 0) scale = 1;
+	}
+	
+	std::vector<float> types, xs, ys, angles, shapes, hxs, hys, radiuses;
+	std::vector<float> densities, frictions, restitutions, sensors;
+	std::vector<float> linearDampings, angularDampings, fixedRotations, bullets, allowSleeps, awakes;
+	std::vector<float> categories, masks, groups;
+	std::vector<std::string> sprites;
+	bool hasSprites = false;
+	SQInteger count = 0;
+	
+	if (sq_gettype(v, 3) == OT_INSTANCE) {
+		SQUserPointer records = NULL;
+		if (SQ_FAILED(sqstd_getblob(v, 3, &records))) {
+			return 0;
+		}
+		count = sqstd_getblobsize(v, 3) / (sizeof(float) * PHYSICS_BATCH_STRIDE);
+		
+		types.resize(count); xs.resize(count); ys.resize(count); angles.resize(count);
+		shapes.resize(count); hxs.resize(count); hys.resize(count);
+		densities.resize(count); frictions.resize(count); restitutions.resize(count);
+		for (SQInteger i = 0; i < count; i++) {
+			const float* record = (const float*)records + i * PHYSICS_BATCH_STRIDE;
+			types[i]        = record[0];
+			xs[i]           = record[1];
+			ys[i]           = record[2];
+			angles[i]       = record[3];
+			shapes[i]       = record[4];
+			hxs[i]          = record[5];
+			hys[i]          = record[6];
+			densities[i]    = record[7];
+			frictions[i]    = record[8];
+			restitutions[i] = record[9];
+		}
+		radiuses = hxs;
+		sensors.assign(count, 0);
+		linearDampings.assign(count, 0);
+		angularDampings.assign(count, 0);
+		fixedRotations.assign(count, 0);
+		bullets.assign(count, 0);
+		allowSleeps.assign(count, 1);
+		awakes.assign(count, 1);
+		categories.assign(count, 0x0001);
+		masks.assign(count, 0xFFFF);
+		groups.assign(count, 0);
+	} else if (sq_gettype(v, 3) == OT_TABLE) {
+		count = getColumnSize(v, 3, "x");
+		if (count < 0) count = getColumnSize(v, 3, "sprite");
+		if (count < 0) return 0;
+		
+		hasSprites = getStringColumn(v, 3, "sprite", sprites, count);
+		
+		getFloatColumn(v, 3, "x",           xs,           count, 0);
+		getFloatColumn(v, 3, "y",           ys,           count, 0);
+		getFloatColumn(v, 3, "type",        types,        count, PHYSICS_BODY_STATIC);
+		getFloatColumn(v, 3, "angle",       angles,       count, 0);
+		getFloatColumn(v, 3, "shape",       shapes,       count, PHYSICS_SHAPE_POLYGON);
+		getFloatColumn(v, 3, "hx",          hxs,          count, 0);
+		getFloatColumn(v, 3, "hy",          hys,          count, 0);
+		getFloatColumn(v, 3, "radius",      radiuses,     count, 0);
+		getFloatColumn(v, 3, "density",     densities,    count, 0);
+		getFloatColumn(v, 3, "friction",    frictions,    count, 0.2f);
+		getFloatColumn(v, 3, "restitution", restitutions, count, 0);
+		getFloatColumn(v, 3, "isSensor",    sensors,      count, 0);
+		getFloatColumn(v, 3, "linearDamping",  linearDampings,  count, 0);
+		getFloatColumn(v, 3, "angularDamping", angularDampings, count, 0);
+		getFloatColumn(v, 3, "fixedRotation",  fixedRotations,  count, 0);
+		getFloatColumn(v, 3, "bullet",         bullets,         count, 0);
+		getFloatColumn(v, 3, "allowSleep",     allowSleeps,     count, 1);
+		getFloatColumn(v, 3, "awake",          awakes,          count, 1);
+		getFloatColumn(v, 3, "categoryBits",   categories,      count, 0x0001);
+		getFloatColumn(v, 3, "maskBits",       masks,           count, 0xFFFF);
+		getFloatColumn(v, 3, "groupIndex",     groups,          count, 0);
+		
+		if (hasSprites) {
+			bool hasX      = getColumnSize(v, 3, "x") >= 0;
+			bool hasAngle  = getColumnSize(v, 3, "angle")  >= 0;
+			bool hasSize   = getColumnSize(v, 3, "hx")     >= 0;
+			bool hasRadius = getColumnSize(v, 3, "radius") >= 0;
+			for (SQInteger i = 0; i < count; i++) {
+				emo::Drawable* drawable = engine->getDrawable(sprites[i]);
+				if (drawable == NULL) continue;
+				float halfWidth  = drawable->width  * 0.5f;
+				float halfHeight = drawable->height * 0.5f;
+				if (!hasX) {
+					xs[i] = (drawable->x + halfWidth)  / scale;
+					ys[i] = (drawable->y + halfHeight) / scale;
+				}
+				if (!hasAngle)  angles[i]   = drawable->param_rotate[0] * b2_pi / 180.0f;
+				if (!hasSize) {
+					hxs[i] = halfWidth  / scale;
+					hys[i] = halfHeight / scale;
+				}
+				if (!hasRadius) radiuses[i] = halfWidth / scale;
+			}
+		} else {
+			for (SQInteger i = 0; i < count; i++) {
+				if (radiuses[i] == 0) radiuses[i] = hxs[i];
+			}
+		}
+	} else {
+		return 0;
+	}
+	
+	world->ReserveBlocks(sizeof(b2Body),    count);
+	world->ReserveBlocks(sizeof(b2Fixture), count);
+	world->ReserveBlocks(sizeof(b2PolygonShape), count);
+	
+	b2PolygonShape polygon;
+	b2CircleShape  circle;
+	
+	sq_newtable(v);
+	
+	sq_pushstring(v, "bodies", -1);
+	sq_newarray(v, 0);
+	sq_pushstring(v, "fixtures", -1);
+	sq_newarray(v, 0);
+	
+	for (SQInteger i = 0; i < count; i++) {
+		b2BodyDef bodyDef;
+		switch ((int)types[i]) {
+			case PHYSICS_BODY_KINEMATIC:
+				bodyDef.type = b2_kinematicBody;
+				break;
+			case PHYSICS_BODY_DYNAMIC:
+				bodyDef.type = b2_dynamicBody;
+				break;
+			default:
+				bodyDef.type = b2_staticBody;
+				break;
+		}
+		bodyDef.position.Set(xs[i], ys[i]);
+		bodyDef.angle          = angles[i];
+		bodyDef.linearDamping  = linearDampings[i];
+		bodyDef.angularDamping = angularDampings[i];
+		bodyDef.fixedRotation  = fixedRotations[i] != 0;
+		bodyDef.bullet         = bullets[i] != 0;
+		bodyDef.allowSleep     = allowSleeps[i] != 0;
+		bodyDef.awake          = awakes[i] != 0;
+		
+		b2FixtureDef fixtureDef;
+		if ((int)shapes[i] == PHYSICS_SHAPE_CIRCLE) {
+			circle.m_radius = radiuses[i];
+			fixtureDef.shape = &circle;
+		} else {
+			polygon.SetAsBox(hxs[i], hys[i]);
+			fixtureDef.shape = &polygon;
+		}
+		fixtureDef.density     = densities[i];
+		fixtureDef.friction    = frictions[i];
+		fixtureDef.restitution = restitutions[i];
+		fixtureDef.isSensor    = sensors[i] != 0;
+		fixtureDef.filter.categoryBits = (uint16)categories[i];
+		fixtureDef.filter.maskBits     = (uint16)masks[i];
+		fixtureDef.filter.groupIndex   = (int16)groups[i];
+		
+		b2Body* body = world->CreateBody(&bodyDef);
+		b2Fixture* fixture = body->CreateFixture(&fixtureDef);
+		
+		sq_pushuserpointer(v, body);
+		sq_arrayappend(v, -4);
+		sq_pushuserpointer(v, fixture);
+		sq_arrayappend(v, -2);
+	}
+	
+	sq_newslot(v, -5, SQFalse);
+	sq_newslot(v, -3, SQFalse);
+	
+	return 1;
+}
+
+/*
+ * enable debug drawing of the physics world
+ * only one world can be drawn at a time.
+ *
+ * @param physics world instance
+ * @param debug draw flags (PHYSICS_DEBUGDRAW_*)
+ * @param pixels per meter
+ * @param line width (optional)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoPhysicsWorld_EnableDebugDraw(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE || sq_gettype(v, 3) != OT_INTEGER) {
+		sq_pushinteger(v, ERR_INVALID_PARAM);
+		return 1;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	SQInteger flags;
+	sq_getinteger(v, 3, &flags);
+	
+	SQFloat scale = 1;
+	if (sq_gettop(v) >= 4 && sq_gettype(v, 4) != OT_NULL) {
+		sq_getfloat(v, 4, &scale);
+	}
+	
+	if (engine->physicsDebugDraw != NULL && engine->physicsDebugDraw->world != world) {
+		engine->physicsDebugDraw->world->SetDebugDraw(NULL);
+		delete engine->physicsDebugDraw;
+		engine->physicsDebugDraw = NULL;
+	}
+	if (engine->physicsDebugDraw == NULL) {
+		engine->physicsDebugDraw = new emo::PhysicsDebugDraw(world);
+		world->SetDebugDraw(engine->physicsDebugDraw);
+	}
+	
+	emo::PhysicsDebugDraw* debugDraw = engine->physicsDebugDraw;
+	debugDraw->SetFlags(flags);
+	debugDraw->scale = scale;
+	
+	if (sq_gettop(v) >= 5 && sq_gettype(v, 5) != OT_NULL) {
+		SQFloat lineWidth;
+		sq_getfloat(v, 5, &lineWidth);
+		debugDraw->lineWidth = lineWidth;
+	}
+	
+	sq_pushinteger(v, EMO_NO_ERROR);
+	return 1;
+}
+
+/*
+ * disable debug drawing of the physics world
+ *
+ * @param physics world instance
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoPhysicsWorld_DisableDebugDraw(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE) {
+		sq_pushinteger(v, ERR_INVALID_PARAM);
+		return 1;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	if (engine->physicsDebugDraw != NULL && engine->physicsDebugDraw->world == world) {
+		world->SetDebugDraw(NULL);
+		delete engine->physicsDebugDraw;
+		engine->physicsDebugDraw = NULL;
+	}
+	
+	sq_pushinteger(v, EMO_NO_ERROR);
+	return 1;
+}
+
+/*
+ * returns debug draw statistics of the last frame
+ *
+ * @param physics world instance
+ * @return [vertex count, build and draw time in milliseconds]
+ */
+SQInteger emoPhysicsWorld_GetDebugDrawStats(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE) {
+		return 0;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	emo::PhysicsDebugDraw* debugDraw = engine->physicsDebugDraw;
+	if (debugDraw == NULL || debugDraw->world != world) {
+		return 0;
+	}
+	
+	sq_newarray(v, 0);
+	sq_pushinteger(v, debugDraw->vertexCount);
+	sq_arrayappend(v, -2);
+	sq_pushfloat(v, debugDraw->drawTime);
+	sq_arrayappend(v, -2);
+	return 1;
+}
+
+/*
+ * enable step profiler of the physics world
+ * only one world can be profiled at a time.
+ *
+ * @param physics world instance
+ * @param log mode (PHYSICS_PROFILE_LOG_*)
+ * @param number of steps of rolling average (optional)
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoPhysicsWorld_EnableProfiler(HSQUIRRELVM v) {
+#ifdef B2_PROFILE
+	if (sq_gettype(v, 2) != OT_INSTANCE) {
+		sq_pushinteger(v, ERR_INVALID_PARAM);
+		return 1;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	SQInteger logMode = PHYSICS_PROFILE_LOG_NONE;
+	if (sq_gettop(v) >= 3 && sq_gettype(v, 3) == OT_INTEGER) {
+		sq_getinteger(v, 3, &logMode);
+	}
+	SQInteger window = PHYSICS_PROFILE_DEFAULT_WINDOW;
+	if (sq_gettop(v) >= 4 && sq_gettype(v, 4) == OT_INTEGER) {
+		sq_getinteger(v, 4, &window);
+	}
+	
+	if (emoPhysicsProfiler != NULL) {
+		delete emoPhysicsProfiler;
+	}
+	emoPhysicsProfiler = new emo::PhysicsProfiler(world, window);
+	emoPhysicsProfiler->logMode = logMode;
+	
+	sq_pushinteger(v, EMO_NO_ERROR);
+#else
+	sq_pushinteger(v, ERR_NOT_SUPPORTED);
+#endif
+	return 1;
+}
+
+/*
+ * disable step profiler of the physics world
+ *
+ * @param physics world instance
+ * @return EMO_NO_ERROR if succeeds
+ */
+SQInteger emoPhysicsWorld_DisableProfiler(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE) {
+		sq_pushinteger(v, ERR_INVALID_PARAM);
+		return 1;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	if (emoPhysicsProfiler != NULL && emoPhysicsProfiler->world == world) {
+		delete emoPhysicsProfiler;
+		emoPhysicsProfiler = NULL;
+	}
+	
+	sq_pushinteger(v, EMO_NO_ERROR);
+	return 1;
+}
+
+/*
+ * returns the step profile of the physics world
+ * times are in milliseconds.
+ *
+ * @param physics world instance
+ * @param true to return the rolling average of the profiler (optional)
+ * @return profile table or null if profiling is not available
+ */
+SQInteger emoPhysicsWorld_GetProfile(HSQUIRRELVM v) {
+#ifdef B2_PROFILE
+	if (sq_gettype(v, 2) != OT_INSTANCE) {
+		return 0;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	SQBool average = false;
+	if (sq_gettop(v) >= 3 && sq_gettype(v, 3) == OT_BOOL) {
+		sq_getbool(v, 3, &average);
+	}
+	
+	b2Profile profile;
+	if (average) {
+		if (emoPhysicsProfiler == NULL || emoPhysicsProfiler->world != world) {
+			return 0;
+		}
+		profile = emoPhysicsProfiler->getAverage();
+	} else {
+		profile = world->GetProfile();
+	}
+	
+	sq_newtable(v);
+	newSlotFloat(v, "step",            profile.step);
+	newSlotFloat(v, "collide",         profile.collide);
+	newSlotFloat(v, "findNewContacts", profile.findNewContacts);
+	newSlotFloat(v, "solve",           profile.solve);
+	newSlotFloat(v, "solveTOI",        profile.solveTOI);
+	newSlotFloat(v, "listener",        profile.listener);
+	newSlotInteger(v, "bodyCount",      profile.bodyCount);
+	newSlotInteger(v, "awakeBodyCount", profile.awakeBodyCount);
+	newSlotInteger(v, "contactCount",   profile.contactCount);
+	newSlotInteger(v, "islandCount",    profile.islandCount);
+	newSlotInteger(v, "toiCount",       profile.toiCount);
+	newSlotInteger(v, "proxyCount",     profile.proxyCount);
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * returns memory statistics of the physics world allocators
+ *
+ * @param physics world instance
+ * @return allocator statistics table
+ */
+SQInteger emoPhysicsWorld_GetAllocatorStats(HSQUIRRELVM v) {
+	if (sq_gettype(v, 2) != OT_INSTANCE) {
+		return 0;
+	}
+	b2World* world = NULL;
+	sq_getinstanceup(v, 2, (SQUserPointer*)&world, 0);
+	
+	b2AllocatorStats stats = world->GetAllocatorStats();
+	
+	sq_newtable(v);
+	newSlotInteger(v, "chunkSize",          stats.chunkSize);
+	newSlotInteger(v, "chunkCount",         stats.chunkCount);
+	newSlotInteger(v, "blockCount",         stats.blockCount);
+	newSlotInteger(v, "blockBytes",         stats.blockBytes);
+	newSlotInteger(v, "maxBlockBytes",      stats.maxBlockBytes);
+	newSlotInteger(v, "stackSize",          stats.stackSize);
+	newSlotInteger(v, "maxStackAllocation", stats.maxStackAllocation);
+	newSlotInteger(v, "stackOverflowCount", stats.stackOverflowCount);
+	return 1;
+}
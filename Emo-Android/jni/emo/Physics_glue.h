@@ -136,3 +136,16 @@ SQInteger emoPhysicsInitPrismaticJointDef(HSQUIRRELVM v);
 SQInteger emoPhysicsInitPulleyJointDef(HSQUIRRELVM v);
 SQInteger emoPhysicsInitRevoluteJointDef(HSQUIRRELVM v);
 SQInteger emoPhysicsInitWeldJointDef(HSQUIRRELVM v);
+SQInteger emoPhysicsWorld_Snapshot(HSQUIRRELVM v);
+SQInteger emoPhysicsWorld_Restore(HSQUIRRELVM v);
+SQInteger emoPhysicsSnapshot_Save(HSQUIRRELVM v);
+SQInteger emoPhysicsSnapshot_Load(HSQUIRRELVM v);
+SQInteger emoPhysicsSnapshot_Size(HSQUIRRELVM v);
+SQInteger emoPhysicsCreateBodies(HSQUIRRELVM v);
+SQInteger emoPhysicsWorld_EnableDebugDraw(HSQUIRRELVM v);
+SQInteger emoPhysicsWorld_DisableDebugDraw(HSQUIRRELVM v);
+SQInteger emoPhysicsWorld_GetDebugDrawStats(HSQUIRRELVM v);
+SQInteger emoPhysicsWorld_EnableProfiler(HSQUIRRELVM v);
+SQInteger emoPhysicsWorld_DisableProfiler(HSQUIRRELVM v);
+SQInteger emoPhysicsWorld_GetProfile(HSQUIRRELVM v);
+SQInteger emoPhysicsWorld_GetAllocatorStats(HSQUIRRELVM v);
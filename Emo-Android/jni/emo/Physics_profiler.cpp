@@ -0,0 +1,125 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include <stdio.h>
+#include <string.h>
+#include "Constants.h"
+#include "Physics_profiler.h"
+
+extern void LOGI(const char* msg);
+
+namespace emo {
+	PhysicsProfiler::PhysicsProfiler(b2World* world, int window) {
+		this->world = world;
+		this->logMode = PHYSICS_PROFILE_LOG_NONE;
+		this->samples.resize(window > 0 ? window : PHYSICS_PROFILE_DEFAULT_WINDOW);
+		this->sampleIndex = 0;
+		this->sampleCount = 0;
+		this->stepCount   = 0;
+		memset(&this->total, 0, sizeof(b2Profile));
+	}
+
+	PhysicsProfiler::~PhysicsProfiler() {
+
+	}
+
+	void PhysicsProfiler::accumulate(const b2Profile& profile, int sign) {
+		this->total.step            += sign * profile.step;
+		this->total.collide         += sign * profile.collide;
+		this->total.findNewContacts += sign * profile.findNewContacts;
+		this->total.solve           += sign * profile.solve;
+		this->total.solveTOI        += sign * profile.solveTOI;
+		this->total.listener        += sign * profile.listener;
+		this->total.bodyCount       += sign * profile.bodyCount;
+		this->total.awakeBodyCount  += sign * profile.awakeBodyCount;
+		this->total.contactCount    += sign * profile.contactCount;
+		this->total.islandCount     += sign * profile.islandCount;
+		this->total.toiCount        += sign * profile.toiCount;
+		this->total.proxyCount      += sign * profile.proxyCount;
+	}
+
+	/*
+	 * called after each world step
+	 */
+	void PhysicsProfiler::onStep() {
+		const b2Profile& profile = this->world->GetProfile();
+		int window = this->samples.size();
+
+		if (this->sampleCount == window) {
+			this->accumulate(this->samples[this->sampleIndex], -1);
+		} else {
+			this->sampleCount++;
+		}
+		this->samples[this->sampleIndex] = profile;
+		this->accumulate(profile, 1);
+		this->sampleIndex = (this->sampleIndex + 1) % window;
+		this->stepCount++;
+
+		if (this->logMode == PHYSICS_PROFILE_LOG_STEP) {
+			this->log(profile, "step");
+		} else if (this->logMode == PHYSICS_PROFILE_LOG_AVERAGE && this->stepCount % window == 0) {
+			this->log(this->getAverage(), "average");
+		}
+	}
+
+	/*
+	 * returns the average profile of the recent steps.
+	 * counters are rounded down.
+	 */
+	b2Profile PhysicsProfiler::getAverage() {
+		b2Profile average;
+		memset(&average, 0, sizeof(b2Profile));
+		if (this->sampleCount == 0) return average;
+
+		float count = this->sampleCount;
+		average.step            = this->total.step            / count;
+		average.collide         = this->total.collide         / count;
+		average.findNewContacts = this->total.findNewContacts / count;
+		average.solve           = this->total.solve           / count;
+		average.solveTOI        = this->total.solveTOI        / count;
+		average.listener        = this->total.listener        / count;
+		average.bodyCount       = this->total.bodyCount       / this->sampleCount;
+		average.awakeBodyCount  = this->total.awakeBodyCount  / this->sampleCount;
+		average.contactCount    = this->total.contactCount    / this->sampleCount;
+		average.islandCount     = this->total.islandCount     / this->sampleCount;
+		average.toiCount        = this->total.toiCount        / this->sampleCount;
+		average.proxyCount      = this->total.proxyCount      / this->sampleCount;
+		return average;
+	}
+
+	void PhysicsProfiler::log(const b2Profile& profile, const char* label) {
+		char str[256];
+		snprintf(str, sizeof(str),
+			"physics %s: step=%.3fms collide=%.3fms findNewContacts=%.3fms solve=%.3fms solveTOI=%.3fms listener=%.3fms "
+			"bodies=%d awake=%d contacts=%d islands=%d toi=%d proxies=%d",
+			label, profile.step, profile.collide, profile.findNewContacts,
+			profile.solve, profile.solveTOI, profile.listener,
+			profile.bodyCount, profile.awakeBodyCount, profile.contactCount,
+			profile.islandCount, profile.toiCount, profile.proxyCount);
+		LOGI(str);
+	}
+}
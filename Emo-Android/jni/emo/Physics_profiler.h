@@ -0,0 +1,62 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_PHYSICS_PROFILER_H
+#define EMO_PHYSICS_PROFILER_H
+
+#include <vector>
+#include "Box2D/Box2D.h"
+
+#define PHYSICS_PROFILE_DEFAULT_WINDOW 60
+
+namespace emo {
+	/*
+	 * collects b2World step profiles into a rolling average
+	 * and optionally dumps them to the log
+	 */
+	class PhysicsProfiler {
+	public:
+		PhysicsProfiler(b2World* world, int window);
+		~PhysicsProfiler();
+
+		void onStep();
+		b2Profile getAverage();
+		void log(const b2Profile& profile, const char* label);
+
+		b2World* world;
+		int logMode;
+	protected:
+		std::vector<b2Profile> samples;
+		int sampleIndex;
+		int sampleCount;
+		int stepCount;
+		b2Profile total;
+
+		void accumulate(const b2Profile& profile, int sign);
+	};
+}
+#endif
@@ -0,0 +1,758 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#include <stdio.h>
+#include <string.h>
+
+#include "Physics_snapshot.h"
+
+extern void LOGI(const char* msg);
+extern void LOGW(const char* msg);
+extern void LOGE(const char* msg);
+
+namespace emo {
+
+	/*
+	 * snapshot records used while restoring
+	 */
+	struct SnapshotFixture {
+		uint64_t id;
+		b2FixtureDef def;
+		b2CircleShape circle;
+		b2PolygonShape polygon;
+		int32 shapeType;
+	};
+
+	struct SnapshotBody {
+		uint64_t id;
+		b2BodyDef def;
+		b2MassData massData;
+		int32 fixtureStart;
+		int32 fixtureCount;
+	};
+
+	struct SnapshotJoint {
+		uint64_t id;
+		int32 bodyA;
+		int32 bodyB;
+		int32 joint1;
+		int32 joint2;
+		b2JointDef* def;
+	};
+
+	/*
+	 * snapshot writer
+	 */
+	static void writeBytes(std::vector<unsigned char>& out, const void* value, int size) {
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(value);
+		out.insert(out.end(), bytes, bytes + size);
+	}
+
+	static void writeInt(std::vector<unsigned char>& out, int32 value) {
+		writeBytes(out, &value, sizeof(int32));
+	}
+
+	static void writeId(std::vector<unsigned char>& out, const void* ptr) {
+		uint64_t value = (uint64_t)(size_t)ptr;
+		writeBytes(out, &value, sizeof(uint64_t));
+	}
+
+	static void writeFloat(std::vector<unsigned char>& out, float32 value) {
+		writeBytes(out, &value, sizeof(float32));
+	}
+
+	static void writeBool(std::vector<unsigned char>& out, bool value) {
+		uint8 flag = value ? 1 : 0;
+		writeBytes(out, &flag, sizeof(uint8));
+	}
+
+	static void writeVec2(std::vector<unsigned char>& out, const b2Vec2& value) {
+		writeFloat(out, value.x);
+		writeFloat(out, value.y);
+	}
+
+	/*
+	 * snapshot reader; every read fails once the end of data is reached
+	 */
+	class SnapshotReader {
+	public:
+		SnapshotReader(const unsigned char* bytes, int length) {
+			this->bytes  = bytes;
+			this->length = length;
+			this->pos    = 0;
+			this->ok     = true;
+		}
+		bool readBytes(void* value, int size) {
+			if (!ok || pos + size > length) {
+				ok = false;
+				memset(value, 0, size);
+				return false;
+			}
+			memcpy(value, bytes + pos, size);
+			pos += size;
+			return true;
+		}
+		int32 readInt() {
+			int32 value;
+			readBytes(&value, sizeof(int32));
+			return value;
+		}
+		uint64_t readId() {
+			uint64_t value;
+			readBytes(&value, sizeof(uint64_t));
+			return value;
+		}
+		float32 readFloat() {
+			float32 value;
+			readBytes(&value, sizeof(float32));
+			return value;
+		}
+		bool readBool() {
+			uint8 value;
+			readBytes(&value, sizeof(uint8));
+			return value != 0;
+		}
+		b2Vec2 readVec2() {
+			b2Vec2 value;
+			value.x = readFloat();
+			value.y = readFloat();
+			return value;
+		}
+
+		const unsigned char* bytes;
+		int  length;
+		int  pos;
+		bool ok;
+	};
+
+	static int32 indexOfBody(std::vector<b2Body*>& bodies, b2Body* body) {
+		for (size_t i = 0; i < bodies.size(); i++) {
+			if (bodies[i] == body) return i;
+		}
+		return -1;
+	}
+
+	static int32 indexOfJoint(std::vector<b2Joint*>& joints, b2Joint* joint) {
+		for (size_t i = 0; i < joints.size(); i++) {
+			if (joints[i] == joint) return i;
+		}
+		return -1;
+	}
+
+	static void writeFixture(std::vector<unsigned char>& out, b2Fixture* fixture) {
+		writeId(out, fixture);
+		writeFloat(out, fixture->GetFriction());
+		writeFloat(out, fixture->GetRestitution());
+		writeFloat(out, fixture->GetDensity());
+		writeBool(out, fixture->IsSensor());
+
+		const b2Filter& filter = fixture->GetFilterData();
+		writeInt(out, filter.categoryBits);
+		writeInt(out, filter.maskBits);
+		writeInt(out, filter.groupIndex);
+
+		b2Shape* shape = fixture->GetShape();
+		writeInt(out, shape->GetType());
+		writeFloat(out, shape->m_radius);
+		if (shape->GetType() == b2Shape::e_circle) {
+			b2CircleShape* circle = reinterpret_cast<b2CircleShape*>(shape);
+			writeVec2(out, circle->m_p);
+		} else if (shape->GetType() == b2Shape::e_polygon) {
+			b2PolygonShape* polygon = reinterpret_cast<b2PolygonShape*>(shape);
+			writeVec2(out, polygon->m_centroid);
+			writeInt(out, polygon->m_vertexCount);
+			for (int32 i = 0; i < polygon->m_vertexCount; i++) {
+				writeVec2(out, polygon->m_vertices[i]);
+				writeVec2(out, polygon->m_normals[i]);
+			}
+		}
+	}
+
+	static void writeJoint(std::vector<unsigned char>& out, b2Joint* joint,
+							std::vector<b2Body*>& bodies, std::vector<b2Joint*>& joints) {
+		writeId(out, joint);
+		writeInt(out, joint->GetType());
+		writeInt(out, indexOfBody(bodies, joint->GetBodyA()));
+		writeInt(out, indexOfBody(bodies, joint->GetBodyB()));
+		writeBool(out, joint->GetCollideConnected());
+
+		switch (joint->GetType()) {
+		case e_distanceJoint: {
+			b2DistanceJoint* j = reinterpret_cast<b2DistanceJoint*>(joint);
+			writeVec2(out, j->GetLocalAnchorA());
+			writeVec2(out, j->GetLocalAnchorB());
+			writeFloat(out, j->GetLength());
+			writeFloat(out, j->GetFrequency());
+			writeFloat(out, j->GetDampingRatio());
+			break;
+		}
+		case e_frictionJoint: {
+			b2FrictionJoint* j = reinterpret_cast<b2FrictionJoint*>(joint);
+			writeVec2(out, j->GetLocalAnchorA());
+			writeVec2(out, j->GetLocalAnchorB());
+			writeFloat(out, j->GetMaxForce());
+			writeFloat(out, j->GetMaxTorque());
+			break;
+		}
+		case e_gearJoint: {
+			b2GearJoint* j = reinterpret_cast<b2GearJoint*>(joint);
+			writeInt(out, indexOfJoint(joints, j->GetJoint1()));
+			writeInt(out, indexOfJoint(joints, j->GetJoint2()));
+			writeFloat(out, j->GetRatio());
+			break;
+		}
+		case e_lineJoint: {
+			b2LineJoint* j = reinterpret_cast<b2LineJoint*>(joint);
+			writeVec2(out, j->GetLocalAnchorA());
+			writeVec2(out, j->GetLocalAnchorB());
+			writeVec2(out, j->GetLocalAxisA());
+			writeBool(out, j->IsLimitEnabled());
+			writeFloat(out, j->GetLowerLimit());
+			writeFloat(out, j->GetUpperLimit());
+			writeBool(out, j->IsMotorEnabled());
+			writeFloat(out, j->GetMaxMotorForce());
+			writeFloat(out, j->GetMotorSpeed());
+			break;
+		}
+		case e_prismaticJoint: {
+			b2PrismaticJoint* j = reinterpret_cast<b2PrismaticJoint*>(joint);
+			writeVec2(out, j->GetLocalAnchorA());
+			writeVec2(out, j->GetLocalAnchorB());
+			writeVec2(out, j->GetLocalAxisA());
+			writeFloat(out, j->GetReferenceAngle());
+			writeBool(out, j->IsLimitEnabled());
+			writeFloat(out, j->GetLowerLimit());
+			writeFloat(out, j->GetUpperLimit());
+			writeBool(out, j->IsMotorEnabled());
+			writeFloat(out, j->GetMaxMotorForce());
+			writeFloat(out, j->GetMotorSpeed());
+			break;
+		}
+		case e_pulleyJoint: {
+			b2PulleyJoint* j = reinterpret_cast<b2PulleyJoint*>(joint);
+			writeVec2(out, j->GetGroundAnchorA());
+			writeVec2(out, j->GetGroundAnchorB());
+			writeVec2(out, j->GetLocalAnchorA());
+			writeVec2(out, j->GetLocalAnchorB());
+			// the rest lengths only survive as the rope constant
+			writeFloat(out, j->GetConstant());
+			writeFloat(out, j->GetMaxLength1());
+			writeFloat(out, j->GetMaxLength2());
+			writeFloat(out, j->GetRatio());
+			break;
+		}
+		case e_revoluteJoint: {
+			b2RevoluteJoint* j = reinterpret_cast<b2RevoluteJoint*>(joint);
+			writeVec2(out, j->GetLocalAnchorA());
+			writeVec2(out, j->GetLocalAnchorB());
+			writeFloat(out, j->GetReferenceAngle());
+			writeBool(out, j->IsLimitEnabled());
+			writeFloat(out, j->GetLowerLimit());
+			writeFloat(out, j->GetUpperLimit());
+			writeBool(out, j->IsMotorEnabled());
+			writeFloat(out, j->GetMotorSpeed());
+			writeFloat(out, j->GetMaxMotorTorque());
+			break;
+		}
+		case e_weldJoint: {
+			b2WeldJoint* j = reinterpret_cast<b2WeldJoint*>(joint);
+			writeVec2(out, j->GetLocalAnchorA());
+			writeVec2(out, j->GetLocalAnchorB());
+			writeFloat(out, j->GetReferenceAngle());
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	static b2JointDef* readJointDef(SnapshotReader& in, int32 type, SnapshotJoint* record) {
+		switch (type) {
+		case e_distanceJoint: {
+			b2DistanceJointDef* def = new b2DistanceJointDef();
+			def->localAnchorA = in.readVec2();
+			def->localAnchorB = in.readVec2();
+			def->length       = in.readFloat();
+			def->frequencyHz  = in.readFloat();
+			def->dampingRatio = in.readFloat();
+			return def;
+		}
+		case e_frictionJoint: {
+			b2FrictionJointDef* def = new b2FrictionJointDef();
+			def->localAnchorA = in.readVec2();
+			def->localAnchorB = in.readVec2();
+			def->maxForce     = in.readFloat();
+			def->maxTorque    = in.readFloat();
+			return def;
+		}
+		case e_gearJoint: {
+			b2GearJointDef* def = new b2GearJointDef();
+			record->joint1 = in.readInt();
+			record->joint2 = in.readInt();
+			def->ratio     = in.readFloat();
+			return def;
+		}
+		case e_lineJoint: {
+			b2LineJointDef* def = new b2LineJointDef();
+			def->localAnchorA     = in.readVec2();
+			def->localAnchorB     = in.readVec2();
+			def->localAxisA       = in.readVec2();
+			def->enableLimit      = in.readBool();
+			def->lowerTranslation = in.readFloat();
+			def->upperTranslation = in.readFloat();
+			def->enableMotor      = in.readBool();
+			def->maxMotorForce    = in.readFloat();
+			def->motorSpeed       = in.readFloat();
+			return def;
+		}
+		case e_prismaticJoint: {
+			b2PrismaticJointDef* def = new b2PrismaticJointDef();
+			def->localAnchorA     = in.readVec2();
+			def->localAnchorB     = in.readVec2();
+			def->localAxis1       = in.readVec2();
+			def->referenceAngle   = in.readFloat();
+			def->enableLimit      = in.readBool();
+			def->lowerTranslation = in.readFloat();
+			def->upperTranslation = in.readFloat();
+			def->enableMotor      = in.readBool();
+			def->maxMotorForce    = in.readFloat();
+			def->motorSpeed       = in.readFloat();
+			return def;
+		}
+		case e_pulleyJoint: {
+			b2PulleyJointDef* def = new b2PulleyJointDef();
+			def->groundAnchorA = in.readVec2();
+			def->groundAnchorB = in.readVec2();
+			def->localAnchorA  = in.readVec2();
+			def->localAnchorB  = in.readVec2();
+			def->lengthA       = in.readFloat();
+			def->lengthB       = 0.0f;
+			def->maxLengthA    = in.readFloat();
+			def->maxLengthB    = in.readFloat();
+			def->ratio         = in.readFloat();
+			return def;
+		}
+		case e_revoluteJoint: {
+			b2RevoluteJointDef* def = new b2RevoluteJointDef();
+			def->localAnchorA   = in.readVec2();
+			def->localAnchorB   = in.readVec2();
+			def->referenceAngle = in.readFloat();
+			def->enableLimit    = in.readBool();
+			def->lowerAngle     = in.readFloat();
+			def->upperAngle     = in.readFloat();
+			def->enableMotor    = in.readBool();
+			def->motorSpeed     = in.readFloat();
+			def->maxMotorTorque = in.readFloat();
+			return def;
+		}
+		case e_weldJoint: {
+			b2WeldJointDef* def = new b2WeldJointDef();
+			def->localAnchorA   = in.readVec2();
+			def->localAnchorB   = in.readVec2();
+			def->referenceAngle = in.readFloat();
+			return def;
+		}
+		default:
+			return NULL;
+		}
+	}
+
+	static int32 jointSize(int32 type) {
+		switch (type) {
+		case e_distanceJoint:  return sizeof(b2DistanceJoint);
+		case e_frictionJoint:  return sizeof(b2FrictionJoint);
+		case e_gearJoint:      return sizeof(b2GearJoint);
+		case e_lineJoint:      return sizeof(b2LineJoint);
+		case e_prismaticJoint: return sizeof(b2PrismaticJoint);
+		case e_pulleyJoint:    return sizeof(b2PulleyJoint);
+		case e_revoluteJoint:  return sizeof(b2RevoluteJoint);
+		case e_weldJoint:      return sizeof(b2WeldJoint);
+		default:               return 0;
+		}
+	}
+
+	PhysicsSnapshot::PhysicsSnapshot() {
+
+	}
+
+	PhysicsSnapshot::~PhysicsSnapshot() {
+		this->data.clear();
+		this->bodies.clear();
+		this->fixtures.clear();
+		this->joints.clear();
+	}
+
+	/*
+	 * write the current state of the world into the snapshot.
+	 * bodies, fixtures and joints are written in creation order
+	 * so that the restored world steps the same way.
+	 * mouse joints are not saved because they only live while dragging.
+	 */
+	void PhysicsSnapshot::save(b2World* world) {
+		std::vector<b2Body*>  worldBodies;
+		std::vector<b2Joint*> worldJoints;
+
+		for (b2Body* body = world->GetBodyList(); body; body = body->GetNext()) {
+			worldBodies.insert(worldBodies.begin(), body);
+		}
+		for (b2Joint* joint = world->GetJointList(); joint; joint = joint->GetNext()) {
+			if (joint->GetType() == e_mouseJoint) continue;
+			worldJoints.insert(worldJoints.begin(), joint);
+		}
+
+		int32 fixtureCount = 0;
+		for (size_t i = 0; i < worldBodies.size(); i++) {
+			for (b2Fixture* f = worldBodies[i]->GetFixtureList(); f; f = f->GetNext()) {
+				fixtureCount++;
+			}
+		}
+
+		this->data.clear();
+		writeInt(this->data, PHYSICS_SNAPSHOT_MAGIC);
+		writeInt(this->data, PHYSICS_SNAPSHOT_VERSION);
+		writeInt(this->data, worldBodies.size());
+		writeInt(this->data, fixtureCount);
+		writeInt(this->data, worldJoints.size());
+		writeVec2(this->data, world->GetGravity());
+		writeBool(this->data, world->GetAutoClearForces());
+
+		for (size_t i = 0; i < worldBodies.size(); i++) {
+			b2Body* body = worldBodies[i];
+			b2MassData massData;
+			body->GetMassData(&massData);
+
+			writeId(this->data, body);
+			writeInt(this->data, body->GetType());
+			writeVec2(this->data, body->GetPosition());
+			writeFloat(this->data, body->GetAngle());
+			writeVec2(this->data, body->GetLinearVelocity());
+			writeFloat(this->data, body->GetAngularVelocity());
+			writeFloat(this->data, body->GetLinearDamping());
+			writeFloat(this->data, body->GetAngularDamping());
+			writeBool(this->data, body->IsSleepingAllowed());
+			writeBool(this->data, body->IsAwake());
+			writeBool(this->data, body->IsFixedRotation());
+			writeBool(this->data, body->IsBullet());
+			writeBool(this->data, body->IsActive());
+			writeFloat(this->data, massData.mass);
+			writeVec2(this->data, massData.center);
+			writeFloat(this->data, massData.I);
+
+			std::vector<b2Fixture*> bodyFixtures;
+			for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext()) {
+				bodyFixtures.insert(bodyFixtures.begin(), f);
+			}
+			writeInt(this->data, bodyFixtures.size());
+			for (size_t j = 0; j < bodyFixtures.size(); j++) {
+				writeFixture(this->data, bodyFixtures[j]);
+			}
+		}
+
+		for (size_t i = 0; i < worldJoints.size(); i++) {
+			writeJoint(this->data, worldJoints[i], worldBodies, worldJoints);
+		}
+	}
+
+	/*
+	 * rebuild the world from the snapshot.
+	 * the whole snapshot is parsed before the world is touched
+	 * so broken data never leaves a half restored world behind.
+	 */
+	bool PhysicsSnapshot::restore(b2World* world, bool clear) {
+		this->bodies.clear();
+		this->fixtures.clear();
+		this->joints.clear();
+
+		if (world->IsLocked()) {
+			LOGE("PhysicsSnapshot::restore: world is locked");
+			return false;
+		}
+
+		if (this->data.empty()) {
+			LOGE("PhysicsSnapshot::restore: invalid snapshot data");
+			return false;
+		}
+		SnapshotReader in(&this->data[0], this->data.size());
+		if (in.readInt() != PHYSICS_SNAPSHOT_MAGIC) {
+			LOGE("PhysicsSnapshot::restore: invalid snapshot data");
+			return false;
+		}
+		if (in.readInt() != PHYSICS_SNAPSHOT_VERSION) {
+			LOGE("PhysicsSnapshot::restore: unsupported snapshot version");
+			return false;
+		}
+
+		int32 bodyCount    = in.readInt();
+		int32 fixtureCount = in.readInt();
+		int32 jointCount   = in.readInt();
+		b2Vec2 gravity     = in.readVec2();
+		bool autoClearForces = in.readBool();
+
+		if (!in.ok || bodyCount < 0 || fixtureCount < 0 || jointCount < 0 ||
+				(int64_t)bodyCount + fixtureCount + jointCount > (int64_t)this->data.size()) {
+			LOGE("PhysicsSnapshot::restore: invalid snapshot header");
+			return false;
+		}
+
+		std::vector<SnapshotBody>    bodyRecords(bodyCount);
+		std::vector<SnapshotFixture> fixtureRecords(fixtureCount);
+		std::vector<SnapshotJoint>   jointRecords(jointCount);
+		int32 polygonCount = 0;
+		int32 circleCount  = 0;
+
+		int32 fixtureIndex = 0;
+		for (int32 i = 0; i < bodyCount && in.ok; i++) {
+			SnapshotBody* body = &bodyRecords[i];
+			body->id = in.readId();
+			body->def.type            = (b2BodyType)in.readInt();
+			body->def.position        = in.readVec2();
+			body->def.angle           = in.readFloat();
+			body->def.linearVelocity  = in.readVec2();
+			body->def.angularVelocity = in.readFloat();
+			body->def.linearDamping   = in.readFloat();
+			body->def.angularDamping  = in.readFloat();
+			body->def.allowSleep      = in.readBool();
+			body->def.awake           = in.readBool();
+			body->def.fixedRotation   = in.readBool();
+			body->def.bullet          = in.readBool();
+			body->def.active          = in.readBool();
+			body->massData.mass       = in.readFloat();
+			body->massData.center     = in.readVec2();
+			body->massData.I          = in.readFloat();
+			body->fixtureStart = fixtureIndex;
+			body->fixtureCount = in.readInt();
+
+			if (body->fixtureCount < 0 || fixtureIndex + body->fixtureCount > fixtureCount) {
+				in.ok = false;
+				break;
+			}
+
+			for (int32 j = 0; j < body->fixtureCount && in.ok; j++) {
+				SnapshotFixture* fixture = &fixtureRecords[fixtureIndex++];
+				fixture->id = in.readId();
+				fixture->def.friction    = in.readFloat();
+				fixture->def.restitution = in.readFloat();
+				fixture->def.density     = in.readFloat();
+				fixture->def.isSensor    = in.readBool();
+				fixture->def.filter.categoryBits = (uint16)in.readInt();
+				fixture->def.filter.maskBits     = (uint16)in.readInt();
+				fixture->def.filter.groupIndex   = (int16)in.readInt();
+
+				fixture->shapeType = in.readInt();
+				float32 radius = in.readFloat();
+				if (fixture->shapeType == b2Shape::e_circle) {
+					fixture->circle.m_radius = radius;
+					fixture->circle.m_p = in.readVec2();
+					circleCount++;
+				} else if (fixture->shapeType == b2Shape::e_polygon) {
+					fixture->polygon.m_radius   = radius;
+					fixture->polygon.m_centroid = in.readVec2();
+					int32 vertexCount = in.readInt();
+					if (vertexCount < 0 || vertexCount > b2_maxPolygonVertices) {
+						in.ok = false;
+						break;
+					}
+					fixture->polygon.m_vertexCount = vertexCount;
+					for (int32 k = 0; k < vertexCount; k++) {
+						fixture->polygon.m_vertices[k] = in.readVec2();
+						fixture->polygon.m_normals[k]  = in.readVec2();
+					}
+					polygonCount++;
+				} else {
+					in.ok = false;
+				}
+			}
+		}
+
+		for (int32 i = 0; i < jointCount && in.ok; i++) {
+			SnapshotJoint* joint = &jointRecords[i];
+			joint->id     = in.readId();
+			int32 type    = in.readInt();
+			joint->bodyA  = in.readInt();
+			joint->bodyB  = in.readInt();
+			joint->joint1 = -1;
+			joint->joint2 = -1;
+			bool collideConnected = in.readBool();
+
+			joint->def = readJointDef(in, type, joint);
+			if (joint->def == NULL ||
+					joint->bodyA < 0 || joint->bodyA >= bodyCount ||
+					joint->bodyB < 0 || joint->bodyB >= bodyCount) {
+				in.ok = false;
+				break;
+			}
+			if (type == e_gearJoint &&
+					(joint->joint1 < 0 || joint->joint1 >= i ||
+					 joint->joint2 < 0 || joint->joint2 >= i)) {
+				in.ok = false;
+				break;
+			}
+			joint->def->collideConnected = collideConnected;
+		}
+
+		if (!in.ok || fixtureIndex != fixtureCount) {
+			for (int32 i = 0; i < jointCount; i++) {
+				if (jointRecords[i].def != NULL) delete jointRecords[i].def;
+			}
+			LOGE("PhysicsSnapshot::restore: snapshot data is broken");
+			return false;
+		}
+
+		if (clear) {
+			b2Body* body = world->GetBodyList();
+			while (body) {
+				b2Body* next = body->GetNext();
+				world->DestroyBody(body);
+				body = next;
+			}
+		}
+
+		world->SetGravity(gravity);
+		world->SetAutoClearForces(autoClearForces);
+
+		world->ReserveBlocks(sizeof(b2Body),         bodyCount);
+		world->ReserveBlocks(sizeof(b2Fixture),      fixtureCount);
+		world->ReserveBlocks(sizeof(b2PolygonShape), polygonCount);
+		world->ReserveBlocks(sizeof(b2CircleShape),  circleCount);
+		for (int32 i = 0; i < jointCount; i++) {
+			world->ReserveBlocks(jointSize(jointRecords[i].def->type), 1);
+		}
+
+		/*
+		 * bodies are created inactive so that no broadphase proxy exists
+		 * until all fixtures are attached, and fixtures are attached without
+		 * density so that the mass is computed only once per body.
+		 */
+		std::vector<b2Body*> newBodies(bodyCount);
+		for (int32 i = 0; i < bodyCount; i++) {
+			SnapshotBody* record = &bodyRecords[i];
+			bool active = record->def.active;
+			record->def.active = false;
+
+			b2Body* body = world->CreateBody(&record->def);
+			newBodies[i] = body;
+
+			for (int32 j = 0; j < record->fixtureCount; j++) {
+				SnapshotFixture* fixtureRecord = &fixtureRecords[record->fixtureStart + j];
+				if (fixtureRecord->shapeType == b2Shape::e_circle) {
+					fixtureRecord->def.shape = &fixtureRecord->circle;
+				} else {
+					fixtureRecord->def.shape = &fixtureRecord->polygon;
+				}
+				float32 density = fixtureRecord->def.density;
+				fixtureRecord->def.density = 0.0f;
+
+				b2Fixture* fixture = body->CreateFixture(&fixtureRecord->def);
+				fixture->SetDensity(density);
+
+				PhysicsSnapshotId fixtureId = { fixtureRecord->id, fixture };
+				this->fixtures.push_back(fixtureId);
+			}
+
+			if (body->GetType() == b2_dynamicBody) {
+				body->SetMassData(&record->massData);
+			}
+			if (active) {
+				body->SetActive(true);
+			}
+			record->def.active = active;
+
+			PhysicsSnapshotId bodyId = { record->id, body };
+			this->bodies.push_back(bodyId);
+		}
+
+		std::vector<b2Joint*> newJoints(jointCount);
+		for (int32 i = 0; i < jointCount; i++) {
+			SnapshotJoint* record = &jointRecords[i];
+			record->def->bodyA = newBodies[record->bodyA];
+			record->def->bodyB = newBodies[record->bodyB];
+			if (record->def->type == e_gearJoint) {
+				b2GearJointDef* def = reinterpret_cast<b2GearJointDef*>(record->def);
+				def->joint1 = newJoints[record->joint1];
+				def->joint2 = newJoints[record->joint2];
+			}
+			newJoints[i] = world->CreateJoint(record->def);
+			delete record->def;
+			record->def = NULL;
+
+			PhysicsSnapshotId jointId = { record->id, newJoints[i] };
+			this->joints.push_back(jointId);
+		}
+
+		return true;
+	}
+
+	bool PhysicsSnapshot::loadFromBytes(const unsigned char* bytes, int length) {
+		if (bytes == NULL || length < (int)(sizeof(int32) * 2)) {
+			return false;
+		}
+		int32 magic;
+		memcpy(&magic, bytes, sizeof(int32));
+		if (magic != PHYSICS_SNAPSHOT_MAGIC) {
+			return false;
+		}
+		this->data.assign(bytes, bytes + length);
+		return true;
+	}
+
+	bool PhysicsSnapshot::loadFromFile(std::string path) {
+		FILE* fp = fopen(path.c_str(), "rb");
+		if (fp == NULL) {
+			return false;
+		}
+		fseek(fp, 0, SEEK_END);
+		long length = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+
+		if (length <= 0) {
+			fclose(fp);
+			return false;
+		}
+
+		std::vector<unsigned char> bytes(length);
+		size_t count = fread(&bytes[0], 1, length, fp);
+		fclose(fp);
+
+		if (count != (size_t)length) {
+			return false;
+		}
+		return loadFromBytes(&bytes[0], length);
+	}
+
+	bool PhysicsSnapshot::saveToFile(std::string path) {
+		if (this->data.empty()) {
+			return false;
+		}
+		FILE* fp = fopen(path.c_str(), "wb");
+		if (fp == NULL) {
+			return false;
+		}
+		size_t count = fwrite(&this->data[0], 1, this->data.size(), fp);
+		fclose(fp);
+		return count == this->data.size();
+	}
+}
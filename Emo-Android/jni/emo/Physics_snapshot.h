@@ -0,0 +1,71 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+#ifndef EMO_PHYSICS_SNAPSHOT_H
+#define EMO_PHYSICS_SNAPSHOT_H
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include "Box2D/Box2D.h"
+
+#define PHYSICS_SNAPSHOT_MAGIC   0x504f4d45
+#define PHYSICS_SNAPSHOT_VERSION 2
+
+/*
+ * Binary snapshot of a Box2D world
+ */
+namespace emo {
+	/*
+	 * maps an object id stored in the snapshot
+	 * to the object created by restore
+	 */
+	struct PhysicsSnapshotId {
+		uint64_t oldId;
+		void*  object;
+	};
+
+	class PhysicsSnapshot {
+	public:
+		PhysicsSnapshot();
+		~PhysicsSnapshot();
+
+		void save(b2World* world);
+		bool restore(b2World* world, bool clear);
+
+		bool loadFromBytes(const unsigned char* bytes, int length);
+		bool loadFromFile(std::string path);
+		bool saveToFile(std::string path);
+
+		std::vector<unsigned char> data;
+
+		std::vector<PhysicsSnapshotId> bodies;
+		std::vector<PhysicsSnapshotId> fixtures;
+		std::vector<PhysicsSnapshotId> joints;
+	};
+}
+#endif
@@ -66,6 +66,113 @@ void pushVec2(HSQUIRRELVM v, b2Vec2 vec2) {
 	sq_arrayappend(v, -2);
 }	
 
+/*
+ * get number or bool value as float
+ */
+static bool getColumnValue(HSQUIRRELVM v, int idx, float* value) {
+	SQFloat fvalue;
+	SQBool  bvalue;
+	switch (sq_gettype(v, idx)) {
+		case OT_INTEGER:
+		case OT_FLOAT:
+			sq_getfloat(v, idx, &fvalue);
+			*value = fvalue;
+			return true;
+		case OT_BOOL:
+			sq_getbool(v, idx, &bvalue);
+			*value = bvalue ? 1 : 0;
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * returns length of the array in the table slot
+ * or -1 if the slot is not an array
+ */
+SQInteger getColumnSize(HSQUIRRELVM v, int idx, const char* name) {
+	SQInteger size = -1;
+	sq_pushstring(v, name, -1);
+	if (!SQ_SUCCEEDED(sq_get(v, idx))) {
+		sq_pop(v, 1);
+		return size;
+	}
+	if (sq_gettype(v, -1) == OT_ARRAY) {
+		size = sq_getsize(v, -1);
+	}
+	sq_pop(v, 1);
+	return size;
+}
+
+/*
+ * Get float values from the table slot.
+ * the slot can be an array that has a value for each row
+ * or a single value that applies to all rows.
+ */
+bool getFloatColumn(HSQUIRRELVM v, int idx, const char* name,
+						std::vector<float>& column, SQInteger count, float defaultValue) {
+	column.assign(count, defaultValue);
+	
+	sq_pushstring(v, name, -1);
+	if (!SQ_SUCCEEDED(sq_get(v, idx))) {
+		sq_pop(v, 1);
+		return false;
+	}
+	
+	float value;
+	if (sq_gettype(v, -1) == OT_ARRAY) {
+		SQInteger size = sq_getsize(v, -1);
+		for (SQInteger i = 0; i < count && i < size; i++) {
+			sq_pushinteger(v, i);
+			if (SQ_SUCCEEDED(sq_get(v, -2))) {
+				if (getColumnValue(v, -1, &value)) column[i] = value;
+				sq_pop(v, 1);
+			}
+		}
+	} else if (getColumnValue(v, -1, &value)) {
+		column.assign(count, value);
+	} else {
+		sq_pop(v, 1);
+		return false;
+	}
+	sq_pop(v, 1);
+	return true;
+}
+
+/*
+ * Get string values from the array in the table slot
+ */
+bool getStringColumn(HSQUIRRELVM v, int idx, const char* name,
+						std::vector<std::string>& column, SQInteger count) {
+	column.assign(count, "");
+	
+	sq_pushstring(v, name, -1);
+	if (!SQ_SUCCEEDED(sq_get(v, idx))) {
+		sq_pop(v, 1);
+		return false;
+	}
+	if (sq_gettype(v, -1) != OT_ARRAY) {
+		sq_pop(v, 1);
+		return false;
+	}
+	
+	SQInteger size = sq_getsize(v, -1);
+	for (SQInteger i = 0; i < count && i < size; i++) {
+		sq_pushinteger(v, i);
+		if (SQ_SUCCEEDED(sq_get(v, -2))) {
+			if (sq_gettype(v, -1) == OT_STRING) {
+				const SQChar* value;
+				sq_getstring(v, -1, &value);
+				column[i] = value;
+			}
+			sq_pop(v, 1);
+		}
+	}
+	sq_pop(v, 1);
+	return true;
+}
+
 /*
  * get b2BodyDef from emo.BodyDef instance
  */
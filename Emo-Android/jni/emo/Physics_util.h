@@ -25,6 +25,12 @@
 // OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // 
+#include <vector>
+#include <string>
+
+SQInteger getColumnSize(HSQUIRRELVM v, int idx, const char* name);
+bool getFloatColumn(HSQUIRRELVM v, int idx, const char* name, std::vector<float>& column, SQInteger count, float defaultValue);
+bool getStringColumn(HSQUIRRELVM v, int idx, const char* name, std::vector<std::string>& column, SQInteger count);
 void getVec2Instance(HSQUIRRELVM v, int idx, b2Vec2* vec2);
 void getVec2InstanceFromMember(HSQUIRRELVM v, int idx, const char* member, b2Vec2* vec2);
 void pushVec2(HSQUIRRELVM v, b2Vec2 vec2);
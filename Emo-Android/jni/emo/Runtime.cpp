@@ -153,15 +153,23 @@ bool printGLErrors(const char* msg) {
     return result;
 }
 
+/*
+ * read position in the asset view of a squirrel script
+ */
+struct sq_asset_reader {
+    emo::AssetView* view;
+    size_t offset;
+};
+
 /*
  * callback function to read squirrel script from asset
  */
-static SQInteger sq_lexer_asset(SQUserPointer asset) {
-	SQChar c;
-		if(AAsset_read((AAsset*)asset, &c, 1) > 0) {
-			return c;
-		}
-	return 0;
+static SQInteger sq_lexer_asset(SQUserPointer reader) {
+    sq_asset_reader* r = (sq_asset_reader*)reader;
+    if (r->offset < r->view->length) {
+        return (SQChar)r->view->data[r->offset++];
+    }
+    return 0;
 }
 
 /*
@@ -179,12 +187,15 @@ static SQInteger sq_lexer_fp(SQUserPointer fp) {
 /*
  * callback function for reading squuirrel bytecodes
  */
-static SQInteger sq_lexer_bytecode(SQUserPointer asset, SQUserPointer buf, SQInteger size) {
-    SQInteger ret;
-    if ((ret = AAsset_read((AAsset*)asset, buf, size)) != 0) {
-        return ret;
-    }
-    return -1;
+static SQInteger sq_lexer_bytecode(SQUserPointer reader, SQUserPointer buf, SQInteger size) {
+    sq_asset_reader* r = (sq_asset_reader*)reader;
+    size_t remaining = r->view->length - r->offset;
+    if (remaining == 0) return -1;
+
+    size_t count = (size_t)size < remaining ? size : remaining;
+    memcpy(buf, r->view->data + r->offset, count);
+    r->offset += count;
+    return count;
 }
 
 /*
@@ -192,39 +203,17 @@ static SQInteger sq_lexer_bytecode(SQUserPointer asset, SQUserPointer buf, SQInt
  */
 std::string loadContentFromAsset(std::string fname) {
     std::string content;
-    /*
-     * read squirrel script from asset
-     */
-    AAssetManager* mgr = engine->app->activity->assetManager;
-    if (mgr == NULL) {
-    	engine->setLastError(ERR_SCRIPT_LOAD);
-    	LOGE("loadScriptFromAsset: failed to load AAssetManager");
-    	return content;
-    }
 
-    AAsset* asset = AAssetManager_open(mgr, fname.c_str(), AASSET_MODE_UNKNOWN);
-    if (asset == NULL) {
+    emo::AssetView* view = engine->assets->acquire(fname);
+    if (view == NULL) {
     	engine->setLastError(ERR_SCRIPT_OPEN);
-    	LOGW("loadScriptFromAsset: failed to open main script file");
+    	LOGW("loadContentFromAsset: failed to open asset");
         LOGW(fname.c_str());
     	return content;
     }
 
-    off_t length = AAsset_getLength(asset);
-    char* buffer = new char[length + 1];
-
-    for (int i = 0; i < length; i++) {
-	    SQChar c;
-		if(AAsset_read((AAsset*)asset, &c, 1) > 0) {
-            buffer[i] = c;
-        }
-    }
-    buffer[length] = NULL;
-
-    content = buffer;
-    delete buffer;
-
-    AAsset_close(asset);
+    content.assign((const char*)view->data, view->length);
+    engine->assets->release(view);
 
     return content;
 }
@@ -236,60 +225,54 @@ bool loadScriptFromAsset(const char* fname) {
     /*
      * read squirrel script from asset
      */
-    AAssetManager* mgr = engine->app->activity->assetManager;
-    if (mgr == NULL) {
-    	engine->setLastError(ERR_SCRIPT_LOAD);
-    	LOGE("loadScriptFromAsset: failed to load AAssetManager");
-    	return false;
-    }
-
-    AAsset* asset = AAssetManager_open(mgr, fname, AASSET_MODE_UNKNOWN);
-    if (asset == NULL) {
+    emo::AssetView* view = engine->assets->acquire(fname);
+    if (view == NULL) {
     	engine->setLastError(ERR_SCRIPT_OPEN);
     	LOGW("loadScriptFromAsset: failed to open main script file");
         LOGW(fname);
     	return false;
     }
 
-    unsigned short sqtag;
-    bool isByteCode = false;
-    if (AAsset_read(asset, &sqtag, 2) > 0) {
-        if (sqtag == SQ_BYTECODE_STREAM_TAG) {
-            isByteCode = true;
-        }
-        AAsset_seek(asset, 0, SEEK_SET);
-    } else {
-        AAsset_close(asset);
+    if (view->length < 2) {
+        engine->assets->release(view);
         return false;
     }
 
-    if (isByteCode && SQ_SUCCEEDED(sq_readclosure(engine->sqvm, sq_lexer_bytecode, asset))) {
+    unsigned short sqtag;
+    memcpy(&sqtag, view->data, 2);
+    bool isByteCode = sqtag == SQ_BYTECODE_STREAM_TAG;
+
+    sq_asset_reader reader;
+    reader.view   = view;
+    reader.offset = 0;
+
+    if (isByteCode && SQ_SUCCEEDED(sq_readclosure(engine->sqvm, sq_lexer_bytecode, &reader))) {
         sq_pushroottable(engine->sqvm);
         if (SQ_FAILED(sq_call(engine->sqvm, 1, SQFalse, SQTrue))) {
         	engine->setLastError(ERR_SCRIPT_CALL_ROOT);
             LOGW("loadScriptFromAsset: failed to sq_call");
             LOGW(fname);
-            AAsset_close(asset);
+            engine->assets->release(view);
             return false;
         }
-    } else if(!isByteCode && SQ_SUCCEEDED(sq_compile(engine->sqvm, sq_lexer_asset, asset, fname, SQTrue))) {
+    } else if(!isByteCode && SQ_SUCCEEDED(sq_compile(engine->sqvm, sq_lexer_asset, &reader, fname, SQTrue))) {
         sq_pushroottable(engine->sqvm);
         if (SQ_FAILED(sq_call(engine->sqvm, 1, SQFalse, SQTrue))) {
         	engine->setLastError(ERR_SCRIPT_CALL_ROOT);
             LOGW("loadScriptFromAsset: failed to sq_call");
             LOGW(fname);
-            AAsset_close(asset);
+            engine->assets->release(view);
             return false;
         }
     } else {
     	engine->setLastError(ERR_SCRIPT_COMPILE);
         LOGW("loadScriptFromAsset: failed to compile squirrel script");
         LOGW(fname);
-        AAsset_close(asset);
+        engine->assets->release(view);
         return false;
     }
 
-    AAsset_close(asset);
+    engine->assets->release(view);
 
     return true;
 }
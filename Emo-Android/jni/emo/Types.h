@@ -35,5 +35,7 @@
 typedef std::hash_map <std::string, std::string> kvs_t;
 typedef std::hash_map <std::string, emo::Drawable *> drawables_t;
 typedef std::hash_map <std::string, emo::Image *> images_t;
+typedef std::hash_map <std::string, emo::TextureAtlas *> atlases_t;
+typedef std::hash_map <std::string, emo::GlyphAtlas *> glyph_atlases_t;
 
 #endif
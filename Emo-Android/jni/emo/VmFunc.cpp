@@ -361,6 +361,24 @@ bool getBool(HSQUIRRELVM v, int idx, SQBool* value) {
 	return true;
 }
 
+/*
+ * create new integer slot in the table on top of the stack
+ */
+void newSlotInteger(HSQUIRRELVM v, const char* name, SQInteger value) {
+	sq_pushstring(v, name, -1);
+	sq_pushinteger(v, value);
+	sq_newslot(v, -3, SQFalse);
+}
+
+/*
+ * create new float slot in the table on top of the stack
+ */
+void newSlotFloat(HSQUIRRELVM v, const char* name, SQFloat value) {
+	sq_pushstring(v, name, -1);
+	sq_pushfloat(v, value);
+	sq_newslot(v, -3, SQFalse);
+}
+
 /*
  * get instance member value as float
  */
@@ -54,4 +54,6 @@ bool getInstanceMemberAsTable(HSQUIRRELVM v, int idx, const char *cname, const c
 bool getInstanceMemberAsUserPointer(HSQUIRRELVM v, int idx, const char *cname, const char *name, SQUserPointer* value);
 bool getInstanceMemberAsInstance(HSQUIRRELVM v, int idx, const char *cname, const char *name, SQUserPointer* value);
 bool getBool(HSQUIRRELVM v, int idx, SQBool* value);
+void newSlotInteger(HSQUIRRELVM v, const char* name, SQInteger value);
+void newSlotFloat(HSQUIRRELVM v, const char* name, SQFloat value);
 SQInteger createSQObject(HSQUIRRELVM v, const char* package_name, const char* name, SQUserPointer ptr, SQRELEASEHOOK releaseHook);
@@ -9,17 +9,20 @@ import android.graphics.Color;
 import android.graphics.Paint;
 import android.graphics.Paint.FontMetrics;
 import android.graphics.Paint.Style;
+import android.graphics.Rect;
 import android.graphics.Typeface;
 import android.os.AsyncTask;
 import android.os.Vibrator;
 import android.util.Log;
 import android.widget.Toast;
 
+import java.util.HashMap;
 import java.util.List;
 import java.util.ArrayList;
 import java.util.Locale;
 import java.util.Random;
 import java.io.ByteArrayOutputStream;
+import java.io.DataOutputStream;
 import java.io.File;
 import java.io.InputStream;
 import java.io.InputStreamReader;
@@ -49,6 +52,8 @@ public class EmoActivity extends NativeActivity {
     protected String lastErrorCode;
 
     private static Random randomNumberGenerator;
+
+    private HashMap<String, Paint> glyphPaints = new HashMap<String, Paint>();
     
     private static synchronized Random initRNG() {
         Random rnd = randomNumberGenerator;
@@ -76,9 +81,30 @@ public class EmoActivity extends NativeActivity {
     	targetValue = String.format(targetValue,
     			param1, param2, param3, param4, param5, param6);
     	
-    	Paint forePaint = new Paint();
+    	Paint forePaint = createTextPaint(fontSize, fontFace, isBold, isItalic);
     	Paint backPaint = new Paint();
     	
+    	backPaint.setColor(Color.TRANSPARENT);
+    	backPaint.setStyle(Style.FILL);
+
+    	FontMetrics metrics = forePaint.getFontMetrics();
+    	int width  = (int)Math.ceil(forePaint.measureText(targetValue));
+    	int height = (int)Math.ceil(Math.abs(metrics.ascent) + 
+    			Math.abs(metrics.descent) + Math.abs(metrics.leading));
+    	
+    	Bitmap bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888);
+    	Canvas canvas = new Canvas(bitmap);
+    	canvas.drawRect(0, 0, width, height, backPaint);
+    	canvas.drawText(targetValue, 0, height - metrics.descent , forePaint);
+
+    	ByteArrayOutputStream os = new ByteArrayOutputStream();
+        bitmap.compress(Bitmap.CompressFormat.PNG, 100, os);
+        return os.toByteArray();
+    }
+
+    protected Paint createTextPaint(int fontSize, String fontFace, boolean isBold, boolean isItalic) {
+    	Paint forePaint = new Paint();
+    	
     	if (fontFace.length() == 0) {
     		if (isBold && isItalic) {
     			forePaint.setTypeface(Typeface.create(Typeface.DEFAULT, Typeface.BOLD_ITALIC));
@@ -113,22 +139,77 @@ public class EmoActivity extends NativeActivity {
     	forePaint.setColor(Color.WHITE);
     	if (fontSize > 0) forePaint.setTextSize(fontSize);
     	forePaint.setAntiAlias(true);
-    	
-    	backPaint.setColor(Color.TRANSPARENT);
-    	backPaint.setStyle(Style.FILL);
+    	return forePaint;
+    }
 
-    	FontMetrics metrics = forePaint.getFontMetrics();
-    	int width  = (int)Math.ceil(forePaint.measureText(targetValue));
-    	int height = (int)Math.ceil(Math.abs(metrics.ascent) + 
-    			Math.abs(metrics.descent) + Math.abs(metrics.leading));
-    	
-    	Bitmap bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888);
-    	Canvas canvas = new Canvas(bitmap);
-    	canvas.drawRect(0, 0, width, height, backPaint);
-    	canvas.drawText(targetValue, 0, height - metrics.descent , forePaint);
+    /*
+     * Rasterizes the glyphs of the codepoints for the glyph atlas of the native side.
+     * All values are big-endian integers: count, ascent, descent and line height
+     * (26.6 fixed point), then codepoint, advance (26.6), left, top, width, height
+     * and width * height bytes of alpha for each glyph.
+     */
+    public byte[] loadGlyphBitmaps(String fontFace, int fontSize,
+    		boolean isBold, boolean isItalic, int[] codepoints) {
+    	String key = fontFace + ":" + fontSize + ":" + isBold + ":" + isItalic;
+    	Paint paint = glyphPaints.get(key);
+    	if (paint == null) {
+    		paint = createTextPaint(fontSize, fontFace, isBold, isItalic);
+    		glyphPaints.put(key, paint);
+    	}
 
+    	FontMetrics metrics = paint.getFontMetrics();
     	ByteArrayOutputStream os = new ByteArrayOutputStream();
-        bitmap.compress(Bitmap.CompressFormat.PNG, 100, os);
+    	DataOutputStream out = new DataOutputStream(os);
+    	Rect bounds = new Rect();
+    	try {
+    		out.writeInt(codepoints.length);
+    		out.writeInt(Math.round(Math.abs(metrics.ascent) * 64));
+    		out.writeInt(Math.round(Math.abs(metrics.descent) * 64));
+    		out.writeInt(Math.round((Math.abs(metrics.ascent) +
+    				Math.abs(metrics.descent) + Math.abs(metrics.leading)) * 64));
+
+    		for (int i = 0; i < codepoints.length; i++) {
+    			String glyph = new String(Character.toChars(codepoints[i]));
+    			paint.getTextBounds(glyph, 0, glyph.length(), bounds);
+
+    			out.writeInt(codepoints[i]);
+    			out.writeInt(Math.round(paint.measureText(glyph) * 64));
+
+    			if (bounds.isEmpty()) {
+    				out.writeInt(0);
+    				out.writeInt(0);
+    				out.writeInt(0);
+    				out.writeInt(0);
+    				continue;
+    			}
+
+    			// antialiasing may reach one pixel outside of the bounds
+    			int left   = bounds.left - 1;
+    			int top    = bounds.top  - 1;
+    			int width  = bounds.width()  + 2;
+    			int height = bounds.height() + 2;
+
+    			Bitmap bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888);
+    			Canvas canvas = new Canvas(bitmap);
+    			canvas.drawText(glyph, -left, -top, paint);
+
+    			int[] pixels = new int[width * height];
+    			bitmap.getPixels(pixels, 0, width, 0, 0, width, height);
+    			bitmap.recycle();
+
+    			out.writeInt(left);
+    			out.writeInt(top);
+    			out.writeInt(width);
+    			out.writeInt(height);
+    			for (int j = 0; j < pixels.length; j++) {
+    				out.writeByte(pixels[j] >>> 24);
+    			}
+    		}
+    		out.flush();
+    	} catch (IOException e) {
+    		Log.e(ENGINE_TAG, "failed to rasterize glyphs", e);
+    		return null;
+    	}
         return os.toByteArray();
     }
 
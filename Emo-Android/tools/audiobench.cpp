@@ -0,0 +1,135 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+/*
+ * audiobench: measures how many voices the mixing kernels mix per
+ * millisecond on the host, for the scalar reference and the SIMD kernels.
+ *
+ *   g++ -O2 -I../jni/emo -o audiobench audiobench.cpp ../jni/emo/Audio_kernels.cpp
+ *   audiobench [milliseconds per case]
+ *
+ * One voice is one mixer buffer of AUDIO_MIXER_BUFFER_FRAMES frames,
+ * resampled from 22.05kHz and accumulated like AudioMixer::mixVoice,
+ * plus the share of the final int16 conversion. The budget column is
+ * the number of voices that fit in a quarter of the buffer period.
+ * Built for ARM with -DEMO_AUDIO_NEON and Audio_kernels_neon.cpp it
+ * measures the NEON kernels.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Audio_kernels.h"
+#include "Audio_mixer.h"
+
+using namespace emo;
+
+#define BENCH_VOICES 16
+#define BENCH_FRAMES 22050
+
+struct KernelSet {
+    const char* name;
+    AudioAccumulateFunc   accumulate;
+    AudioFloatToInt16Func floatToInt16;
+    AudioResampleFunc     linear;
+    AudioResampleFunc     polyphase;
+};
+
+static const KernelSet kernelSets[] = {
+    {"scalar", audioAccumulateScalar, audioFloatToInt16Scalar, audioResampleLinearScalar, audioResamplePolyphaseScalar},
+#if defined(EMO_AUDIO_NEON)
+    {"neon",   audioAccumulateNeon,   audioFloatToInt16Neon,   audioResampleLinearNeon,   audioResamplePolyphaseNeon},
+#elif defined(__SSE2__)
+    {"sse2",   audioAccumulateSSE2,   audioFloatToInt16SSE2,   audioResampleLinearSSE2,   audioResamplePolyphaseSSE2},
+#endif
+};
+
+static int16_t input[BENCH_VOICES][BENCH_FRAMES * 2];
+static float   voiceBuffer[AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS];
+static float   mixBuffer[AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS];
+static int16_t output[AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS];
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/*
+ * mix buffers of BENCH_VOICES voices for the given time and
+ * return the voices mixed per millisecond
+ */
+static double measure(const KernelSet& kernels, AudioResampleFunc resample, int channels, double duration) {
+    const uint64_t step  = ((uint64_t)22050 << 32) / AUDIO_MIXER_SAMPLE_RATE;
+    const uint64_t first = (uint64_t)AUDIO_POLYPHASE_TAPS << 32;
+    const uint64_t end   = (uint64_t)(BENCH_FRAMES - AUDIO_POLYPHASE_TAPS) << 32;
+    uint64_t positions[BENCH_VOICES];
+    for (int v = 0; v < BENCH_VOICES; v++) positions[v] = first + ((uint64_t)v << 28);
+
+    long voices = 0;
+    double start = now();
+    double elapsed = 0;
+    while (elapsed < duration) {
+        for (int i = 0; i < AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS; i++) mixBuffer[i] = 0;
+        for (int v = 0; v < BENCH_VOICES; v++) {
+            if (positions[v] >= end - step * AUDIO_MIXER_BUFFER_FRAMES) positions[v] = first;
+            int frames = resample(voiceBuffer, AUDIO_MIXER_BUFFER_FRAMES, input[v], channels, BENCH_FRAMES,
+                                  &positions[v], step);
+            kernels.accumulate(mixBuffer, voiceBuffer, frames * AUDIO_MIXER_CHANNELS, 0.5f);
+        }
+        kernels.floatToInt16(output, mixBuffer, AUDIO_MIXER_BUFFER_FRAMES * AUDIO_MIXER_CHANNELS);
+        voices += BENCH_VOICES;
+        elapsed = now() - start;
+    }
+    return voices / elapsed;
+}
+
+int main(int argc, char** argv) {
+    double duration = argc > 1 ? atof(argv[1]) : 300;
+    initAudioKernels();
+
+    srand(1);
+    for (int v = 0; v < BENCH_VOICES; v++) {
+        for (int i = 0; i < BENCH_FRAMES * 2; i++) input[v][i] = (int16_t)(rand() % 65536 - 32768);
+    }
+
+    // a quarter of the time one buffer plays
+    double budget = AUDIO_MIXER_BUFFER_FRAMES * 1000.0 / AUDIO_MIXER_SAMPLE_RATE / 4;
+
+    printf("%-8s %-10s %-7s %12s %10s\n", "kernels", "resampler", "input", "voices/ms", "budget");
+    for (size_t k = 0; k < sizeof(kernelSets) / sizeof(kernelSets[0]); k++) {
+        const KernelSet& kernels = kernelSets[k];
+        for (int r = 0; r < 2; r++) {
+            for (int channels = 1; channels <= 2; channels++) {
+                double rate = measure(kernels, r == 0 ? kernels.linear : kernels.polyphase, channels, duration);
+                printf("%-8s %-10s %-7s %12.1f %10.0f\n", kernels.name, r == 0 ? "linear" : "polyphase",
+                       channels == 1 ? "mono" : "stereo", rate, rate * budget);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,422 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+/*
+ * audiotest: drives the software mixer output and its metrics on the
+ * host, with a fake buffer queue in place of OpenSL ES and a fake clock.
+ *
+ *   g++ -O2 -I../jni/emo -o audiotest audiotest.cpp ../jni/emo/Audio_mixer.cpp \
+ *       ../jni/emo/Audio_metrics.cpp ../jni/emo/Audio_kernels.cpp ../jni/emo/Audio_stream.cpp -lpthread
+ *   audiotest
+ *
+ * The fake queue plays one buffer per period of the fake clock and calls
+ * back like the Android simple buffer queue, so the latency, period, cpu
+ * and underrun values are known exactly. The SIMD mixing kernels of the
+ * host (SSE2, or NEON when built with -DEMO_AUDIO_NEON and
+ * Audio_kernels_neon.cpp) are compared against the scalar reference on
+ * random input. Exits with 1 if a check fails.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <deque>
+
+#include "Constants.h"
+#include "Audio_mixer.h"
+#include "Audio_metrics.h"
+#include "Audio_kernels.h"
+
+using namespace emo;
+
+// one buffer of 512 frames at 44.1kHz, rounded up to whole microseconds
+static const uint64_t PERIOD   = 11610;
+static const uint64_t MIX_COST = 300;
+
+static uint64_t fakeTime = 1000000;
+static int failures = 0;
+
+static uint64_t fakeClock() {
+    return fakeTime;
+}
+
+static void check(bool condition, const char* what, double value) {
+    printf("%-6s %-44s %.1f\n", condition ? "ok" : "FAILED", what, value);
+    if (!condition) failures++;
+}
+
+/*
+ * stands in for SLAndroidSimpleBufferQueueItf: holds the enqueued
+ * buffers and plays them back on the fake clock
+ */
+class FakeBufferQueue {
+public:
+    FakeBufferQueue() {
+        this->output   = NULL;
+        this->starved  = 0;
+        this->lastTime = 0;
+    }
+
+    static void enqueue(void* context, int16_t* buffer, int size) {
+        FakeBufferQueue* queue = (FakeBufferQueue*)context;
+        queue->buffers.push_back(size);
+        // the mixing time as seen by the metrics
+        fakeTime += MIX_COST;
+    }
+
+    /*
+     * play the oldest buffer and call back, delay microseconds late
+     */
+    void play(uint64_t delay = 0) {
+        fakeTime = this->lastTime + PERIOD + delay;
+        this->lastTime = fakeTime;
+        if (this->buffers.empty()) {
+            this->starved++;
+        } else {
+            this->buffers.pop_front();
+        }
+        this->output->onBufferDone();
+    }
+
+    AudioMixerOutput* output;
+    std::deque<int> buffers;
+    int starved;
+    uint64_t lastTime;
+};
+
+static AudioSample* createTone(int frames) {
+    AudioSample* sample = new AudioSample();
+    sample->channels   = 1;
+    sample->sampleRate = AUDIO_MIXER_SAMPLE_RATE;
+    sample->frameCount = frames;
+    sample->data.resize(frames);
+    for (int i = 0; i < frames; i++) {
+        sample->data[i] = (int16_t)(8000 * sin(i * 0.05));
+    }
+    return sample;
+}
+
+static void testOutput() {
+    setAudioClock(fakeClock);
+
+    AudioMixer   mixer(4, AUDIO_MIXER_SAMPLE_RATE);
+    AudioMetrics metrics(AUDIO_MIXER_BUFFER_FRAMES, AUDIO_MIXER_SAMPLE_RATE);
+    FakeBufferQueue queue;
+    AudioMixerOutput output(&mixer, &metrics, FakeBufferQueue::enqueue, &queue);
+    queue.output = &output;
+
+    queue.lastTime = fakeTime;
+    output.start();
+    check(queue.buffers.size() == AUDIO_MIXER_QUEUE_BUFFERS, "start primes the queue", queue.buffers.size());
+
+    // steady output
+    metrics.reset();
+    AudioMetricsSnapshot snapshot;
+    metrics.getSnapshot(&snapshot);
+    check(snapshot.callbackCount == 0, "snapshot is empty while reset is pending", snapshot.callbackCount);
+
+    queue.lastTime = fakeTime;
+    for (int i = 0; i < 100; i++) queue.play();
+    metrics.getSnapshot(&snapshot);
+    check(snapshot.callbackCount == 100, "callback count", snapshot.callbackCount);
+    check(snapshot.period.count == 99 && snapshot.period.average == PERIOD, "callback period (us)", snapshot.period.average);
+    check(snapshot.cpu.average == MIX_COST, "mixing time per callback (us)", snapshot.cpu.average);
+    check(snapshot.underrunCount == 0 && queue.starved == 0, "no underrun", snapshot.underrunCount);
+
+    // play() to the enqueue of the first buffer with the voice
+    AudioSample* tone = createTone(AUDIO_MIXER_BUFFER_FRAMES * 4);
+    mixer.setSample(0, tone);
+    mixer.setSample(1, tone);
+    queue.play();
+    fakeTime += 4000;
+    uint64_t firstPlay = fakeTime;
+    mixer.play(0);
+    fakeTime += 1000;
+    uint64_t secondPlay = fakeTime;
+    mixer.play(1);
+    queue.play();
+    uint64_t enqueued = queue.lastTime + MIX_COST;
+    metrics.getSnapshot(&snapshot);
+    check(snapshot.latency.count == 2, "latency samples", snapshot.latency.count);
+    check(snapshot.latency.max == enqueued - firstPlay, "latency of the first voice (us)", snapshot.latency.max);
+    check(snapshot.latency.min == enqueued - secondPlay, "latency of the second voice (us)", snapshot.latency.min);
+
+    // a callback later than the two queued buffers
+    queue.play(2 * PERIOD);
+    metrics.getSnapshot(&snapshot);
+    check(snapshot.underrunCount == 1, "late callback is an underrun", snapshot.underrunCount);
+    check(snapshot.period.max == 3 * PERIOD, "late callback period (us)", snapshot.period.max);
+
+    // the voices ended, the detached sample is free
+    for (int i = 0; i < 4; i++) queue.play();
+    check(mixer.getState(0) == AUDIO_CHANNEL_STOPPED, "voice stops at the end of the sample", mixer.getState(0));
+    mixer.setSample(0, NULL);
+    mixer.setSample(1, NULL);
+    check(tone->isMixing(), "sample in use until the next mix", tone->voiceRefs);
+    queue.play();
+    check(!tone->isMixing(), "sample released by the audio thread", tone->voiceRefs);
+    delete tone;
+
+    metrics.reset();
+    queue.play();
+    metrics.getSnapshot(&snapshot);
+    check(snapshot.callbackCount == 1 && snapshot.underrunCount == 0 && snapshot.latency.count == 0,
+          "reset clears the counters", snapshot.callbackCount);
+
+    setAudioClock(NULL);
+}
+
+static void testStreamUnderrunReset() {
+    AudioMetrics metrics(AUDIO_MIXER_BUFFER_FRAMES, AUDIO_MIXER_SAMPLE_RATE);
+    AudioMetricsSnapshot snapshot;
+
+    metrics.setStreamUnderrunCount(5);
+    metrics.getSnapshot(&snapshot);
+    check(snapshot.streamUnderrunCount == 5, "stream underruns", snapshot.streamUnderrunCount);
+
+    metrics.reset();
+    metrics.setStreamUnderrunCount(5);
+    metrics.getSnapshot(&snapshot);
+    check(snapshot.streamUnderrunCount == 0, "reset clears stream underruns", snapshot.streamUnderrunCount);
+
+    metrics.setStreamUnderrunCount(7);
+    metrics.getSnapshot(&snapshot);
+    check(snapshot.streamUnderrunCount == 2, "stream underruns since reset", snapshot.streamUnderrunCount);
+}
+
+struct SeqlockTest {
+    AudioMetrics* metrics;
+    volatile bool done;
+    long snapshots;
+    long torn;
+};
+
+static void* metricsWriter(void* arg) {
+    SeqlockTest* test = (SeqlockTest*)arg;
+    uint64_t time = 1;
+    while (!test->done) {
+        test->metrics->recordCallback(time, time + 100, AUDIO_MIXER_QUEUE_BUFFERS);
+        time += PERIOD;
+    }
+    return NULL;
+}
+
+/*
+ * the reader never sees a half written callback:
+ * the cpu window and the callback count are updated together
+ */
+static void testSeqlock() {
+    AudioMetrics metrics(AUDIO_MIXER_BUFFER_FRAMES, AUDIO_MIXER_SAMPLE_RATE);
+    SeqlockTest test;
+    test.metrics   = &metrics;
+    test.done      = false;
+    test.snapshots = 0;
+    test.torn      = 0;
+
+    pthread_t writer;
+    pthread_create(&writer, NULL, metricsWriter, &test);
+    uint64_t end = audioNow() + 500000;
+    while (audioNow() < end) {
+        AudioMetricsSnapshot snapshot;
+        metrics.getSnapshot(&snapshot);
+        if (snapshot.cpu.count != snapshot.callbackCount) test.torn++;
+        if (snapshot.callbackCount > 0 && snapshot.period.count != snapshot.callbackCount - 1) test.torn++;
+        test.snapshots++;
+    }
+    test.done = true;
+    pthread_join(writer, NULL);
+
+    check(test.snapshots > 0 && test.torn == 0, "consistent snapshots under concurrent writes", test.snapshots);
+}
+
+#if defined(EMO_AUDIO_NEON) || defined(__SSE2__)
+#if defined(EMO_AUDIO_NEON)
+#define SIMD_NAME             "neon"
+#define simdAccumulate        audioAccumulateNeon
+#define simdAccumulateRamp    audioAccumulateRampNeon
+#define simdFloatToInt16      audioFloatToInt16Neon
+#define simdResampleLinear    audioResampleLinearNeon
+#define simdResamplePolyphase audioResamplePolyphaseNeon
+#else
+#define SIMD_NAME             "sse2"
+#define simdAccumulate        audioAccumulateSSE2
+#define simdAccumulateRamp    audioAccumulateRampSSE2
+#define simdFloatToInt16      audioFloatToInt16SSE2
+#define simdResampleLinear    audioResampleLinearSSE2
+#define simdResamplePolyphase audioResamplePolyphaseSSE2
+#endif
+
+// lengths around the vector widths, including empty and single frames
+static const int KERNEL_LENGTHS[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 13, 16, 31, 64, 255, 512, 515};
+static const int KERNEL_LENGTH_COUNT = sizeof(KERNEL_LENGTHS) / sizeof(KERNEL_LENGTHS[0]);
+static const int KERNEL_TRIALS = 20;
+static const int KERNEL_MAX    = 1200;
+
+static uint32_t kernelSeed = 12345;
+
+static uint32_t nextRandom() {
+    kernelSeed = kernelSeed * 1664525 + 1013904223;
+    return kernelSeed >> 8;
+}
+
+static float randomFloat(float range) {
+    return ((float)nextRandom() / (1 << 24) * 2 - 1) * range;
+}
+
+static void fillFloats(float* data, int count, float range) {
+    for (int i = 0; i < count; i++) data[i] = randomFloat(range);
+}
+
+static double maxDifference(const float* a, const float* b, int count) {
+    double diff = 0;
+    for (int i = 0; i < count; i++) {
+        double d = fabs((double)a[i] - b[i]);
+        if (d > diff) diff = d;
+    }
+    return diff;
+}
+
+static void testAccumulateKernels() {
+    static float in[KERNEL_MAX * 2], expected[KERNEL_MAX * 2 + 8], actual[KERNEL_MAX * 2 + 8];
+    double accumulateDiff = 0, rampDiff = 0;
+    bool guarded = true;
+    for (int n = 0; n < KERNEL_LENGTH_COUNT; n++) {
+        int count = KERNEL_LENGTHS[n];
+        for (int trial = 0; trial < KERNEL_TRIALS; trial++) {
+            fillFloats(in, count * 2, 32768);
+            fillFloats(expected, count * 2 + 8, 65536);
+            memcpy(actual, expected, sizeof(expected));
+            float gain = randomFloat(2);
+            audioAccumulateScalar(expected, in, count, gain);
+            simdAccumulate(actual, in, count, gain);
+            double diff = maxDifference(expected, actual, count + 8);
+            if (diff > accumulateDiff) accumulateDiff = diff;
+
+            // frames of interleaved stereo
+            float startGain = randomFloat(1), endGain = randomFloat(1);
+            audioAccumulateRampScalar(expected, in, count, startGain, endGain);
+            simdAccumulateRamp(actual, in, count, startGain, endGain);
+            diff = maxDifference(expected, actual, count * 2 + 8);
+            if (diff > rampDiff) rampDiff = diff;
+            // nothing is written after the last sample
+            if (maxDifference(expected + count * 2, actual + count * 2, 8) != 0) guarded = false;
+        }
+    }
+    check(accumulateDiff <= 1e-3, SIMD_NAME " accumulate matches scalar (max diff)", accumulateDiff);
+    check(rampDiff <= 1e-3, SIMD_NAME " accumulate ramp matches scalar (max diff)", rampDiff);
+    check(guarded, SIMD_NAME " accumulate stays within count", 0);
+}
+
+static void testFloatToInt16Kernel() {
+    static float in[KERNEL_MAX];
+    static int16_t expected[KERNEL_MAX + 8], actual[KERNEL_MAX + 8];
+    int mismatches = 0;
+    for (int n = 0; n < KERNEL_LENGTH_COUNT; n++) {
+        int count = KERNEL_LENGTHS[n];
+        for (int trial = 0; trial < KERNEL_TRIALS; trial++) {
+            // out of range values saturate, halves round away from zero
+            fillFloats(in, count, 40000);
+            for (int i = 0; i < count; i += 5) in[i] = (float)((int)randomFloat(100)) + 0.5f;
+            for (int i = 0; i < KERNEL_MAX + 8; i++) expected[i] = actual[i] = (int16_t)i;
+            audioFloatToInt16Scalar(expected, in, count);
+            simdFloatToInt16(actual, in, count);
+            for (int i = 0; i < count + 8; i++) {
+                if (expected[i] != actual[i]) mismatches++;
+            }
+        }
+    }
+    check(mismatches == 0, SIMD_NAME " float to int16 matches scalar (mismatches)", mismatches);
+}
+
+/*
+ * runs both resamplers over the same input and compares the frame
+ * count, the advanced position and the output frames
+ */
+static void compareResampler(AudioResampleFunc scalar, AudioResampleFunc simd, const char* what, double tolerance) {
+    static int16_t in[KERNEL_MAX * 2];
+    static float expected[KERNEL_MAX * 2 + 8], actual[KERNEL_MAX * 2 + 8];
+    static const double steps[] = {1.0, 0.5, 0.731, 1.37, 2.0, 3.9};
+    double maxDiff = 0;
+    int countMismatches = 0;
+    for (int channels = 1; channels <= 2; channels++) {
+        for (int n = 0; n < KERNEL_LENGTH_COUNT; n++) {
+            int outFrames = KERNEL_LENGTHS[n];
+            for (int trial = 0; trial < KERNEL_TRIALS; trial++) {
+                int frames = nextRandom() % KERNEL_MAX;
+                for (int i = 0; i < frames * channels; i++) in[i] = (int16_t)randomFloat(32767);
+                uint64_t step  = (uint64_t)(steps[trial % 6] * 4294967296.0);
+                uint64_t start = ((uint64_t)(nextRandom() % 8) << 32) | (nextRandom() << 8);
+                for (int i = 0; i < KERNEL_MAX * 2 + 8; i++) expected[i] = actual[i] = -1;
+
+                uint64_t expectedPosition = start, actualPosition = start;
+                int expectedCount = scalar(expected, outFrames, in, channels, frames, &expectedPosition, step);
+                int actualCount   = simd(actual, outFrames, in, channels, frames, &actualPosition, step);
+                if (expectedCount != actualCount || expectedPosition != actualPosition) {
+                    countMismatches++;
+                    continue;
+                }
+                double diff = maxDifference(expected, actual, expectedCount * 2 + 8);
+                if (diff > maxDiff) maxDiff = diff;
+            }
+        }
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "%s %s frame counts and positions", SIMD_NAME, what);
+    check(countMismatches == 0, label, countMismatches);
+    snprintf(label, sizeof(label), "%s %s matches scalar (max diff)", SIMD_NAME, what);
+    check(maxDiff <= tolerance, label, maxDiff);
+}
+
+static void testKernels() {
+    initAudioKernels();
+    testAccumulateKernels();
+    testFloatToInt16Kernel();
+    compareResampler(audioResampleLinearScalar, simdResampleLinear, "linear resampler", 1e-3);
+    // the filter taps are summed in a different order
+    compareResampler(audioResamplePolyphaseScalar, simdResamplePolyphase, "polyphase resampler", 0.25);
+}
+#else
+static void testKernels() {
+    printf("%-6s %s\n", "skip", "no SIMD kernels on this host");
+}
+#endif
+
+int main(int argc, char** argv) {
+    testOutput();
+    testStreamUnderrunReset();
+    testSeqlock();
+    testKernels();
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,276 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+/*
+ * emopack: writes the packed asset archive (emo.pak) of an asset directory.
+ *
+ *   g++ -O2 -I../jni -I../jni/emo -o emopack emopack.cpp ../jni/emo/Drawable_atlas.cpp -lz
+ *   emopack [-z] assets/emo.pak assets
+ *
+ * -z deflates the assets that shrink by more than 10%. PNG, OGG and MP3
+ * files are always stored because they are compressed already.
+ * Texture atlas xml files are compiled to "<name>.atlas" entries which
+ * the runtime loads instead of parsing the xml.
+ * Store the archive uncompressed in the APK (aapt -0 pak) so the runtime
+ * maps it instead of inflating it. The build.xml of Android-Examples
+ * overrides -package-resources with <nocompress extension="pak" /> for this.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Asset_archive.h"
+#include "Drawable_atlas.h"
+
+struct PackItem {
+    std::string name;
+    std::vector<unsigned char> data;
+    emo::AssetArchiveEntry entry;
+};
+
+static bool endsWith(const std::string& str, const char* ending) {
+    size_t length = strlen(ending);
+    return str.size() >= length && str.compare(str.size() - length, length, ending) == 0;
+}
+
+static bool readFile(const std::string& path, std::vector<unsigned char>* data) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) return false;
+    fseek(fp, 0, SEEK_END);
+    long length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data->resize(length);
+    bool result = length == 0 || fread(&(*data)[0], 1, length, fp) == (size_t)length;
+    fclose(fp);
+    return result;
+}
+
+static void listFiles(const std::string& root, const std::string& dir, std::vector<std::string>* names) {
+    std::string path = dir.empty() ? root : root + "/" + dir;
+    DIR* dp = opendir(path.c_str());
+    if (dp == NULL) return;
+
+    struct dirent* ent;
+    while ((ent = readdir(dp)) != NULL) {
+        if (ent->d_name[0] == '.') continue;
+        std::string name = dir.empty() ? ent->d_name : dir + "/" + ent->d_name;
+        struct stat st;
+        if (stat((root + "/" + name).c_str(), &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            listFiles(root, name, names);
+        } else if (S_ISREG(st.st_mode)) {
+            names->push_back(name);
+        }
+    }
+    closedir(dp);
+}
+
+/*
+ * read the dimensions and the color type from the PNG IHDR chunk
+ */
+static void readPngInfo(const std::vector<unsigned char>& data, emo::AssetArchiveEntry* entry) {
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a};
+    if (data.size() < 33 || memcmp(&data[0], signature, 8) != 0 || memcmp(&data[12], "IHDR", 4) != 0) {
+        return;
+    }
+
+    uint32_t width  = (data[16] << 24) | (data[17] << 16) | (data[18] << 8) | data[19];
+    uint32_t height = (data[20] << 24) | (data[21] << 16) | (data[22] << 8) | data[23];
+    if (width > 0xffff || height > 0xffff) return;
+
+    entry->width  = width;
+    entry->height = height;
+    switch (data[25]) {
+    case 2:  entry->format = ASSET_FORMAT_PNG_RGB;   break;
+    case 6:  entry->format = ASSET_FORMAT_PNG_RGBA;  break;
+    default: entry->format = ASSET_FORMAT_PNG_OTHER; break;
+    }
+}
+
+namespace rapidxml {
+    void parse_error_handler(const char *what, void *) {
+        fprintf(stderr, "emopack: xml parse error: %s\n", what);
+        exit(1);
+    }
+}
+
+/*
+ * compile the atlas xml to the binary atlas. returns false if the
+ * xml is not a texture atlas.
+ */
+static bool compileAtlas(const std::string& root, const std::string& name,
+                         const std::vector<unsigned char>& xml, std::vector<unsigned char>* data) {
+    static const char* markers[] = {"<Imageset", "<TextureAtlas"};
+    std::string text(xml.begin(), xml.end());
+    if (text.find(markers[0]) == std::string::npos && text.find(markers[1]) == std::string::npos) {
+        return false;
+    }
+
+    size_t pos = name.find_last_of("/");
+    std::string baseDir = pos == std::string::npos ? "" : name.substr(0, pos + 1);
+
+    emo::TextureAtlas atlas;
+    if (!atlas.parse(text.data(), text.size(), baseDir)) {
+        fprintf(stderr, "emopack: %s: no frames or the frame index could not be built\n", name.c_str());
+        return false;
+    }
+
+    std::vector<unsigned char> image;
+    emo::AssetArchiveEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    if (!readFile(root + "/" + atlas.imageName, &image)) {
+        return false;
+    }
+    readPngInfo(image, &entry);
+    if (entry.width == 0 || entry.height == 0) {
+        return false;
+    }
+    atlas.imageWidth  = entry.width;
+    atlas.imageHeight = entry.height;
+
+    atlas.save(data);
+    return true;
+}
+
+static PackItem* createItem(const std::string& name, std::vector<unsigned char>& data, bool compress) {
+    PackItem* item = new PackItem();
+    item->name = name;
+    item->data.swap(data);
+
+    memset(&item->entry, 0, sizeof(item->entry));
+    item->entry.hash       = emo::assetArchiveHash(item->name.c_str(), item->name.size());
+    item->entry.rawSize    = item->data.size();
+    item->entry.nameLength = item->name.size();
+    readPngInfo(item->data, &item->entry);
+
+    bool packed = endsWith(item->name, ".png") || endsWith(item->name, ".ogg") || endsWith(item->name, ".mp3");
+    if (compress && !packed && !item->data.empty()) {
+        uLongf length = compressBound(item->data.size());
+        std::vector<unsigned char> deflated(length);
+        if (compress2(&deflated[0], &length, &item->data[0], item->data.size(), 9) == Z_OK &&
+                length < item->data.size() * 9 / 10) {
+            deflated.resize(length);
+            item->data.swap(deflated);
+            item->entry.flags |= ASSET_ARCHIVE_COMPRESSED;
+        }
+    }
+    item->entry.size = item->data.size();
+    return item;
+}
+
+static bool compareHash(const PackItem* a, const PackItem* b) {
+    return a->entry.hash < b->entry.hash;
+}
+
+int main(int argc, char** argv) {
+    bool compress = false;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-z") == 0) {
+        compress = true;
+        arg++;
+    }
+    if (argc - arg != 2) {
+        fprintf(stderr, "usage: emopack [-z] output.pak asset_dir\n");
+        return 1;
+    }
+    std::string output = argv[arg];
+    std::string root   = argv[arg + 1];
+
+    std::vector<std::string> names;
+    listFiles(root, "", &names);
+
+    std::vector<PackItem*> items;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (root + "/" + names[i] == output || endsWith(names[i], ".pak")) continue;
+        if (endsWith(names[i], TEXTURE_ATLAS_SUFFIX)) continue;
+
+        std::vector<unsigned char> data;
+        if (!readFile(root + "/" + names[i], &data)) {
+            fprintf(stderr, "emopack: failed to read %s\n", names[i].c_str());
+            return 1;
+        }
+
+        std::vector<unsigned char> atlas;
+        if (endsWith(names[i], ".xml") && compileAtlas(root, names[i], data, &atlas)) {
+            items.push_back(createItem(names[i] + TEXTURE_ATLAS_SUFFIX, atlas, compress));
+        }
+        items.push_back(createItem(names[i], data, compress));
+    }
+
+    std::stable_sort(items.begin(), items.end(), compareHash);
+
+    emo::AssetArchiveHeader header;
+    header.magic       = ASSET_ARCHIVE_MAGIC;
+    header.version     = ASSET_ARCHIVE_VERSION;
+    header.entryCount  = items.size();
+    header.namesOffset = sizeof(header) + items.size() * sizeof(emo::AssetArchiveEntry);
+
+    std::string table;
+    for (size_t i = 0; i < items.size(); i++) {
+        items[i]->entry.nameOffset = table.size();
+        table += items[i]->name;
+    }
+    header.namesSize  = table.size();
+    header.dataOffset = (header.namesOffset + header.namesSize + 3) & ~3;
+
+    uint32_t offset = header.dataOffset;
+    for (size_t i = 0; i < items.size(); i++) {
+        items[i]->entry.offset = offset;
+        offset = (offset + items[i]->entry.size + 3) & ~3;
+    }
+
+    FILE* fp = fopen(output.c_str(), "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "emopack: failed to open %s\n", output.c_str());
+        return 1;
+    }
+    fwrite(&header, sizeof(header), 1, fp);
+    for (size_t i = 0; i < items.size(); i++) {
+        fwrite(&items[i]->entry, sizeof(emo::AssetArchiveEntry), 1, fp);
+    }
+    fwrite(table.data(), 1, table.size(), fp);
+
+    static const unsigned char padding[4] = {0, 0, 0, 0};
+    fwrite(padding, 1, header.dataOffset - (header.namesOffset + header.namesSize), fp);
+    for (size_t i = 0; i < items.size(); i++) {
+        const emo::AssetArchiveEntry& entry = items[i]->entry;
+        if (entry.size > 0) fwrite(&items[i]->data[0], 1, entry.size, fp);
+        fwrite(padding, 1, ((entry.size + 3) & ~3) - entry.size, fp);
+    }
+    fclose(fp);
+
+    printf("emopack: %u assets, %u bytes\n", (unsigned int)items.size(), offset);
+    for (size_t i = 0; i < items.size(); i++) delete items[i];
+    return 0;
+}
@@ -0,0 +1,336 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+/*
+ * etc1test: checks the PKM and KTX parser and the ETC1 decoder of the
+ * engine on the host against a reference decoder written from the
+ * specification (one 64-bit big endian word per block).
+ *
+ *   g++ -O2 -I../jni/emo -o etc1test etc1test.cpp ../jni/emo/Image_etc1.cpp
+ *   etc1test [foo.pkm|foo.ktx ...]
+ *
+ * Random blocks cover the individual and differential modes, flipped and
+ * side by side subblocks and every differential delta including -4.
+ * The decoded rows must be bottom-up as the png decoder stores them, and
+ * the uploaded blocks top-down: the drawables flip the texture coords of
+ * compressed textures and the alpha plane is decoded with a negative
+ * stride to match. Files given on the command line are parsed, decoded
+ * and timed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "Image_etc1.h"
+
+using namespace emo;
+
+static int failures = 0;
+
+static void check(bool condition, const char* what, double value) {
+    printf("%-6s %-44s %.1f\n", condition ? "ok" : "FAILED", what, value);
+    if (!condition) failures++;
+}
+
+static const int referenceTable[8][4] = {
+    {  2,   8,  -2,   -8 }, {  5,  17,  -5,  -17 }, {  9,  29,  -9,  -29 }, { 13,  42, -13,  -42 },
+    { 18,  60, -18,  -60 }, { 24,  80, -24,  -80 }, { 33, 106, -33, -106 }, { 47, 183, -47, -183 }
+};
+
+static int clampReference(int value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+/*
+ * pixel (x, y) of the block, y from the top of the block
+ */
+static void decodeReference(const unsigned char* block, int x, int y, unsigned char* rgb) {
+    unsigned long long word = 0;
+    for (int i = 0; i < 8; i++) word = (word << 8) | block[i];
+
+    bool differential = (word >> 33) & 1;
+    bool flipped      = (word >> 32) & 1;
+    bool second       = flipped ? y >= 2 : x >= 2;
+    int  table        = second ? (word >> 34) & 7 : (word >> 37) & 7;
+
+    int bit   = x * 4 + y;
+    int index = (((word >> (16 + bit)) & 1) << 1) | ((word >> bit) & 1);
+
+    for (int c = 0; c < 3; c++) {
+        int base;
+        if (differential) {
+            int color = (word >> (59 - 8 * c)) & 31;
+            int delta = (word >> (56 - 8 * c)) & 7;
+            if (delta >= 4) delta -= 8;
+            if (second) color = (color + delta) & 31;
+            base = (color << 3) | (color >> 2);
+        } else {
+            base = ((word >> ((second ? 56 : 60) - 8 * c)) & 15) * 0x11;
+        }
+        rgb[c] = clampReference(base + referenceTable[table][index]);
+    }
+}
+
+static void putBigEndian16(unsigned char* p, int value) {
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+}
+
+static std::vector<unsigned char> makePkm(int width, int height, const std::vector<unsigned char>& blocks) {
+    std::vector<unsigned char> pkm(16 + blocks.size());
+    memcpy(&pkm[0], "PKM 10", 6);
+    putBigEndian16(&pkm[6],  0);
+    putBigEndian16(&pkm[8],  (width  + 3) & ~3);
+    putBigEndian16(&pkm[10], (height + 3) & ~3);
+    putBigEndian16(&pkm[12], width);
+    putBigEndian16(&pkm[14], height);
+    memcpy(&pkm[16], &blocks[0], blocks.size());
+    return pkm;
+}
+
+static void putKtx32(unsigned char* p, unsigned int value, bool bigEndian) {
+    for (int i = 0; i < 4; i++) {
+        p[bigEndian ? 3 - i : i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+static std::vector<unsigned char> makeKtx(int width, int height, const std::vector<unsigned char>& blocks, bool bigEndian) {
+    static const unsigned char magic[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    // endianness, glType, glTypeSize, glFormat, glInternalFormat, glBaseInternalFormat,
+    // width, height, depth, array elements, faces, mipmap levels, key/value bytes
+    unsigned int header[13] = { 0x04030201, 0, 1, 0, ETC1_RGB8_OES, 0x1907,
+                                (unsigned int)width, (unsigned int)height, 0, 0, 1, 1, 8 };
+    std::vector<unsigned char> ktx(64 + 8 + 4 + blocks.size(), 0);
+    memcpy(&ktx[0], magic, 12);
+    for (int i = 0; i < 13; i++) putKtx32(&ktx[12 + i * 4], header[i], bigEndian);
+    putKtx32(&ktx[72], blocks.size(), bigEndian);
+    memcpy(&ktx[76], &blocks[0], blocks.size());
+    return ktx;
+}
+
+/*
+ * random blocks, every fourth one differential with a -4 delta in each channel
+ */
+static std::vector<unsigned char> makeBlocks(int width, int height) {
+    std::vector<unsigned char> blocks(((width + 3) / 4) * ((height + 3) / 4) * ETC1_BLOCK_SIZE);
+    for (size_t i = 0; i < blocks.size(); i++) blocks[i] = rand();
+    for (size_t i = 0; i < blocks.size(); i += ETC1_BLOCK_SIZE * 4) {
+        for (int c = 0; c < 3; c++) blocks[i + c] = (blocks[i + c] & 0xF8) | 4;
+        blocks[i + 3] |= 2;
+    }
+    return blocks;
+}
+
+/*
+ * compare the decoded rows (bottom-up, stride of the padded width) with
+ * the reference, and check that the padding is left alone
+ */
+static int compareDecoded(const Etc1Texture& texture, const unsigned char* pixels, int stride, int pixelSize) {
+    int mismatches = 0;
+    int columns = texture.encodedWidth / 4;
+    for (int y = 0; y < texture.height; y++) {
+        const unsigned char* row = pixels + stride * (texture.height - 1 - y);
+        for (int x = 0; x < texture.width; x++) {
+            unsigned char rgb[3];
+            decodeReference(texture.data + ((y / 4) * columns + x / 4) * ETC1_BLOCK_SIZE, x & 3, y & 3, rgb);
+            const unsigned char* pixel = row + x * pixelSize;
+            if (memcmp(pixel, rgb, 3) != 0 || (pixelSize == 4 && pixel[3] != 0xFF)) mismatches++;
+        }
+        for (int i = texture.width * pixelSize; i < stride; i++) {
+            if (row[i] != 0xA5) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static void testDecode(int width, int height, int pixelSize) {
+    std::vector<unsigned char> blocks = makeBlocks(width, height);
+    std::vector<unsigned char> pkm = makePkm(width, height, blocks);
+
+    Etc1Texture texture;
+    char label[64];
+    snprintf(label, sizeof(label), "pkm %dx%d parses", width, height);
+    bool parsed = parseEtc1Texture(&pkm[0], pkm.size(), &texture);
+    check(parsed && texture.width == width && texture.height == height &&
+          texture.dataSize == blocks.size(), label, texture.dataSize);
+
+    int stride = (width + 5) * pixelSize;
+    std::vector<unsigned char> pixels(stride * height, 0xA5);
+    decodeEtc1Image(texture, &pixels[0], stride, pixelSize);
+    snprintf(label, sizeof(label), "%dx%d %s matches the reference", width, height, pixelSize == 4 ? "rgba" : "rgb");
+    int mismatches = compareDecoded(texture, &pixels[0], stride, pixelSize);
+    check(mismatches == 0, label, mismatches);
+}
+
+static void testAlphaPlane() {
+    int width = 32, height = 16;
+    std::vector<unsigned char> blocks = makeBlocks(width, height);
+    std::vector<unsigned char> pkm = makePkm(width, height, blocks);
+    Etc1Texture texture;
+    parseEtc1Texture(&pkm[0], pkm.size(), &texture);
+
+    std::vector<unsigned char> rgb(width * height * 3);
+    decodeEtc1Image(texture, &rgb[0], width * 3, 3);
+
+    // bottom-up into the alpha byte of rgba as the decoded path does
+    std::vector<unsigned char> rgba(width * height * 4);
+    decodeEtc1Plane(texture, &rgba[3], width * 4, 4);
+    // top-down from the last row as the compressed path does
+    std::vector<unsigned char> plane(width * height);
+    decodeEtc1Plane(texture, &plane[width * (height - 1)], -width, 1);
+
+    int bottomUp = 0, topDown = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned char green = rgb[(y * width + x) * 3 + 1];
+            if (rgba[(y * width + x) * 4 + 3] != green) bottomUp++;
+            if (plane[(height - 1 - y) * width + x] != green) topDown++;
+        }
+    }
+    check(bottomUp == 0, "alpha plane bottom-up", bottomUp);
+    check(topDown  == 0, "alpha plane top-down (negative stride)", topDown);
+}
+
+/*
+ * the compressed path uploads the blocks as they are: texture row 0 is
+ * the top of the image. sampling it at 1 - v must give the decoded image.
+ */
+static void testUploadOrientation() {
+    int width = 64, height = 32;
+    std::vector<unsigned char> blocks = makeBlocks(width, height);
+    std::vector<unsigned char> pkm = makePkm(width, height, blocks);
+    Etc1Texture texture;
+    parseEtc1Texture(&pkm[0], pkm.size(), &texture);
+
+    std::vector<unsigned char> decoded(width * height * 3);
+    decodeEtc1Image(texture, &decoded[0], width * 3, 3);
+
+    int mismatches = 0;
+    for (int row = 0; row < height; row++) {
+        for (int x = 0; x < width; x++) {
+            unsigned char rgb[3];
+            decodeReference(texture.data + ((row / 4) * (width / 4) + x / 4) * ETC1_BLOCK_SIZE, x & 3, row & 3, rgb);
+            float v = (row + 0.5f) / height;
+            int decodedRow = (int)((1 - v) * height);
+            if (memcmp(&decoded[(decodedRow * width + x) * 3], rgb, 3) != 0) mismatches++;
+        }
+    }
+    check(mismatches == 0, "uploaded blocks sampled at 1 - v", mismatches);
+}
+
+static void testContainers() {
+    int width = 30, height = 14;
+    std::vector<unsigned char> blocks = makeBlocks(width, height);
+    std::vector<unsigned char> pkm = makePkm(width, height, blocks);
+
+    for (int bigEndian = 0; bigEndian < 2; bigEndian++) {
+        std::vector<unsigned char> ktx = makeKtx(width, height, blocks, bigEndian != 0);
+        Etc1Texture texture;
+        bool parsed = parseEtc1Texture(&ktx[0], ktx.size(), &texture);
+        check(parsed && texture.width == width && texture.height == height &&
+              texture.encodedWidth == 32 && texture.encodedHeight == 16 &&
+              memcmp(texture.data, &blocks[0], blocks.size()) == 0,
+              bigEndian ? "ktx big endian parses" : "ktx little endian parses", texture.dataSize);
+    }
+
+    Etc1Texture texture;
+    std::vector<unsigned char> ktx = makeKtx(width, height, blocks, false);
+    check(!parseEtc1Texture(&pkm[0], pkm.size() - 1, &texture), "truncated pkm rejected", pkm.size() - 1);
+    check(!parseEtc1Texture(&ktx[0], ktx.size() - 1, &texture), "truncated ktx rejected", ktx.size() - 1);
+    check(!parseEtc1Texture(&ktx[0], 70, &texture), "ktx without image size rejected", 70);
+
+    std::vector<unsigned char> bad = pkm;
+    putBigEndian16(&bad[12], 40);
+    check(!parseEtc1Texture(&bad[0], bad.size(), &texture), "pkm larger than encoded rejected", 40);
+    bad = ktx;
+    putKtx32(&bad[28], 0x8D65, false);
+    check(!parseEtc1Texture(&bad[0], bad.size(), &texture), "ktx of other format rejected", 0x8D65);
+    bad = pkm;
+    bad[0] = 'X';
+    check(!parseEtc1Texture(&bad[0], bad.size(), &texture), "unknown magic rejected", 0);
+}
+
+static double elapsedMillis(const timespec& start, const timespec& end) {
+    return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+static void testFile(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        check(false, path, 0);
+        return;
+    }
+    std::vector<unsigned char> bytes;
+    unsigned char buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + length);
+    }
+    fclose(fp);
+
+    Etc1Texture texture;
+    if (bytes.empty() || !parseEtc1Texture(&bytes[0], bytes.size(), &texture)) {
+        check(false, path, bytes.size());
+        return;
+    }
+
+    int stride = texture.width * 4;
+    std::vector<unsigned char> pixels(stride * texture.height, 0xA5);
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    decodeEtc1Image(texture, &pixels[0], stride, 4);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    int mismatches = compareDecoded(texture, &pixels[0], stride, 4);
+    check(mismatches == 0, path, mismatches);
+    printf("       %dx%d, %u bytes of blocks, decoded in %.2f ms\n",
+           texture.width, texture.height, texture.dataSize, elapsedMillis(start, end));
+}
+
+int main(int argc, char** argv) {
+    srand(1);
+    testDecode(64, 32, 4);
+    testDecode(61, 30, 4);
+    testDecode(5, 3, 3);
+    testDecode(1, 1, 4);
+    testAlphaPlane();
+    testUploadOrientation();
+    testContainers();
+
+    for (int i = 1; i < argc; i++) {
+        testFile(argv[i]);
+    }
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,229 @@
+// Copyright (c) 2011 emo-framework project
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of the project nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+/*
+ * mipmapbench: host side numbers for the mipmap example scene of
+ * Android-Examples (mipmap_example.nut), which measures the frame rate
+ * on a device.
+ *
+ *   g++ -O2 -I../jni/emo -o mipmapbench mipmapbench.cpp ../jni/emo/Image_mipmap.cpp
+ *   mipmapbench [width height]
+ *
+ * The chain of the 1024x1024 grid texture is generated with the engine
+ * code and timed. Then the texture traffic of the scene is estimated
+ * with a model of a GPU texture cache: 8KB, 4-way LRU with hashed sets,
+ * 64 byte lines holding 4x4 texels of 4 bytes. The screen is drawn in 16x16 tiles as
+ * tile based GPUs do, every layer of a tile before the next tile.
+ * GL_LINEAR reads the 2x2 texels of level 0, GL_LINEAR_MIPMAP_LINEAR
+ * reads 2x2 texels of the two nearest levels, only one when the scale
+ * is a power of two. The bytes that miss the cache are the memory
+ * bandwidth the texture costs each frame.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "Image_mipmap.h"
+
+using namespace emo;
+
+#define TEXTURE_SIZE       1024
+#define SCENE_LAYERS       4
+#define SCREEN_TILE        16
+#define CACHE_LINE_TEXELS  4
+#define CACHE_LINE_BYTES   (CACHE_LINE_TEXELS * CACHE_LINE_TEXELS * 4)
+#define CACHE_WAYS         4
+#define CACHE_SETS         (8192 / CACHE_LINE_BYTES / CACHE_WAYS)
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/*
+ * the pattern of grid_1024.png: 1px lines every 8 texels over 32x32 cells
+ */
+static void makeGrid(unsigned char* pixels, int pixelSize) {
+    for (int y = 0; y < TEXTURE_SIZE; y++) {
+        for (int x = 0; x < TEXTURE_SIZE; x++) {
+            unsigned char* p = pixels + (y * TEXTURE_SIZE + x) * pixelSize;
+            int cx = x / 32, cy = y / 32;
+            bool line = x % 8 == 0 || y % 8 == 0;
+            p[0] = line ? 255 : (cx * 37) & 255;
+            p[1] = line ? 255 : (cy * 53) & 255;
+            p[2] = line ? 255 : ((cx ^ cy) * 29) & 255;
+            if (pixelSize == 4) p[3] = 255;
+        }
+    }
+}
+
+static void benchChain(int pixelSize) {
+    std::vector<unsigned char> level0(TEXTURE_SIZE * TEXTURE_SIZE * pixelSize);
+    std::vector<unsigned char> chain(getMipmapChainSize(TEXTURE_SIZE, TEXTURE_SIZE, pixelSize));
+    makeGrid(&level0[0], pixelSize);
+
+    int runs = 0;
+    double start = now();
+    while (now() - start < 500) {
+        generateMipmapChain(&chain[0], &level0[0], TEXTURE_SIZE, TEXTURE_SIZE, pixelSize);
+        runs++;
+    }
+    double ms = (now() - start) / runs;
+    printf("%-4s chain of %dx%d: %d levels, %6.2f ms, %7d bytes (+%.0f%%)\n",
+           pixelSize == 4 ? "rgba" : "rgb", TEXTURE_SIZE, TEXTURE_SIZE,
+           getMipmapLevelCount(TEXTURE_SIZE, TEXTURE_SIZE), ms,
+           (int)chain.size(), 100.0 * chain.size() / level0.size());
+}
+
+class TextureCache {
+public:
+    TextureCache() : clock(0), misses(0), reads(0) {
+        memset(tags, 0xFF, sizeof(tags));
+        memset(used, 0, sizeof(used));
+    }
+
+    void read(long line) {
+        reads++;
+        // hashed like the GPUs do so that power of two rows do not alias
+        int set = (int)(((unsigned long)line * 2654435761u >> 16) % CACHE_SETS);
+        int victim = 0;
+        for (int way = 0; way < CACHE_WAYS; way++) {
+            if (tags[set][way] == line) {
+                used[set][way] = ++clock;
+                return;
+            }
+            if (used[set][way] < used[set][victim]) victim = way;
+        }
+        misses++;
+        tags[set][victim] = line;
+        used[set][victim] = ++clock;
+    }
+
+    long tags[CACHE_SETS][CACHE_WAYS];
+    unsigned long used[CACHE_SETS][CACHE_WAYS];
+    unsigned long clock;
+    long misses;
+    long reads;
+};
+
+/*
+ * first cache line of each level, levels are stored in 4x4 texel lines
+ */
+static long levelBase[16];
+
+static void initLevels() {
+    long base = 0;
+    for (int level = 0, size = TEXTURE_SIZE; size >= 1; level++, size /= 2) {
+        levelBase[level] = base;
+        int lines = (size + CACHE_LINE_TEXELS - 1) / CACHE_LINE_TEXELS;
+        base += (long)lines * lines;
+    }
+}
+
+static void readTexel(TextureCache* cache, int level, int x, int y) {
+    int size = TEXTURE_SIZE >> level;
+    // GL_CLAMP_TO_EDGE
+    x = x < 0 ? 0 : (x >= size ? size - 1 : x);
+    y = y < 0 ? 0 : (y >= size ? size - 1 : y);
+    int lines = (size + CACHE_LINE_TEXELS - 1) / CACHE_LINE_TEXELS;
+    cache->read(levelBase[level] + (long)(y / CACHE_LINE_TEXELS) * lines + x / CACHE_LINE_TEXELS);
+}
+
+static void readBilinear(TextureCache* cache, int level, float u, float v) {
+    float size = (float)(TEXTURE_SIZE >> level);
+    int x = (int)floorf(u * size - 0.5f);
+    int y = (int)floorf(v * size - 0.5f);
+    readTexel(cache, level, x,     y);
+    readTexel(cache, level, x + 1, y);
+    readTexel(cache, level, x,     y + 1);
+    readTexel(cache, level, x + 1, y + 1);
+}
+
+/*
+ * returns the bytes read from memory for one frame of the scene
+ */
+static long simulateFrame(int width, int height, float scale, bool mipmap) {
+    TextureCache cache;
+    float spriteSize = TEXTURE_SIZE * scale;
+    float lod = log2f(1 / scale);
+    int   level = lod > 0 ? (int)floorf(lod) : 0;
+    float fraction = lod > 0 ? lod - level : 0;
+    int   maxLevel = (int)log2f(TEXTURE_SIZE);
+
+    for (int ty = 0; ty < height; ty += SCREEN_TILE) {
+        for (int tx = 0; tx < width; tx += SCREEN_TILE) {
+            for (int layer = 0; layer < SCENE_LAYERS; layer++) {
+                for (int y = ty; y < ty + SCREEN_TILE && y < height; y++) {
+                    for (int x = tx; x < tx + SCREEN_TILE && x < width; x++) {
+                        float u = fmodf(x + 0.5f, spriteSize) / spriteSize;
+                        float v = fmodf(y + 0.5f, spriteSize) / spriteSize;
+                        if (!mipmap) {
+                            readBilinear(&cache, 0, u, v);
+                            continue;
+                        }
+                        readBilinear(&cache, level, u, v);
+                        if (fraction > 0 && level < maxLevel) {
+                            readBilinear(&cache, level + 1, u, v);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return cache.misses * CACHE_LINE_BYTES;
+}
+
+int main(int argc, char** argv) {
+    int width  = argc > 2 ? atoi(argv[1]) : 480;
+    int height = argc > 2 ? atoi(argv[2]) : 800;
+
+    initMipmapKernels();
+    printf("mipmap kernels: %s\n", getMipmapKernelsName());
+    benchChain(3);
+    benchChain(4);
+
+    initLevels();
+    printf("\ntexture traffic of %d layers on %dx%d (%d pixels per frame)\n",
+           SCENE_LAYERS, width, height, width * height * SCENE_LAYERS);
+    printf("%-6s %22s %22s %8s\n", "scale", "GL_LINEAR", "MIPMAP_LINEAR", "ratio");
+
+    static const float scales[] = { 1.0f, 0.75f, 0.5f, 0.25f, 0.125f };
+    for (size_t i = 0; i < sizeof(scales) / sizeof(scales[0]); i++) {
+        long linear  = simulateFrame(width, height, scales[i], false);
+        long mipmaps = simulateFrame(width, height, scales[i], true);
+        double pixels = (double)width * height * SCENE_LAYERS;
+        printf("%-6.3f %8.2f MB %5.2f B/px %8.2f MB %5.2f B/px %7.1fx\n", scales[i],
+               linear  / 1048576.0, linear  / pixels,
+               mipmaps / 1048576.0, mipmaps / pixels,
+               (double)linear / mipmaps);
+    }
+    return 0;
+}